@@ -496,9 +496,63 @@ MutationIndex Chromosome::DrawNewMutation(IndividualSex p_sex, slim_objectid_t p
 	return new_mut_index;
 }
 
+// draw the position of a new mutation, and the genomic element containing it; DrawNewMutationAtPosition() then makes the mutation
+slim_position_t Chromosome::DrawNewMutationPosition(gsl_rng *p_rng, IndividualSex p_sex, const GenomicElement **p_element) const
+{
+	gsl_ran_discrete_t *lookup;
+	const vector<GESubrange> *subranges;
+	
+	if (single_mutation_map_)
+	{
+		// With a single map, we don't care what sex we are passed; same map for all, and sex may be enabled or disabled
+		lookup = lookup_mutation_H_;
+		subranges = &mutation_subranges_H_;
+	}
+	else
+	{
+		// With sex-specific maps, we treat males and females separately, and the individual we're given better be one of the two
+		if (p_sex == IndividualSex::kMale)
+		{
+			lookup = lookup_mutation_M_;
+			subranges = &mutation_subranges_M_;
+		}
+		else if (p_sex == IndividualSex::kFemale)
+		{
+			lookup = lookup_mutation_F_;
+			subranges = &mutation_subranges_F_;
+		}
+		else
+		{
+			MutationMapConfigError();
+		}
+	}
+	
+	int mut_subrange_index = static_cast<int>(gsl_ran_discrete(p_rng, lookup));
+	const GESubrange &subrange = (*subranges)[mut_subrange_index];
+	
+	*p_element = subrange.genomic_element_ptr_;
+	
+	return subrange.start_position_ + static_cast<slim_position_t>(gsl_rng_uniform_int(p_rng, subrange.end_position_ - subrange.start_position_ + 1));
+}
+
+// make a new mutation at a position drawn by DrawNewMutationPosition(), drawing its mutation type and selection coefficient
+MutationIndex Chromosome::DrawNewMutationAtPosition(slim_position_t p_position, const GenomicElement &p_element, slim_objectid_t p_subpop_index, slim_generation_t p_generation) const
+{
+	const GenomicElementType &genomic_element_type = *p_element.genomic_element_type_ptr_;
+	MutationType *mutation_type_ptr = genomic_element_type.DrawMutationType();
+	double selection_coeff = mutation_type_ptr->DrawSelectionCoefficient();
+	
+	// NOTE THAT THE STACKING POLICY IS NOT ENFORCED HERE, SINCE WE DO NOT KNOW WHAT GENOME WE WILL BE INSERTED INTO!  THIS IS THE CALLER'S RESPONSIBILITY!
+	MutationIndex new_mut_index = SLiM_NewMutationFromBlock();
+	
+	new (gSLiM_Mutation_Block + new_mut_index) Mutation(mutation_type_ptr, p_position, selection_coeff, p_subpop_index, p_generation);
+	
+	return new_mut_index;
+}
+
 // choose a set of recombination breakpoints, based on recombination intervals, overall recombination rate, and gene conversion probability
 // BEWARE!  Chromosome::DrawBreakpoints_Detailed() below must be altered in parallel with this method!
-void Chromosome::DrawBreakpoints(IndividualSex p_sex, const int p_num_breakpoints, std::vector<slim_position_t> &p_crossovers) const
+void Chromosome::DrawBreakpoints(gsl_rng *p_rng, IndividualSex p_sex, const int p_num_breakpoints, std::vector<slim_position_t> &p_crossovers) const
 {
 	gsl_ran_discrete_t *lookup;
 	const vector<slim_position_t> *end_positions;
@@ -532,7 +586,7 @@ void Chromosome::DrawBreakpoints(IndividualSex p_sex, const int p_num_breakpoint
 	for (int i = 0; i < p_num_breakpoints; i++)
 	{
 		slim_position_t breakpoint = 0;
-		int recombination_interval = static_cast<int>(gsl_ran_discrete(gEidos_rng, lookup));
+		int recombination_interval = static_cast<int>(gsl_ran_discrete(p_rng, lookup));
 		
 		// choose a breakpoint anywhere in the chosen recombination interval with equal probability
 		
@@ -566,21 +620,21 @@ void Chromosome::DrawBreakpoints(IndividualSex p_sex, const int p_num_breakpoint
 		// since we guarantee that recombination end positions are in strictly ascending order.  So we should never crash.  :->
 		
 		if (recombination_interval == 0)
-			breakpoint = static_cast<slim_position_t>(gsl_rng_uniform_int(gEidos_rng, (*end_positions)[recombination_interval]) + 1);
+			breakpoint = static_cast<slim_position_t>(gsl_rng_uniform_int(p_rng, (*end_positions)[recombination_interval]) + 1);
 		else
-			breakpoint = (*end_positions)[recombination_interval - 1] + 1 + static_cast<slim_position_t>(gsl_rng_uniform_int(gEidos_rng, (*end_positions)[recombination_interval] - (*end_positions)[recombination_interval - 1]));
+			breakpoint = (*end_positions)[recombination_interval - 1] + 1 + static_cast<slim_position_t>(gsl_rng_uniform_int(p_rng, (*end_positions)[recombination_interval] - (*end_positions)[recombination_interval - 1]));
 		
 		p_crossovers.emplace_back(breakpoint);
 		
 		// recombination can result in gene conversion, with probability gene_conversion_fraction_
 		if (gene_conversion_fraction_ > 0.0)
 		{
-			if ((gene_conversion_fraction_ < 1.0) && (gsl_rng_uniform(gEidos_rng) < gene_conversion_fraction_))
+			if ((gene_conversion_fraction_ < 1.0) && (gsl_rng_uniform(p_rng) < gene_conversion_fraction_))
 			{
 				// for gene conversion, choose a second breakpoint that is relatively likely to be near to the first
 				// note that this second breakpoint does not count toward the total number of breakpoints we need to
 				// generate; this means that when gene conversion occurs, we return more breakpoints than requested!
-				slim_position_t breakpoint2 = SLiMClampToPositionType(breakpoint + gsl_ran_geometric(gEidos_rng, 1.0 / gene_conversion_avg_length_));
+				slim_position_t breakpoint2 = SLiMClampToPositionType(breakpoint + gsl_ran_geometric(p_rng, 1.0 / gene_conversion_avg_length_));
 				
 				if (breakpoint2 <= last_position_)	// used to always add; added this 17 August 2015 BCH, but shouldn't really matter
 					p_crossovers.emplace_back(breakpoint2);
@@ -591,7 +645,7 @@ void Chromosome::DrawBreakpoints(IndividualSex p_sex, const int p_num_breakpoint
 
 // The same logic as Chromosome::DrawBreakpoints() above, but breaks results down into crossovers versus
 // gene conversion stand/end points.  See Chromosome::DrawBreakpoints for comments on the logic.
-void Chromosome::DrawBreakpoints_Detailed(IndividualSex p_sex, const int p_num_breakpoints, vector<slim_position_t> &p_crossovers, vector<slim_position_t> &p_gcstarts, vector<slim_position_t> &p_gcends) const
+void Chromosome::DrawBreakpoints_Detailed(gsl_rng *p_rng, IndividualSex p_sex, const int p_num_breakpoints, vector<slim_position_t> &p_crossovers, vector<slim_position_t> &p_gcstarts, vector<slim_position_t> &p_gcends) const
 {
 	gsl_ran_discrete_t *lookup;
 	const vector<slim_position_t> *end_positions;
@@ -625,25 +679,25 @@ void Chromosome::DrawBreakpoints_Detailed(IndividualSex p_sex, const int p_num_b
 	for (int i = 0; i < p_num_breakpoints; i++)
 	{
 		slim_position_t breakpoint = 0;
-		int recombination_interval = static_cast<int>(gsl_ran_discrete(gEidos_rng, lookup));
+		int recombination_interval = static_cast<int>(gsl_ran_discrete(p_rng, lookup));
 		
 		// choose a breakpoint anywhere in the chosen recombination interval with equal probability
 		if (recombination_interval == 0)
-			breakpoint = static_cast<slim_position_t>(gsl_rng_uniform_int(gEidos_rng, (*end_positions)[recombination_interval]) + 1);
+			breakpoint = static_cast<slim_position_t>(gsl_rng_uniform_int(p_rng, (*end_positions)[recombination_interval]) + 1);
 		else
-			breakpoint = (*end_positions)[recombination_interval - 1] + 1 + static_cast<slim_position_t>(gsl_rng_uniform_int(gEidos_rng, (*end_positions)[recombination_interval] - (*end_positions)[recombination_interval - 1]));
+			breakpoint = (*end_positions)[recombination_interval - 1] + 1 + static_cast<slim_position_t>(gsl_rng_uniform_int(p_rng, (*end_positions)[recombination_interval] - (*end_positions)[recombination_interval - 1]));
 		
 		// recombination can result in gene conversion, with probability gene_conversion_fraction_
 		if (gene_conversion_fraction_ > 0.0)
 		{
-			if ((gene_conversion_fraction_ < 1.0) && (gsl_rng_uniform(gEidos_rng) < gene_conversion_fraction_))
+			if ((gene_conversion_fraction_ < 1.0) && (gsl_rng_uniform(p_rng) < gene_conversion_fraction_))
 			{
 				p_gcstarts.emplace_back(breakpoint);
 				
 				// for gene conversion, choose a second breakpoint that is relatively likely to be near to the first
 				// note that this second breakpoint does not count toward the total number of breakpoints we need to
 				// generate; this means that when gene conversion occurs, we return more breakpoints than requested!
-				slim_position_t breakpoint2 = SLiMClampToPositionType(breakpoint + gsl_ran_geometric(gEidos_rng, 1.0 / gene_conversion_avg_length_));
+				slim_position_t breakpoint2 = SLiMClampToPositionType(breakpoint + gsl_ran_geometric(p_rng, 1.0 / gene_conversion_avg_length_));
 				
 				if (breakpoint2 <= last_position_)	// used to always add; added this 17 August 2015 BCH, but shouldn't really matter
 					p_gcends.emplace_back(breakpoint2);
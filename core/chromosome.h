@@ -162,22 +162,30 @@ public:
 	void _InitializeOneMutationMap(gsl_ran_discrete_t *&p_lookup, vector<slim_position_t> &p_end_positions, vector<double> &p_rates, double &p_overall_rate, double &p_exp_neg_overall_rate, vector<GESubrange> &p_subranges);
 	void ChooseMutationRunLayout(int p_preferred_count);
 	
+	// The methods below that take a gsl_rng draw from that generator, which is gEidos_rng except when drawing from a random number
+	// stream on a worker thread (see Population::ExecuteReproductionTasks()); they must not touch any other shared state.
+	
 	// draw the number of mutations that occur, based on the overall mutation rate
-	int DrawMutationCount(IndividualSex p_sex) const;
+	int DrawMutationCount(gsl_rng *p_rng, IndividualSex p_sex) const;
 	
 	// draw a new mutation, based on the genomic element types present and their mutational proclivities
 	MutationIndex DrawNewMutation(IndividualSex p_sex, slim_objectid_t p_subpop_index, slim_generation_t p_generation) const;
 	
+	// draw a new mutation in two steps: first its position and genomic element, which can be done on a worker thread, and then the mutation
+	// itself, which must be done on the main thread since it draws from gEidos_rng, allocates from the mutation block, and may run Eidos code
+	slim_position_t DrawNewMutationPosition(gsl_rng *p_rng, IndividualSex p_sex, const GenomicElement **p_element) const;
+	MutationIndex DrawNewMutationAtPosition(slim_position_t p_position, const GenomicElement &p_element, slim_objectid_t p_subpop_index, slim_generation_t p_generation) const;
+	
 	// draw the number of breakpoints that occur, based on the overall recombination rate
-	int DrawBreakpointCount(IndividualSex p_sex) const;
+	int DrawBreakpointCount(gsl_rng *p_rng, IndividualSex p_sex) const;
 	
 	// choose a set of recombination breakpoints, based on recomb. intervals, overall recomb. rate, and gene conversion probability
-	void DrawBreakpoints(IndividualSex p_sex, const int p_num_breakpoints, std::vector<slim_position_t> &p_crossovers) const;
-	void DrawBreakpoints_Detailed(IndividualSex p_sex, const int p_num_breakpoints, vector<slim_position_t> &p_crossovers, vector<slim_position_t> &p_gcstarts, vector<slim_position_t> &p_gcends) const;
+	void DrawBreakpoints(gsl_rng *p_rng, IndividualSex p_sex, const int p_num_breakpoints, std::vector<slim_position_t> &p_crossovers) const;
+	void DrawBreakpoints_Detailed(gsl_rng *p_rng, IndividualSex p_sex, const int p_num_breakpoints, vector<slim_position_t> &p_crossovers, vector<slim_position_t> &p_gcstarts, vector<slim_position_t> &p_gcends) const;
 	
 #ifndef USE_GSL_POISSON
 	// draw both the mutation count and breakpoint count, using a single Poisson draw for speed
-	void DrawMutationAndBreakpointCounts(IndividualSex p_sex, int *p_mut_count, int *p_break_count) const;
+	void DrawMutationAndBreakpointCounts(gsl_rng *p_rng, IndividualSex p_sex, int *p_mut_count, int *p_break_count) const;
 	
 	// initialize the joint probabilities used by DrawMutationAndBreakpointCounts()
 	void _InitializeJointProbabilities(double p_overall_mutation_rate, double p_exp_neg_overall_mutation_rate,
@@ -204,24 +212,24 @@ public:
 };
 
 // draw the number of mutations that occur, based on the overall mutation rate
-inline __attribute__((always_inline)) int Chromosome::DrawMutationCount(IndividualSex p_sex) const
+inline __attribute__((always_inline)) int Chromosome::DrawMutationCount(gsl_rng *p_rng, IndividualSex p_sex) const
 {
 #ifdef USE_GSL_POISSON
 	if (single_mutation_map_)
 	{
 		// With a single map, we don't care what sex we are passed; same map for all, and sex may be enabled or disabled
-		return gsl_ran_poisson(gEidos_rng, overall_mutation_rate_H_);
+		return gsl_ran_poisson(p_rng, overall_mutation_rate_H_);
 	}
 	else
 	{
 		// With sex-specific maps, we treat males and females separately, and the individual we're given better be one of the two
 		if (p_sex == IndividualSex::kMale)
 		{
-			return gsl_ran_poisson(gEidos_rng, overall_mutation_rate_M_);
+			return gsl_ran_poisson(p_rng, overall_mutation_rate_M_);
 		}
 		else if (p_sex == IndividualSex::kFemale)
 		{
-			return gsl_ran_poisson(gEidos_rng, overall_mutation_rate_F_);
+			return gsl_ran_poisson(p_rng, overall_mutation_rate_F_);
 		}
 		else
 		{
@@ -232,18 +240,18 @@ inline __attribute__((always_inline)) int Chromosome::DrawMutationCount(Individu
 	if (single_mutation_map_)
 	{
 		// With a single map, we don't care what sex we are passed; same map for all, and sex may be enabled or disabled
-		return Eidos_FastRandomPoisson(overall_mutation_rate_H_, exp_neg_overall_mutation_rate_H_);
+		return Eidos_FastRandomPoisson(p_rng, overall_mutation_rate_H_, exp_neg_overall_mutation_rate_H_);
 	}
 	else
 	{
 		// With sex-specific maps, we treat males and females separately, and the individual we're given better be one of the two
 		if (p_sex == IndividualSex::kMale)
 		{
-			return Eidos_FastRandomPoisson(overall_mutation_rate_M_, exp_neg_overall_mutation_rate_M_);
+			return Eidos_FastRandomPoisson(p_rng, overall_mutation_rate_M_, exp_neg_overall_mutation_rate_M_);
 		}
 		else if (p_sex == IndividualSex::kFemale)
 		{
-			return Eidos_FastRandomPoisson(overall_mutation_rate_F_, exp_neg_overall_mutation_rate_F_);
+			return Eidos_FastRandomPoisson(p_rng, overall_mutation_rate_F_, exp_neg_overall_mutation_rate_F_);
 		}
 		else
 		{
@@ -254,24 +262,24 @@ inline __attribute__((always_inline)) int Chromosome::DrawMutationCount(Individu
 }
 
 // draw the number of breakpoints that occur, based on the overall recombination rate
-inline __attribute__((always_inline)) int Chromosome::DrawBreakpointCount(IndividualSex p_sex) const
+inline __attribute__((always_inline)) int Chromosome::DrawBreakpointCount(gsl_rng *p_rng, IndividualSex p_sex) const
 {
 #ifdef USE_GSL_POISSON
 	if (single_recombination_map_)
 	{
 		// With a single map, we don't care what sex we are passed; same map for all, and sex may be enabled or disabled
-		return gsl_ran_poisson(gEidos_rng, overall_recombination_rate_H_);
+		return gsl_ran_poisson(p_rng, overall_recombination_rate_H_);
 	}
 	else
 	{
 		// With sex-specific maps, we treat males and females separately, and the individual we're given better be one of the two
 		if (p_sex == IndividualSex::kMale)
 		{
-			return gsl_ran_poisson(gEidos_rng, overall_recombination_rate_M_);
+			return gsl_ran_poisson(p_rng, overall_recombination_rate_M_);
 		}
 		else if (p_sex == IndividualSex::kFemale)
 		{
-			return gsl_ran_poisson(gEidos_rng, overall_recombination_rate_F_);
+			return gsl_ran_poisson(p_rng, overall_recombination_rate_F_);
 		}
 		else
 		{
@@ -282,18 +290,18 @@ inline __attribute__((always_inline)) int Chromosome::DrawBreakpointCount(Indivi
 	if (single_recombination_map_)
 	{
 		// With a single map, we don't care what sex we are passed; same map for all, and sex may be enabled or disabled
-		return Eidos_FastRandomPoisson(overall_recombination_rate_H_, exp_neg_overall_recombination_rate_H_);
+		return Eidos_FastRandomPoisson(p_rng, overall_recombination_rate_H_, exp_neg_overall_recombination_rate_H_);
 	}
 	else
 	{
 		// With sex-specific maps, we treat males and females separately, and the individual we're given better be one of the two
 		if (p_sex == IndividualSex::kMale)
 		{
-			return Eidos_FastRandomPoisson(overall_recombination_rate_M_, exp_neg_overall_recombination_rate_M_);
+			return Eidos_FastRandomPoisson(p_rng, overall_recombination_rate_M_, exp_neg_overall_recombination_rate_M_);
 		}
 		else if (p_sex == IndividualSex::kFemale)
 		{
-			return Eidos_FastRandomPoisson(overall_recombination_rate_F_, exp_neg_overall_recombination_rate_F_);
+			return Eidos_FastRandomPoisson(p_rng, overall_recombination_rate_F_, exp_neg_overall_recombination_rate_F_);
 		}
 		else
 		{
@@ -306,9 +314,9 @@ inline __attribute__((always_inline)) int Chromosome::DrawBreakpointCount(Indivi
 #ifndef USE_GSL_POISSON
 // determine both the mutation count and the breakpoint count with (usually) a single RNG draw
 // this method relies on Eidos_FastRandomPoisson_NONZERO() and cannot be called when USE_GSL_POISSON is defined
-inline __attribute__((always_inline)) void Chromosome::DrawMutationAndBreakpointCounts(IndividualSex p_sex, int *p_mut_count, int *p_break_count) const
+inline __attribute__((always_inline)) void Chromosome::DrawMutationAndBreakpointCounts(gsl_rng *p_rng, IndividualSex p_sex, int *p_mut_count, int *p_break_count) const
 {
-	double u = gsl_rng_uniform(gEidos_rng);
+	double u = gsl_rng_uniform(p_rng);
 	
 	if (single_recombination_map_ && single_mutation_map_)
 	{
@@ -322,17 +330,17 @@ inline __attribute__((always_inline)) void Chromosome::DrawMutationAndBreakpoint
 		else if (u <= probability_both_0_OR_mut_0_break_non0_H_)
 		{
 			*p_mut_count = 0;
-			*p_break_count = Eidos_FastRandomPoisson_NONZERO(overall_recombination_rate_H_, exp_neg_overall_recombination_rate_H_);
+			*p_break_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_recombination_rate_H_, exp_neg_overall_recombination_rate_H_);
 		}
 		else if (u <= probability_both_0_OR_mut_0_break_non0_OR_mut_non0_break_0_H_)
 		{
-			*p_mut_count = Eidos_FastRandomPoisson_NONZERO(overall_mutation_rate_H_, exp_neg_overall_mutation_rate_H_);
+			*p_mut_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_mutation_rate_H_, exp_neg_overall_mutation_rate_H_);
 			*p_break_count = 0;
 		}
 		else
 		{
-			*p_mut_count = Eidos_FastRandomPoisson_NONZERO(overall_mutation_rate_H_, exp_neg_overall_mutation_rate_H_);
-			*p_break_count = Eidos_FastRandomPoisson_NONZERO(overall_recombination_rate_H_, exp_neg_overall_recombination_rate_H_);
+			*p_mut_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_mutation_rate_H_, exp_neg_overall_mutation_rate_H_);
+			*p_break_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_recombination_rate_H_, exp_neg_overall_recombination_rate_H_);
 		}
 	}
 	else
@@ -351,17 +359,17 @@ inline __attribute__((always_inline)) void Chromosome::DrawMutationAndBreakpoint
 			else if (u <= probability_both_0_OR_mut_0_break_non0_M_)
 			{
 				*p_mut_count = 0;
-				*p_break_count = Eidos_FastRandomPoisson_NONZERO(overall_recombination_rate_M_, exp_neg_overall_recombination_rate_M_);
+				*p_break_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_recombination_rate_M_, exp_neg_overall_recombination_rate_M_);
 			}
 			else if (u <= probability_both_0_OR_mut_0_break_non0_OR_mut_non0_break_0_M_)
 			{
-				*p_mut_count = Eidos_FastRandomPoisson_NONZERO(overall_mutation_rate_M_, exp_neg_overall_mutation_rate_M_);
+				*p_mut_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_mutation_rate_M_, exp_neg_overall_mutation_rate_M_);
 				*p_break_count = 0;
 			}
 			else
 			{
-				*p_mut_count = Eidos_FastRandomPoisson_NONZERO(overall_mutation_rate_M_, exp_neg_overall_mutation_rate_M_);
-				*p_break_count = Eidos_FastRandomPoisson_NONZERO(overall_recombination_rate_M_, exp_neg_overall_recombination_rate_M_);
+				*p_mut_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_mutation_rate_M_, exp_neg_overall_mutation_rate_M_);
+				*p_break_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_recombination_rate_M_, exp_neg_overall_recombination_rate_M_);
 			}
 		}
 		else if (p_sex == IndividualSex::kFemale)
@@ -374,17 +382,17 @@ inline __attribute__((always_inline)) void Chromosome::DrawMutationAndBreakpoint
 			else if (u <= probability_both_0_OR_mut_0_break_non0_F_)
 			{
 				*p_mut_count = 0;
-				*p_break_count = Eidos_FastRandomPoisson_NONZERO(overall_recombination_rate_F_, exp_neg_overall_recombination_rate_F_);
+				*p_break_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_recombination_rate_F_, exp_neg_overall_recombination_rate_F_);
 			}
 			else if (u <= probability_both_0_OR_mut_0_break_non0_OR_mut_non0_break_0_F_)
 			{
-				*p_mut_count = Eidos_FastRandomPoisson_NONZERO(overall_mutation_rate_F_, exp_neg_overall_mutation_rate_F_);
+				*p_mut_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_mutation_rate_F_, exp_neg_overall_mutation_rate_F_);
 				*p_break_count = 0;
 			}
 			else
 			{
-				*p_mut_count = Eidos_FastRandomPoisson_NONZERO(overall_mutation_rate_F_, exp_neg_overall_mutation_rate_F_);
-				*p_break_count = Eidos_FastRandomPoisson_NONZERO(overall_recombination_rate_F_, exp_neg_overall_recombination_rate_F_);
+				*p_mut_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_mutation_rate_F_, exp_neg_overall_mutation_rate_F_);
+				*p_break_count = Eidos_FastRandomPoisson_NONZERO(p_rng, overall_recombination_rate_F_, exp_neg_overall_recombination_rate_F_);
 			}
 		}
 		else
@@ -370,6 +370,7 @@ Genome::Genome(const Genome &p_original)
 	
 	// and copy other state
 	genome_type_ = p_original.genome_type_;
+	tree_node_id_ = p_original.tree_node_id_;
 	
 	// We copy this because we only use this constructor within a single subpopulation, never to
 	// construct a genome destined for a new subpopulation that is identical to an existing
@@ -407,6 +408,7 @@ Genome& Genome::operator= (const Genome& p_original)
 		
 		// and copy other state
 		genome_type_ = p_original.genome_type_;
+		tree_node_id_ = p_original.tree_node_id_;
 		
 		// DO NOT copy the subpop pointer!  That is not part of the genetic state of the genome,
 		// it's a back-pointer to the Subpopulation that owns this genome, and never changes!
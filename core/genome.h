@@ -89,6 +89,8 @@ private:
 	
 	slim_usertag_t tag_value_;									// a user-defined tag value
 	
+	slim_treenodeid_t tree_node_id_ = -1;						// this genome's node in the recorded tree sequence, or -1; see TreeSequence
+
 #ifdef DEBUG
 	static bool s_log_copy_and_assign_;							// true if logging is disabled (see below)
 #endif
@@ -130,6 +132,11 @@ public:
 	
 	void MakeNull(void);	// transform into a null genome
 	
+	// The node representing this genome in the recorded tree sequence; this is the identity of the genome, not part of its genetic
+	// state, so copy_from_genome() does not copy it.  See TreeSequence for how nodes are assigned.
+	inline slim_treenodeid_t TreeNodeID(void) const { return tree_node_id_; }
+	inline void SetTreeNodeID(slim_treenodeid_t p_node_id) { tree_node_id_ = p_node_id; }
+	
 	// This should be called before starting to define a mutation run from scratch, as the crossover-mutation code does.  It will
 	// discard the current MutationRun and start over from scratch with a unique, new MutationRun which is returned by the call.
 	inline MutationRun *WillCreateRun(int p_run_index)
@@ -147,6 +154,40 @@ public:
 		return new_run;
 	}
 	
+	// Copy the run at a given index from another genome, sharing it; the run is retained as usual
+	inline void copy_run(int p_run_index, const Genome &p_source_genome)
+	{
+		mutruns_[p_run_index] = p_source_genome.mutruns_[p_run_index];
+	}
+	
+	// The _Unretained variants below are used by Population's parallel reproduction code.  They set run pointers without
+	// touching run refcounts, which are not thread-safe and which are heavily contended for shared parental runs.  The genome
+	// must be cleared to nullptr beforehand, and RetainMutationRuns() must be called afterwards, back on the main thread.
+	inline MutationRun *WillCreateRun_Unretained(int p_run_index, std::vector<MutationRun *> &p_free_list)
+	{
+		MutationRun *new_run = MutationRun::NewMutationRun(p_free_list);	// take from the calling thread's pool
+		
+		mutruns_[p_run_index].reset(new_run, false);
+		return new_run;
+	}
+	
+	inline void copy_run_Unretained(int p_run_index, const Genome &p_source_genome)
+	{
+		mutruns_[p_run_index].reset(p_source_genome.mutruns_[p_run_index].get(), false);
+	}
+	
+	inline void copy_from_genome_Unretained(const Genome &p_source_genome)
+	{
+		for (int run_index = 0; run_index < mutrun_count_; ++run_index)
+			mutruns_[run_index].reset(p_source_genome.mutruns_[run_index].get(), false);
+	}
+	
+	inline void RetainMutationRuns(void)
+	{
+		for (int run_index = 0; run_index < mutrun_count_; ++run_index)
+			Eidos_intrusive_ptr_add_ref(mutruns_[run_index].get());
+	}
+	
 	// This should be called before modifying the run at a given index.  It will replicate the run to produce a single-referenced copy
 	// if necessary, thus guaranteeting that the run can be modified legally.  If the run is already single-referenced, it is a no-op.
 	void WillModifyRun(int p_run_index);
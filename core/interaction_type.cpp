@@ -24,6 +24,7 @@
 #include "slim_eidos_block.h"
 #include "subpopulation.h"
 #include "slim_sim.h"
+#include "eidos_openmp.h"
 
 #include <utility>
 #include <algorithm>
@@ -48,8 +49,8 @@ std::ostream& operator<<(std::ostream& p_out, IFType p_if_type)
 #pragma mark InteractionType
 #pragma mark -
 
-InteractionType::InteractionType(slim_objectid_t p_interaction_type_id, std::string p_spatiality_string, bool p_reciprocal, double p_max_distance, IndividualSex p_receiver_sex, IndividualSex p_exerter_sex) :
-	interaction_type_id_(p_interaction_type_id), spatiality_string_(p_spatiality_string), reciprocal_(p_reciprocal), max_distance_(p_max_distance), max_distance_sq_(p_max_distance * p_max_distance), receiver_sex_(p_receiver_sex), exerter_sex_(p_exerter_sex), if_type_(IFType::kFixed), if_param1_(1.0), if_param2_(0.0),
+InteractionType::InteractionType(slim_objectid_t p_interaction_type_id, std::string p_spatiality_string, bool p_reciprocal, double p_max_distance, IndividualSex p_receiver_sex, IndividualSex p_exerter_sex, bool p_sparse) :
+	interaction_type_id_(p_interaction_type_id), spatiality_string_(p_spatiality_string), reciprocal_(p_reciprocal), max_distance_(p_max_distance), max_distance_sq_(p_max_distance * p_max_distance), receiver_sex_(p_receiver_sex), exerter_sex_(p_exerter_sex), sparse_(p_sparse), if_type_(IFType::kFixed), if_param1_(1.0), if_param2_(0.0),
 	self_symbol_(Eidos_GlobalStringIDForString(SLiMEidosScript::IDStringWithPrefix('i', p_interaction_type_id)),
 				 EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Object_singleton(this, gSLiM_InteractionType_Class)))
 {
@@ -129,6 +130,7 @@ void InteractionType::EvaluateSubpopulation(Subpopulation *p_subpop, bool p_imme
 		}
 		
 		subpop_data->kd_root_ = nullptr;
+		subpop_data->sparse_present_ = false;
 		
 		subpop_data->evaluation_interaction_callbacks_.clear();
 	}
@@ -136,6 +138,7 @@ void InteractionType::EvaluateSubpopulation(Subpopulation *p_subpop, bool p_imme
 	// At this point, positions_ is guaranteed to be nullptr; distances_ and strengths_ are either (1) nullptr,
 	// or (2) allocated, but containing garbage.  Now we mark ourselves evaluated and fill in the buffers as needed.
 	subpop_data->evaluated_ = true;
+	subpop_data->thread_count_ = sim.ThreadCount();
 	
 	// At a minimum, fetch positional data from the subpopulation; this is guaranteed to be present (for spatiality > 0)
 	if (spatiality_ > 0)
@@ -427,7 +430,22 @@ void InteractionType::EvaluateSubpopulation(Subpopulation *p_subpop, bool p_imme
 	subpop_data->evaluation_interaction_callbacks_ = sim.ScriptBlocksMatching(generation, SLiMEidosBlockType::SLiMEidosInteractionCallback, -1, interaction_type_id_, subpop_id);
 	
 	// If we're supposed to evaluate it immediately, do so
-	if (p_immediate)
+	if (p_immediate && sparse_)
+	{
+		// With sparse storage, we build the rows of interacting pairs and then calculate the strength of every pair
+		EnsureSparsePresent(p_subpop, *subpop_data);
+		
+		std::vector<SLiMEidosBlock*> &callbacks = subpop_data->evaluation_interaction_callbacks_;
+		
+		for (slim_popsize_t receiver_index = 0; receiver_index < subpop_size; ++receiver_index)
+		{
+			size_t row_end = subpop_data->sparse_offsets_[receiver_index + 1];
+			
+			for (size_t entry = subpop_data->sparse_offsets_[receiver_index]; entry < row_end; ++entry)
+				SparseStrength(p_subpop, *subpop_data, entry, subpop_individuals + receiver_index, callbacks);
+		}
+	}
+	else if (p_immediate)
 	{
 		// We do not set up the kd-tree here, because we don't know whether or not we'll use it, and we have all the
 		// information we need to set it up later (since it doesn't depend on interactions or even distances).
@@ -485,6 +503,7 @@ void InteractionType::Invalidate(void)
 		}
 		
 		data.kd_root_ = nullptr;
+		data.sparse_present_ = false;
 		
 		data.evaluation_interaction_callbacks_.clear();
 	}
@@ -753,7 +772,7 @@ void InteractionType::CalculateAllInteractions(Subpopulation *p_subpop)
 				double *mirror_exerting_distance = mirror_receiving_distance + exerting_index * subpop_size;
 				double *exerting_strength = receiving_strength + exerting_index;
 				double *mirror_exerting_strength = mirror_receiving_strength + exerting_index * subpop_size;
-				Individual *exerting_individual = subpop_individuals;
+				Individual *exerting_individual = subpop_individuals + exerting_index;
 				
 				if (is_sex_segregated)
 				{
@@ -975,7 +994,7 @@ void InteractionType::CalculateAllInteractions(Subpopulation *p_subpop)
 				double *mirror_exerting_distance = mirror_receiving_distance + exerting_index * subpop_size;
 				double *exerting_strength = receiving_strength + exerting_index;
 				double *mirror_exerting_strength = mirror_receiving_strength + exerting_index * subpop_size;
-				Individual *exerting_individual = subpop_individuals;
+				Individual *exerting_individual = subpop_individuals + exerting_index;
 				
 				if (is_sex_segregated)
 				{
@@ -1264,7 +1283,7 @@ double InteractionType::CalculateStrengthWithCallbacks(double p_distance, Indivi
 
 double InteractionType::ApplyInteractionCallbacks(Individual *p_receiver, Individual *p_exerter, Subpopulation *p_subpop, double p_strength, double p_distance, std::vector<SLiMEidosBlock*> &p_interaction_callbacks)
 {
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_START();
 #endif
@@ -1292,6 +1311,28 @@ double InteractionType::ApplyInteractionCallbacks(Individual *p_receiver, Indivi
 				// the cached value is owned by the tree, so we do not dispose of it
 				// there is also no script output to handle
 			}
+			else if (interaction_callback->has_cached_optimization_)
+			{
+				// The callback has been compiled to C++ code; see SLiMSim::OptimizeScriptBlock()
+				if (interaction_callback->has_cached_opt_native_)
+				{
+					SLiMCallbackArguments args;
+					
+					args.distance_ = p_distance;
+					args.strength_ = p_strength;
+					args.receiver_ = p_receiver;
+					args.exerter_ = p_exerter;
+					
+					p_strength = interaction_callback->cached_opt_native_(args);
+					
+					if (std::isnan(p_strength) || std::isinf(p_strength) || (p_strength < 0.0))
+						EIDOS_TERMINATION << "ERROR (InteractionType::ApplyInteractionCallbacks): interaction() callbacks must return a finite value >= 0.0." << EidosTerminate(interaction_callback->identifier_token_);
+				}
+				else
+				{
+					EIDOS_TERMINATION << "ERROR (InteractionType::ApplyInteractionCallbacks): (internal error) cached optimization flag mismatch" << EidosTerminate(interaction_callback->identifier_token_);
+				}
+			}
 			else
 			{
 				// local variables for the callback parameters that we might need to allocate here, and thus need to free below
@@ -1358,7 +1399,7 @@ double InteractionType::ApplyInteractionCallbacks(Individual *p_receiver, Indivi
 		}
 	}
 	
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_END(sim.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosInteractionCallback)]);
 #endif
@@ -1518,6 +1559,110 @@ void InteractionType::InitializeStrengths(InteractionsData &p_subpop_data)
 		values[ind_index * (subpop_size + 1)] = 0.0;
 }
 
+void InteractionType::EnsureSparsePresent(Subpopulation *p_subpop, InteractionsData &p_subpop_data)
+{
+	if (!p_subpop_data.evaluated_)
+		EIDOS_TERMINATION << "ERROR (InteractionType::EnsureSparsePresent): (internal error) the interaction has not been evaluated." << EidosTerminate();
+	
+	if (p_subpop_data.sparse_present_)
+		return;
+	
+	if ((spatiality_ == 0) || std::isinf(max_distance_))
+		EIDOS_TERMINATION << "ERROR (InteractionType::EnsureSparsePresent): (internal error) sparse storage requires a spatial interaction with a finite maximum distance." << EidosTerminate();
+	
+	// Find the neighbors of each individual with the k-d tree; each row is sorted by exerter index so that single pairs
+	// can be looked up with a binary search.  Interactions are symmetric in distance, so every pair appears in both rows.
+	EnsureKDTreePresent(p_subpop_data);
+	
+	slim_popsize_t subpop_size = p_subpop_data.individual_count_;
+	slim_popsize_t first_male_index = p_subpop_data.first_male_index_;
+	std::vector<Individual> &individuals = p_subpop->parent_individuals_;
+	double *position_data = p_subpop_data.positions_;
+	EidosValue_Object_vector neighbors(gSLiM_Individual_Class);
+	std::vector<slim_popsize_t> neighbor_indices;
+	
+	p_subpop_data.sparse_offsets_.resize(subpop_size + 1);
+	p_subpop_data.sparse_exerters_.clear();
+	p_subpop_data.sparse_distances_.clear();
+	p_subpop_data.sparse_strengths_.clear();
+	
+	for (slim_popsize_t receiver_index = 0; receiver_index < subpop_size; ++receiver_index)
+	{
+		double *receiver_position = position_data + receiver_index * SLIM_MAX_DIMENSIONALITY;
+		
+		p_subpop_data.sparse_offsets_[receiver_index] = p_subpop_data.sparse_exerters_.size();
+		
+		neighbors.resize_no_initialize(0);
+		FindNeighbors(p_subpop, p_subpop_data, receiver_position, subpop_size, neighbors, &individuals[receiver_index]);
+		
+		EidosObjectElement * const *neighbor_data = neighbors.data();
+		size_t neighbor_count = neighbors.size();
+		
+		neighbor_indices.resize(neighbor_count);
+		
+		for (size_t neighbor_index = 0; neighbor_index < neighbor_count; ++neighbor_index)
+			neighbor_indices[neighbor_index] = ((Individual *)neighbor_data[neighbor_index])->index_;
+		
+		std::sort(neighbor_indices.begin(), neighbor_indices.end());
+		
+		// Sex-segregation is handled as in InitializeStrengths(): pairs it excludes get a strength of 0.0, others NAN
+		bool receiver_excluded = (((receiver_sex_ == IndividualSex::kMale) && (receiver_index < first_male_index)) || ((receiver_sex_ == IndividualSex::kFemale) && (receiver_index >= first_male_index)));
+		
+		for (slim_popsize_t exerter_index : neighbor_indices)
+		{
+			bool exerter_excluded = (((exerter_sex_ == IndividualSex::kMale) && (exerter_index < first_male_index)) || ((exerter_sex_ == IndividualSex::kFemale) && (exerter_index >= first_male_index)));
+			
+			p_subpop_data.sparse_exerters_.emplace_back(exerter_index);
+			p_subpop_data.sparse_distances_.emplace_back(CalculateDistanceWithPeriodicity(receiver_position, position_data + exerter_index * SLIM_MAX_DIMENSIONALITY, p_subpop_data));
+			p_subpop_data.sparse_strengths_.emplace_back((receiver_excluded || exerter_excluded) ? 0.0 : NAN);
+		}
+	}
+	
+	p_subpop_data.sparse_offsets_[subpop_size] = p_subpop_data.sparse_exerters_.size();
+	p_subpop_data.sparse_present_ = true;
+}
+
+int64_t InteractionType::SparseEntryIndex(InteractionsData &p_subpop_data, slim_popsize_t p_receiver_index, slim_popsize_t p_exerter_index)
+{
+	// Returns the index of the pair in the sparse vectors, or -1 if the pair is not present (i.e., does not interact)
+	auto row_begin = p_subpop_data.sparse_exerters_.begin() + p_subpop_data.sparse_offsets_[p_receiver_index];
+	auto row_end = p_subpop_data.sparse_exerters_.begin() + p_subpop_data.sparse_offsets_[p_receiver_index + 1];
+	auto entry_iter = std::lower_bound(row_begin, row_end, p_exerter_index);
+	
+	if ((entry_iter == row_end) || (*entry_iter != p_exerter_index))
+		return -1;
+	
+	return (int64_t)(entry_iter - p_subpop_data.sparse_exerters_.begin());
+}
+
+double InteractionType::SparseStrength(Subpopulation *p_subpop, InteractionsData &p_subpop_data, size_t p_entry, Individual *p_receiver, std::vector<SLiMEidosBlock*> &p_interaction_callbacks)
+{
+	double strength = p_subpop_data.sparse_strengths_[p_entry];
+	
+	if (std::isnan(strength))
+	{
+		double distance = p_subpop_data.sparse_distances_[p_entry];
+		slim_popsize_t exerter_index = p_subpop_data.sparse_exerters_[p_entry];
+		
+		if (p_interaction_callbacks.size() == 0)
+			strength = CalculateStrengthNoCallbacks(distance);
+		else
+			strength = CalculateStrengthWithCallbacks(distance, p_receiver, &p_subpop->parent_individuals_[exerter_index], p_subpop, p_interaction_callbacks);
+		
+		p_subpop_data.sparse_strengths_[p_entry] = strength;
+		
+		if (reciprocal_)
+		{
+			int64_t mirror_entry = SparseEntryIndex(p_subpop_data, exerter_index, p_receiver->index_);
+			
+			if (mirror_entry >= 0)
+				p_subpop_data.sparse_strengths_[mirror_entry] = strength;
+		}
+	}
+	
+	return strength;
+}
+
 #pragma mark -
 #pragma mark k-d tree construction
 #pragma mark -
@@ -1729,6 +1874,104 @@ SLiM_kdNode *InteractionType::MakeKDTree3_p2(SLiM_kdNode *t, int len)
 	return n;
 }
 
+// make the subtree for a range of nodes at a given phase, for the current spatiality; used by MakeKDTreeParallel()
+SLiM_kdNode *InteractionType::MakeKDTree_phase(SLiM_kdNode *t, int len, int p_phase)
+{
+	switch (spatiality_)
+	{
+		case 1: return MakeKDTree1_p0(t, len);
+		case 2: return ((p_phase == 0) ? MakeKDTree2_p0(t, len) : MakeKDTree2_p1(t, len));
+		case 3: return ((p_phase == 0) ? MakeKDTree3_p0(t, len) : ((p_phase == 1) ? MakeKDTree3_p1(t, len) : MakeKDTree3_p2(t, len)));
+	}
+	return nullptr;
+}
+
+// make k-d tree for a large node count using multiple threads; the top levels of the tree are built one level at a time, with the medians
+// of all of the ranges at a level found in parallel, until there are enough ranges to keep every thread busy, and then the remaining subtrees
+// are built in parallel.  Each range is partitioned exactly as the recursive construction would partition it, and ranges are disjoint, so
+// the resulting tree is identical to the one made by MakeKDTree1_p0() etc., regardless of the thread count.
+SLiM_kdNode *InteractionType::MakeKDTreeParallel(SLiM_kdNode *t, int len, int p_thread_count)
+{
+	struct kdRange {
+		SLiM_kdNode *start_;
+		int len_;
+		SLiM_kdNode **link_;		// where the root of the subtree for this range should be stored
+	};
+	
+	SLiM_kdNode *root = nullptr;
+	std::vector<kdRange> ranges(1, kdRange{t, len, &root});
+	std::vector<kdRange> next_ranges;
+	int phase = 0;
+	
+	while ((ranges.size() > 0) && (ranges.size() < (size_t)p_thread_count * 4))
+	{
+		int64_t range_count = (int64_t)ranges.size();
+		kdRange *ranges_ptr = ranges.data();
+		
+		next_ranges.resize(range_count * 2);
+		kdRange *next_ranges_ptr = next_ranges.data();
+
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+		for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+		{
+			int64_t range_start = (range_count * thread_index) / p_thread_count;
+			int64_t range_end = (range_count * (thread_index + 1)) / p_thread_count;
+			
+			for (int64_t range_index = range_start; range_index < range_end; ++range_index)
+			{
+				kdRange &range = ranges_ptr[range_index];
+				SLiM_kdNode *range_t = range.start_;
+				SLiM_kdNode *n;
+				
+				if (range.len_ == 1)
+					n = range_t;
+				else if (phase == 0)
+					n = FindMedian_p0(range_t, range_t + range.len_);
+				else if (phase == 1)
+					n = FindMedian_p1(range_t, range_t + range.len_);
+				else
+					n = FindMedian_p2(range_t, range_t + range.len_);
+				
+				*range.link_ = n;
+				n->left = nullptr;
+				n->right = nullptr;
+				
+				next_ranges_ptr[range_index * 2] = kdRange{range_t, (int)(n - range_t), &n->left};
+				next_ranges_ptr[range_index * 2 + 1] = kdRange{n + 1, (int)(range_t + range.len_ - (n + 1)), &n->right};
+			}
+		}
+		
+		// keep the non-empty ranges for the next level, in order
+		ranges.clear();
+		
+		for (kdRange &next_range : next_ranges)
+			if (next_range.len_)
+				ranges.emplace_back(next_range);
+		
+		phase = (phase + 1) % spatiality_;
+	}
+	
+	// build the subtrees below the last level in parallel
+	int64_t range_count = (int64_t)ranges.size();
+	kdRange *ranges_ptr = ranges.data();
+
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+	{
+		int64_t range_start = (range_count * thread_index) / p_thread_count;
+		int64_t range_end = (range_count * (thread_index + 1)) / p_thread_count;
+		
+		for (int64_t range_index = range_start; range_index < range_end; ++range_index)
+		{
+			kdRange &range = ranges_ptr[range_index];
+			
+			*range.link_ = MakeKDTree_phase(range.start_, range.len_, phase);
+		}
+	}
+	
+	return root;
+}
+
 void InteractionType::EnsureKDTreePresent(InteractionsData &p_subpop_data)
 {
 	if (!p_subpop_data.evaluated_)
@@ -1891,12 +2134,19 @@ void InteractionType::EnsureKDTreePresent(InteractionsData &p_subpop_data)
 		}
 		else
 		{
-			// Now call out to recursively construct the tree
-			switch (spatiality_)
+			// Now call out to recursively construct the tree; large trees are built in parallel when multithreading is enabled
+			if ((p_subpop_data.thread_count_ > 1) && (p_subpop_data.kd_node_count_ >= SLIM_KDTREE_PARALLEL_MIN_NODES))
 			{
-				case 1: p_subpop_data.kd_root_ = MakeKDTree1_p0(p_subpop_data.kd_nodes_, p_subpop_data.kd_node_count_);	break;
-				case 2: p_subpop_data.kd_root_ = MakeKDTree2_p0(p_subpop_data.kd_nodes_, p_subpop_data.kd_node_count_);	break;
-				case 3: p_subpop_data.kd_root_ = MakeKDTree3_p0(p_subpop_data.kd_nodes_, p_subpop_data.kd_node_count_);	break;
+				p_subpop_data.kd_root_ = MakeKDTreeParallel(p_subpop_data.kd_nodes_, p_subpop_data.kd_node_count_, p_subpop_data.thread_count_);
+			}
+			else
+			{
+				switch (spatiality_)
+				{
+					case 1: p_subpop_data.kd_root_ = MakeKDTree1_p0(p_subpop_data.kd_nodes_, p_subpop_data.kd_node_count_);	break;
+					case 2: p_subpop_data.kd_root_ = MakeKDTree2_p0(p_subpop_data.kd_nodes_, p_subpop_data.kd_node_count_);	break;
+					case 3: p_subpop_data.kd_root_ = MakeKDTree3_p0(p_subpop_data.kd_nodes_, p_subpop_data.kd_node_count_);	break;
+				}
 			}
 			
 			// Check the tree for correctness; for now I will leave this enabled in the DEBUG case,
@@ -3611,6 +3861,102 @@ double InteractionType::TotalNeighborStrength(Subpopulation *p_subpop, Interacti
 }
 
 
+// Calculate the total interaction strength felt by each of a set of receivers, using multiple threads.  This may only be called when there
+// are no interaction() callbacks, and the receivers must be distinct; each thread then writes only to the strength rows of its own receivers,
+// so the mirroring done by the reciprocal code paths is skipped.  Each total is summed in the same order as in TotalNeighborStrength(), so
+// the results are identical to those of the single-threaded code path, with one exception: with periodic boundaries, a distance measured
+// to a periodic replicate can differ in the last bit depending upon which individual of the pair it is measured from, so a mirrored value
+// may differ by rounding error from the value calculated here.  That is already the case in TotalNeighborStrength(), which depends upon the
+// order in which receivers are queried; the results here depend only upon the set of receivers.
+void InteractionType::TotalNeighborStrengthsParallel(InteractionsData &p_subpop_data, const slim_popsize_t *p_receivers, int64_t p_receiver_count, double *p_totals, int p_thread_count)
+{
+	if (p_subpop_data.evaluation_interaction_callbacks_.size() != 0)
+		EIDOS_TERMINATION << "ERROR (InteractionType::TotalNeighborStrengthsParallel): (internal error) totals cannot be calculated in parallel when interaction() callbacks are present." << EidosTerminate();
+	
+	int subpop_size = (int)p_subpop_data.individual_count_;
+	bool periodicity_enabled = (periodic_x_ || periodic_y_ || periodic_z_);
+	
+	if (sparse_)
+	{
+		// With sparse storage each total is just the sum over the receiver's row; strengths are calculated as needed, but not mirrored
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+		for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+		{
+			int64_t receiver_start = (p_receiver_count * thread_index) / p_thread_count;
+			int64_t receiver_end = (p_receiver_count * (thread_index + 1)) / p_thread_count;
+			
+			for (int64_t receiver_index = receiver_start; receiver_index < receiver_end; ++receiver_index)
+			{
+				slim_popsize_t focal_index = p_receivers[receiver_index];
+				size_t row_end = p_subpop_data.sparse_offsets_[focal_index + 1];
+				double total = 0.0;
+				
+				for (size_t entry = p_subpop_data.sparse_offsets_[focal_index]; entry < row_end; ++entry)
+				{
+					double strength = p_subpop_data.sparse_strengths_[entry];
+					
+					if (std::isnan(strength))
+					{
+						strength = CalculateStrengthNoCallbacks(p_subpop_data.sparse_distances_[entry]);
+						p_subpop_data.sparse_strengths_[entry] = strength;
+					}
+					
+					total += strength;
+				}
+				
+				p_totals[receiver_index] = total;
+			}
+		}
+		
+		return;
+	}
+	
+	if (!p_subpop_data.kd_root_)
+		EIDOS_TERMINATION << "ERROR (InteractionType::TotalNeighborStrengthsParallel): (internal error) the k-d tree is rootless." << EidosTerminate();
+
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+	{
+		int64_t receiver_start = (p_receiver_count * thread_index) / p_thread_count;
+		int64_t receiver_end = (p_receiver_count * (thread_index + 1)) / p_thread_count;
+		std::vector<uint8_t> visited_buf(periodicity_enabled ? subpop_size : 0);	// each thread needs its own visited flags; see TotalNeighborStrength()
+		
+		for (int64_t receiver_index = receiver_start; receiver_index < receiver_end; ++receiver_index)
+		{
+			slim_popsize_t focal_index = p_receivers[receiver_index];
+			double *point = p_subpop_data.positions_ + focal_index * SLIM_MAX_DIMENSIONALITY;
+			double *focal_strengths = p_subpop_data.strengths_ + focal_index * subpop_size;
+			double *focal_distances = p_subpop_data.distances_ + focal_index * subpop_size;
+			double total = 0.0;
+			
+			if (!periodicity_enabled)
+			{
+				switch (spatiality_)
+				{
+					case 1: total = TotalNeighborStrengthA_1(p_subpop_data.kd_root_, point, focal_strengths); break;
+					case 2: total = TotalNeighborStrengthA_2(p_subpop_data.kd_root_, point, focal_strengths, focal_distances, 0); break;
+					case 3: total = TotalNeighborStrengthA_3(p_subpop_data.kd_root_, point, focal_strengths, focal_distances, 0); break;
+				}
+			}
+			else
+			{
+				uint8_t *visited = visited_buf.data();
+				
+				EIDOS_BZERO(visited, subpop_size * sizeof(uint8_t));
+				
+				switch (spatiality_)
+				{
+					case 1: total = TotalNeighborStrengthA_1_PERIODIC(p_subpop_data.kd_root_, point, visited, focal_strengths); break;
+					case 2: total = TotalNeighborStrengthA_2_PERIODIC(p_subpop_data.kd_root_, point, visited, focal_strengths, focal_distances, 0); break;
+					case 3: total = TotalNeighborStrengthA_3_PERIODIC(p_subpop_data.kd_root_, point, visited, focal_strengths, focal_distances, 0); break;
+				}
+			}
+			
+			p_totals[receiver_index] = total;
+		}
+	}
+}
+
 #pragma mark -
 #pragma mark k-d tree neighbor strength fetching
 #pragma mark -
@@ -4377,6 +4723,10 @@ EidosValue_SP InteractionType::GetProperty(EidosGlobalStringID p_property_id)
 		{
 			return EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_String_singleton(spatiality_string_));
 		}
+		case gID_sparse:
+		{
+			return (sparse_ ? gStaticEidosValue_LogicalT : gStaticEidosValue_LogicalF);
+		}
 			
 			// variables
 		case gID_maxDistance:
@@ -4418,6 +4768,8 @@ void InteractionType::SetProperty(EidosGlobalStringID p_property_id, const Eidos
 				EIDOS_TERMINATION << "ERROR (InteractionType::SetProperty): the maximum interaction distance must be greater than or equal to zero." << EidosTerminate();
 			if ((if_type_ == IFType::kLinear) && (std::isinf(max_distance_) || (max_distance_ <= 0.0)))
 				EIDOS_TERMINATION << "ERROR (InteractionType::SetProperty): the maximum interaction distance must be finite and greater than zero when interaction type 'l' has been chosen." << EidosTerminate();
+			if (sparse_ && std::isinf(max_distance_))
+				EIDOS_TERMINATION << "ERROR (InteractionType::SetProperty): the maximum interaction distance must be finite for an interaction type that uses sparse storage." << EidosTerminate();
 			
 			return;
 		}
@@ -4491,6 +4843,39 @@ EidosValue_SP InteractionType::ExecuteMethod_distance(EidosGlobalStringID p_meth
 	
 	InteractionsData &subpop_data = subpop_data_iter->second;
 	
+	if (sparse_)
+	{
+		// Sparse storage keeps distances only for interacting pairs, so we just calculate distances here without caching them
+		double *position_data = subpop_data.positions_;
+		double *ind1_position = position_data + ind1_index * SLIM_MAX_DIMENSIONALITY;
+		
+		if (individuals2->Type() == EidosValueType::kValueNULL)
+		{
+			EidosValue_Float_vector *result_vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Float_vector())->resize_no_initialize(subpop1_size);
+			
+			for (int ind2_index = 0; ind2_index < subpop1_size; ++ind2_index)
+				result_vec->set_float_no_check(CalculateDistanceWithPeriodicity(ind1_position, position_data + ind2_index * SLIM_MAX_DIMENSIONALITY, subpop_data), ind2_index);
+			
+			return EidosValue_SP(result_vec);
+		}
+		else
+		{
+			EidosValue_Float_vector *result_vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Float_vector())->resize_no_initialize(count2);
+			
+			for (int ind2_index = 0; ind2_index < count2; ++ind2_index)
+			{
+				Individual *ind2 = (Individual *)individuals2->ObjectElementAtIndex(ind2_index, nullptr);
+				
+				if (subpop1 != &(ind2->subpopulation_))
+					EIDOS_TERMINATION << "ERROR (InteractionType::ExecuteMethod_distance): distance() requires that all individuals be in the same subpopulation." << EidosTerminate();
+				
+				result_vec->set_float_no_check(CalculateDistanceWithPeriodicity(ind1_position, position_data + ind2->index_ * SLIM_MAX_DIMENSIONALITY, subpop_data), ind2_index);
+			}
+			
+			return EidosValue_SP(result_vec);
+		}
+	}
+	
 	EnsureDistancesPresent(subpop_data);
 	
 	double *ind1_distances = subpop_data.distances_ + ind1_index * subpop1_size;
@@ -4741,7 +5126,20 @@ EidosValue_SP InteractionType::ExecuteMethod_drawByStrength(EidosGlobalStringID
 	bool no_callbacks = (callbacks.size() == 0);
 	EidosValue_Object_vector neighbors(gSLiM_Individual_Class);
 	
-	if (spatiality_ == 0)
+	if (sparse_)
+	{
+		// With sparse storage, the interacting neighbors are already known; they are the exerters in this individual's row
+		EnsureSparsePresent(subpop, subpop_data);
+		
+		std::vector<Individual> &parents = subpop->parent_individuals_;
+		size_t row_begin = subpop_data.sparse_offsets_[ind_index], row_end = subpop_data.sparse_offsets_[ind_index + 1];
+		
+		neighbors.resize_no_initialize(row_end - row_begin);
+		
+		for (size_t entry = row_begin; entry < row_end; ++entry)
+			neighbors.set_object_element_no_check(&parents[subpop_data.sparse_exerters_[entry]], entry - row_begin);
+	}
+	else if (spatiality_ == 0)
 	{
 		EnsureStrengthsPresent(subpop_data);
 		
@@ -4774,7 +5172,19 @@ EidosValue_SP InteractionType::ExecuteMethod_drawByStrength(EidosGlobalStringID
 	
 	cached_strength.reserve((int)count);
 	
-	if (spatiality_ == 0)
+	if (sparse_)
+	{
+		size_t row_begin = subpop_data.sparse_offsets_[ind_index];
+		
+		for (int neighbor_index = 0; neighbor_index < neighbor_count; ++neighbor_index)
+		{
+			double strength = SparseStrength(subpop, subpop_data, row_begin + neighbor_index, individual, callbacks);
+			
+			total_interaction_strength += strength;
+			cached_strength.emplace_back(strength);
+		}
+	}
+	else if (spatiality_ == 0)
 	{
 		double *ind1_strengths = subpop_data.strengths_ + ind_index * subpop_size;
 		double *mirror_ind1_strengths = subpop_data.strengths_ + ind_index;			// used when reciprocality is enabled
@@ -5156,6 +5566,49 @@ EidosValue_SP InteractionType::ExecuteMethod_strength(EidosGlobalStringID p_meth
 	std::vector<SLiMEidosBlock*> &callbacks = subpop_data.evaluation_interaction_callbacks_;
 	bool no_callbacks = (callbacks.size() == 0);
 	
+	if (sparse_)
+	{
+		//
+		// Sparse storage; pairs that are not present in the receiver's row do not interact
+		//
+		
+		EnsureSparsePresent(subpop1, subpop_data);
+		
+		if (individuals2->Type() == EidosValueType::kValueNULL)
+		{
+			// NULL means return strengths from individuals1 (which must be singleton) to all individuals in the subpopulation
+			EidosValue_Float_vector *result_vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Float_vector())->resize_no_initialize(subpop1_size);
+			double *result_data = result_vec->data();
+			size_t row_end = subpop_data.sparse_offsets_[ind1_index + 1];
+			
+			EIDOS_BZERO(result_data, subpop1_size * sizeof(double));
+			
+			for (size_t entry = subpop_data.sparse_offsets_[ind1_index]; entry < row_end; ++entry)
+				result_data[subpop_data.sparse_exerters_[entry]] = SparseStrength(subpop1, subpop_data, entry, ind1, callbacks);
+			
+			return EidosValue_SP(result_vec);
+		}
+		else
+		{
+			// Otherwise, individuals1 is singleton, and individuals2 is any length, so we loop over individuals2
+			EidosValue_Float_vector *result_vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Float_vector())->resize_no_initialize(count2);
+			
+			for (int ind2_index = 0; ind2_index < count2; ++ind2_index)
+			{
+				Individual *ind2 = (Individual *)individuals2->ObjectElementAtIndex(ind2_index, nullptr);
+				
+				if (subpop1 != &(ind2->subpopulation_))
+					EIDOS_TERMINATION << "ERROR (InteractionType::ExecuteMethod_strength): strength() requires that all individuals be in the same subpopulation." << EidosTerminate();
+				
+				int64_t entry = SparseEntryIndex(subpop_data, ind1_index, ind2->index_);
+				
+				result_vec->set_float_no_check((entry >= 0) ? SparseStrength(subpop1, subpop_data, entry, ind1, callbacks) : 0.0, ind2_index);
+			}
+			
+			return EidosValue_SP(result_vec);
+		}
+	}
+	
 	EnsureStrengthsPresent(subpop_data);
 	
 	if (spatiality_)
@@ -5449,6 +5902,80 @@ EidosValue_SP InteractionType::ExecuteMethod_totalOfNeighborStrengths(EidosGloba
 	
 	InteractionsData &subpop_data = subpop_data_iter->second;
 	
+	// With no interaction() callbacks, the totals for a large vector of distinct receivers can be calculated in parallel; if the
+	// same individual is requested more than once we fall back to the code below, since its strength row would be shared
+	int thread_count = subpop_data.thread_count_;
+	
+	if ((thread_count > 1) && (count >= SLIM_INTERACTION_PARALLEL_MIN_RECEIVERS) && (subpop_data.evaluation_interaction_callbacks_.size() == 0))
+	{
+		std::vector<slim_popsize_t> receivers(count);
+		std::vector<uint8_t> receiver_seen(subpop_data.individual_count_, 0);
+		bool receivers_distinct = true;
+		
+		for (int ind_index = 0; ind_index < count; ++ind_index)
+		{
+			Individual *individual = (Individual *)individuals->ObjectElementAtIndex(ind_index, nullptr);
+			
+			if (subpop != &(individual->subpopulation_))
+				EIDOS_TERMINATION << "ERROR (InteractionType::ExecuteMethod_totalOfNeighborStrengths): totalOfNeighborStrengths() requires that all individuals be in the same subpopulation." << EidosTerminate();
+			
+			slim_popsize_t ind_index_in_subpop = individual->index_;
+			
+			if (receiver_seen[ind_index_in_subpop])
+				receivers_distinct = false;
+			
+			receiver_seen[ind_index_in_subpop] = 1;
+			receivers[ind_index] = ind_index_in_subpop;
+		}
+		
+		if (receivers_distinct)
+		{
+			if (sparse_)
+			{
+				EnsureSparsePresent(subpop, subpop_data);
+			}
+			else
+			{
+				EnsureStrengthsPresent(subpop_data);
+				EnsureKDTreePresent(subpop_data);
+			}
+			
+			EidosValue_Float_vector *result_vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Float_vector())->resize_no_initialize(count);
+			
+			TotalNeighborStrengthsParallel(subpop_data, receivers.data(), count, result_vec->data(), thread_count);
+			
+			return EidosValue_SP(result_vec);
+		}
+	}
+	
+	if (sparse_)
+	{
+		// With sparse storage, the total is just the sum over the individual's row; no k-d tree traversal is needed
+		EnsureSparsePresent(subpop, subpop_data);
+		
+		std::vector<SLiMEidosBlock*> &callbacks = subpop_data.evaluation_interaction_callbacks_;
+		EidosValue_Float_vector *result_vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Float_vector())->resize_no_initialize(count);
+		
+		for (int ind_index = 0; ind_index < count; ++ind_index)
+		{
+			Individual *individual = (Individual *)individuals->ObjectElementAtIndex(ind_index, nullptr);
+			
+			if (subpop != &(individual->subpopulation_))
+				EIDOS_TERMINATION << "ERROR (InteractionType::ExecuteMethod_totalOfNeighborStrengths): totalOfNeighborStrengths() requires that all individuals be in the same subpopulation." << EidosTerminate();
+			
+			slim_popsize_t ind_index_in_subpop = individual->index_;
+			size_t row_end = subpop_data.sparse_offsets_[ind_index_in_subpop + 1];
+			double total_strength = 0.0;
+			
+			for (size_t entry = subpop_data.sparse_offsets_[ind_index_in_subpop]; entry < row_end; ++entry)
+				total_strength += SparseStrength(subpop, subpop_data, entry, individual, callbacks);
+			
+			result_vec->set_float_no_check(total_strength, ind_index);
+		}
+		
+		return EidosValue_SP(result_vec);
+	}
+	
 	EnsureStrengthsPresent(subpop_data);
 	EnsureKDTreePresent(subpop_data);
 	
@@ -5535,6 +6062,7 @@ const std::vector<const EidosPropertySignature *> *InteractionType_Class::Proper
 		properties->emplace_back(SignatureForPropertyOrRaise(gID_reciprocal));
 		properties->emplace_back(SignatureForPropertyOrRaise(gID_sexSegregation));
 		properties->emplace_back(SignatureForPropertyOrRaise(gID_spatiality));
+		properties->emplace_back(SignatureForPropertyOrRaise(gID_sparse));
 		properties->emplace_back(SignatureForPropertyOrRaise(gID_maxDistance));
 		properties->emplace_back(SignatureForPropertyOrRaise(gID_tag));
 		std::sort(properties->begin(), properties->end(), CompareEidosPropertySignatures);
@@ -5550,6 +6078,7 @@ const EidosPropertySignature *InteractionType_Class::SignatureForProperty(EidosG
 	static EidosPropertySignature *reciprocalSig = nullptr;
 	static EidosPropertySignature *sexSegregationSig = nullptr;
 	static EidosPropertySignature *spatialitySig = nullptr;
+	static EidosPropertySignature *sparseSig = nullptr;
 	static EidosPropertySignature *maxDistanceSig = nullptr;
 	static EidosPropertySignature *tagSig = nullptr;
 	
@@ -5559,6 +6088,7 @@ const EidosPropertySignature *InteractionType_Class::SignatureForProperty(EidosG
 		reciprocalSig =		(EidosPropertySignature *)(new EidosPropertySignature(gStr_reciprocal,		gID_reciprocal,		true,	kEidosValueMaskLogical | kEidosValueMaskSingleton));
 		sexSegregationSig =	(EidosPropertySignature *)(new EidosPropertySignature(gStr_sexSegregation,	gID_sexSegregation,	true,	kEidosValueMaskString | kEidosValueMaskSingleton));
 		spatialitySig =		(EidosPropertySignature *)(new EidosPropertySignature(gStr_spatiality,		gID_spatiality,		true,	kEidosValueMaskString | kEidosValueMaskSingleton));
+		sparseSig =			(EidosPropertySignature *)(new EidosPropertySignature(gStr_sparse,			gID_sparse,			true,	kEidosValueMaskLogical | kEidosValueMaskSingleton));
 		maxDistanceSig =	(EidosPropertySignature *)(new EidosPropertySignature(gStr_maxDistance,		gID_maxDistance,	false,	kEidosValueMaskFloat | kEidosValueMaskSingleton));
 		tagSig =			(EidosPropertySignature *)(new EidosPropertySignature(gStr_tag,				gID_tag,			false,	kEidosValueMaskInt | kEidosValueMaskSingleton))->DeclareAcceleratedGet();
 	}
@@ -5570,6 +6100,7 @@ const EidosPropertySignature *InteractionType_Class::SignatureForProperty(EidosG
 		case gID_reciprocal:		return reciprocalSig;
 		case gID_sexSegregation:	return sexSegregationSig;
 		case gID_spatiality:		return spatialitySig;
+		case gID_sparse:			return sparseSig;
 		case gID_maxDistance:		return maxDistanceSig;
 		case gID_tag:				return tagSig;
 			
@@ -5667,12 +6198,18 @@ _InteractionsData::_InteractionsData(_InteractionsData&& p_source)
 	evaluation_interaction_callbacks_.swap(p_source.evaluation_interaction_callbacks_);
 	individual_count_ = p_source.individual_count_;
 	first_male_index_ = p_source.first_male_index_;
+	thread_count_ = p_source.thread_count_;
 	kd_node_count_ = p_source.kd_node_count_;
 	positions_ = p_source.positions_;
 	distances_ = p_source.distances_;
 	strengths_ = p_source.strengths_;
 	kd_nodes_ = p_source.kd_nodes_;
 	kd_root_ = p_source.kd_root_;
+	sparse_present_ = p_source.sparse_present_;
+	sparse_offsets_.swap(p_source.sparse_offsets_);
+	sparse_exerters_.swap(p_source.sparse_exerters_);
+	sparse_distances_.swap(p_source.sparse_distances_);
+	sparse_strengths_.swap(p_source.sparse_strengths_);
 	
 	p_source.evaluated_ = false;
 	p_source.evaluation_interaction_callbacks_.clear();
@@ -5684,6 +6221,7 @@ _InteractionsData::_InteractionsData(_InteractionsData&& p_source)
 	p_source.strengths_ = nullptr;
 	p_source.kd_nodes_ = nullptr;
 	p_source.kd_root_ = nullptr;
+	p_source.sparse_present_ = false;
 }
 
 _InteractionsData& _InteractionsData::operator=(_InteractionsData&& p_source)
@@ -5703,12 +6241,18 @@ _InteractionsData& _InteractionsData::operator=(_InteractionsData&& p_source)
 		evaluation_interaction_callbacks_.swap(p_source.evaluation_interaction_callbacks_);
 		individual_count_ = p_source.individual_count_;
 		first_male_index_ = p_source.first_male_index_;
+		thread_count_ = p_source.thread_count_;
 		kd_node_count_ = p_source.kd_node_count_;
 		positions_ = p_source.positions_;
 		distances_ = p_source.distances_;
 		strengths_ = p_source.strengths_;
 		kd_nodes_ = p_source.kd_nodes_;
 		kd_root_ = p_source.kd_root_;
+		sparse_present_ = p_source.sparse_present_;
+		sparse_offsets_.swap(p_source.sparse_offsets_);
+		sparse_exerters_.swap(p_source.sparse_exerters_);
+		sparse_distances_.swap(p_source.sparse_distances_);
+		sparse_strengths_.swap(p_source.sparse_strengths_);
 		
 		p_source.evaluated_ = false;
 		p_source.evaluation_interaction_callbacks_.clear();
@@ -5720,6 +6264,7 @@ _InteractionsData& _InteractionsData::operator=(_InteractionsData&& p_source)
 		p_source.strengths_ = nullptr;
 		p_source.kd_nodes_ = nullptr;
 		p_source.kd_root_ = nullptr;
+		p_source.sparse_present_ = false;
 	}
 	
 	return *this;
@@ -66,6 +66,11 @@ std::ostream& operator<<(std::ostream& p_out, IFType p_if_type);
 // subpopulation; if a subpopulation is not evaluated there is no overhead.
 #define SLIM_MAX_DIMENSIONALITY		3
 
+// With multithreading, k-d trees with at least this many nodes are built in parallel, and totalOfNeighborStrengths() works in
+// parallel for at least this many receivers; below these sizes the overhead of starting threads outweighs the gain
+#define SLIM_KDTREE_PARALLEL_MIN_NODES				10000
+#define SLIM_INTERACTION_PARALLEL_MIN_RECEIVERS		100
+
 struct _SLiM_kdNode
 {
 	double x[SLIM_MAX_DIMENSIONALITY];		// the coordinates of the individual
@@ -93,6 +98,7 @@ struct _InteractionsData
 	slim_popsize_t individual_count_ = 0;	// the number of individuals managed; this will be equal to the size of the corresponding subpopulation
 	slim_popsize_t first_male_index_ = 0;	// from the subpopulation's value; needed for sex-segregation handling
 	slim_popsize_t kd_node_count_ = 0;		// the number of entries in the k-d tree; may be a multiple of individual_count_ due to periodicity
+	int thread_count_ = 1;					// the number of threads to use for work on this block; from SLiMSim::ThreadCount() at evaluation
 	
 	double bounds_x1_, bounds_y1_, bounds_z1_;	// copied from the Subpopulation; the zero-bound in each dimension is guaranteed to be zero *if* the dimension is periodic
 	
@@ -102,6 +108,17 @@ struct _InteractionsData
 	SLiM_kdNode *kd_nodes_ = nullptr;		// individual_count_ entries, holding the nodes of the k-d tree
 	SLiM_kdNode *kd_root_ = nullptr;		// the root of the k-d tree
 	
+	// Sparse storage, used in place of distances_ and strengths_ by interaction types created with sparse=T.  Only pairs within
+	// the maximum interaction distance are kept, in compressed rows: the exerters for receiver i are at indices sparse_offsets_[i]
+	// through sparse_offsets_[i+1]-1 of the other vectors, sorted by exerter index.  Distances are calculated when the rows are
+	// built; strengths are NAN until calculated, as in strengths_.  Memory use scales with the number of interacting pairs.
+	// Like the blocks above, these vectors are kept across evaluations to avoid reallocation; sparse_present_ says they are valid.
+	bool sparse_present_ = false;
+	std::vector<size_t> sparse_offsets_;			// individual_count_ + 1 entries, the start of each receiver's row
+	std::vector<slim_popsize_t> sparse_exerters_;	// the index of the exerter for each pair
+	std::vector<double> sparse_distances_;			// the distance for each pair
+	std::vector<double> sparse_strengths_;			// the interaction strength for each pair
+	
 	_InteractionsData(const _InteractionsData&) = delete;					// no copying
 	_InteractionsData& operator=(const _InteractionsData&) = delete;		// no copying
 	_InteractionsData(_InteractionsData&&);									// move constructor, for std::map compatibility
@@ -127,6 +144,7 @@ class InteractionType : public SLiMEidosDictionary
 	double max_distance_sq_;					// the maximum distance squared, cached for speed
 	IndividualSex receiver_sex_;				// the sex of the individuals that feel the interaction
 	IndividualSex exerter_sex_;					// the sex of the individuals that exert the interaction
+	bool sparse_;								// if true, keep only pairs within max_distance_, in InteractionsData's sparse storage
 	
 	slim_usertag_t tag_value_;					// a user-defined tag value
 	
@@ -148,6 +166,9 @@ class InteractionType : public SLiMEidosDictionary
 	void InitializeDistances(InteractionsData &p_subpop_data);
 	void EnsureStrengthsPresent(InteractionsData &p_subpop_data);
 	void InitializeStrengths(InteractionsData &p_subpop_data);
+	void EnsureSparsePresent(Subpopulation *p_subpop, InteractionsData &p_subpop_data);
+	int64_t SparseEntryIndex(InteractionsData &p_subpop_data, slim_popsize_t p_receiver_index, slim_popsize_t p_exerter_index);
+	double SparseStrength(Subpopulation *p_subpop, InteractionsData &p_subpop_data, size_t p_entry, Individual *p_receiver, std::vector<SLiMEidosBlock*> &p_interaction_callbacks);
 	
 	SLiM_kdNode *FindMedian_p0(SLiM_kdNode *start, SLiM_kdNode *end);
 	SLiM_kdNode *FindMedian_p1(SLiM_kdNode *start, SLiM_kdNode *end);
@@ -158,6 +179,8 @@ class InteractionType : public SLiMEidosDictionary
 	SLiM_kdNode *MakeKDTree3_p0(SLiM_kdNode *t, int len);
 	SLiM_kdNode *MakeKDTree3_p1(SLiM_kdNode *t, int len);
 	SLiM_kdNode *MakeKDTree3_p2(SLiM_kdNode *t, int len);
+	SLiM_kdNode *MakeKDTree_phase(SLiM_kdNode *t, int len, int p_phase);
+	SLiM_kdNode *MakeKDTreeParallel(SLiM_kdNode *t, int len, int p_thread_count);
 	void EnsureKDTreePresent(InteractionsData &p_subpop_data);
 	
 	int CheckKDTree1_p0(SLiM_kdNode *t);
@@ -197,6 +220,7 @@ class InteractionType : public SLiMEidosDictionary
 	double TotalNeighborStrengthA_2_reciprocal_PERIODIC(SLiM_kdNode *root, double *nd, uint8_t *p_visited_buf, double *p_focal_strengths, double *p_mirror_strengths, double *p_focal_distances, double *p_mirror_distances, int subpop_size, int p_phase);
 	double TotalNeighborStrengthA_3_reciprocal_PERIODIC(SLiM_kdNode *root, double *nd, uint8_t *p_visited_buf, double *p_focal_strengths, double *p_mirror_strengths, double *p_focal_distances, double *p_mirror_distances, int subpop_size, int p_phase);
 	double TotalNeighborStrength(Subpopulation *p_subpop, InteractionsData &p_subpop_data, double *p_point, Individual *p_excluded_individual);
+	void TotalNeighborStrengthsParallel(InteractionsData &p_subpop_data, const slim_popsize_t *p_receivers, int64_t p_receiver_count, double *p_totals, int p_thread_count);
 	
 	void FillNeighborStrengthsA_1(SLiM_kdNode *root, double *nd, double *p_focal_strengths, double *p_result_vec);
 	void FillNeighborStrengthsA_2(SLiM_kdNode *root, double *nd, double *p_focal_strengths, double *p_focal_distances, double *p_result_vec, int p_phase);
@@ -219,7 +243,7 @@ public:
 	InteractionType(const InteractionType&) = delete;					// no copying
 	InteractionType& operator=(const InteractionType&) = delete;		// no copying
 	InteractionType(void) = delete;										// no null construction
-	InteractionType(slim_objectid_t p_interaction_type_id, std::string p_spatiality_string, bool p_reciprocal, double p_max_distance, IndividualSex p_receiver_sex, IndividualSex p_exerter_sex);
+	InteractionType(slim_objectid_t p_interaction_type_id, std::string p_spatiality_string, bool p_reciprocal, double p_max_distance, IndividualSex p_receiver_sex, IndividualSex p_exerter_sex, bool p_sparse);
 	~InteractionType(void);
 	
 	void EvaluateSubpopulation(Subpopulation *p_subpop, bool p_immediate);
@@ -25,6 +25,7 @@
 
 
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -35,6 +36,7 @@
 #include "eidos_test.h"
 #include "slim_test.h"
 #include "eidos_test_element.h"
+#include "eidos_openmp.h"
 
 
 void PrintUsageAndDie(bool p_print_header, bool p_print_full_usage);
@@ -81,6 +83,7 @@ void PrintUsageAndDie(bool p_print_header, bool p_print_full_usage)
 	
 	SLIM_OUTSTREAM << "usage: slim -v[ersion] | -u[sage] | -testEidos | -testSLiM |" << std::endl;
 	SLIM_OUTSTREAM << "   [-l[ong]] [-s[eed] <seed>] [-t[ime]] [-m[em]] [-M[emhist]] [-x]" << std::endl;
+	SLIM_OUTSTREAM << "   [-threads <n>] [-p[rofile] <file>]" << std::endl;
 	SLIM_OUTSTREAM << "   [-d[efine] <def>] <script file>" << std::endl;
 	
 	if (p_print_full_usage)
@@ -97,6 +100,8 @@ void PrintUsageAndDie(bool p_print_header, bool p_print_full_usage)
 		SLIM_OUTSTREAM << "   -m[em]           : print SLiM's peak memory usage" << std::endl;
 		SLIM_OUTSTREAM << "   -M[emhist]       : print a histogram of SLiM's memory usage" << std::endl;
 		SLIM_OUTSTREAM << "   -x               : disable SLiM's runtime safety/consistency checks" << std::endl;
+		SLIM_OUTSTREAM << "   -threads <n>     : use n threads for offspring generation (default 1)" << std::endl;
+		SLIM_OUTSTREAM << "   -p[rofile] <file>: write a profile report to <file>, and as JSON to <file>.json (profiling builds only)" << std::endl;
 		SLIM_OUTSTREAM << "   -d[efine] <def>  : define an Eidos constant, such as \"mu=1e-7\"" << std::endl;
 	}
 	
@@ -124,6 +129,7 @@ int main(int argc, char *argv[])
 	const char *input_file = nullptr;
 	bool verbose_output = false, keep_time = false, keep_mem = false, keep_mem_hist = false, skip_checks = false;
 	std::vector<std::string> defined_constants;
+	const char *profile_file = nullptr;
 	
 	// command-line SLiM generally terminates rather than throwing
 	gEidosTerminateThrows = false;
@@ -190,6 +196,43 @@ int main(int argc, char *argv[])
 			continue;
 		}
 		
+		// -threads <n>: set the number of threads used for parallel work; the model may override this with initializeSLiMOptions()
+		if (strcmp(arg, "-threads") == 0)
+		{
+			if (++arg_index == argc)
+				PrintUsageAndDie(false, true);
+			
+			const char *thread_count_string = argv[arg_index];
+			char *thread_count_end = nullptr;
+			long thread_count = strtol(thread_count_string, &thread_count_end, 10);
+			
+			if ((thread_count_end == thread_count_string) || (*thread_count_end != 0) || (thread_count < 1) || (thread_count > EIDOS_MAX_THREADS))
+			{
+				SLIM_ERRSTREAM << "The -threads command-line option requires an integer value between 1 and " << EIDOS_MAX_THREADS << "." << std::endl;
+				exit(EXIT_FAILURE);
+			}
+			
+			gEidosMaxThreads = (int)thread_count;
+			
+			continue;
+		}
+		
+		// -profile <file> or -p <file>: profile the run, and write a report to <file> and <file>.json at the end
+		if (strcmp(arg, "-profile") == 0 || strcmp(arg, "-p") == 0)
+		{
+			if (++arg_index == argc)
+				PrintUsageAndDie(false, true);
+
+#if (SLIMPROFILING == 1)
+			profile_file = argv[arg_index];
+#else
+			SLIM_ERRSTREAM << "The -profile command-line option requires a build of SLiM with profiling enabled (-DSLIMPROFILING=1; with make, PROFILING=-DSLIMPROFILING=1)." << std::endl;
+			exit(EXIT_FAILURE);
+#endif
+			
+			continue;
+		}
+		
 		// -version or -v: print version information
 		if (strcmp(arg, "-version") == 0 || strcmp(arg, "-v") == 0)
 		{
@@ -254,6 +297,14 @@ int main(int argc, char *argv[])
 		SLIM_ERRSTREAM << "// ********** The -l[ong] command-line option has enabled verbose output" << std::endl << std::endl;
 	if (skip_checks)
 		SLIM_ERRSTREAM << "// ********** The -x command-line option has disabled some runtime checks" << std::endl << std::endl;
+#ifdef DEBUG
+	if (profile_file)
+		SLIM_ERRSTREAM << "// ********** Profiling a DEBUG build; timings will not reflect those of a release build" << std::endl << std::endl;
+#endif
+#ifndef _OPENMP
+	if (gEidosMaxThreads > 1)
+		SLIM_ERRSTREAM << "// ********** This build of SLiM does not support OpenMP; the requested threads will run sequentially" << std::endl << std::endl;
+#endif
 	
 	// keep time (we do this whether or not the -time flag was passed)
 	clock_t begin = clock();
@@ -300,6 +351,30 @@ int main(int argc, char *argv[])
 		int mem_check_counter = 0, mem_check_mod = 10;
 #endif
 		
+#if (SLIMPROFILING == 1)
+		// PROFILING
+		// The report files are opened up front, so that a bad path is caught before the run rather than after it
+		eidos_profile_t profile_elapsed_wall_clock = 0;
+		clock_t profile_start_cpu_clock = clock();
+		std::ofstream profile_stream, profile_json_stream;
+		
+		if (profile_file)
+		{
+			profile_stream.open(profile_file);
+			profile_json_stream.open(std::string(profile_file) + ".json");
+			
+			if (!profile_stream.is_open() || !profile_json_stream.is_open())
+			{
+				SLIM_ERRSTREAM << "The -profile command-line option could not open " << profile_file << " and " << profile_file << ".json for writing." << std::endl;
+				exit(EXIT_FAILURE);
+			}
+			
+			sim->StartProfiling();
+		}
+		
+		SLIM_PROFILE_BLOCK_START();
+#endif
+		
 		// Run the simulation to its natural end
 		while (sim->RunOneGeneration())
 		{
@@ -332,6 +407,18 @@ int main(int argc, char *argv[])
 #endif
 		}
 		
+#if (SLIMPROFILING == 1)
+		// PROFILING
+		SLIM_PROFILE_BLOCK_END(profile_elapsed_wall_clock);
+		
+		if (profile_file)
+		{
+			sim->EndProfiling(profile_elapsed_wall_clock, clock() - profile_start_cpu_clock);
+			sim->WriteProfileReport(profile_stream);
+			sim->WriteProfileReportJSON(profile_json_stream);
+		}
+#endif
+		
 		// clean up; but this is an unnecessary waste of time in the command-line context
 		//delete sim;
 		//gsl_rng_free(gEidos_rng);
@@ -31,11 +31,15 @@
 
 // All Mutation objects get allocated out of a single shared block, for speed; see SLiM_WarmUp()
 Mutation *gSLiM_Mutation_Block = nullptr;
-MutationIndex gSLiM_Mutation_Block_Capacity = 0;
+int64_t gSLiM_Mutation_Block_Capacity = 0;			// not a MutationIndex, since it can be SLIM_MUTATION_INDEX_MAX + 1
 MutationIndex gSLiM_Mutation_FreeIndex = -1;
 MutationIndex gSLiM_Mutation_Block_LastUsedIndex = -1;
 
 slim_refcount_t *gSLiM_Mutation_Refcounts = nullptr;
+slim_position_t *gSLiM_Mutation_Positions = nullptr;
+MutationType **gSLiM_Mutation_Types = nullptr;
+slim_selcoeff_t *gSLiM_Mutation_OnePlusSel = nullptr;
+slim_selcoeff_t *gSLiM_Mutation_OnePlusDomSel = nullptr;
 
 #define SLIM_MUTATION_BLOCK_INITIAL_SIZE	16384		// makes for about a 1 MB block; not unreasonable
 
@@ -47,6 +51,10 @@ void SLiM_CreateMutationBlock(void)
 	gSLiM_Mutation_Block_Capacity = SLIM_MUTATION_BLOCK_INITIAL_SIZE;
 	gSLiM_Mutation_Block = (Mutation *)malloc(gSLiM_Mutation_Block_Capacity * sizeof(Mutation));
 	gSLiM_Mutation_Refcounts = (slim_refcount_t *)malloc(gSLiM_Mutation_Block_Capacity * sizeof(slim_refcount_t));
+	gSLiM_Mutation_Positions = (slim_position_t *)malloc(gSLiM_Mutation_Block_Capacity * sizeof(slim_position_t));
+	gSLiM_Mutation_Types = (MutationType **)malloc(gSLiM_Mutation_Block_Capacity * sizeof(MutationType *));
+	gSLiM_Mutation_OnePlusSel = (slim_selcoeff_t *)malloc(gSLiM_Mutation_Block_Capacity * sizeof(slim_selcoeff_t));
+	gSLiM_Mutation_OnePlusDomSel = (slim_selcoeff_t *)malloc(gSLiM_Mutation_Block_Capacity * sizeof(slim_selcoeff_t));
 	
 	//std::cout << "Allocating initial mutation block, " << SLIM_MUTATION_BLOCK_INITIAL_SIZE * sizeof(Mutation) << " bytes (sizeof(Mutation) == " << sizeof(Mutation) << ")" << std::endl;
 	
@@ -79,22 +87,31 @@ void SLiM_IncreaseMutationBlockCapacity(void)
 	// For now we will just double in size; we don't want to waste too much memory, but we
 	// don't want to have to realloc too often, either.
 	std::uintptr_t old_mutation_block = reinterpret_cast<std::uintptr_t>(gSLiM_Mutation_Block);
-	MutationIndex old_block_capacity = gSLiM_Mutation_Block_Capacity;
+	int64_t old_block_capacity = gSLiM_Mutation_Block_Capacity;
 	
-	gSLiM_Mutation_Block_Capacity *= 2;
+	// The block can hold at most SLIM_MUTATION_INDEX_MAX + 1 mutations, since indices beyond that are not representable; this
+	// matters in practice only when building with 16-bit indices (see mutation.h), which models with many mutations will exhaust.
+	if (old_block_capacity > SLIM_MUTATION_INDEX_MAX)
+		EIDOS_TERMINATION << "ERROR (SLiM_IncreaseMutationBlockCapacity): too many mutations; at most " << ((int64_t)SLIM_MUTATION_INDEX_MAX + 1) << " mutations can exist at one time" << (SLIM_MUTATION_INDEX_16BIT ? " in a build of SLiM with 16-bit mutation indices (SLIM_MUTATION_INDEX_16BIT); rebuild SLiM without that flag to run this model." : ".") << EidosTerminate();
+	
+	gSLiM_Mutation_Block_Capacity = std::min(old_block_capacity * 2, (int64_t)SLIM_MUTATION_INDEX_MAX + 1);
 	gSLiM_Mutation_Block = (Mutation *)realloc(gSLiM_Mutation_Block, gSLiM_Mutation_Block_Capacity * sizeof(Mutation));
 	gSLiM_Mutation_Refcounts = (slim_refcount_t *)realloc(gSLiM_Mutation_Refcounts, gSLiM_Mutation_Block_Capacity * sizeof(slim_refcount_t));
+	gSLiM_Mutation_Positions = (slim_position_t *)realloc(gSLiM_Mutation_Positions, gSLiM_Mutation_Block_Capacity * sizeof(slim_position_t));
+	gSLiM_Mutation_Types = (MutationType **)realloc(gSLiM_Mutation_Types, gSLiM_Mutation_Block_Capacity * sizeof(MutationType *));
+	gSLiM_Mutation_OnePlusSel = (slim_selcoeff_t *)realloc(gSLiM_Mutation_OnePlusSel, gSLiM_Mutation_Block_Capacity * sizeof(slim_selcoeff_t));
+	gSLiM_Mutation_OnePlusDomSel = (slim_selcoeff_t *)realloc(gSLiM_Mutation_OnePlusDomSel, gSLiM_Mutation_Block_Capacity * sizeof(slim_selcoeff_t));
 	
 	std::uintptr_t new_mutation_block = reinterpret_cast<std::uintptr_t>(gSLiM_Mutation_Block);
 	
 	// Set up the free list to extend into the new portion of the buffer.  If we are called when
 	// gSLiM_Mutation_FreeIndex != -1, the free list will start with the new region.
-	for (MutationIndex i = old_block_capacity; i < gSLiM_Mutation_Block_Capacity - 1; ++i)
+	for (MutationIndex i = (MutationIndex)old_block_capacity; i < gSLiM_Mutation_Block_Capacity - 1; ++i)
 		*(MutationIndex *)(gSLiM_Mutation_Block + i) = i + 1;
 	
 	*(MutationIndex *)(gSLiM_Mutation_Block + gSLiM_Mutation_Block_Capacity - 1) = gSLiM_Mutation_FreeIndex;
 	
-	gSLiM_Mutation_FreeIndex = old_block_capacity;
+	gSLiM_Mutation_FreeIndex = (MutationIndex)old_block_capacity;
 	
 	// Now we go out and fix Mutation * references in EidosValue_Object in all symbol tables
 	if (new_mutation_block != old_mutation_block)
@@ -172,11 +189,14 @@ Mutation::Mutation(MutationType *p_mutation_type_ptr, slim_position_t p_position
 mutation_type_ptr_(p_mutation_type_ptr), position_(p_position), selection_coeff_(static_cast<slim_selcoeff_t>(p_selection_coeff)), subpop_index_(p_subpop_index), generation_(p_generation), mutation_id_(gSLiM_next_mutation_id++)
 {
 	// cache values used by the fitness calculation code for speed; see header
-	cached_one_plus_sel_ = (slim_selcoeff_t)std::max(0.0, 1.0 + selection_coeff_);
-	cached_one_plus_dom_sel_ = (slim_selcoeff_t)std::max(0.0, 1.0 + mutation_type_ptr_->dominance_coeff_ * selection_coeff_);
+	CacheFitnessEffects();
+	
+	// zero out our refcount and mirror our hot fields, which are kept in separate buffers; see header
+	MutationIndex mut_index = BlockIndex();
 	
-	// zero out our refcount, which is now kept in a separate buffer
-	gSLiM_Mutation_Refcounts[BlockIndex()] = 0;
+	gSLiM_Mutation_Refcounts[mut_index] = 0;
+	gSLiM_Mutation_Positions[mut_index] = position_;
+	gSLiM_Mutation_Types[mut_index] = mutation_type_ptr_;
 	
 #if DEBUG_MUTATIONS
 	SLIM_OUTSTREAM << "Mutation constructed: " << this << std::endl;
@@ -187,11 +207,14 @@ Mutation::Mutation(slim_mutationid_t p_mutation_id, MutationType *p_mutation_typ
 mutation_type_ptr_(p_mutation_type_ptr), position_(p_position), selection_coeff_(static_cast<slim_selcoeff_t>(p_selection_coeff)), subpop_index_(p_subpop_index), generation_(p_generation), mutation_id_(p_mutation_id)
 {
 	// cache values used by the fitness calculation code for speed; see header
-	cached_one_plus_sel_ = (slim_selcoeff_t)std::max(0.0, 1.0 + selection_coeff_);
-	cached_one_plus_dom_sel_ = (slim_selcoeff_t)std::max(0.0, 1.0 + mutation_type_ptr_->dominance_coeff_ * selection_coeff_);
-
-	// zero out our refcount, which is now kept in a separate buffer
-	gSLiM_Mutation_Refcounts[BlockIndex()] = 0;
+	CacheFitnessEffects();
+	
+	// zero out our refcount and mirror our hot fields, which are kept in separate buffers; see header
+	MutationIndex mut_index = BlockIndex();
+	
+	gSLiM_Mutation_Refcounts[mut_index] = 0;
+	gSLiM_Mutation_Positions[mut_index] = position_;
+	gSLiM_Mutation_Types[mut_index] = mutation_type_ptr_;
 	
 #if DEBUG_MUTATIONS
 	SLIM_OUTSTREAM << "Mutation constructed: " << this << std::endl;
@@ -361,24 +384,19 @@ EidosValue_SP Mutation::ExecuteMethod_setSelectionCoeff(EidosGlobalStringID p_me
 		
 		sim.pure_neutral_ = false;							// let the sim know that it is no longer a pure-neutral simulation
 		mutation_type_ptr_->all_pure_neutral_DFE_ = false;	// let the mutation type for this mutation know that it is no longer pure neutral
-		
-		// If a selection coefficient has changed from zero to non-zero, or vice versa, MutationRun's nonneutral mutation caches need revalidation
-		if (old_coeff == 0.0)
-		{
-			sim.nonneutral_change_counter_++;
-		}
 	}
-	else if (old_coeff != 0.0)	// && (selection_coeff_ == 0.0) implied by the "else"
+	
+	// If a selection coefficient has changed at all, MutationRun's nonneutral mutation caches need revalidation; a change from zero to non-zero,
+	// or vice versa, changes the cached mutations, and any other change invalidates the fitness products kept with them
+	if (selection_coeff_ != old_coeff)
 	{
 		SLiMSim &sim = SLiM_GetSimFromInterpreter(p_interpreter);
 		
-		// If a selection coefficient has changed from zero to non-zero, or vice versa, MutationRun's nonneutral mutation caches need revalidation
 		sim.nonneutral_change_counter_++;
 	}
 	
 	// cache values used by the fitness calculation code for speed; see header
-	cached_one_plus_sel_ = (slim_selcoeff_t)std::max(0.0, 1.0 + selection_coeff_);
-	cached_one_plus_dom_sel_ = (slim_selcoeff_t)std::max(0.0, 1.0 + mutation_type_ptr_->dominance_coeff_ * selection_coeff_);
+	CacheFitnessEffects();
 	
 	return gStaticEidosValueNULLInvisible;
 }
@@ -395,14 +413,14 @@ EidosValue_SP Mutation::ExecuteMethod_setMutationType(EidosGlobalStringID p_meth
 	
 	// We take just the mutation type pointer; if the user wants a new selection coefficient, they can do that themselves
 	mutation_type_ptr_ = mutation_type_ptr;
+	gSLiM_Mutation_Types[BlockIndex()] = mutation_type_ptr;
 	
 	// If we are non-neutral, make sure the mutation type knows it is now also non-neutral; I think this is unnecessary but being safe...
 	if (selection_coeff_ != 0.0)
 		mutation_type_ptr_->all_pure_neutral_DFE_ = false;
 	
 	// cache values used by the fitness calculation code for speed; see header
-	cached_one_plus_sel_ = (slim_selcoeff_t)std::max(0.0, 1.0 + selection_coeff_);
-	cached_one_plus_dom_sel_ = (slim_selcoeff_t)std::max(0.0, 1.0 + mutation_type_ptr_->dominance_coeff_ * selection_coeff_);
+	CacheFitnessEffects();
 	
 	return gStaticEidosValueNULLInvisible;
 }
@@ -29,6 +29,7 @@
 
 
 #include <iostream>
+#include <algorithm>
 
 #include "mutation_type.h"
 #include "slim_global.h"
@@ -41,15 +42,31 @@ extern EidosObjectClass *gSLiM_Mutation_Class;
 // Note that type int32_t is used instead of uint32_t so that -1 can be used as a "null pointer"; perhaps UINT32_MAX would be
 // better, but on the other hand using int32_t has the virtue that if we run out of room we will probably crash hard rather
 // than perhaps just silently overrunning gSLiM_Mutation_Block with mysterious memory corruption bugs that are hard to catch.
-// For small simulations, defining this as int16_t instead can produce a substantial speedup (as much as 25%), but there are no
-// safeguards in the code to check for running out of indices, so doing that is quite dangerous at present.  A way to make
-// simulations switch from 16-bit to 32-bit at runtime, to get that speedup when possible, would be nice but in practice is very
-// difficult to code since MutationRun's internal buffer of MutationIndex is accessible and used directly by many clients.
+// For small simulations, defining this as int16_t instead can produce a substantial speedup (as much as 25%), since the
+// buffers of MutationRun are half the size; building with SLIM_MUTATION_INDEX_16BIT defined to 1 does that.  Such a build
+// can have at most SLIM_MUTATION_INDEX_MAX + 1 (32768) mutations in existence at once; SLiM_IncreaseMutationBlockCapacity()
+// stops the simulation with an error if a model needs more.  A way to make simulations switch from 16-bit to 32-bit at
+// runtime, to get that speedup when possible, would be nice but in practice is very difficult to code since MutationRun's
+// internal buffer of MutationIndex is accessible and used directly by many clients; so the choice is made at build time.
+#ifndef SLIM_MUTATION_INDEX_16BIT
+#define SLIM_MUTATION_INDEX_16BIT	0
+#endif
+
+#if SLIM_MUTATION_INDEX_16BIT
+typedef int16_t MutationIndex;
+#define SLIM_MUTATION_INDEX_MAX		INT16_MAX
+#else
 typedef int32_t MutationIndex;
+#define SLIM_MUTATION_INDEX_MAX		INT32_MAX
+#endif
 
 // forward declaration of Mutation block allocation; see bottom of header
 class Mutation;
 extern Mutation *gSLiM_Mutation_Block;
+extern slim_position_t *gSLiM_Mutation_Positions;
+extern MutationType **gSLiM_Mutation_Types;
+extern slim_selcoeff_t *gSLiM_Mutation_OnePlusSel;
+extern slim_selcoeff_t *gSLiM_Mutation_OnePlusDomSel;
 
 
 class Mutation : public SLiMEidosDictionary
@@ -71,13 +88,6 @@ public:
 	mutable slim_refcount_t gui_scratch_reference_count_;	// an additional refcount used for temporary tallies by SLiMgui, valid only when explicitly updated
 #endif
 	
-	// We cache values used in the fitness calculation code, for speed.  These are the final fitness effects of this mutation
-	// when it is homozygous or heterozygous, respectively.  These values are clamped to a minimum of 0.0, so that multiplying
-	// by them cannot cause the fitness of the individual to go below 0.0, avoiding slow tests in the core fitness loop.  These
-	// values use slim_selcoeff_t for speed; roundoff should not be a concern, since such differences would be inconsequential.
-	slim_selcoeff_t cached_one_plus_sel_;				// a cached value for (1 + selection_coeff_), clamped to 0.0 minimum
-	slim_selcoeff_t cached_one_plus_dom_sel_;			// a cached value for (1 + dominance_coeff * selection_coeff_), clamped to 0.0 minimum
-	
 	Mutation(const Mutation&) = delete;					// no copying
 	Mutation& operator=(const Mutation&) = delete;		// no copying
 	Mutation(void) = delete;							// no null construction; Mutation is an immutable class
@@ -97,6 +107,22 @@ public:
 	
 	inline MutationIndex BlockIndex(void) const			{ return (MutationIndex)(this - gSLiM_Mutation_Block); }
 	
+	// We cache values used in the fitness calculation code, for speed.  These are the final fitness effects of this mutation
+	// when it is homozygous or heterozygous, respectively.  These values are clamped to a minimum of 0.0, so that multiplying
+	// by them cannot cause the fitness of the individual to go below 0.0, avoiding slow tests in the core fitness loop.  These
+	// values use slim_selcoeff_t for speed; roundoff should not be a concern, since such differences would be inconsequential.
+	// They are kept in gSLiM_Mutation_OnePlusSel and gSLiM_Mutation_OnePlusDomSel, not in Mutation; see below.
+	inline void CacheFitnessEffects(void)
+	{
+		MutationIndex mut_index = BlockIndex();
+		
+		gSLiM_Mutation_OnePlusSel[mut_index] = (slim_selcoeff_t)std::max(0.0, 1.0 + selection_coeff_);
+		gSLiM_Mutation_OnePlusDomSel[mut_index] = (slim_selcoeff_t)std::max(0.0, 1.0 + mutation_type_ptr_->dominance_coeff_ * selection_coeff_);
+	}
+	
+	inline slim_selcoeff_t CachedOnePlusSel(void) const		{ return gSLiM_Mutation_OnePlusSel[BlockIndex()]; }
+	inline slim_selcoeff_t CachedOnePlusDomSel(void) const	{ return gSLiM_Mutation_OnePlusDomSel[BlockIndex()]; }
+	
 	//
 	// Eidos support
 	//
@@ -151,8 +177,17 @@ extern Mutation *gSLiM_Mutation_Block;
 extern MutationIndex gSLiM_Mutation_FreeIndex;
 extern MutationIndex gSLiM_Mutation_Block_LastUsedIndex;
 
-extern slim_refcount_t *gSLiM_Mutation_Refcounts;	// an auxiliary buffer, parallel to gSLiM_Mutation_Block, to increase memory cache efficiency
-													// note that I tried keeping the fitness cache values and positions in separate buffers too, not a win
+// The fields of Mutation read by the innermost loops (crossover-mutation, fitness calculation, and reference tallying) are kept
+// in auxiliary buffers parallel to gSLiM_Mutation_Block, indexed by MutationIndex, so that those loops touch only densely packed
+// hot data rather than pulling whole Mutation objects (vtable, dictionary, ids, tag...) into the cache.  Position and mutation
+// type are mirrored here, and kept in sync by Mutation, since they are also read through the Mutation object in many places;
+// the fitness cache values and refcounts live only here.  All of these buffers are reallocated together with the block.
+extern slim_refcount_t *gSLiM_Mutation_Refcounts;	// the number of references to each mutation; see Population::TallyMutationReferences()
+extern slim_position_t *gSLiM_Mutation_Positions;	// mirrors position_
+extern MutationType **gSLiM_Mutation_Types;			// mirrors mutation_type_ptr_
+extern slim_selcoeff_t *gSLiM_Mutation_OnePlusSel;		// (1 + selection_coeff_), clamped to 0.0 minimum; see Mutation::CacheFitnessEffects()
+extern slim_selcoeff_t *gSLiM_Mutation_OnePlusDomSel;	// (1 + dominance_coeff * selection_coeff_), clamped to 0.0 minimum
+
 void SLiM_CreateMutationBlock(void);
 void SLiM_IncreaseMutationBlockCapacity(void);
 void SLiM_ZeroRefcountBlock(MutationRun &p_mutation_registry);
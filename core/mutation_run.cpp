@@ -21,14 +21,93 @@
 #include "mutation_run.h"
 
 #include <vector>
+#include <algorithm>
+
+#if SLIM_MUTRUN_SIMD
+#include <immintrin.h>
+#endif
 
 
 // For doing bulk operations across all MutationRun objects; see header
 int64_t gSLiM_MutationRun_OperationID = 0;
 
+#if SLIM_INCREMENTAL_TALLIES
+// For carrying mutation refcounts forward between tallies; see header
+int64_t gSLiM_MutationRun_TallyEpoch = 1;
+int64_t gSLiM_MutationRun_UntalliedCount = 0;
+#endif
+
 std::vector<MutationRun *> MutationRun::s_freed_mutation_runs_;
 
 
+#if SLIM_MUTRUN_SIMD
+// AVX2 kernels; see SLiM_FirstMutationAtOrAfter() in the header.  These are compiled for AVX2 regardless of the build flags, and are
+// called only if the CPU supports it.  MutationIndex may be 16 or 32 bits (see SLIM_MUTATION_INDEX_16BIT); positions are 32 bits.
+static bool _SLiM_CPUSupportsAVX2(void)
+{
+	__builtin_cpu_init();	// we may run before the runtime's own initialization of the CPU model
+	return __builtin_cpu_supports("avx2");
+}
+
+const bool gSLiM_MutationRun_UseAVX2 = _SLiM_CPUSupportsAVX2();
+
+__attribute__((target("avx2"))) static inline __m256i _SLiM_LoadEightMutationIndices(const MutationIndex *p_indices)
+{
+	if (sizeof(MutationIndex) == 2)
+		return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)p_indices));
+	else
+		return _mm256_loadu_si256((const __m256i *)p_indices);
+}
+
+__attribute__((target("avx2"))) const MutationIndex *SLiM_FirstMutationAtOrAfter_AVX2(const MutationIndex *p_begin, const MutationIndex *p_end, slim_position_t p_position)
+{
+	// gather the positions of eight mutations at a time; since they are sorted, the first one at or after p_position is the lowest set bit
+	const int *position_block_ptr = (const int *)gSLiM_Mutation_Positions;
+	const __m256i threshold = _mm256_set1_epi32(p_position - 1);
+	
+	while (p_end - p_begin >= 8)
+	{
+		__m256i positions = _mm256_i32gather_epi32(position_block_ptr, _SLiM_LoadEightMutationIndices(p_begin), sizeof(slim_position_t));
+		int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(positions, threshold)));
+		
+		if (mask)
+			return p_begin + __builtin_ctz((unsigned int)mask);
+		
+		p_begin += 8;
+	}
+	
+	while ((p_begin != p_end) && (position_block_ptr[*p_begin] < p_position))
+		++p_begin;
+	
+	return p_begin;
+}
+
+__attribute__((target("avx2"))) bool SLiM_ContainsMutationIndex_AVX2(const MutationIndex *p_begin, const MutationIndex *p_end, MutationIndex p_mutation_index)
+{
+	// compare the indices themselves, 256 bits at a time; no positions are needed
+	const int lanes = 32 / sizeof(MutationIndex);
+	const __m256i target = (sizeof(MutationIndex) == 2) ? _mm256_set1_epi16((short)p_mutation_index) : _mm256_set1_epi32((int)p_mutation_index);
+	
+	while (p_end - p_begin >= lanes)
+	{
+		__m256i indices = _mm256_loadu_si256((const __m256i *)p_begin);
+		__m256i matches = (sizeof(MutationIndex) == 2) ? _mm256_cmpeq_epi16(indices, target) : _mm256_cmpeq_epi32(indices, target);
+		
+		if (!_mm256_testz_si256(matches, matches))
+			return true;
+		
+		p_begin += lanes;
+	}
+	
+	for (; p_begin != p_end; ++p_begin)
+		if (*p_begin == p_mutation_index)
+			return true;
+	
+	return false;
+}
+#endif
+
+
 MutationRun::MutationRun() : intrusive_ref_count_(0)
 {
 }
@@ -45,6 +124,65 @@ MutationRun::~MutationRun(void)
 #endif
 }
 
+void MutationRun::TrimMutationRunFreeList(void)
+{
+	for (MutationRun *mutrun : s_freed_mutation_runs_)
+		mutrun->trim_buffers();
+}
+
+// The capacity that the growth policy in emplace_back() would reach for a given number of mutations, beyond the internal buffer
+static inline int32_t _SLiM_MutationRunCapacityForCount(int32_t p_count)
+{
+	int32_t capacity = SLIM_MUTRUN_BUFFER_SIZE * 2;
+	
+	while (capacity < p_count)
+	{
+		if (capacity < 32)
+			capacity <<= 1;
+		else
+			capacity += 16;
+	}
+	
+	return capacity;
+}
+
+void MutationRun::trim_buffers(void)
+{
+	int32_t slack = mutation_capacity_ - mutation_count_;
+	
+	if ((mutations_ != mutations_buffer_) && (slack > SLIM_MUTRUN_MAX_SLACK) && (slack > (mutation_capacity_ >> 2)))
+	{
+		if (mutation_count_ <= SLIM_MUTRUN_BUFFER_SIZE)
+		{
+			// the contents fit in our internal buffer, so go back to using it
+			memcpy(mutations_buffer_, mutations_, mutation_count_ * sizeof(MutationIndex));
+			free(mutations_);
+			
+			mutations_ = mutations_buffer_;
+			mutation_capacity_ = SLIM_MUTRUN_BUFFER_SIZE;
+		}
+		else
+		{
+			mutation_capacity_ = _SLiM_MutationRunCapacityForCount(mutation_count_);
+			mutations_ = (MutationIndex *)realloc(mutations_, mutation_capacity_ * sizeof(MutationIndex));
+		}
+	}
+	
+#if SLIM_USE_NONNEUTRAL_CACHES
+	if (nonneutral_mutations_)
+	{
+		int32_t nonneutral_count = std::max(nonneutral_mutations_count_, 0);	// -1 for an invalid cache
+		int32_t nonneutral_slack = nonneutral_mutation_capacity_ - nonneutral_count;
+		
+		if ((nonneutral_slack > SLIM_MUTRUN_MAX_SLACK) && (nonneutral_slack > (nonneutral_mutation_capacity_ >> 2)))
+		{
+			nonneutral_mutation_capacity_ = _SLiM_MutationRunCapacityForCount(nonneutral_count);
+			nonneutral_mutations_ = (MutationIndex *)realloc(nonneutral_mutations_, nonneutral_mutation_capacity_ * sizeof(MutationIndex));
+		}
+	}
+#endif
+}
+
 #ifdef SLIM_MUTRUN_CHECK_LOCKING
 void MutationRun::LockingViolation(void) const
 {
@@ -66,12 +204,16 @@ bool MutationRun::contains_mutation(MutationIndex p_mutation_index)
 	return false;
 }
 #else
-// binary search
+// binary search, or a vectorized linear search for runs of modest length, which is faster since it needs no positions
 bool MutationRun::contains_mutation(MutationIndex p_mutation_index)
 {
-	Mutation *mut_block_ptr = gSLiM_Mutation_Block;
-	Mutation *mutation = gSLiM_Mutation_Block + p_mutation_index;
-	slim_position_t position = mutation->position_;
+#if SLIM_MUTRUN_SIMD
+	if (gSLiM_MutationRun_UseAVX2 && (mutation_count_ <= 256))
+		return SLiM_ContainsMutationIndex_AVX2(mutations_, mutations_ + mutation_count_, p_mutation_index);
+#endif
+	
+	slim_position_t *position_block_ptr = gSLiM_Mutation_Positions;
+	slim_position_t position = position_block_ptr[p_mutation_index];
 	int mut_count = size();
 	const MutationIndex *mut_ptr = begin_pointer_const();
 	int mut_index;
@@ -89,7 +231,7 @@ bool MutationRun::contains_mutation(MutationIndex p_mutation_index)
 					return false;
 				
 				mut_index = (L + R) >> 1;	// overflow-safe because base positions have a max of 1000000000L
-				mut_pos = (mut_block_ptr + mut_ptr[mut_index])->position_;
+				mut_pos = position_block_ptr[mut_ptr[mut_index]];
 				
 				if (mut_pos < position)
 				{
@@ -122,7 +264,7 @@ bool MutationRun::contains_mutation(MutationIndex p_mutation_index)
 		{
 			const MutationIndex scan_mut_index = mut_ptr[--back_scan];
 			
-			if ((mut_block_ptr + scan_mut_index)->position_ != position)
+			if (position_block_ptr[scan_mut_index] != position)
 				break;
 			if (scan_mut_index == p_mutation_index)
 				return true;
@@ -136,7 +278,7 @@ bool MutationRun::contains_mutation(MutationIndex p_mutation_index)
 		{
 			const MutationIndex scan_mut_index = mut_ptr[++forward_scan];
 			
-			if ((mut_block_ptr + scan_mut_index)->position_ != position)
+			if (position_block_ptr[scan_mut_index] != position)
 				break;
 			if (scan_mut_index == p_mutation_index)
 				return true;
@@ -588,66 +730,31 @@ void MutationRun::clear_set_and_merge(MutationRun &p_mutations_to_set, MutationR
 		}
 	}
 	
-	// then interleave mutations together, effectively setting p_mutations_to_set and then adding in p_mutations_to_add
-	Mutation *mut_block_ptr = gSLiM_Mutation_Block;
+	// then interleave mutations together, effectively setting p_mutations_to_set and then adding in p_mutations_to_add; before each
+	// mutation to add, we copy the mutations to set that are at or before its position
+	slim_position_t *position_block_ptr = gSLiM_Mutation_Positions;
+	MutationType **muttype_block_ptr = gSLiM_Mutation_Types;
 	const MutationIndex *mutation_iter		= p_mutations_to_add.begin_pointer_const();
 	const MutationIndex *mutation_iter_max	= p_mutations_to_add.end_pointer_const();
-	MutationIndex mutation_iter_mutation_index = *mutation_iter;
-	slim_position_t mutation_iter_pos = (mut_block_ptr + mutation_iter_mutation_index)->position_;
-	
 	const MutationIndex *parent_iter		= p_mutations_to_set.begin_pointer_const();
 	const MutationIndex *parent_iter_max	= p_mutations_to_set.end_pointer_const();
-	MutationIndex parent_iter_mutation_index = *parent_iter;
-	slim_position_t parent_iter_pos = (mut_block_ptr + parent_iter_mutation_index)->position_;
-	
-	// this loop runs while we are still interleaving mutations from both sources
-	do
-	{
-		if (parent_iter_pos <= mutation_iter_pos)
-		{
-			// we have a parent mutation that comes first, so copy it
-			emplace_back(*parent_iter);
-			
-			parent_iter++;
-			if (parent_iter == parent_iter_max)
-				break;
-			
-			parent_iter_mutation_index = *parent_iter;
-			parent_iter_pos = (mut_block_ptr + parent_iter_mutation_index)->position_;
-		}
-		else
-		{
-			// we have a new mutation to add, which we know is not already present; check the stacking policy
-			if (enforce_stack_policy_for_addition(mutation_iter_pos, (mut_block_ptr + mutation_iter_mutation_index)->mutation_type_ptr_))
-				emplace_back(mutation_iter_mutation_index);
-			
-			mutation_iter++;
-			if (mutation_iter == mutation_iter_max)
-				break;
-			
-			mutation_iter_mutation_index = *mutation_iter;
-			mutation_iter_pos = (mut_block_ptr + mutation_iter_mutation_index)->position_;
-		}
-	}
-	while (true);
 	
-	// one source is exhausted, but there are still mutations left in the other source
-	while (parent_iter != parent_iter_max)
+	for (; mutation_iter != mutation_iter_max; ++mutation_iter)
 	{
-		emplace_back(*parent_iter);
-		parent_iter++;
-	}
-	
-	while (mutation_iter != mutation_iter_max)
-	{
-		mutation_iter_mutation_index = *mutation_iter;
-		mutation_iter_pos = (mut_block_ptr + mutation_iter_mutation_index)->position_;
+		MutationIndex mutation_iter_mutation_index = *mutation_iter;
+		slim_position_t mutation_iter_pos = position_block_ptr[mutation_iter_mutation_index];
+		const MutationIndex *parent_stop = SLiM_FirstMutationAtOrAfter(parent_iter, parent_iter_max, mutation_iter_pos + 1);
 		
-		if (enforce_stack_policy_for_addition(mutation_iter_pos, (mut_block_ptr + mutation_iter_mutation_index)->mutation_type_ptr_))
-			emplace_back(mutation_iter_mutation_index);
+		emplace_back_bulk(parent_iter, parent_stop - parent_iter);
+		parent_iter = parent_stop;
 		
-		mutation_iter++;
+		// we have a new mutation to add, which we know is not already present; check the stacking policy
+		if (enforce_stack_policy_for_addition(mutation_iter_pos, muttype_block_ptr[mutation_iter_mutation_index]))
+			emplace_back(mutation_iter_mutation_index);
 	}
+	
+	// copy any remaining mutations to set
+	emplace_back_bulk(parent_iter, parent_iter_max - parent_iter);
 }
 
 
@@ -48,6 +48,13 @@ typedef Eidos_intrusive_ptr<MutationRun>	MutationRun_SP;
 #define SLIM_MUTRUN_BUFFER_SIZE		4
 
 
+// MutationRun objects are recycled with their buffers intact, so a run can end up with a buffer much larger than its contents; this
+// happens particularly after the number of mutation runs per genome changes, since every recycled run then has a buffer sized for
+// the old run length.  A finished run with more than this many unused entries, and more than a quarter of its buffer unused, has its
+// buffer trimmed by trim_buffers(); see Population::InternMutationRuns().
+#define SLIM_MUTRUN_MAX_SLACK		64
+
+
 // If defined, runtime checks are conducted to ensure that MutationRun objects are not modified once they have been referenced by
 // more than one Genome.  This allows multiple Genome objects to refer to the same underlying MutationRun securely.  Genome and other
 // clients are responsible for making a copy of a MutationRun before modification when they do not know they are the sole owner.
@@ -69,6 +76,58 @@ typedef Eidos_intrusive_ptr<MutationRun>	MutationRun_SP;
 extern int64_t gSLiM_MutationRun_OperationID;
 
 
+// If defined as 1, MutationRun remembers the use count with which it was last tallied into gSLiM_Mutation_Refcounts, so that
+// Population::TallyMutationReferences() can carry the refcounts forward from one tally to the next, rescanning only the runs whose
+// use count has changed; runs that are freed or modified in place take their old contribution back out as that happens.  A run's
+// tally counts only while its tally_epoch_ matches gSLiM_MutationRun_TallyEpoch, so incrementing that counter discards all of
+// them at once.  This is not used in SLiMgui, where several simulations share the mutation block.
+#ifndef SLIMGUI
+#define SLIM_INCREMENTAL_TALLIES	1
+#else
+#define SLIM_INCREMENTAL_TALLIES	0
+#endif
+
+#if SLIM_INCREMENTAL_TALLIES
+extern int64_t gSLiM_MutationRun_TallyEpoch;			// the current tally epoch; never 0, which marks a run that has not been tallied
+extern int64_t gSLiM_MutationRun_UntalliedCount;		// the number of mutations untallied since the last tally, for cost accounting
+#endif
+
+
+// Kernels for scanning runs of MutationIndex, which are sorted by position; these are the innermost loops of offspring generation,
+// where the mutations of a parental run are copied up to each breakpoint.  If SLIM_MUTRUN_SIMD is 1, AVX2 versions are used when
+// the CPU supports them (checked once, at startup), and scalar versions otherwise; define it as 0 to build only the scalar versions.
+#ifndef SLIM_MUTRUN_SIMD
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SLIM_MUTRUN_SIMD	1
+#else
+#define SLIM_MUTRUN_SIMD	0
+#endif
+#endif
+
+#if SLIM_MUTRUN_SIMD
+extern const bool gSLiM_MutationRun_UseAVX2;
+
+const MutationIndex *SLiM_FirstMutationAtOrAfter_AVX2(const MutationIndex *p_begin, const MutationIndex *p_end, slim_position_t p_position);
+bool SLiM_ContainsMutationIndex_AVX2(const MutationIndex *p_begin, const MutationIndex *p_end, MutationIndex p_mutation_index);
+#endif
+
+// Returns the first mutation in [p_begin, p_end) whose position is at or after p_position, or p_end if there is none
+inline __attribute__((always_inline)) const MutationIndex *SLiM_FirstMutationAtOrAfter(const MutationIndex *p_begin, const MutationIndex *p_end, slim_position_t p_position)
+{
+#if SLIM_MUTRUN_SIMD
+	if (gSLiM_MutationRun_UseAVX2 && (p_end - p_begin >= 8))
+		return SLiM_FirstMutationAtOrAfter_AVX2(p_begin, p_end, p_position);
+#endif
+	
+	const slim_position_t *position_block_ptr = gSLiM_Mutation_Positions;
+	
+	while ((p_begin != p_end) && (position_block_ptr[*p_begin] < p_position))
+		++p_begin;
+	
+	return p_begin;
+}
+
+
 class MutationRun
 {
 	//	This class has its copy constructor and assignment operator disabled, to prevent accidental copying.
@@ -142,13 +201,23 @@ private:
 	MutationIndex *nonneutral_mutations_ = nullptr;				// OWNED POINTER: a pointer to MutationIndex for non-neutral mutations
 	
 	int32_t nonneutral_change_validation_ = 0;					// compared to sim.nonneutral_change_counter_ to detect changes
-
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+	
+	// The fitness effects of this run, with no fitness() callbacks, when it is paired with itself (so that all of its non-neutral mutations
+	// are homozygous) and when it has no partner (in a male, when a sex chromosome is modeled).  A run shared by many genomes recurs in these
+	// roles in many individuals, so the products are calculated once by Subpopulation and kept here; they are over the non-neutral cache, so
+	// they are reset whenever it is revalidated, which SLiMSim forces (with nonneutral_change_counter_) when a selection coefficient changes.
+	// A negative value indicates that a product has not been calculated.  The unpaired product of an X chromosome depends upon the X dominance
+	// coefficient, so the coefficient it was calculated with is kept too.
+	double homozygous_fitness_ = -1.0;
+	double unpaired_fitness_ = -1.0;
+	double unpaired_x_dominance_coeff_ = 0.0;
+
+#if (SLIMPROFILING == 1)
 // PROFILING
 	
 	bool recached_run_ = false;
 	
-#endif	// defined(SLIMGUI) && (SLIMPROFILING == 1)
+#endif	// (SLIMPROFILING == 1)
 	
 #endif	// SLIM_USE_NONNEUTRAL_CACHES
 	
@@ -156,6 +225,11 @@ public:
 	
 	int64_t operation_id_ = 0;		// used to mark the MutationRun objects that have been handled by a global operation
 	
+#if SLIM_INCREMENTAL_TALLIES
+	int64_t tally_epoch_ = 0;					// the tally epoch in which tallied_use_count_ was added into the refcounts
+	slim_refcount_t tallied_use_count_ = 0;		// the use count this run contributed to each of its mutations' refcounts
+#endif
+	
 	// Allocation and disposal of MutationRun objects should go through these funnels.  The point of this architecture
 	// is to re-use the instances completely.  We don't use EidosObjectPool here because it would construct/destruct the
 	// objects, and we actually don't want that; we want the buffers in used MutationRun objects to stay allocated, for
@@ -176,11 +250,27 @@ public:
 		return new MutationRun();
 	}
 	
+	// A variant of NewMutationRun() that takes from a caller-supplied free list; this is used by the parallel reproduction
+	// code in Population, which gives each worker thread a share of s_freed_mutation_runs_ so that no locking is needed
+	static inline MutationRun *NewMutationRun(std::vector<MutationRun *> &p_free_list)
+	{
+		if (p_free_list.size())
+		{
+			MutationRun *back = p_free_list.back();
+			
+			p_free_list.pop_back();
+			return back;
+		}
+		
+		return new MutationRun();
+	}
+	
 	static inline void FreeMutationRun(MutationRun *p_run)
 	{
 		// We return mutation runs to the free list in a valid, reuseable state.  We do not free its buffers, avoiding that
 		// free/alloc thrash is one of the big wins of recycling mutation run objects, in fact.
 		
+		p_run->untally_mutation_references();			// take back the run's contribution to the refcounts, if any
 		p_run->mutation_count_ = 0;						// empty the mutation buffer
 		
 #if SLIM_USE_NONNEUTRAL_CACHES
@@ -200,6 +290,9 @@ public:
 		s_freed_mutation_runs_.clear();
 	}
 	
+	// Release the buffers of the runs in the free list, after a change in run length has made them the wrong size
+	static void TrimMutationRunFreeList(void);
+	
 	static std::vector<MutationRun *> s_freed_mutation_runs_;
 	
 	MutationRun(const MutationRun&) = delete;					// no copying
@@ -226,9 +319,36 @@ public:
 #endif
 	
 	
+	// Add p_count to the refcount of every mutation in the run
+	inline void add_to_mutation_references(slim_refcount_t p_count) const
+	{
+		slim_refcount_t *refcount_block_ptr = gSLiM_Mutation_Refcounts;
+		const MutationIndex *mut_iter = mutations_;
+		const MutationIndex *mut_end_iter = mutations_ + mutation_count_;
+		
+		while (mut_iter != mut_end_iter)
+			*(refcount_block_ptr + (*mut_iter++)) += p_count;
+	}
+	
+	// Remove the run's contribution to the refcounts, if it made one in the current tally epoch; this must be called before a
+	// tallied run is modified in place or freed, so that the refcounts carried forward by Population stay correct
+	inline void untally_mutation_references(void)
+	{
+#if SLIM_INCREMENTAL_TALLIES
+		if (tally_epoch_ == gSLiM_MutationRun_TallyEpoch)
+		{
+			add_to_mutation_references(-tallied_use_count_);
+			gSLiM_MutationRun_UntalliedCount += mutation_count_;
+			tally_epoch_ = 0;
+		}
+#endif
+	}
+	
 	inline void will_modify_run(void) {
 		SLIM_MUTRUN_LOCK_CHECK();
 		
+		untally_mutation_references();			// the run's refcount contribution will be stale once it changes
+
 #if SLIM_USE_NONNEUTRAL_CACHES
 		nonneutral_mutations_count_ = -1;		// invalidate the nonneutral cache since the run is changing
 #endif
@@ -596,6 +716,9 @@ public:
 		return true;
 	}
 	
+	// shrink the mutation buffer (and the non-neutral buffer) to fit the run's contents, if they have much unused capacity
+	void trim_buffers(void);
+	
 	// splitting mutation runs
 	void split_run(MutationRun **p_first_half, MutationRun **p_second_half, int32_t p_split_first_position);
 	
@@ -643,26 +766,44 @@ public:
 	
 	void check_nonneutral_mutation_cache();
 	
-	inline void beginend_nonneutral_pointers(const MutationIndex **p_mutptr_iter, const MutationIndex **p_mutptr_max, int32_t p_nonneutral_change_counter, int32_t p_nonneutral_regime)
+	inline bool nonneutral_cache_needs_validation(int32_t p_nonneutral_change_counter) const
 	{
-		if ((nonneutral_change_validation_ != p_nonneutral_change_counter) || (nonneutral_mutations_count_ == -1))
+		// The cache is invalid if the nonneutral change counter has changed since we last validated, or for other
+		// reasons (most notably being a new mutation run that has not yet cached)
+		return ((nonneutral_change_validation_ != p_nonneutral_change_counter) || (nonneutral_mutations_count_ == -1));
+	}
+	
+	inline void validate_nonneutral_cache(int32_t p_nonneutral_change_counter, int32_t p_nonneutral_regime)
+	{
+		nonneutral_change_validation_ = p_nonneutral_change_counter;
+		homozygous_fitness_ = -1.0;
+		unpaired_fitness_ = -1.0;
+		
+		switch (p_nonneutral_regime)
 		{
-			// If the nonneutral change counter has changed since we last validated, or our cache is invalid for other
-			// reasons (most notably being a new mutation run that has not yet cached), validate it immediately
-			nonneutral_change_validation_ = p_nonneutral_change_counter;
-			
-			switch (p_nonneutral_regime)
-			{
-				case 1: cache_nonneutral_mutations_REGIME_1(); break;
-				case 2: cache_nonneutral_mutations_REGIME_2(); break;
-				case 3: cache_nonneutral_mutations_REGIME_3(); break;
-			}
-			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
-			// PROFILING
-			recached_run_ = true;
-#endif
+			case 1: cache_nonneutral_mutations_REGIME_1(); break;
+			case 2: cache_nonneutral_mutations_REGIME_2(); break;
+			case 3: cache_nonneutral_mutations_REGIME_3(); break;
 		}
+
+#if (SLIMPROFILING == 1)
+		// PROFILING
+		recached_run_ = true;
+#endif
+	}
+	
+	// Access to the fitness products kept with the non-neutral cache; see homozygous_fitness_.  The cache must be valid when these are used.
+	inline double cached_homozygous_fitness(void) const { return homozygous_fitness_; }
+	inline void set_cached_homozygous_fitness(double p_fitness) { homozygous_fitness_ = p_fitness; }
+	inline double cached_unpaired_fitness(double p_x_dominance_coeff) const { return (unpaired_x_dominance_coeff_ == p_x_dominance_coeff) ? unpaired_fitness_ : -1.0; }
+	inline void set_cached_unpaired_fitness(double p_fitness, double p_x_dominance_coeff) { unpaired_fitness_ = p_fitness; unpaired_x_dominance_coeff_ = p_x_dominance_coeff; }
+	
+	inline void beginend_nonneutral_pointers(const MutationIndex **p_mutptr_iter, const MutationIndex **p_mutptr_max, int32_t p_nonneutral_change_counter, int32_t p_nonneutral_regime)
+	{
+		// If our cache is invalid, validate it immediately; note that this modifies the run, so callers working in parallel
+		// must validate all of the runs they will use beforehand (see Subpopulation::ValidateParentalNonneutralCaches())
+		if (nonneutral_cache_needs_validation(p_nonneutral_change_counter))
+			validate_nonneutral_cache(p_nonneutral_change_counter, p_nonneutral_regime);
 		
 #if DEBUG
 		check_nonneutral_mutation_cache();
@@ -673,7 +814,7 @@ public:
 		*p_mutptr_max = nonneutral_mutations_ + nonneutral_mutations_count_;
 	}
 	
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	inline void tally_nonneutral_mutations(int64_t *p_mutation_count, int64_t *p_nonneutral_count, int64_t *p_recached_count)
 	{
@@ -688,7 +829,7 @@ public:
 			recached_run_ = false;
 		}
 	}
-#endif	// defined(SLIMGUI) && (SLIMPROFILING == 1)
+#endif	// (SLIMPROFILING == 1)
 	
 #endif	// SLIM_USE_NONNEUTRAL_CACHES
 	
@@ -33,14 +33,36 @@
 #include "eidos_interpreter.h"
 #include "eidos_symbol_table.h"
 #include "polymorphism.h"
+#include "tree_sequence.h"
+#include "eidos_openmp.h"
 
 
+_ReproductionThreadState::_ReproductionThreadState(void)
+{
+	Eidos_InitializeRNGStream(&rng_);
+}
+
+_ReproductionThreadState::~_ReproductionThreadState(void)
+{
+	Eidos_FreeRNGStream(&rng_);
+	
+	for (MutationRun *mutrun : freed_mutation_runs_)
+		delete mutrun;
+	
+	freed_mutation_runs_.clear();
+}
+
 Population::Population(SLiMSim &p_sim) : sim_(p_sim)
 {
 }
 
 Population::~Population(void)
 {
+#if SLIM_INCREMENTAL_TALLIES
+	// our mutation runs should not untally themselves as our genomes are disposed of
+	++gSLiM_MutationRun_TallyEpoch;
+#endif
+	
 	RemoveAllSubpopulationInfo();
 	
 #ifdef SLIMGUI
@@ -63,6 +85,12 @@ Population::~Population(void)
 		delete removed_subpop;
 	
 	removed_subpops_.clear();
+	
+	// dispose of per-thread state for parallel offspring generation
+	for (ReproductionThreadState *thread_state : reproduction_threads_)
+		delete thread_state;
+	
+	reproduction_threads_.clear();
 }
 
 void Population::RemoveAllSubpopulationInfo(void)
@@ -147,6 +175,15 @@ Subpopulation *Population::AddSubpopulation(slim_objectid_t p_subpop_id, slim_po
 	
 	insert(std::pair<const slim_objectid_t,Subpopulation*>(p_subpop_id, new_subpop));
 	
+	// the new genomes are founders in the tree sequence, with no parents
+	if (TreeSequence *tree_seq = sim_.TreeSeq())
+	{
+		double founding_time = sim_.TreeSeqParentalTime();
+		
+		for (Genome &genome : new_subpop->parent_genomes_)
+			tree_seq->AddNode(genome, founding_time, p_subpop_id);
+	}
+	
 	return new_subpop;
 }
 
@@ -180,6 +217,10 @@ Subpopulation *Population::AddSubpopulation(slim_objectid_t p_subpop_id, Subpopu
 	// then draw parents from the source population according to fitness, obeying the new subpop's sex ratio
 	Subpopulation &subpop = *new_subpop;
 	
+	// the new genomes are clones of their source genomes in the tree sequence; see TreeSequence::NextSplitTime()
+	TreeSequence *tree_seq = sim_.TreeSeq();
+	double split_time = (tree_seq ? tree_seq->NextSplitTime(sim_.TreeSeqParentalTime()) : 0.0);
+	
 	for (slim_popsize_t parent_index = 0; parent_index < subpop.parent_subpop_size_; parent_index++)
 	{
 		// draw individual from p_source_subpop and assign to be a parent in subpop
@@ -199,6 +240,18 @@ Subpopulation *Population::AddSubpopulation(slim_objectid_t p_subpop_id, Subpopu
 		
 		subpop.parent_genomes_[2 * parent_index].copy_from_genome(p_source_subpop.parent_genomes_[2 * migrant_index]);
 		subpop.parent_genomes_[2 * parent_index + 1].copy_from_genome(p_source_subpop.parent_genomes_[2 * migrant_index + 1]);
+		
+		if (tree_seq)
+		{
+			for (int genome_offset = 0; genome_offset <= 1; ++genome_offset)
+			{
+				Genome &genome = subpop.parent_genomes_[2 * parent_index + genome_offset];
+				slim_treenodeid_t node = tree_seq->AddNode(genome, split_time, p_subpop_id);
+				
+				if (!genome.IsNull())
+					tree_seq->AddClonalEdge(node, p_source_subpop.parent_genomes_[2 * migrant_index + genome_offset]);
+			}
+		}
 	}
 	
 	// UpdateFitness() is not called here - all fitnesses are kept as equal.  This is because the parents were drawn from the source subpopulation according
@@ -288,7 +341,7 @@ void Population::ExecuteScript(SLiMEidosBlock *p_script_block, slim_generation_t
 // apply mateChoice() callbacks to a mating event with a chosen first parent; the return is the second parent index, or -1 to force a redraw
 slim_popsize_t Population::ApplyMateChoiceCallbacks(slim_popsize_t p_parent1_index, Subpopulation *p_subpop, Subpopulation *p_source_subpop, std::vector<SLiMEidosBlock*> &p_mate_choice_callbacks)
 {
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_START();
 #endif
@@ -460,7 +513,7 @@ slim_popsize_t Population::ApplyMateChoiceCallbacks(slim_popsize_t p_parent1_ind
 				if (weights_modified)
 					free(current_weights);
 				
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 				// PROFILING
 				SLIM_PROFILE_BLOCK_END(sim_.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosMateChoiceCallback)]);
 #endif
@@ -484,7 +537,7 @@ slim_popsize_t Population::ApplyMateChoiceCallbacks(slim_popsize_t p_parent1_ind
 				EIDOS_TERMINATION << "ERROR (Population::ApplyMateChoiceCallbacks): second parent chosen by mateChoice() callback is female." << EidosTerminate(last_interventionist_mate_choice_callback->identifier_token_);
 		}
 		
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 		SLIM_PROFILE_BLOCK_END(sim_.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosMateChoiceCallback)]);
 #endif
@@ -529,7 +582,7 @@ slim_popsize_t Population::ApplyMateChoiceCallbacks(slim_popsize_t p_parent1_ind
 			if (weights_modified)
 				free(current_weights);
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_END(sim_.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosMateChoiceCallback)]);
 #endif
@@ -601,7 +654,7 @@ slim_popsize_t Population::ApplyMateChoiceCallbacks(slim_popsize_t p_parent1_ind
 				EIDOS_TERMINATION << "ERROR (Population::ApplyMateChoiceCallbacks): second parent chosen by mateChoice() callback is female." << EidosTerminate(last_interventionist_mate_choice_callback->identifier_token_);
 		}
 		
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 		SLIM_PROFILE_BLOCK_END(sim_.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosMateChoiceCallback)]);
 #endif
@@ -609,7 +662,7 @@ slim_popsize_t Population::ApplyMateChoiceCallbacks(slim_popsize_t p_parent1_ind
 		return drawn_parent;
 	}
 	
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_END(sim_.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosMateChoiceCallback)]);
 #endif
@@ -621,7 +674,7 @@ slim_popsize_t Population::ApplyMateChoiceCallbacks(slim_popsize_t p_parent1_ind
 // apply modifyChild() callbacks to a generated child; a return of false means "do not use this child, generate a new one"
 bool Population::ApplyModifyChildCallbacks(slim_popsize_t p_child_index, IndividualSex p_child_sex, slim_popsize_t p_parent1_index, slim_popsize_t p_parent2_index, bool p_is_selfing, bool p_is_cloning, Subpopulation *p_subpop, Subpopulation *p_source_subpop, std::vector<SLiMEidosBlock*> &p_modify_child_callbacks)
 {
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_START();
 #endif
@@ -734,7 +787,7 @@ bool Population::ApplyModifyChildCallbacks(slim_popsize_t p_child_index, Individ
 				// If this callback told us not to generate the child, we do not call the rest of the callback chain; we're done
 				if (!generate_child)
 				{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 					// PROFILING
 					SLIM_PROFILE_BLOCK_END(sim_.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosModifyChildCallback)]);
 #endif
@@ -752,7 +805,7 @@ bool Population::ApplyModifyChildCallbacks(slim_popsize_t p_child_index, Individ
 		}
 	}
 	
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_END(sim_.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosModifyChildCallback)]);
 #endif
@@ -1103,6 +1156,9 @@ void Population::EvolveSubpopulation(Subpopulation &p_subpop, const Chromosome &
 					{
 						if (!ApplyModifyChildCallbacks(child_index, child_sex, parent1, parent2, selfed, cloned, &p_subpop, &source_subpop, *modify_child_callbacks))
 						{
+							if (TreeSequence *tree_seq = sim_.TreeSeq())
+								tree_seq->RetractNodes(p_subpop.child_genomes_[2 * child_index].TreeNodeID());
+							
 							// The modifyChild() callbacks suppressed the child altogether; this is juvenile migrant mortality, basically, so
 							// we need to even change the source subpop for our next attempt.  In this case, however, we have no migration.
 							num_tries++;
@@ -1159,6 +1215,9 @@ void Population::EvolveSubpopulation(Subpopulation &p_subpop, const Chromosome &
 					{
 						if (!ApplyModifyChildCallbacks(child_count, IndividualSex::kHermaphrodite, parent1, parent2, false, false, &p_subpop, &source_subpop, *modify_child_callbacks))
 						{
+							if (TreeSequence *tree_seq = sim_.TreeSeq())
+								tree_seq->RetractNodes(p_subpop.child_genomes_[2 * child_count].TreeNodeID());
+							
 							num_tries++;
 							
 							if (num_tries > 1000000)
@@ -1461,6 +1520,9 @@ void Population::EvolveSubpopulation(Subpopulation &p_subpop, const Chromosome &
 				{
 					if (!ApplyModifyChildCallbacks(child_index, child_sex, parent1, parent2, selfed, cloned, &p_subpop, source_subpop, *modify_child_callbacks))
 					{
+						if (TreeSequence *tree_seq = sim_.TreeSeq())
+							tree_seq->RetractNodes(p_subpop.child_genomes_[2 * child_index].TreeNodeID());
+						
 						// The modifyChild() callbacks suppressed the child altogether; this is juvenile migrant mortality, basically, so
 						// we need to even change the source subpop for our next attempt, so that differential mortality between different
 						// migration sources leads to differential representation in the offspring generation – more offspring from the
@@ -1487,6 +1549,12 @@ void Population::EvolveSubpopulation(Subpopulation &p_subpop, const Chromosome &
 		// some setup overhead, including the gsl_ran_shuffle() call.  All code that accesses individuals within a subpopulation needs to be aware of
 		// the fact that the individuals might be in a non-random order, because of this code path.  BEWARE!
 		
+		// If we are generating offspring in parallel, parents are still drawn here, in order, on the main thread, but the calls to
+		// DoCrossoverMutation() and DoClonalMutation() are replaced by calls that plan the equivalent work, which is then done below
+		// by ExecuteReproductionTasks().  Since there are no callbacks, nothing can observe the child genomes in the meantime.
+		int thread_count = sim_.ThreadCount();
+		bool parallel_reproduction = (thread_count > 1);
+		
 		// We loop to generate females first (sex_index == 0) and males second (sex_index == 1).
 		// In nonsexual simulations number_of_sexes == 1 and this loops just once.
 		slim_popsize_t child_count = 0;	// counter over all subpop_size_ children
@@ -1546,50 +1614,76 @@ void Population::EvolveSubpopulation(Subpopulation &p_subpop, const Chromosome &
 					else if (cloning_fraction > 0)
 						number_to_clone = static_cast<slim_popsize_t>(gsl_ran_binomial(gEidos_rng, cloning_fraction, (unsigned int)migrants_to_generate));
 					
+					// All of the parents are drawn up front, in one tight loop per kind of parent, rather than interleaved with the generation
+					// of each child; the buffer holds the parents of cloned children, then the first parents of all other children, and then
+					// the second parents of the children that are neither selfed nor cloned, in the order in which the children are generated
+					slim_popsize_t number_to_outcross = migrants_to_generate - (number_to_self + number_to_clone);
+					
+					drawn_parents_.resize((size_t)migrants_to_generate + (size_t)number_to_outcross);
+					
+					slim_popsize_t *clone_parents = drawn_parents_.data();
+					slim_popsize_t *parents1 = clone_parents + number_to_clone;
+					slim_popsize_t *parents2 = parents1 + (migrants_to_generate - number_to_clone);
+					IndividualSex parent1_sex, parent2_sex;
+					
+					if (sex_enabled)
+					{
+						if (child_sex == IndividualSex::kFemale)
+							source_subpop.DrawFemaleParentsUsingFitness(number_to_clone, clone_parents);
+						else
+							source_subpop.DrawMaleParentsUsingFitness(number_to_clone, clone_parents);
+						
+						source_subpop.DrawFemaleParentsUsingFitness(migrants_to_generate - number_to_clone, parents1);
+						source_subpop.DrawMaleParentsUsingFitness(number_to_outcross, parents2);
+						parent1_sex = IndividualSex::kFemale;
+						parent2_sex = IndividualSex::kMale;
+					}
+					else
+					{
+						source_subpop.DrawParentsUsingFitness(migrants_to_generate + number_to_outcross, clone_parents);
+						parent1_sex = IndividualSex::kHermaphrodite;
+						parent2_sex = IndividualSex::kHermaphrodite;
+						
+						// the selfed children come first, so the second parent parents2[i] goes with the first parent parents1[number_to_self + i]
+						if (prevent_incidental_selfing)
+							for (slim_popsize_t parent_index = 0; parent_index < number_to_outcross; ++parent_index)
+								while (parents2[parent_index] == parents1[number_to_self + parent_index])
+									parents2[parent_index] = source_subpop.DrawParentUsingFitness();
+					}
+					
 					// generate all selfed, cloned, and autogamous offspring in one shared loop
 					slim_popsize_t migrant_count = 0;
 					
 					if ((number_to_self == 0) && (number_to_clone == 0))
 					{
-						// a simple loop for the base case with no selfing, no cloning, and no callbacks; we split into two cases by sex_enabled for maximal speed
-						if (sex_enabled)
+						// a simple loop for the base case with no selfing, no cloning, and no callbacks; we split into two cases by parallel_reproduction for maximal speed
+						if (parallel_reproduction)
 						{
-							while (migrant_count < migrants_to_generate)
+							for (; migrant_count < migrants_to_generate; ++migrant_count, ++child_count)
 							{
-								slim_popsize_t parent1 = source_subpop.DrawFemaleParentUsingFitness();
-								slim_popsize_t parent2 = source_subpop.DrawMaleParentUsingFitness();
+								slim_popsize_t parent1 = parents1[migrant_count];
+								slim_popsize_t parent2 = parents2[migrant_count];
 								
-								// recombination, gene-conversion, mutation
-								DoCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count, subpop_id, parent1, p_chromosome, p_generation, child_sex, IndividualSex::kFemale, nullptr);
-								DoCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count + 1, subpop_id, parent2, p_chromosome, p_generation, child_sex, IndividualSex::kMale, nullptr);
+								PlanCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count, subpop_id, parent1, child_sex, parent1_sex);
+								PlanCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count + 1, subpop_id, parent2, child_sex, parent2_sex);
 								
 								if (pedigrees_enabled)
 									p_subpop.child_individuals_[child_count].TrackPedigreeWithParents(source_subpop.parent_individuals_[parent1], source_subpop.parent_individuals_[parent2]);
-								
-								migrant_count++;
-								child_count++;
 							}
 						}
 						else
 						{
-							while (migrant_count < migrants_to_generate)
+							for (; migrant_count < migrants_to_generate; ++migrant_count, ++child_count)
 							{
-								slim_popsize_t parent1 = source_subpop.DrawParentUsingFitness();
-								slim_popsize_t parent2;
-								
-								do
-									parent2 = source_subpop.DrawParentUsingFitness();	// note this does not prohibit selfing!
-								while (prevent_incidental_selfing && (parent2 == parent1));
+								slim_popsize_t parent1 = parents1[migrant_count];
+								slim_popsize_t parent2 = parents2[migrant_count];
 								
 								// recombination, gene-conversion, mutation
-								DoCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count, subpop_id, parent1, p_chromosome, p_generation, child_sex, IndividualSex::kHermaphrodite, nullptr);
-								DoCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count + 1, subpop_id, parent2, p_chromosome, p_generation, child_sex, IndividualSex::kHermaphrodite, nullptr);
+								DoCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count, subpop_id, parent1, p_chromosome, p_generation, child_sex, parent1_sex, nullptr);
+								DoCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count + 1, subpop_id, parent2, p_chromosome, p_generation, child_sex, parent2_sex, nullptr);
 								
 								if (pedigrees_enabled)
 									p_subpop.child_individuals_[child_count].TrackPedigreeWithParents(source_subpop.parent_individuals_[parent1], source_subpop.parent_individuals_[parent2]);
-								
-								migrant_count++;
-								child_count++;
 							}
 						}
 					}
@@ -1600,66 +1694,54 @@ void Population::EvolveSubpopulation(Subpopulation &p_subpop, const Chromosome &
 						{
 							slim_popsize_t parent1, parent2;
 							
-							if (number_to_clone > 0)
+							if (migrant_count < number_to_clone)
 							{
-								if (sex_enabled)
-									parent1 = (child_sex == IndividualSex::kFemale) ? source_subpop.DrawFemaleParentUsingFitness() : source_subpop.DrawMaleParentUsingFitness();
-								else
-									parent1 = source_subpop.DrawParentUsingFitness();
+								parent1 = clone_parents[migrant_count];
 								
-								parent2 = parent1;
-								(void)parent2;		// tell the static analyzer that we know we just did a dead store
-								
-								--number_to_clone;
-								
-								DoClonalMutation(&p_subpop, &source_subpop, 2 * child_count, subpop_id, 2 * parent1, p_chromosome, p_generation, child_sex);
-								DoClonalMutation(&p_subpop, &source_subpop, 2 * child_count + 1, subpop_id, 2 * parent1 + 1, p_chromosome, p_generation, child_sex);
+								if (parallel_reproduction)
+								{
+									PlanClonalMutation(&p_subpop, &source_subpop, 2 * child_count, subpop_id, 2 * parent1, child_sex);
+									PlanClonalMutation(&p_subpop, &source_subpop, 2 * child_count + 1, subpop_id, 2 * parent1 + 1, child_sex);
+								}
+								else
+								{
+									DoClonalMutation(&p_subpop, &source_subpop, 2 * child_count, subpop_id, 2 * parent1, p_chromosome, p_generation, child_sex);
+									DoClonalMutation(&p_subpop, &source_subpop, 2 * child_count + 1, subpop_id, 2 * parent1 + 1, p_chromosome, p_generation, child_sex);
+								}
 								
 								if (pedigrees_enabled)
 									p_subpop.child_individuals_[child_count].TrackPedigreeWithParents(source_subpop.parent_individuals_[parent1], source_subpop.parent_individuals_[parent1]);
 							}
 							else
 							{
-								IndividualSex parent1_sex, parent2_sex;
+								slim_popsize_t parent_index = migrant_count - number_to_clone;
+								IndividualSex child_parent2_sex;
 								
-								if (sex_enabled)
+								parent1 = parents1[parent_index];
+								
+								if (parent_index < number_to_self)
 								{
-									parent1 = source_subpop.DrawFemaleParentUsingFitness();
-									parent1_sex = IndividualSex::kFemale;
+									parent2 = parent1;
+									child_parent2_sex = parent1_sex;
 								}
 								else
 								{
-									parent1 = source_subpop.DrawParentUsingFitness();
-									parent1_sex = IndividualSex::kHermaphrodite;
+									parent2 = parents2[parent_index - number_to_self];
+									child_parent2_sex = parent2_sex;
 								}
 								
-								if (number_to_self > 0)
+								// recombination, gene-conversion, mutation
+								if (parallel_reproduction)
 								{
-									parent2 = parent1;
-									parent2_sex = parent1_sex;
-									--number_to_self;
+									PlanCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count, subpop_id, parent1, child_sex, parent1_sex);
+									PlanCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count + 1, subpop_id, parent2, child_sex, child_parent2_sex);
 								}
 								else
 								{
-									if (sex_enabled)
-									{
-										parent2 = source_subpop.DrawMaleParentUsingFitness();
-										parent2_sex = IndividualSex::kMale;
-									}
-									else
-									{
-										do
-											parent2 = source_subpop.DrawParentUsingFitness();	// selfing possible!
-										while (prevent_incidental_selfing && (parent2 == parent1));
-										
-										parent2_sex = IndividualSex::kHermaphrodite;
-									}
+									DoCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count, subpop_id, parent1, p_chromosome, p_generation, child_sex, parent1_sex, nullptr);
+									DoCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count + 1, subpop_id, parent2, p_chromosome, p_generation, child_sex, child_parent2_sex, nullptr);
 								}
 								
-								// recombination, gene-conversion, mutation
-								DoCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count, subpop_id, parent1, p_chromosome, p_generation, child_sex, parent1_sex, nullptr);
-								DoCrossoverMutation(&p_subpop, &source_subpop, 2 * child_count + 1, subpop_id, parent2, p_chromosome, p_generation, child_sex, parent2_sex, nullptr);
-								
 								if (pedigrees_enabled)
 									p_subpop.child_individuals_[child_count].TrackPedigreeWithParents(source_subpop.parent_individuals_[parent1], source_subpop.parent_individuals_[parent2]);
 							}
@@ -1672,13 +1754,16 @@ void Population::EvolveSubpopulation(Subpopulation &p_subpop, const Chromosome &
 				}
 			}
 		}
+		
+		if (parallel_reproduction)
+			ExecuteReproductionTasks(p_subpop.subpopulation_id_, p_chromosome, p_generation, thread_count);
 	}
 }
 
 // apply recombination() callbacks to a generated child; a return of true means breakpoints were changed
 bool Population::ApplyRecombinationCallbacks(slim_popsize_t p_parent_index, Genome *p_genome1, Genome *p_genome2, Subpopulation *p_source_subpop, std::vector<slim_position_t> &p_crossovers, std::vector<slim_position_t> &p_gc_starts, std::vector<slim_position_t> &p_gc_ends, std::vector<SLiMEidosBlock*> &p_recombination_callbacks)
 {
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_START();
 #endif
@@ -1869,7 +1954,7 @@ bool Population::ApplyRecombinationCallbacks(slim_popsize_t p_parent_index, Geno
 		breakpoints_changed = true;
 	}
 	
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_END(sim_.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosRecombinationCallback)]);
 #endif
@@ -1877,40 +1962,14 @@ bool Population::ApplyRecombinationCallbacks(slim_popsize_t p_parent_index, Geno
 	return breakpoints_changed;
 }
 
-// generate a child genome from parental genomes, with recombination, gene conversion, and mutation
-void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_source_subpop, slim_popsize_t p_child_genome_index, slim_objectid_t p_source_subpop_id, slim_popsize_t p_parent_index, const Chromosome &p_chromosome, slim_generation_t p_generation, IndividualSex p_child_sex, IndividualSex p_parent_sex, std::vector<SLiMEidosBlock*> *p_recombination_callbacks)
+// Work out which parental strands a child genome may inherit from, given the genome types involved, which matters only when modeling
+// sex chromosomes; the meaning of use_only_strand_1 and do_swap is as described in DoCrossoverMutation(), which also uses this for
+// its error-checking.  This is shared with PlanCrossoverMutation(), so that both paths handle the degenerate cases identically.
+static void ResolveCrossoverStrands(GenomeType child_genome_type, IndividualSex p_child_sex, GenomeType parent1_genome_type, GenomeType parent2_genome_type, bool *p_use_only_strand_1, bool *p_do_swap)
 {
-	slim_popsize_t parent_genome_1_index = p_parent_index * 2;
-	slim_popsize_t parent_genome_2_index = parent_genome_1_index + 1;
-	
-	// child genome p_child_genome_index in subpopulation p_subpop_id is assigned outcome of cross-overs at breakpoints in all_breakpoints
-	// between parent genomes p_parent1_genome_index and p_parent2_genome_index from subpopulation p_source_subpop_id and new mutations added
-	// 
-	// example: all_breakpoints = (r1, r2)
-	// 
-	// mutations (      x < r1) assigned from p1
-	// mutations (r1 <= x < r2) assigned from p2
-	// mutations (r2 <= x     ) assigned from p1
-	
-	// A lot of the checks here are only on when DEBUG is defined.  They should absolutely never be hit; if they are, it indicates a flaw
-	// in SLiM's internal logic, not user error.  This method gets called a whole lot; every test makes a speed difference.  So disabling
-	// these checks seems to make sense.  Of course, if you want the checks on, just define DEBUG.
-	
-#ifdef DEBUG
-	if (p_child_sex == IndividualSex::kUnspecified)
-		EIDOS_TERMINATION << "ERROR (Population::DoCrossoverMutation): Child sex cannot be IndividualSex::kUnspecified." << EidosTerminate();
-#endif
-	
 	bool use_only_strand_1 = false;		// if true, we are in a case where crossover cannot occur, and we are to use only parent strand 1
 	bool do_swap = true;				// if true, we are to swap the parental strands at the beginning, either 50% of the time (if use_only_strand_1 is false), or always (if use_only_strand_1 is true – in other words, we are directed to use only strand 2)
 	
-	Genome &child_genome = p_subpop->child_genomes_[p_child_genome_index];
-	GenomeType child_genome_type = child_genome.Type();
-	Genome *parent_genome_1 = &(p_source_subpop->parent_genomes_[parent_genome_1_index]);
-	GenomeType parent1_genome_type = parent_genome_1->Type();
-	Genome *parent_genome_2 = &(p_source_subpop->parent_genomes_[parent_genome_2_index]);
-	GenomeType parent2_genome_type = parent_genome_2->Type();
-	
 	if (child_genome_type == GenomeType::kAutosome)
 	{
 		// If we're modeling autosomes, we can disregard p_child_sex entirely; we don't care whether we're modeling sexual or hermaphrodite individuals
@@ -1977,6 +2036,42 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 		}
 	}
 	
+	*p_use_only_strand_1 = use_only_strand_1;
+	*p_do_swap = do_swap;
+}
+
+// generate a child genome from parental genomes, with recombination, gene conversion, and mutation
+void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_source_subpop, slim_popsize_t p_child_genome_index, slim_objectid_t p_source_subpop_id, slim_popsize_t p_parent_index, const Chromosome &p_chromosome, slim_generation_t p_generation, IndividualSex p_child_sex, IndividualSex p_parent_sex, std::vector<SLiMEidosBlock*> *p_recombination_callbacks)
+{
+	slim_popsize_t parent_genome_1_index = p_parent_index * 2;
+	slim_popsize_t parent_genome_2_index = parent_genome_1_index + 1;
+	
+	// child genome p_child_genome_index in subpopulation p_subpop_id is assigned outcome of cross-overs at breakpoints in all_breakpoints
+	// between parent genomes p_parent1_genome_index and p_parent2_genome_index from subpopulation p_source_subpop_id and new mutations added
+	// 
+	// example: all_breakpoints = (r1, r2)
+	// 
+	// mutations (      x < r1) assigned from p1
+	// mutations (r1 <= x < r2) assigned from p2
+	// mutations (r2 <= x     ) assigned from p1
+	
+	// A lot of the checks here are only on when DEBUG is defined.  They should absolutely never be hit; if they are, it indicates a flaw
+	// in SLiM's internal logic, not user error.  This method gets called a whole lot; every test makes a speed difference.  So disabling
+	// these checks seems to make sense.  Of course, if you want the checks on, just define DEBUG.
+
+#ifdef DEBUG
+	if (p_child_sex == IndividualSex::kUnspecified)
+		EIDOS_TERMINATION << "ERROR (Population::DoCrossoverMutation): Child sex cannot be IndividualSex::kUnspecified." << EidosTerminate();
+#endif
+	
+	Genome &child_genome = p_subpop->child_genomes_[p_child_genome_index];
+	Genome *parent_genome_1 = &(p_source_subpop->parent_genomes_[parent_genome_1_index]);
+	Genome *parent_genome_2 = &(p_source_subpop->parent_genomes_[parent_genome_2_index]);
+	bool use_only_strand_1;		// if true, we are in a case where crossover cannot occur, and we are to use only parent strand 1
+	bool do_swap;				// if true, we are to swap the parental strands at the beginning, either 50% of the time (if use_only_strand_1 is false), or always (if use_only_strand_1 is true – in other words, we are directed to use only strand 2)
+	
+	ResolveCrossoverStrands(child_genome.Type(), p_child_sex, parent_genome_1->Type(), parent_genome_2->Type(), &use_only_strand_1, &do_swap);
+	
 	// swap strands in half of cases to assure random assortment (or in all cases, if use_only_strand_1 == true, meaning that crossover cannot occur)
 	if (do_swap && (use_only_strand_1 || Eidos_RandomBool(gEidos_rng)))
 	{
@@ -1985,6 +2080,10 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 		//std::swap(parent1_genome_type, parent2_genome_type);		// Not used below this point...
 	}
 	
+	// every child genome gets a node in the tree sequence, even a null one, so that a rejected child's nodes can be retracted
+	TreeSequence *tree_seq = sim_.TreeSeq();
+	slim_treenodeid_t child_node = (tree_seq ? tree_seq->AddNode(child_genome, p_generation, p_subpop->subpopulation_id_) : -1);
+	
 	// check for null cases
 	bool child_genome_null = child_genome.IsNull();
 #ifdef DEBUG
@@ -2035,7 +2134,7 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 	if (use_only_strand_1)
 	{
 		num_breakpoints = 0;
-		num_mutations = p_chromosome.DrawMutationCount(p_parent_sex);
+		num_mutations = p_chromosome.DrawMutationCount(gEidos_rng, p_parent_sex);
 		
 		// no call to recombination() callbacks here, since recombination is not possible
 		
@@ -2047,11 +2146,11 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 #ifdef USE_GSL_POISSON
 		// When using the GSL's poisson draw, we have to draw the mutation count and breakpoint count separately;
 		// the DrawMutationAndBreakpointCounts() method does not support USE_GSL_POISSON
-		num_mutations = p_chromosome.DrawMutationCount(p_parent_sex);
-		num_breakpoints = p_chromosome.DrawBreakpointCount(p_parent_sex);
+		num_mutations = p_chromosome.DrawMutationCount(gEidos_rng, p_parent_sex);
+		num_breakpoints = p_chromosome.DrawBreakpointCount(gEidos_rng, p_parent_sex);
 #else
 		// get both the number of mutations and the number of breakpoints here; this allows us to draw both jointly, super fast!
-		p_chromosome.DrawMutationAndBreakpointCounts(p_parent_sex, &num_mutations, &num_breakpoints);
+		p_chromosome.DrawMutationAndBreakpointCounts(gEidos_rng, p_parent_sex, &num_mutations, &num_breakpoints);
 #endif
 		
 		//std::cout << num_mutations << " mutations, " << num_breakpoints << " breakpoints" << std::endl;
@@ -2063,7 +2162,7 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 			std::vector<slim_position_t> crossovers, gc_starts, gc_ends;
 			
 			if (num_breakpoints)
-				p_chromosome.DrawBreakpoints_Detailed(p_parent_sex, num_breakpoints, crossovers, gc_starts, gc_ends);
+				p_chromosome.DrawBreakpoints_Detailed(gEidos_rng, p_parent_sex, num_breakpoints, crossovers, gc_starts, gc_ends);
 			
 			// next, apply the recombination callbacks
 			ApplyRecombinationCallbacks(p_parent_index, parent_genome_1, parent_genome_2, p_source_subpop, crossovers, gc_starts, gc_ends, *p_recombination_callbacks);
@@ -2090,7 +2189,7 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 		else if (num_breakpoints)
 		{
 			// just draw, sort, and unique breakpoints in the standard way
-			p_chromosome.DrawBreakpoints(p_parent_sex, num_breakpoints, all_breakpoints);
+			p_chromosome.DrawBreakpoints(gEidos_rng, p_parent_sex, num_breakpoints, all_breakpoints);
 			
 			all_breakpoints.emplace_back(p_chromosome.last_position_mutrun_ + 1);
 			std::sort(all_breakpoints.begin(), all_breakpoints.end());
@@ -2103,135 +2202,28 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 		}
 	}
 	
+	if (tree_seq)
+		tree_seq->AddCrossoverEdges(child_node, *parent_genome_1, *parent_genome_2, all_breakpoints.data(), (int)all_breakpoints.size());
+	
 	// mutations are usually rare, so let's streamline the case where none occur
 	if (num_mutations == 0)
 	{
-		if (num_breakpoints == 0)
-		{
-			//
-			// no mutations and no crossovers, so the child genome is just a copy of the parental genome
-			//
-			
-			child_genome.copy_from_genome(*parent_genome_1);
-		}
-		else
-		{
-			//
-			// no mutations, but we do have crossovers, so we just need to interleave the two parental genomes
-			//
-			
-			// start with a clean slate in the child genome
+		// if there are crossovers, start with a clean slate in the child genome; otherwise it is just a copy of the parental genome
+		if (all_breakpoints.size())
 			child_genome.clear_to_nullptr();
-			
-			Mutation *mut_block_ptr = gSLiM_Mutation_Block;
-			Genome *parent_genome = parent_genome_1;
-			int mutrun_length = child_genome.mutrun_length_;
-			int mutrun_count = child_genome.mutrun_count_;
-			int first_uncompleted_mutrun = 0;
-			int break_index_max = static_cast<int>(all_breakpoints.size());	// can be != num_breakpoints+1 due to gene conversion and dup removal!
-			
-			for (int break_index = 0; break_index < break_index_max; break_index++)
-			{
-				slim_position_t breakpoint = all_breakpoints[break_index];
-				int break_mutrun_index = breakpoint / mutrun_length;
-				
-				// Copy over mutation runs until we arrive at the run in which the breakpoint occurs
-				while (break_mutrun_index > first_uncompleted_mutrun)
-				{
-					child_genome.mutruns_[first_uncompleted_mutrun] = parent_genome->mutruns_[first_uncompleted_mutrun];
-					++first_uncompleted_mutrun;
-					
-					if (first_uncompleted_mutrun >= mutrun_count)
-						break;
-				}
-				
-				// Now we are supposed to process a breakpoint in first_uncompleted_mutrun; check whether that means we're done
-				if (first_uncompleted_mutrun >= mutrun_count)
-					break;
-				
-				// The break occurs to the left of the base position of the breakpoint; check whether that is between runs
-				if (breakpoint > break_mutrun_index * mutrun_length)
-				{
-					// The breakpoint occurs *inside* the run, so process the run by copying mutations and switching strands
-					int this_mutrun_index = first_uncompleted_mutrun;
-					const MutationIndex *parent1_iter		= parent_genome_1->mutruns_[this_mutrun_index]->begin_pointer_const();
-					const MutationIndex *parent2_iter		= parent_genome_2->mutruns_[this_mutrun_index]->begin_pointer_const();
-					const MutationIndex *parent1_iter_max	= parent_genome_1->mutruns_[this_mutrun_index]->end_pointer_const();
-					const MutationIndex *parent2_iter_max	= parent_genome_2->mutruns_[this_mutrun_index]->end_pointer_const();
-					const MutationIndex *parent_iter		= parent1_iter;
-					const MutationIndex *parent_iter_max	= parent1_iter_max;
-					MutationRun *child_mutrun = child_genome.WillCreateRun(this_mutrun_index);
-					
-					while (true)
-					{
-						// while there are still old mutations in the parent before the current breakpoint...
-						while (parent_iter != parent_iter_max)
-						{
-							MutationIndex current_mutation = *parent_iter;
-							
-							if ((mut_block_ptr + current_mutation)->position_ >= breakpoint)
-								break;
-							
-							// add the old mutation; no need to check for a duplicate here since the parental genome is already duplicate-free
-							child_mutrun->emplace_back(current_mutation);
-							
-							parent_iter++;
-						}
-						
-						// we have reached the breakpoint, so swap parents; we want the "current strand" variables to change, so no std::swap()
-						parent1_iter = parent2_iter;	parent1_iter_max = parent2_iter_max;	parent_genome_1 = parent_genome_2;
-						parent2_iter = parent_iter;		parent2_iter_max = parent_iter_max;		parent_genome_2 = parent_genome;
-						parent_iter = parent1_iter;		parent_iter_max = parent1_iter_max;		parent_genome = parent_genome_1;
-						
-						// skip over anything in the new parent that occurs prior to the breakpoint; it was not the active strand
-						while (parent_iter != parent_iter_max && (mut_block_ptr + *parent_iter)->position_ < breakpoint)
-							parent_iter++;
-						
-						// we have now handled the current breakpoint, so move on to the next breakpoint; advance the enclosing for loop here
-						break_index++;
-						
-						// if we just handled the last breakpoint, which is guaranteed to be at or beyond lastPosition+1, then we are done
-						if (break_index == break_index_max)
-							break;
-						
-						// otherwise, figure out the new breakpoint, and continue looping on the current mutation run, which needs to be finished
-						breakpoint = all_breakpoints[break_index];
-						break_mutrun_index = breakpoint / mutrun_length;
-						
-						// if the next breakpoint is outside this mutation run, then finish the run and break out
-						if (break_mutrun_index > this_mutrun_index)
-						{
-							while (parent_iter != parent_iter_max)
-								child_mutrun->emplace_back(*(parent_iter++));
-							
-							break_index--;	// the outer loop will want to handle the current breakpoint again at the mutation-run level
-							break;
-						}
-					}
-					
-					// We have completed this run
-					++first_uncompleted_mutrun;
-				}
-				else
-				{
-					// The breakpoint occurs *between* runs, so just switch parent strands and the breakpoint is handled
-					parent_genome_1 = parent_genome_2;
-					parent_genome_2 = parent_genome;
-					parent_genome = parent_genome_1;
-				}
-			}
-		}
+		
+		AssembleCrossoverGenome<false>(child_genome, parent_genome_1, parent_genome_2, all_breakpoints.data(), (int)all_breakpoints.size(), nullptr, nullptr, nullptr);
+		
+#if SLIM_INTERN_MUTATION_RUNS
+		if (all_breakpoints.size())
+			InternMutationRuns(child_genome);
+#endif
 	}
 	else
 	{
-		// we have at least one new mutation, so set up for that case (which splits into two cases below)
-		
 		// start with a clean slate in the child genome
 		child_genome.clear_to_nullptr();
 		
-		int mutrun_length = child_genome.mutrun_length_;
-		int mutrun_count = child_genome.mutrun_count_;
-		
 		// create vector with the mutations to be added
 		MutationRun &mutations_to_add = *MutationRun::NewMutationRun();		// take from shared pool of used objects;
 		
@@ -2246,29 +2238,337 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 			// we add the new mutation to the registry below, if the stacking policy says the mutation can actually be added
 		}
 		
-		Mutation *mut_block_ptr = gSLiM_Mutation_Block;
-		const MutationIndex *mutation_iter		= mutations_to_add.begin_pointer_const();
-		const MutationIndex *mutation_iter_max	= mutations_to_add.end_pointer_const();
-		
-		MutationIndex mutation_iter_mutation_index;
-		slim_position_t mutation_iter_pos;
-		
-		if (mutation_iter != mutation_iter_max) {
-			mutation_iter_mutation_index = *mutation_iter;
-			mutation_iter_pos = (mut_block_ptr + mutation_iter_mutation_index)->position_;
-		} else {
-			mutation_iter_mutation_index = -1;
-			mutation_iter_pos = SLIM_INF_BASE_POSITION;
-		}
-		
-		int mutation_mutrun_index = mutation_iter_pos / mutrun_length;
+		// interleave the parental genomes and the new mutations
+		AssembleCrossoverGenome<false>(child_genome, parent_genome_1, parent_genome_2, all_breakpoints.data(), (int)all_breakpoints.size(), mutations_to_add.begin_pointer_const(), mutations_to_add.end_pointer_const(), nullptr);
 		
-		Genome *parent_genome = parent_genome_1;
-		int first_uncompleted_mutrun = 0;
+		MutationRun::FreeMutationRun(&mutations_to_add);
 		
-		if (num_breakpoints == 0)
-		{
-			//
+#if SLIM_INTERN_MUTATION_RUNS
+		InternMutationRuns(child_genome);
+#endif
+	}
+	
+	// debugging check
+#if 0
+	for (int i = 0; i < child_genome.mutrun_count_; ++i)
+		if (child_genome.mutruns_[i].get() == nullptr)
+			EIDOS_TERMINATION << "ERROR (Population::DoCrossoverMutation): (internal error) null mutation run left at end of crossover-mutation." << EidosTerminate();
+#endif
+}
+
+void Population::DoClonalMutation(Subpopulation *p_subpop, Subpopulation *p_source_subpop, slim_popsize_t p_child_genome_index, slim_objectid_t p_source_subpop_id, slim_popsize_t p_parent_genome_index, const Chromosome &p_chromosome, slim_generation_t p_generation, IndividualSex p_child_sex)
+{
+#pragma unused(p_child_sex)
+#ifdef DEBUG
+	if (p_child_sex == IndividualSex::kUnspecified)
+		EIDOS_TERMINATION << "ERROR (Population::DoClonalMutation): Child sex cannot be IndividualSex::kUnspecified." << EidosTerminate();
+#endif
+	
+	Genome &child_genome = p_subpop->child_genomes_[p_child_genome_index];
+	GenomeType child_genome_type = child_genome.Type();
+	Genome *parent_genome = &(p_source_subpop->parent_genomes_[p_parent_genome_index]);
+	GenomeType parent_genome_type = parent_genome->Type();
+	
+	if (child_genome_type != parent_genome_type)
+		EIDOS_TERMINATION << "ERROR (Population::DoClonalMutation): Mismatch between parent and child genome types (type != type)." << EidosTerminate();
+	
+	// check for null cases
+	bool child_genome_null = child_genome.IsNull();
+	bool parent_genome_null = parent_genome->IsNull();
+	
+	if (child_genome_null != parent_genome_null)
+		EIDOS_TERMINATION << "ERROR (Population::DoClonalMutation): Mismatch between parent and child genome types (null != null)." << EidosTerminate();
+	
+	TreeSequence *tree_seq = sim_.TreeSeq();
+	slim_treenodeid_t child_node = (tree_seq ? tree_seq->AddNode(child_genome, p_generation, p_subpop->subpopulation_id_) : -1);
+	
+	if (child_genome_null)
+	{
+		// a null strand cannot mutate, so we are done
+		return;
+	}
+	
+	if (tree_seq)
+		tree_seq->AddClonalEdge(child_node, *parent_genome);
+	
+	// determine how many mutations and breakpoints we have
+	int num_mutations = p_chromosome.DrawMutationCount(gEidos_rng, p_child_sex);	// the parent sex is the same as the child sex
+	
+	// mutations are usually rare, so let's streamline the case where none occur
+	if (num_mutations == 0)
+	{
+		// no mutations, so the child genome is just a copy of the parental genome
+		child_genome.copy_from_genome(*parent_genome);
+	}
+	else
+	{
+		// start with a clean slate in the child genome
+		child_genome.clear_to_nullptr();
+		
+		// create vector with the mutations to be added
+		MutationRun &mutations_to_add = *MutationRun::NewMutationRun();		// take from shared pool of used objects;
+		
+		for (int k = 0; k < num_mutations; k++)
+		{
+			MutationIndex new_mutation = p_chromosome.DrawNewMutation(p_child_sex, p_source_subpop_id, p_generation);	// the parent sex is the same as the child sex
+			
+			mutations_to_add.insert_sorted_mutation(new_mutation);	// keeps it sorted; since few mutations are expected, this is fast
+			
+			// no need to worry about pure_neutral_ or all_pure_neutral_DFE_ here; the mutation is drawn from a registered genomic element type
+			// we can't handle the stacking policy here, since we don't yet know what the context of the new mutation will be; we do it below
+			// we add the new mutation to the registry below, if the stacking policy says the mutation can actually be added
+		}
+		
+		// interleave the new mutations into the parental genome
+		AssembleClonalGenome<false>(child_genome, parent_genome, mutations_to_add.begin_pointer_const(), mutations_to_add.end_pointer_const(), nullptr);
+		
+		MutationRun::FreeMutationRun(&mutations_to_add);
+		
+#if SLIM_INTERN_MUTATION_RUNS
+		InternMutationRuns(child_genome);
+#endif
+	}
+}
+
+#if SLIM_INTERN_MUTATION_RUNS
+// Look up each newly assembled run of a child genome in interned_mutruns_, and share an identical run in its place if one is found; otherwise
+// trim the run's buffers and add it to the table.  A new run is recognized by a use count of 1, since runs copied from a parent are shared with it.  The table does
+// not retain its runs, because use counts must match genome references for TallyMutationReferences(), so an entry might have been freed
+// since it was added (a use count of 0), or modified or reused with different contents; Identical() and UseCount() screen those out.
+// The table is emptied by SwapGenerations().
+void Population::InternMutationRuns(Genome &p_child_genome)
+{
+	int mutrun_count = p_child_genome.mutrun_count_;
+	
+	for (int run_index = 0; run_index < mutrun_count; ++run_index)
+	{
+		MutationRun *mutrun = p_child_genome.mutruns_[run_index].get();
+		
+		if (mutrun->UseCount() != 1)
+			continue;
+		
+		int64_t hash = mutrun->Hash();
+		auto range = interned_mutruns_.equal_range(hash);
+		MutationRun *identical_run = nullptr;
+		
+		for (auto hash_iter = range.first; hash_iter != range.second; ++hash_iter)
+		{
+			MutationRun *hash_run = hash_iter->second;
+			
+			if ((hash_run != mutrun) && (hash_run->UseCount() != 0) && mutrun->Identical(*hash_run))
+			{
+				identical_run = hash_run;
+				break;
+			}
+		}
+		
+		if (identical_run)
+		{
+			p_child_genome.mutruns_[run_index].reset(identical_run);		// frees mutrun
+		}
+		else
+		{
+			// this run is being kept, so trim its buffers if it was recycled from a larger run
+			mutrun->trim_buffers();
+			interned_mutruns_.emplace(hash, mutrun);
+		}
+	}
+}
+#endif
+
+// Helpers for AssembleCrossoverGenome() and AssembleClonalGenome().  In the parallel case these avoid touching any shared state: run
+// refcounts are left alone, new runs come from the calling thread's free list, and new mutations are recorded in the thread's state,
+// to be registered or disposed of later on the main thread; see ExecuteReproductionTasks().
+template <const bool f_parallel>
+static inline __attribute__((always_inline)) void _CopyParentalRun(Genome &p_child_genome, Genome *p_parent_genome, int p_run_index)
+{
+	if (f_parallel)
+		p_child_genome.copy_run_Unretained(p_run_index, *p_parent_genome);
+	else
+		p_child_genome.copy_run(p_run_index, *p_parent_genome);
+}
+
+template <const bool f_parallel>
+static inline __attribute__((always_inline)) MutationRun *_CreateChildRun(Genome &p_child_genome, int p_run_index, ReproductionThreadState *p_thread, int64_t &p_assembled_count)
+{
+	if (f_parallel)
+	{
+		p_thread->assembled_mutrun_count_++;
+		return p_child_genome.WillCreateRun_Unretained(p_run_index, p_thread->freed_mutation_runs_);
+	}
+	else
+	{
+		p_assembled_count++;
+		return p_child_genome.WillCreateRun(p_run_index);
+	}
+}
+
+template <const bool f_parallel>
+static inline __attribute__((always_inline)) void _RegisterNewMutation(MutationRun &p_registry, MutationIndex p_mutation, ReproductionThreadState *p_thread)
+{
+	if (f_parallel)
+		p_thread->accepted_mutations_.emplace_back(p_mutation);
+	else
+		p_registry.emplace_back(p_mutation);
+}
+
+template <const bool f_parallel>
+static inline __attribute__((always_inline)) void _DisposeRejectedMutation(MutationIndex p_mutation, ReproductionThreadState *p_thread)
+{
+	if (f_parallel)
+	{
+		p_thread->rejected_mutations_.emplace_back(p_mutation);
+	}
+	else
+	{
+		(gSLiM_Mutation_Block + p_mutation)->~Mutation();
+		SLiM_DisposeMutationToBlock(p_mutation);
+	}
+}
+
+// Assemble a child genome from its two parental strands, switching strands at each breakpoint and interleaving new mutations.  The
+// breakpoints must be sorted and uniqued, and must include the end breakpoint (or be empty, if no crossover occurs); the new mutations
+// must be sorted by position.  The child genome must already have been cleared to nullptr, unless it is simply to be copied from
+// parent_genome_1 (no breakpoints and no new mutations) in the serial case.
+template <const bool f_parallel>
+void Population::AssembleCrossoverGenome(Genome &p_child_genome, Genome *parent_genome_1, Genome *parent_genome_2, const slim_position_t *p_breakpoints, int p_breakpoint_count, const MutationIndex *mutation_iter, const MutationIndex *mutation_iter_max, ReproductionThreadState *p_thread)
+{
+	// mutations are usually rare, so let's streamline the case where none occur
+	if (mutation_iter == mutation_iter_max)
+	{
+		if (p_breakpoint_count == 0)
+		{
+			//
+			// no mutations and no crossovers, so the child genome is just a copy of the parental genome
+			//
+			
+			if (f_parallel)
+				p_child_genome.copy_from_genome_Unretained(*parent_genome_1);
+			else
+				p_child_genome.copy_from_genome(*parent_genome_1);
+		}
+		else
+		{
+			//
+			// no mutations, but we do have crossovers, so we just need to interleave the two parental genomes
+			//
+			
+			Genome *parent_genome = parent_genome_1;
+			int mutrun_length = p_child_genome.mutrun_length_;
+			int mutrun_count = p_child_genome.mutrun_count_;
+			int first_uncompleted_mutrun = 0;
+			int break_index_max = p_breakpoint_count;	// can be != num_breakpoints+1 due to gene conversion and dup removal!
+			
+			for (int break_index = 0; break_index < break_index_max; break_index++)
+			{
+				slim_position_t breakpoint = p_breakpoints[break_index];
+				int break_mutrun_index = breakpoint / mutrun_length;
+				
+				// Copy over mutation runs until we arrive at the run in which the breakpoint occurs
+				while (break_mutrun_index > first_uncompleted_mutrun)
+				{
+					_CopyParentalRun<f_parallel>(p_child_genome, parent_genome, first_uncompleted_mutrun);
+					++first_uncompleted_mutrun;
+					
+					if (first_uncompleted_mutrun >= mutrun_count)
+						break;
+				}
+				
+				// Now we are supposed to process a breakpoint in first_uncompleted_mutrun; check whether that means we're done
+				if (first_uncompleted_mutrun >= mutrun_count)
+					break;
+				
+				// The break occurs to the left of the base position of the breakpoint; check whether that is between runs
+				if (breakpoint > break_mutrun_index * mutrun_length)
+				{
+					// The breakpoint occurs *inside* the run, so process the run by copying mutations and switching strands
+					int this_mutrun_index = first_uncompleted_mutrun;
+					const MutationIndex *parent1_iter		= parent_genome_1->mutruns_[this_mutrun_index]->begin_pointer_const();
+					const MutationIndex *parent2_iter		= parent_genome_2->mutruns_[this_mutrun_index]->begin_pointer_const();
+					const MutationIndex *parent1_iter_max	= parent_genome_1->mutruns_[this_mutrun_index]->end_pointer_const();
+					const MutationIndex *parent2_iter_max	= parent_genome_2->mutruns_[this_mutrun_index]->end_pointer_const();
+					const MutationIndex *parent_iter		= parent1_iter;
+					const MutationIndex *parent_iter_max	= parent1_iter_max;
+					MutationRun *child_mutrun = _CreateChildRun<f_parallel>(p_child_genome, this_mutrun_index, p_thread, assembled_mutrun_count_);
+					
+					while (true)
+					{
+						// copy the old mutations in the parent before the current breakpoint; no need to check for duplicates here since the parental
+						// genome is already duplicate-free
+						const MutationIndex *parent_stop = SLiM_FirstMutationAtOrAfter(parent_iter, parent_iter_max, breakpoint);
+						
+						child_mutrun->emplace_back_bulk(parent_iter, parent_stop - parent_iter);
+						parent_iter = parent_stop;
+						
+						// we have reached the breakpoint, so swap parents; we want the "current strand" variables to change, so no std::swap()
+						parent1_iter = parent2_iter;	parent1_iter_max = parent2_iter_max;	parent_genome_1 = parent_genome_2;
+						parent2_iter = parent_iter;		parent2_iter_max = parent_iter_max;		parent_genome_2 = parent_genome;
+						parent_iter = parent1_iter;		parent_iter_max = parent1_iter_max;		parent_genome = parent_genome_1;
+						
+						// skip over anything in the new parent that occurs prior to the breakpoint; it was not the active strand
+						parent_iter = SLiM_FirstMutationAtOrAfter(parent_iter, parent_iter_max, breakpoint);
+						
+						// we have now handled the current breakpoint, so move on to the next breakpoint; advance the enclosing for loop here
+						break_index++;
+						
+						// if we just handled the last breakpoint, which is guaranteed to be at or beyond lastPosition+1, then we are done
+						if (break_index == break_index_max)
+							break;
+						
+						// otherwise, figure out the new breakpoint, and continue looping on the current mutation run, which needs to be finished
+						breakpoint = p_breakpoints[break_index];
+						break_mutrun_index = breakpoint / mutrun_length;
+						
+						// if the next breakpoint is outside this mutation run, then finish the run and break out
+						if (break_mutrun_index > this_mutrun_index)
+						{
+							child_mutrun->emplace_back_bulk(parent_iter, parent_iter_max - parent_iter);
+							
+							break_index--;	// the outer loop will want to handle the current breakpoint again at the mutation-run level
+							break;
+						}
+					}
+					
+					// We have completed this run
+					++first_uncompleted_mutrun;
+				}
+				else
+				{
+					// The breakpoint occurs *between* runs, so just switch parent strands and the breakpoint is handled
+					parent_genome_1 = parent_genome_2;
+					parent_genome_2 = parent_genome;
+					parent_genome = parent_genome_1;
+				}
+			}
+		}
+	}
+	else
+	{
+		// we have at least one new mutation, so set up for that case (which splits into two cases below)
+		int mutrun_length = p_child_genome.mutrun_length_;
+		int mutrun_count = p_child_genome.mutrun_count_;
+		
+		slim_position_t *position_block_ptr = gSLiM_Mutation_Positions;
+		MutationType **muttype_block_ptr = gSLiM_Mutation_Types;
+		MutationIndex mutation_iter_mutation_index;
+		slim_position_t mutation_iter_pos;
+		
+		if (mutation_iter != mutation_iter_max) {
+			mutation_iter_mutation_index = *mutation_iter;
+			mutation_iter_pos = position_block_ptr[mutation_iter_mutation_index];
+		} else {
+			mutation_iter_mutation_index = -1;
+			mutation_iter_pos = SLIM_INF_BASE_POSITION;
+		}
+		
+		int mutation_mutrun_index = mutation_iter_pos / mutrun_length;
+		
+		Genome *parent_genome = parent_genome_1;
+		int first_uncompleted_mutrun = 0;
+		
+		if (p_breakpoint_count == 0)
+		{
+			//
 			// mutations without breakpoints; we have to be careful here not to touch the second strand, because it could be null
 			//
 			
@@ -2277,7 +2577,7 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 				// Copy over mutation runs until we arrive at the run in which the mutation occurs
 				while (mutation_mutrun_index > first_uncompleted_mutrun)
 				{
-					child_genome.mutruns_[first_uncompleted_mutrun] = parent_genome->mutruns_[first_uncompleted_mutrun];
+					_CopyParentalRun<f_parallel>(p_child_genome, parent_genome, first_uncompleted_mutrun);
 					++first_uncompleted_mutrun;
 					
 					if (first_uncompleted_mutrun >= mutrun_count)
@@ -2291,42 +2591,34 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 				int this_mutrun_index = first_uncompleted_mutrun;
 				const MutationIndex *parent_iter		= parent_genome->mutruns_[this_mutrun_index]->begin_pointer_const();
 				const MutationIndex *parent_iter_max	= parent_genome->mutruns_[this_mutrun_index]->end_pointer_const();
-				MutationRun *child_mutrun = child_genome.WillCreateRun(this_mutrun_index);
+				MutationRun *child_mutrun = _CreateChildRun<f_parallel>(p_child_genome, this_mutrun_index, p_thread, assembled_mutrun_count_);
 				
 				// add any additional new mutations that occur before the end of the mutation run; there is at least one
 				do
 				{
 					// add any parental mutations that occur before or at the next new mutation's position
-					while (parent_iter != parent_iter_max)
-					{
-						MutationIndex current_mutation = *parent_iter;
-						slim_position_t current_mutation_pos = (mut_block_ptr + current_mutation)->position_;
-						
-						if (current_mutation_pos > mutation_iter_pos)
-							break;
-						
-						child_mutrun->emplace_back(current_mutation);
-						parent_iter++;
-					}
+					const MutationIndex *parent_stop = SLiM_FirstMutationAtOrAfter(parent_iter, parent_iter_max, mutation_iter_pos + 1);
+					
+					child_mutrun->emplace_back_bulk(parent_iter, parent_stop - parent_iter);
+					parent_iter = parent_stop;
 					
 					// add the new mutation, which might overlap with the last added old mutation
-					if (child_mutrun->enforce_stack_policy_for_addition((mut_block_ptr + mutation_iter_mutation_index)->position_, (mut_block_ptr + mutation_iter_mutation_index)->mutation_type_ptr_))
+					if (child_mutrun->enforce_stack_policy_for_addition(position_block_ptr[mutation_iter_mutation_index], muttype_block_ptr[mutation_iter_mutation_index]))
 					{
 						// The mutation was passed by the stacking policy, so we can add it to the child genome and the registry
 						child_mutrun->emplace_back(mutation_iter_mutation_index);
-						mutation_registry_.emplace_back(mutation_iter_mutation_index);
+						_RegisterNewMutation<f_parallel>(mutation_registry_, mutation_iter_mutation_index, p_thread);
 					}
 					else
 					{
 						// The mutation was rejected by the stacking policy, so we have to dispose of it
 						// We no longer delete mutation objects; instead, we remove them from our shared pool
-						(gSLiM_Mutation_Block + mutation_iter_mutation_index)->~Mutation();
-						SLiM_DisposeMutationToBlock(mutation_iter_mutation_index);
+						_DisposeRejectedMutation<f_parallel>(mutation_iter_mutation_index, p_thread);
 					}
 					
 					if (++mutation_iter != mutation_iter_max) {
 						mutation_iter_mutation_index = *mutation_iter;
-						mutation_iter_pos = (mut_block_ptr + mutation_iter_mutation_index)->position_;
+						mutation_iter_pos = position_block_ptr[mutation_iter_mutation_index];
 					} else {
 						mutation_iter_mutation_index = -1;
 						mutation_iter_pos = SLIM_INF_BASE_POSITION;
@@ -2337,8 +2629,7 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 				while (mutation_mutrun_index == this_mutrun_index);
 				
 				// finish up any parental mutations that come after the last new mutation in the mutation run
-				while (parent_iter != parent_iter_max)
-					child_mutrun->emplace_back(*(parent_iter++));
+				child_mutrun->emplace_back_bulk(parent_iter, parent_iter_max - parent_iter);
 				
 				// We have completed this run
 				++first_uncompleted_mutrun;
@@ -2353,14 +2644,9 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 			// mutations and crossovers; this is the most complex case
 			//
 			
-			// fix up the breakpoints vector; above we allow it to be completely empty, for maximal speed in the
-			// 0-mutation/0-breakpoint case, but here we need a defined end breakpoint, so we add it now if necessary
-			if (all_breakpoints.size() == 0)
-				all_breakpoints.emplace_back(p_chromosome.last_position_mutrun_ + 1);
-			
-			int break_index_max = static_cast<int>(all_breakpoints.size());	// can be != num_breakpoints+1 due to gene conversion and dup removal!
+			int break_index_max = p_breakpoint_count;	// can be != num_breakpoints+1 due to gene conversion and dup removal!
 			int break_index = 0;
-			slim_position_t breakpoint = all_breakpoints[break_index];
+			slim_position_t breakpoint = p_breakpoints[break_index];
 			int break_mutrun_index = breakpoint / mutrun_length;
 			
 			while (true)	// loop over breakpoints until we have handled the last one, which comes at the end
@@ -2370,7 +2656,7 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 					// Copy over mutation runs until we arrive at the run in which the mutation occurs
 					while (mutation_mutrun_index > first_uncompleted_mutrun)
 					{
-						child_genome.mutruns_[first_uncompleted_mutrun] = parent_genome->mutruns_[first_uncompleted_mutrun];
+						_CopyParentalRun<f_parallel>(p_child_genome, parent_genome, first_uncompleted_mutrun);
 						++first_uncompleted_mutrun;
 						
 						// We can't be done, since we have a mutation waiting to be placed, so we don't need to check
@@ -2383,7 +2669,7 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 					// Copy over mutation runs until we arrive at the run in which the breakpoint occurs
 					while (break_mutrun_index > first_uncompleted_mutrun)
 					{
-						child_genome.mutruns_[first_uncompleted_mutrun] = parent_genome->mutruns_[first_uncompleted_mutrun];
+						_CopyParentalRun<f_parallel>(p_child_genome, parent_genome, first_uncompleted_mutrun);
 						++first_uncompleted_mutrun;
 						
 						if (first_uncompleted_mutrun >= mutrun_count)
@@ -2405,7 +2691,7 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 						if (++break_index == break_index_max)
 							break;
 						
-						breakpoint = all_breakpoints[break_index];
+						breakpoint = p_breakpoints[break_index];
 						break_mutrun_index = breakpoint / mutrun_length;
 						
 						continue;
@@ -2414,7 +2700,7 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 				
 				// The event occurs *inside* the run, so process the run by copying mutations and switching strands
 				int this_mutrun_index = first_uncompleted_mutrun;
-				MutationRun *child_mutrun = child_genome.WillCreateRun(this_mutrun_index);
+				MutationRun *child_mutrun = _CreateChildRun<f_parallel>(p_child_genome, this_mutrun_index, p_thread, assembled_mutrun_count_);
 				const MutationIndex *parent1_iter		= parent_genome_1->mutruns_[this_mutrun_index]->begin_pointer_const();
 				const MutationIndex *parent1_iter_max	= parent_genome_1->mutruns_[this_mutrun_index]->end_pointer_const();
 				const MutationIndex *parent_iter		= parent1_iter;
@@ -2437,7 +2723,7 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 							while (parent_iter != parent_iter_max)
 							{
 								MutationIndex current_mutation = *parent_iter;
-								slim_position_t current_mutation_pos = (mut_block_ptr + current_mutation)->position_;
+								slim_position_t current_mutation_pos = position_block_ptr[current_mutation];
 								
 								if (current_mutation_pos >= breakpoint)
 									break;
@@ -2445,23 +2731,22 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 								// add any new mutations that occur before the parental mutation; we know the parental mutation is in this run, so these are too
 								while (mutation_iter_pos < current_mutation_pos)
 								{
-									if (child_mutrun->enforce_stack_policy_for_addition((mut_block_ptr + mutation_iter_mutation_index)->position_, (mut_block_ptr + mutation_iter_mutation_index)->mutation_type_ptr_))
+									if (child_mutrun->enforce_stack_policy_for_addition(position_block_ptr[mutation_iter_mutation_index], muttype_block_ptr[mutation_iter_mutation_index]))
 									{
 										// The mutation was passed by the stacking policy, so we can add it to the child genome and the registry
 										child_mutrun->emplace_back(mutation_iter_mutation_index);
-										mutation_registry_.emplace_back(mutation_iter_mutation_index);
+										_RegisterNewMutation<f_parallel>(mutation_registry_, mutation_iter_mutation_index, p_thread);
 									}
 									else
 									{
 										// The mutation was rejected by the stacking policy, so we have to dispose of it
 										// We no longer delete mutation objects; instead, we remove them from our shared pool
-										(gSLiM_Mutation_Block + mutation_iter_mutation_index)->~Mutation();
-										SLiM_DisposeMutationToBlock(mutation_iter_mutation_index);
+										_DisposeRejectedMutation<f_parallel>(mutation_iter_mutation_index, p_thread);
 									}
 									
 									if (++mutation_iter != mutation_iter_max) {
 										mutation_iter_mutation_index = *mutation_iter;
-										mutation_iter_pos = (mut_block_ptr + mutation_iter_mutation_index)->position_;
+										mutation_iter_pos = position_block_ptr[mutation_iter_mutation_index];
 									} else {
 										mutation_iter_mutation_index = -1;
 										mutation_iter_pos = SLIM_INF_BASE_POSITION;
@@ -2479,23 +2764,22 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 							// add any new mutations that occur before the breakpoint; for these we have to check that they fall within this mutation run
 							while ((mutation_iter_pos < breakpoint) && (mutation_mutrun_index == this_mutrun_index))
 							{
-								if (child_mutrun->enforce_stack_policy_for_addition((mut_block_ptr + mutation_iter_mutation_index)->position_, (mut_block_ptr + mutation_iter_mutation_index)->mutation_type_ptr_))
+								if (child_mutrun->enforce_stack_policy_for_addition(position_block_ptr[mutation_iter_mutation_index], muttype_block_ptr[mutation_iter_mutation_index]))
 								{
 									// The mutation was passed by the stacking policy, so we can add it to the child genome and the registry
 									child_mutrun->emplace_back(mutation_iter_mutation_index);
-									mutation_registry_.emplace_back(mutation_iter_mutation_index);
+									_RegisterNewMutation<f_parallel>(mutation_registry_, mutation_iter_mutation_index, p_thread);
 								}
 								else
 								{
 									// The mutation was rejected by the stacking policy, so we have to dispose of it
 									// We no longer delete mutation objects; instead, we remove them from our shared pool
-									(gSLiM_Mutation_Block + mutation_iter_mutation_index)->~Mutation();
-									SLiM_DisposeMutationToBlock(mutation_iter_mutation_index);
+									_DisposeRejectedMutation<f_parallel>(mutation_iter_mutation_index, p_thread);
 								}
 								
 								if (++mutation_iter != mutation_iter_max) {
 									mutation_iter_mutation_index = *mutation_iter;
-									mutation_iter_pos = (mut_block_ptr + mutation_iter_mutation_index)->position_;
+									mutation_iter_pos = position_block_ptr[mutation_iter_mutation_index];
 								} else {
 									mutation_iter_mutation_index = -1;
 									mutation_iter_pos = SLIM_INF_BASE_POSITION;
@@ -2515,15 +2799,14 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 							parent_iter = parent1_iter;		parent_iter_max = parent1_iter_max;		parent_genome = parent_genome_1;
 							
 							// skip over anything in the new parent that occurs prior to the breakpoint; it was not the active strand
-							while (parent_iter != parent_iter_max && (mut_block_ptr + *parent_iter)->position_ < breakpoint)
-								parent_iter++;
+							parent_iter = SLiM_FirstMutationAtOrAfter(parent_iter, parent_iter_max, breakpoint);
 							
 							// we have now handled the current breakpoint, so move on; if we just handled the last breakpoint, then we are done
 							if (++break_index == break_index_max)
 								break;
 							
 							// otherwise, figure out the new breakpoint, and continue looping on the current mutation run, which needs to be finished
-							breakpoint = all_breakpoints[break_index];
+							breakpoint = p_breakpoints[break_index];
 							break_mutrun_index = breakpoint / mutrun_length;
 						}
 						
@@ -2542,19 +2825,12 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 						
 						while (true)
 						{
-							// while there are still old mutations in the parent before the current breakpoint...
-							while (parent_iter != parent_iter_max)
-							{
-								MutationIndex current_mutation = *parent_iter;
-								
-								if ((mut_block_ptr + current_mutation)->position_ >= breakpoint)
-									break;
-								
-								// add the old mutation; no need to check for a duplicate here since the parental genome is already duplicate-free
-								child_mutrun->emplace_back(current_mutation);
-								
-								parent_iter++;
-							}
+							// copy the old mutations in the parent before the current breakpoint; no need to check for duplicates here since the parental
+							// genome is already duplicate-free
+							const MutationIndex *parent_stop = SLiM_FirstMutationAtOrAfter(parent_iter, parent_iter_max, breakpoint);
+							
+							child_mutrun->emplace_back_bulk(parent_iter, parent_stop - parent_iter);
+							parent_iter = parent_stop;
 							
 							// we have reached the breakpoint, so swap parents; we want the "current strand" variables to change, so no std::swap()
 							parent1_iter = parent2_iter;	parent1_iter_max = parent2_iter_max;	parent_genome_1 = parent_genome_2;
@@ -2562,22 +2838,20 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 							parent_iter = parent1_iter;		parent_iter_max = parent1_iter_max;		parent_genome = parent_genome_1;
 							
 							// skip over anything in the new parent that occurs prior to the breakpoint; it was not the active strand
-							while (parent_iter != parent_iter_max && (mut_block_ptr + *parent_iter)->position_ < breakpoint)
-								parent_iter++;
+							parent_iter = SLiM_FirstMutationAtOrAfter(parent_iter, parent_iter_max, breakpoint);
 							
 							// we have now handled the current breakpoint, so move on; if we just handled the last breakpoint, then we are done
 							if (++break_index == break_index_max)
 								break;
 							
 							// otherwise, figure out the new breakpoint, and continue looping on the current mutation run, which needs to be finished
-							breakpoint = all_breakpoints[break_index];
+							breakpoint = p_breakpoints[break_index];
 							break_mutrun_index = breakpoint / mutrun_length;
 							
 							// if the next breakpoint is outside this mutation run, then finish the run and break out
 							if (break_mutrun_index > this_mutrun_index)
 							{
-								while (parent_iter != parent_iter_max)
-									child_mutrun->emplace_back(*(parent_iter++));
+								child_mutrun->emplace_back_bulk(parent_iter, parent_iter_max - parent_iter);
 								
 								break;	// the outer loop will want to handle this breakpoint again at the mutation-run level
 							}
@@ -2601,36 +2875,28 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 					do
 					{
 						// add any parental mutations that occur before or at the next new mutation's position
-						while (parent_iter != parent_iter_max)
-						{
-							MutationIndex current_mutation = *parent_iter;
-							slim_position_t current_mutation_pos = (mut_block_ptr + current_mutation)->position_;
-							
-							if (current_mutation_pos > mutation_iter_pos)
-								break;
-							
-							child_mutrun->emplace_back(current_mutation);
-							parent_iter++;
-						}
+						const MutationIndex *parent_stop = SLiM_FirstMutationAtOrAfter(parent_iter, parent_iter_max, mutation_iter_pos + 1);
+						
+						child_mutrun->emplace_back_bulk(parent_iter, parent_stop - parent_iter);
+						parent_iter = parent_stop;
 						
 						// add the new mutation, which might overlap with the last added old mutation
-						if (child_mutrun->enforce_stack_policy_for_addition((mut_block_ptr + mutation_iter_mutation_index)->position_, (mut_block_ptr + mutation_iter_mutation_index)->mutation_type_ptr_))
+						if (child_mutrun->enforce_stack_policy_for_addition(position_block_ptr[mutation_iter_mutation_index], muttype_block_ptr[mutation_iter_mutation_index]))
 						{
 							// The mutation was passed by the stacking policy, so we can add it to the child genome and the registry
 							child_mutrun->emplace_back(mutation_iter_mutation_index);
-							mutation_registry_.emplace_back(mutation_iter_mutation_index);
+							_RegisterNewMutation<f_parallel>(mutation_registry_, mutation_iter_mutation_index, p_thread);
 						}
 						else
 						{
 							// The mutation was rejected by the stacking policy, so we have to dispose of it
 							// We no longer delete mutation objects; instead, we remove them from our shared pool
-							(gSLiM_Mutation_Block + mutation_iter_mutation_index)->~Mutation();
-							SLiM_DisposeMutationToBlock(mutation_iter_mutation_index);
+							_DisposeRejectedMutation<f_parallel>(mutation_iter_mutation_index, p_thread);
 						}
 						
 						if (++mutation_iter != mutation_iter_max) {
 							mutation_iter_mutation_index = *mutation_iter;
-							mutation_iter_pos = (mut_block_ptr + mutation_iter_mutation_index)->position_;
+							mutation_iter_pos = position_block_ptr[mutation_iter_mutation_index];
 						} else {
 							mutation_iter_mutation_index = -1;
 							mutation_iter_pos = SLIM_INF_BASE_POSITION;
@@ -2641,8 +2907,7 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 					while (mutation_mutrun_index == this_mutrun_index);
 					
 					// finish up any parental mutations that come after the last new mutation in the mutation run
-					while (parent_iter != parent_iter_max)
-						child_mutrun->emplace_back(*(parent_iter++));
+					child_mutrun->emplace_back_bulk(parent_iter, parent_iter_max - parent_iter);
 					
 					// We have completed this run
 					++first_uncompleted_mutrun;
@@ -2653,40 +2918,185 @@ void Population::DoCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_s
 				}
 			}
 		}
+	}
+
+}
+
+// Assemble a clonal child genome from its parental genome and a (possibly empty) set of new mutations, sorted by position.  In the
+// serial case (f_parallel == false) the child genome must already have been cleared to nullptr if there are new mutations; in the
+// parallel case it must always have been cleared, and the work on shared state is deferred to p_thread (see AssembleCrossoverGenome()).
+template <const bool f_parallel>
+void Population::AssembleClonalGenome(Genome &p_child_genome, Genome *p_parent_genome, const MutationIndex *mutation_iter, const MutationIndex *mutation_iter_max, ReproductionThreadState *p_thread)
+{
+	if (mutation_iter == mutation_iter_max)
+	{
+		// no mutations, so the child genome is just a copy of the parental genome
+		if (f_parallel)
+			p_child_genome.copy_from_genome_Unretained(*p_parent_genome);
+		else
+			p_child_genome.copy_from_genome(*p_parent_genome);
 		
-		MutationRun::FreeMutationRun(&mutations_to_add);
+		return;
 	}
 	
-	// debugging check
-#if 0
-	for (int i = 0; i < child_genome.mutrun_count_; ++i)
-		if (child_genome.mutruns_[i].get() == nullptr)
-			EIDOS_TERMINATION << "ERROR (Population::DoCrossoverMutation): (internal error) null mutation run left at end of crossover-mutation." << EidosTerminate();
+	// loop over mutation runs and either (1) copy the mutrun pointer from the parent, or (2) make a new mutrun by modifying that of the parent
+	slim_position_t *position_block_ptr = gSLiM_Mutation_Positions;
+	MutationType **muttype_block_ptr = gSLiM_Mutation_Types;
+	
+	int mutrun_count = p_child_genome.mutrun_count_;
+	int mutrun_length = p_child_genome.mutrun_length_;
+	
+	MutationIndex mutation_iter_mutation_index = *mutation_iter;
+	slim_position_t mutation_iter_pos = position_block_ptr[mutation_iter_mutation_index];
+	int mutation_iter_mutrun_index = mutation_iter_pos / mutrun_length;
+	
+	for (int run_index = 0; run_index < mutrun_count; ++run_index)
+	{
+		if (mutation_iter_mutrun_index > run_index)
+		{
+			// no mutations in this run, so just copy the run pointer
+			_CopyParentalRun<f_parallel>(p_child_genome, p_parent_genome, run_index);
+		}
+		else
+		{
+			// interleave the parental genome with the new mutations
+			MutationRun *child_run = _CreateChildRun<f_parallel>(p_child_genome, run_index, p_thread, assembled_mutrun_count_);
+			MutationRun *parent_run = p_parent_genome->mutruns_[run_index].get();
+			const MutationIndex *parent_iter		= parent_run->begin_pointer_const();
+			const MutationIndex *parent_iter_max	= parent_run->end_pointer_const();
+			
+			// while there is at least one new mutation left to place in this run... (which we know is true when we first reach here)
+			do
+			{
+				// copy the old mutations in the parent that are before or at the next new mutation; we know they are not already present,
+				// since mutations on the parent strand are already uniqued, and new mutations are, by definition, new and thus cannot
+				// match the existing mutations
+				const MutationIndex *parent_stop = SLiM_FirstMutationAtOrAfter(parent_iter, parent_iter_max, mutation_iter_pos + 1);
+				
+				child_run->emplace_back_bulk(parent_iter, parent_stop - parent_iter);
+				parent_iter = parent_stop;
+				
+				// while a new mutation in this run is before the next old mutation in the parent... (which we know is true when we first reach here)
+				slim_position_t parent_iter_pos = (parent_iter == parent_iter_max) ? (SLIM_INF_BASE_POSITION) : position_block_ptr[*parent_iter];
+				
+				do
+				{
+					// we know the mutation is not already present, since mutations on the parent strand are already uniqued,
+					// and new mutations are, by definition, new and thus cannot match the existing mutations
+					if (child_run->enforce_stack_policy_for_addition(mutation_iter_pos, muttype_block_ptr[mutation_iter_mutation_index]))
+					{
+						// The mutation was passed by the stacking policy, so we can add it to the child genome and the registry
+						child_run->emplace_back(mutation_iter_mutation_index);
+						_RegisterNewMutation<f_parallel>(mutation_registry_, mutation_iter_mutation_index, p_thread);
+					}
+					else
+					{
+						// The mutation was rejected by the stacking policy, so we have to dispose of it
+						// We no longer delete mutation objects; instead, we remove them from our shared pool
+						_DisposeRejectedMutation<f_parallel>(mutation_iter_mutation_index, p_thread);
+					}
+					
+					// move to the next mutation
+					mutation_iter++;
+					
+					if (mutation_iter == mutation_iter_max)
+					{
+						mutation_iter_mutation_index = -1;
+						mutation_iter_pos = SLIM_INF_BASE_POSITION;
+					}
+					else
+					{
+						mutation_iter_mutation_index = *mutation_iter;
+						mutation_iter_pos = position_block_ptr[mutation_iter_mutation_index];
+					}
+					
+					mutation_iter_mutrun_index = mutation_iter_pos / mutrun_length;
+					
+					// if we're out of new mutations for this run, transfer down to the simpler loop below
+					if (mutation_iter_mutrun_index != run_index)
+						goto noNewMutationsLeft;
+				}
+				while (mutation_iter_pos < parent_iter_pos);
+				
+				// at this point we know we have a new mutation to place in this run, but it falls after the next parental mutation, so we loop back
+			}
+			while (true);
+			
+			// complete the mutation run after all new mutations within this run have been placed
+		noNewMutationsLeft:
+			child_run->emplace_back_bulk(parent_iter, parent_iter_max - parent_iter);
+		}
+	}
+}
+
+// Plan the work of a DoCrossoverMutation() call, without recombination() callbacks, for later execution by ExecuteReproductionTasks().
+// Genome type mismatches are diagnosed here, on the main thread; the child genome is released here too, since its runs are shared.
+void Population::PlanCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_source_subpop, slim_popsize_t p_child_genome_index, slim_objectid_t p_source_subpop_id, slim_popsize_t p_parent_index, IndividualSex p_child_sex, IndividualSex p_parent_sex)
+{
+#ifdef DEBUG
+	if (p_child_sex == IndividualSex::kUnspecified)
+		EIDOS_TERMINATION << "ERROR (Population::PlanCrossoverMutation): Child sex cannot be IndividualSex::kUnspecified." << EidosTerminate();
 #endif
+	
+	Genome &child_genome = p_subpop->child_genomes_[p_child_genome_index];
+	Genome *parent_genome_1 = &(p_source_subpop->parent_genomes_[p_parent_index * 2]);
+	Genome *parent_genome_2 = &(p_source_subpop->parent_genomes_[p_parent_index * 2 + 1]);
+	bool use_only_strand_1, do_swap;
+	
+	ResolveCrossoverStrands(child_genome.Type(), p_child_sex, parent_genome_1->Type(), parent_genome_2->Type(), &use_only_strand_1, &do_swap);
+	
+	// the child's node in the tree sequence is added now, in the same order as DoCrossoverMutation() would; its edges are added
+	// by ExecuteReproductionTasks(), once the breakpoints are known
+	if (TreeSequence *tree_seq = sim_.TreeSeq())
+		tree_seq->AddNode(child_genome, sim_.Generation(), p_subpop->subpopulation_id_);
+	
+	// a null strand cannot cross over and cannot mutate, so there is nothing to do
+	if (child_genome.IsNull())
+		return;
+	
+	child_genome.clear_to_nullptr();
+	
+	ReproductionTask task;
+	
+	task.child_genome_ = &child_genome;
+	task.parent_genome_1_ = parent_genome_1;
+	task.parent_genome_2_ = parent_genome_2;
+	task.parent_sex_ = p_parent_sex;
+	task.source_subpop_id_ = p_source_subpop_id;
+	task.is_clonal_ = false;
+	task.use_only_strand_1_ = use_only_strand_1;
+	task.do_swap_ = do_swap;
+	task.num_mutations_ = 0;
+	task.breakpoints_start_ = 0;
+	task.breakpoints_count_ = 0;
+	task.mutations_start_ = 0;
+	
+	reproduction_tasks_.emplace_back(task);
 }
 
-void Population::DoClonalMutation(Subpopulation *p_subpop, Subpopulation *p_source_subpop, slim_popsize_t p_child_genome_index, slim_objectid_t p_source_subpop_id, slim_popsize_t p_parent_genome_index, const Chromosome &p_chromosome, slim_generation_t p_generation, IndividualSex p_child_sex)
+// Plan the work of a DoClonalMutation() call, for later execution by ExecuteReproductionTasks(); see PlanCrossoverMutation()
+void Population::PlanClonalMutation(Subpopulation *p_subpop, Subpopulation *p_source_subpop, slim_popsize_t p_child_genome_index, slim_objectid_t p_source_subpop_id, slim_popsize_t p_parent_genome_index, IndividualSex p_child_sex)
 {
-#pragma unused(p_child_sex)
 #ifdef DEBUG
 	if (p_child_sex == IndividualSex::kUnspecified)
-		EIDOS_TERMINATION << "ERROR (Population::DoClonalMutation): Child sex cannot be IndividualSex::kUnspecified." << EidosTerminate();
+		EIDOS_TERMINATION << "ERROR (Population::PlanClonalMutation): Child sex cannot be IndividualSex::kUnspecified." << EidosTerminate();
 #endif
 	
 	Genome &child_genome = p_subpop->child_genomes_[p_child_genome_index];
-	GenomeType child_genome_type = child_genome.Type();
 	Genome *parent_genome = &(p_source_subpop->parent_genomes_[p_parent_genome_index]);
-	GenomeType parent_genome_type = parent_genome->Type();
 	
-	if (child_genome_type != parent_genome_type)
-		EIDOS_TERMINATION << "ERROR (Population::DoClonalMutation): Mismatch between parent and child genome types (type != type)." << EidosTerminate();
+	if (child_genome.Type() != parent_genome->Type())
+		EIDOS_TERMINATION << "ERROR (Population::PlanClonalMutation): Mismatch between parent and child genome types (type != type)." << EidosTerminate();
 	
 	// check for null cases
 	bool child_genome_null = child_genome.IsNull();
 	bool parent_genome_null = parent_genome->IsNull();
 	
 	if (child_genome_null != parent_genome_null)
-		EIDOS_TERMINATION << "ERROR (Population::DoClonalMutation): Mismatch between parent and child genome types (null != null)." << EidosTerminate();
+		EIDOS_TERMINATION << "ERROR (Population::PlanClonalMutation): Mismatch between parent and child genome types (null != null)." << EidosTerminate();
+	
+	if (TreeSequence *tree_seq = sim_.TreeSeq())
+		tree_seq->AddNode(child_genome, sim_.Generation(), p_subpop->subpopulation_id_);
 	
 	if (child_genome_null)
 	{
@@ -2694,132 +3104,273 @@ void Population::DoClonalMutation(Subpopulation *p_subpop, Subpopulation *p_sour
 		return;
 	}
 	
-	// determine how many mutations and breakpoints we have
-	int num_mutations = p_chromosome.DrawMutationCount(p_child_sex);	// the parent sex is the same as the child sex
+	child_genome.clear_to_nullptr();
 	
-	// mutations are usually rare, so let's streamline the case where none occur
-	if (num_mutations == 0)
+	ReproductionTask task;
+	
+	task.child_genome_ = &child_genome;
+	task.parent_genome_1_ = parent_genome;
+	task.parent_genome_2_ = nullptr;
+	task.parent_sex_ = p_child_sex;		// the parent sex is the same as the child sex
+	task.source_subpop_id_ = p_source_subpop_id;
+	task.is_clonal_ = true;
+	task.use_only_strand_1_ = true;
+	task.do_swap_ = false;
+	task.num_mutations_ = 0;
+	task.breakpoints_start_ = 0;
+	task.breakpoints_count_ = 0;
+	task.mutations_start_ = 0;
+	
+	reproduction_tasks_.emplace_back(task);
+}
+
+// Carry out the tasks planned by PlanCrossoverMutation() / PlanClonalMutation(), split into p_thread_count contiguous blocks.  This
+// happens in four phases.  (1) In parallel, each block draws a plan for its tasks from its own random number stream (strand swaps,
+// mutation and breakpoint counts, sorted breakpoints, and sorted new mutation positions), and assembles the child genomes that receive
+// no new mutations, which is the great majority of them.  (2) On the main thread, new mutations are made at the planned positions, in
+// task order; this can allocate in the mutation block and can call out to Eidos for script-based DFEs, so it cannot be done in parallel.  (3) In parallel, the remaining child genomes are assembled.  (4) On the
+// main thread, the new child genomes retain their runs, and new mutations are registered or disposed of.  The division into blocks
+// depends only on p_thread_count, so a given seed and thread count always produce the same result, even without OpenMP.
+void Population::ExecuteReproductionTasks(slim_objectid_t p_subpop_id, const Chromosome &p_chromosome, slim_generation_t p_generation, int p_thread_count)
+{
+	int64_t task_count = (int64_t)reproduction_tasks_.size();
+	ReproductionTask *tasks = reproduction_tasks_.data();
+	
+	// set up per-block state; the random number streams are keyed by a draw from gEidos_rng (taken here, on the main thread), mixed
+	// with the generation and subpopulation, and each block gets its own non-overlapping stream.  Drawing the key means that the
+	// streams follow the state of gEidos_rng, as single-threaded runs do; re-running a generation after readFromPopulationFile(),
+	// for example, gives new draws each time rather than replaying the same ones.
+	uint64_t stream_draw = ((uint64_t)gsl_rng_get(gEidos_rng) << 32) | (uint64_t)gsl_rng_get(gEidos_rng);
+	uint64_t stream_key = Eidos_RNGStreamKey(stream_draw, (uint64_t)p_generation, (uint64_t)p_subpop_id);
+	
+	while ((int)reproduction_threads_.size() < p_thread_count)
+		reproduction_threads_.emplace_back(new ReproductionThreadState());
+	
+	std::vector<MutationRun *> &shared_free_runs = MutationRun::s_freed_mutation_runs_;
+	size_t free_run_share = shared_free_runs.size() / p_thread_count;
+	
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
 	{
-		// no mutations, so the child genome is just a copy of the parental genome
-		child_genome.copy_from_genome(p_source_subpop->parent_genomes_[p_parent_genome_index]);
+		ReproductionThreadState &thread_state = *reproduction_threads_[thread_index];
+		
+		Eidos_SeedRNGStream(&thread_state.rng_, stream_key, thread_index);
+		
+		// give each block an equal share of the free MutationRun objects, so that runs get recycled without locking
+		thread_state.freed_mutation_runs_.insert(thread_state.freed_mutation_runs_.end(), shared_free_runs.end() - free_run_share, shared_free_runs.end());
+		shared_free_runs.resize(shared_free_runs.size() - free_run_share);
 	}
-	else
+	
+	ReproductionThreadState **threads = reproduction_threads_.data();
+	
+	// phase 1 (parallel): each block makes the draw plan for all of its tasks, in batches, into flat arrays: first strand swaps and counts,
+	// then breakpoints, then the positions of new mutations.  It then assembles the child genomes that receive no new mutations, the great
+	// majority of them, in a separate pass that just reads the plan.
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
 	{
-		// start with a clean slate in the child genome
-		child_genome.clear_to_nullptr();
+		ReproductionThreadState &thread_state = *threads[thread_index];
+		std::vector<slim_position_t> &breakpoints = thread_state.breakpoints_;
+		std::vector<PlannedMutation> &planned_mutations = thread_state.planned_mutations_;
+		int64_t task_start = (task_count * thread_index) / p_thread_count;
+		int64_t task_end = (task_count * (thread_index + 1)) / p_thread_count;
 		
-		// create vector with the mutations to be added
-		MutationRun &mutations_to_add = *MutationRun::NewMutationRun();		// take from shared pool of used objects;
+		gsl_rng *rng = thread_state.rng_.gsl_rng_;
 		
-		for (int k = 0; k < num_mutations; k++)
+		// draw strand swaps, mutation counts, and breakpoint counts
+		for (int64_t task_index = task_start; task_index < task_end; ++task_index)
 		{
-			MutationIndex new_mutation = p_chromosome.DrawNewMutation(p_child_sex, p_source_subpop_id, p_generation);	// the parent sex is the same as the child sex
+			ReproductionTask &task = tasks[task_index];
+			int num_mutations, num_breakpoints = 0;
 			
-			mutations_to_add.insert_sorted_mutation(new_mutation);	// keeps it sorted; since few mutations are expected, this is fast
+			if (task.is_clonal_)
+			{
+				num_mutations = p_chromosome.DrawMutationCount(rng, task.parent_sex_);
+			}
+			else
+			{
+				// swap strands in half of cases to assure random assortment (or in all cases, if use_only_strand_1 == true, meaning use only strand 2)
+				if (task.do_swap_ && (task.use_only_strand_1_ || Eidos_RandomBool(&thread_state.rng_)))
+					std::swap(task.parent_genome_1_, task.parent_genome_2_);
+				
+				if (task.use_only_strand_1_)
+				{
+					num_mutations = p_chromosome.DrawMutationCount(rng, task.parent_sex_);
+				}
+				else
+				{
+#ifdef USE_GSL_POISSON
+					num_mutations = p_chromosome.DrawMutationCount(rng, task.parent_sex_);
+					num_breakpoints = p_chromosome.DrawBreakpointCount(rng, task.parent_sex_);
+#else
+					p_chromosome.DrawMutationAndBreakpointCounts(rng, task.parent_sex_, &num_mutations, &num_breakpoints);
+#endif
+				}
+			}
 			
-			// no need to worry about pure_neutral_ or all_pure_neutral_DFE_ here; the mutation is drawn from a registered genomic element type
-			// we can't handle the stacking policy here, since we don't yet know what the context of the new mutation will be; we do it below
-			// we add the new mutation to the registry below, if the stacking policy says the mutation can actually be added
+			task.num_mutations_ = num_mutations;
+			task.breakpoints_start_ = 0;
+			task.breakpoints_count_ = num_breakpoints;		// the number to draw; replaced below by the number actually used
 		}
 		
-		// loop over mutation runs and either (1) copy the mutrun pointer from the parent, or (2) make a new mutrun by modifying that of the parent
-		Mutation *mut_block_ptr = gSLiM_Mutation_Block;
-		
-		int mutrun_count = child_genome.mutrun_count_;
-		int mutrun_length = child_genome.mutrun_length_;
-		
-		const MutationIndex *mutation_iter		= mutations_to_add.begin_pointer_const();
-		const MutationIndex *mutation_iter_max	= mutations_to_add.end_pointer_const();
-		MutationIndex mutation_iter_mutation_index = *mutation_iter;
-		slim_position_t mutation_iter_pos = (mut_block_ptr + mutation_iter_mutation_index)->position_;
-		int mutation_iter_mutrun_index = mutation_iter_pos / mutrun_length;
-		
-		for (int run_index = 0; run_index < mutrun_count; ++run_index)
+		// draw breakpoints for each task, sorted and uniqued, with the end of the last mutation run appended as a sentinel
+		for (int64_t task_index = task_start; task_index < task_end; ++task_index)
 		{
-			if (mutation_iter_mutrun_index > run_index)
+			ReproductionTask &task = tasks[task_index];
+			
+			if (task.breakpoints_count_)
 			{
-				// no mutations in this run, so just copy the run pointer
-				child_genome.mutruns_[run_index] = parent_genome->mutruns_[run_index];
+				size_t breakpoints_start = breakpoints.size();
+				
+				p_chromosome.DrawBreakpoints(rng, task.parent_sex_, task.breakpoints_count_, breakpoints);
+				
+				breakpoints.emplace_back(p_chromosome.last_position_mutrun_ + 1);
+				std::sort(breakpoints.begin() + breakpoints_start, breakpoints.end());
+				breakpoints.erase(std::unique(breakpoints.begin() + breakpoints_start, breakpoints.end()), breakpoints.end());
+				
+				task.breakpoints_start_ = (int32_t)breakpoints_start;
+				task.breakpoints_count_ = (int32_t)(breakpoints.size() - breakpoints_start);
 			}
-			else
+		}
+		
+		// draw the positions of new mutations for each task, sorted by position; tasks with new mutations are deferred until phase 2
+		for (int64_t task_index = task_start; task_index < task_end; ++task_index)
+		{
+			ReproductionTask &task = tasks[task_index];
+			
+			if (task.num_mutations_)
 			{
-				// interleave the parental genome with the new mutations
-				MutationRun *child_run = child_genome.WillCreateRun(run_index);
-				MutationRun *parent_run = parent_genome->mutruns_[run_index].get();
-				const MutationIndex *parent_iter		= parent_run->begin_pointer_const();
-				const MutationIndex *parent_iter_max	= parent_run->end_pointer_const();
+				size_t mutations_start = planned_mutations.size();
 				
-				// while there is at least one new mutation left to place in this run... (which we know is true when we first reach here)
-				do
+				for (int k = 0; k < task.num_mutations_; k++)
 				{
-					// while an old mutation in the parent is before or at the next new mutation...
-					while ((parent_iter != parent_iter_max) && ((mut_block_ptr + *parent_iter)->position_ <= mutation_iter_pos))
-					{
-						// we know the mutation is not already present, since mutations on the parent strand are already uniqued,
-						// and new mutations are, by definition, new and thus cannot match the existing mutations
-						child_run->emplace_back(*parent_iter);
-						parent_iter++;
-					}
-					
-					// while a new mutation in this run is before the next old mutation in the parent... (which we know is true when we first reach here)
-					slim_position_t parent_iter_pos = (parent_iter == parent_iter_max) ? (SLIM_INF_BASE_POSITION) : (mut_block_ptr + *parent_iter)->position_;
-					
-					do
-					{
-						// we know the mutation is not already present, since mutations on the parent strand are already uniqued,
-						// and new mutations are, by definition, new and thus cannot match the existing mutations
-						if (child_run->enforce_stack_policy_for_addition(mutation_iter_pos, (mut_block_ptr + mutation_iter_mutation_index)->mutation_type_ptr_))
-						{
-							// The mutation was passed by the stacking policy, so we can add it to the child genome and the registry
-							child_run->emplace_back(mutation_iter_mutation_index);
-							mutation_registry_.emplace_back(mutation_iter_mutation_index);
-						}
-						else
-						{
-							// The mutation was rejected by the stacking policy, so we have to dispose of it
-							// We no longer delete mutation objects; instead, we remove them from our shared pool
-							(gSLiM_Mutation_Block + mutation_iter_mutation_index)->~Mutation();
-							SLiM_DisposeMutationToBlock(mutation_iter_mutation_index);
-						}
-						
-						// move to the next mutation
-						mutation_iter++;
-						
-						if (mutation_iter == mutation_iter_max)
-						{
-							mutation_iter_mutation_index = -1;
-							mutation_iter_pos = SLIM_INF_BASE_POSITION;
-						}
-						else
-						{
-							mutation_iter_mutation_index = *mutation_iter;
-							mutation_iter_pos = (mut_block_ptr + mutation_iter_mutation_index)->position_;
-						}
-						
-						mutation_iter_mutrun_index = mutation_iter_pos / mutrun_length;
-						
-						// if we're out of new mutations for this run, transfer down to the simpler loop below
-						if (mutation_iter_mutrun_index != run_index)
-							goto noNewMutationsLeft;
-					}
-					while (mutation_iter_pos < parent_iter_pos);
+					PlannedMutation planned_mutation;
 					
-					// at this point we know we have a new mutation to place in this run, but it falls after the next parental mutation, so we loop back
+					planned_mutation.position_ = p_chromosome.DrawNewMutationPosition(rng, task.parent_sex_, &planned_mutation.element_);
+					planned_mutations.emplace_back(planned_mutation);
 				}
-				while (true);
 				
-				// complete the mutation run after all new mutations within this run have been placed
-			noNewMutationsLeft:
-				while (parent_iter != parent_iter_max)
-				{
-					child_run->emplace_back(*parent_iter);
-					parent_iter++;
-				}
+				std::sort(planned_mutations.begin() + mutations_start, planned_mutations.end(), [](const PlannedMutation &a, const PlannedMutation &b) { return a.position_ < b.position_; });
+				
+				task.mutations_start_ = (int32_t)mutations_start;
+				thread_state.deferred_tasks_.emplace_back((int32_t)task_index);
 			}
 		}
 		
-		MutationRun::FreeMutationRun(&mutations_to_add);
+		// assemble the child genomes that receive no new mutations
+		for (int64_t task_index = task_start; task_index < task_end; ++task_index)
+		{
+			ReproductionTask &task = tasks[task_index];
+			
+			if (task.num_mutations_ == 0)
+			{
+				if (task.is_clonal_)
+					AssembleClonalGenome<true>(*task.child_genome_, task.parent_genome_1_, nullptr, nullptr, &thread_state);
+				else
+					AssembleCrossoverGenome<true>(*task.child_genome_, task.parent_genome_1_, task.parent_genome_2_, breakpoints.data() + task.breakpoints_start_, task.breakpoints_count_, nullptr, nullptr, &thread_state);
+			}
+		}
+	}
+	
+	// phase 2 (main thread): make the new mutations for the deferred tasks at their planned positions, in task order; since the positions
+	// are sorted, so are the mutations, and new_mutations_ ends up parallel to planned_mutations_
+	bool any_deferred = false;
+	
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+	{
+		ReproductionThreadState &thread_state = *threads[thread_index];
+		std::vector<MutationIndex> &new_mutations = thread_state.new_mutations_;
+		
+		for (int32_t task_index : thread_state.deferred_tasks_)
+		{
+			ReproductionTask &task = tasks[task_index];
+			const PlannedMutation *planned_mutations = thread_state.planned_mutations_.data() + task.mutations_start_;
+			
+			for (int k = 0; k < task.num_mutations_; k++)
+				new_mutations.emplace_back(p_chromosome.DrawNewMutationAtPosition(planned_mutations[k].position_, *planned_mutations[k].element_, task.source_subpop_id_, p_generation));
+			
+			any_deferred = true;
+		}
+	}
+	
+	// phase 3 (parallel): assemble the deferred child genomes
+	if (any_deferred)
+	{
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+		for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+		{
+			ReproductionThreadState &thread_state = *threads[thread_index];
+			
+			for (int32_t task_index : thread_state.deferred_tasks_)
+			{
+				ReproductionTask &task = tasks[task_index];
+				const MutationIndex *mutations = thread_state.new_mutations_.data() + task.mutations_start_;
+				
+				if (task.is_clonal_)
+					AssembleClonalGenome<true>(*task.child_genome_, task.parent_genome_1_, mutations, mutations + task.num_mutations_, &thread_state);
+				else
+					AssembleCrossoverGenome<true>(*task.child_genome_, task.parent_genome_1_, task.parent_genome_2_, thread_state.breakpoints_.data() + task.breakpoints_start_, task.breakpoints_count_, mutations, mutations + task.num_mutations_, &thread_state);
+			}
+		}
 	}
+	
+	// phase 4 (main thread): do all the work on shared state, in block order
+	TreeSequence *tree_seq = sim_.TreeSeq();
+	
+	for (int64_t task_index = 0; task_index < task_count; ++task_index)
+		tasks[task_index].child_genome_->RetainMutationRuns();
+	
+#if SLIM_INTERN_MUTATION_RUNS
+	for (int64_t task_index = 0; task_index < task_count; ++task_index)
+		InternMutationRuns(*tasks[task_index].child_genome_);
+#endif
+	
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+	{
+		ReproductionThreadState &thread_state = *threads[thread_index];
+		
+		// log the parentage of this block's child genomes in the tree sequence; their nodes were added when the tasks were planned
+		if (tree_seq)
+		{
+			int64_t task_start = (task_count * thread_index) / p_thread_count;
+			int64_t task_end = (task_count * (thread_index + 1)) / p_thread_count;
+			
+			for (int64_t task_index = task_start; task_index < task_end; ++task_index)
+			{
+				ReproductionTask &task = tasks[task_index];
+				slim_treenodeid_t child_node = task.child_genome_->TreeNodeID();
+				
+				if (task.is_clonal_)
+					tree_seq->AddClonalEdge(child_node, *task.parent_genome_1_);
+				else
+					tree_seq->AddCrossoverEdges(child_node, *task.parent_genome_1_, *task.parent_genome_2_, thread_state.breakpoints_.data() + task.breakpoints_start_, task.breakpoints_count_);
+			}
+		}
+		
+		// fold this block's work counter into ours, for SLiMSim's mutation run count optimization
+		assembled_mutrun_count_ += thread_state.assembled_mutrun_count_;
+		thread_state.assembled_mutrun_count_ = 0;
+		
+		for (MutationIndex new_mutation : thread_state.accepted_mutations_)
+			mutation_registry_.emplace_back(new_mutation);
+		
+		for (MutationIndex new_mutation : thread_state.rejected_mutations_)
+		{
+			(gSLiM_Mutation_Block + new_mutation)->~Mutation();
+			SLiM_DisposeMutationToBlock(new_mutation);
+		}
+		
+		shared_free_runs.insert(shared_free_runs.end(), thread_state.freed_mutation_runs_.begin(), thread_state.freed_mutation_runs_.end());
+		
+		thread_state.breakpoints_.clear();
+		thread_state.planned_mutations_.clear();
+		thread_state.deferred_tasks_.clear();
+		thread_state.new_mutations_.clear();
+		thread_state.accepted_mutations_.clear();
+		thread_state.rejected_mutations_.clear();
+		thread_state.freed_mutation_runs_.clear();
+	}
+	
+	reproduction_tasks_.clear();
 }
 
 #ifdef SLIMGUI
@@ -2939,15 +3490,7 @@ void Population::ValidateMutationFitnessCaches(void)
 	const MutationIndex *registry_iter_end = mutation_registry_.end_pointer_const();
 	
 	while (registry_iter != registry_iter_end)
-	{
-		MutationIndex mut_index = (*registry_iter++);
-		Mutation *mut = mut_block_ptr + mut_index;
-		slim_selcoeff_t sel_coeff = mut->selection_coeff_;
-		slim_selcoeff_t dom_coeff = mut->mutation_type_ptr_->dominance_coeff_;
-		
-		mut->cached_one_plus_sel_ = (slim_selcoeff_t)std::max(0.0, 1.0 + sel_coeff);
-		mut->cached_one_plus_dom_sel_ = (slim_selcoeff_t)std::max(0.0, 1.0 + dom_coeff * sel_coeff);
-	}
+		(mut_block_ptr + *registry_iter++)->CacheFitnessEffects();
 }
 
 void Population::RecalculateFitness(slim_generation_t p_generation)
@@ -3171,6 +3714,18 @@ void Population::RecalculateFitness(slim_generation_t p_generation)
 // Clear all parental genomes to use nullptr for their mutation runs, so they don't mess up our MutationRun refcounts
 void Population::ClearParentalGenomes(void)
 {
+#if SLIM_INCREMENTAL_TALLIES
+	// If carrying tallies forward across generations has not been paying off, end the tally epoch first, so that the parental runs
+	// do not untally themselves as they are freed; the next tally starts over instead.  Every so often we try carrying forward again.
+	if (!incremental_tally_enabled_)
+	{
+		if (++incremental_tally_skip_count_ >= SLIM_INCREMENTAL_TALLY_RETRY_INTERVAL)
+			incremental_tally_enabled_ = true;
+		else
+			++gSLiM_MutationRun_TallyEpoch;
+	}
+#endif
+	
 	for (const std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : *this)
 	{
 		Subpopulation *subpop = subpop_pair.second;
@@ -3309,6 +3864,12 @@ void Population::UniqueMutationRuns(void)
 	
 	if (total_final != total_mutruns - total_identical)
 		EIDOS_TERMINATION << "ERROR (Population::UniqueMutationRuns): (internal error) bookkeeping error in mutation run uniquing." << EidosTerminate();
+	
+#if SLIM_INCREMENTAL_TALLIES
+	// runs uniqued away have taken their contributions back out of the refcounts, so the cached tally is no longer valid
+	if (total_uniqued_away)
+		cached_tally_genome_count_ = 0;
+#endif
 }
 
 #ifndef __clang_analyzer__
@@ -3453,6 +4014,11 @@ void Population::SplitMutationRuns(int32_t p_new_mutrun_count)
 	
 	if (mutruns_buf)
 		free(mutruns_buf);
+	
+#if SLIM_INCREMENTAL_TALLIES
+	// the old runs will take their contributions back out of the refcounts as they are freed, so the cached tally is no longer valid
+	cached_tally_genome_count_ = 0;
+#endif
 }
 #else
 // the static analyzer has a lot of trouble understanding this method
@@ -3620,6 +4186,11 @@ void Population::JoinMutationRuns(int32_t p_new_mutrun_count)
 	
 	if (mutruns_buf)
 		free(mutruns_buf);
+	
+#if SLIM_INCREMENTAL_TALLIES
+	// the old runs will take their contributions back out of the refcounts as they are freed, so the cached tally is no longer valid
+	cached_tally_genome_count_ = 0;
+#endif
 }
 #else
 // the static analyzer has a lot of trouble understanding this method
@@ -3735,6 +4306,11 @@ void Population::SwapGenerations(void)
 	
 	// flip our flag to indicate that the good genomes are now in the parental generation, and the next child generation is ready to be produced
 	child_generation_valid_ = false;
+	
+#if SLIM_INTERN_MUTATION_RUNS
+	// runs interned during offspring generation are not shared with the next generation's offspring; most will soon be freed
+	interned_mutruns_.clear();
+#endif
 }
 
 // count the total number of times that each Mutation in the registry is referenced by a population, and return the maximum possible number of references (i.e. fixation)
@@ -3770,9 +4346,13 @@ slim_refcount_t Population::TallyMutationReferences(std::vector<Subpopulation*>
 	{
 		// When tallying just a subset of the subpops, we don't update the SLiMgui counts, nor do we update total_genome_count_
 		
-		// first zero out the refcounts in all registered Mutation objects
+		// first zero out the refcounts in all registered Mutation objects; this discards any incremental tallies
 		SLiM_ZeroRefcountBlock(mutation_registry_);
 		
+#if SLIM_INCREMENTAL_TALLIES
+		++gSLiM_MutationRun_TallyEpoch;
+#endif
+		
 		// then increment the refcounts through all pointers to Mutation in all genomes
 		slim_refcount_t *refcount_block_ptr = gSLiM_Mutation_Refcounts;
 		slim_refcount_t total_genome_count = 0;
@@ -3843,37 +4423,8 @@ slim_refcount_t Population::TallyMutationReferences(std::vector<Subpopulation*>
 		// To tally using MutationRun, the refcounts of all active MutationRun objects should add up to the same
 		// total as the total number of Genome objects being tallied across.  Otherwise, something is very wrong.
 #ifdef DEBUG
-		if (can_tally_runs)
-		{
-			slim_refcount_t total_genome_count = 0, tally_mutrun_ref_count = 0, total_mutrun_count = 0;
-			int64_t operation_id = ++gSLiM_MutationRun_OperationID;
-			
-			for (const std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : *this)
-			{
-				Subpopulation *subpop = subpop_pair.second;
-				
-				slim_popsize_t subpop_genome_count = (child_generation_valid_ ? 2 * subpop->child_subpop_size_ : 2 * subpop->parent_subpop_size_);
-				std::vector<Genome> &subpop_genomes = (child_generation_valid_ ? subpop->child_genomes_ : subpop->parent_genomes_);
-				
-				for (slim_popsize_t i = 0; i < subpop_genome_count; i++)							// child genomes
-				{
-					Genome &genome = subpop_genomes[i];
-					
-					if (!genome.IsNull())
-					{
-						subpop_genomes[i].TallyGenomeReferences(&tally_mutrun_ref_count, &total_mutrun_count, operation_id);
-						total_genome_count++;
-					}
-				}
-			}
-			
-			int mutrun_count = sim_.TheChromosome().mutrun_count_;
-			
-			if (total_genome_count * mutrun_count != tally_mutrun_ref_count)
-				EIDOS_TERMINATION << "ERROR (Population::TallyMutationReferences): (internal error) tally != total genome count." << EidosTerminate();
-			
-			//std::cout << "Total genomes / MutationRuns: " << total_genome_count << " / " << total_mutrun_count << std::endl;
-		}
+		if (can_tally_runs && !MutationRunUseCountsMatchGenomes())
+			EIDOS_TERMINATION << "ERROR (Population::TallyMutationReferences): (internal error) tally != total genome count." << EidosTerminate();
 #endif
 		
 		if (can_tally_runs)
@@ -3949,6 +4500,10 @@ slim_refcount_t Population::TallyMutationReferences(std::vector<Subpopulation*>
 #endif
 			SLiM_ZeroRefcountBlock(mutation_registry_);
 			
+#if SLIM_INCREMENTAL_TALLIES
+			++gSLiM_MutationRun_TallyEpoch;		// zeroing the refcounts discards any incremental tallies
+#endif
+			
 			// then increment the refcounts through all pointers to Mutation in all genomes
 			slim_refcount_t *refcount_block_ptr = gSLiM_Mutation_Refcounts;
 			
@@ -4061,59 +4616,331 @@ slim_refcount_t Population::TallyMutationReferences(std::vector<Subpopulation*>
 				const MutationIndex *registry_iter = mutation_registry_.begin_pointer_const();
 				const MutationIndex *registry_iter_end = mutation_registry_.end_pointer_const();
 				
-				while (registry_iter != registry_iter_end)
+				while (registry_iter != registry_iter_end)
+				{
+					MutationIndex mut_index = *registry_iter;
+					slim_refcount_t *refcount_ptr = refcount_block_ptr + mut_index;
+					const Mutation *mutation = mut_block_ptr + mut_index;
+					
+					mutation->gui_reference_count_ = *refcount_ptr;
+					registry_iter++;
+				}
+				
+				gui_total_genome_count = total_genome_count;
+			}
+			
+			gui_total_genome_count_ = gui_total_genome_count;
+#endif
+			
+			return total_genome_count;
+		}
+	}
+}
+
+// check that the use counts of the MutationRun objects in the current generation's genomes add up to the number of references to them from
+// those genomes, so that no other genomes refer to them; this is the condition for tallying mutations a whole MutationRun at a time, which
+// TallyMutationReferences() checks in DEBUG builds
+bool Population::MutationRunUseCountsMatchGenomes(void)
+{
+	slim_refcount_t total_genome_count = 0, tally_mutrun_ref_count = 0, total_mutrun_count = 0;
+	int64_t operation_id = ++gSLiM_MutationRun_OperationID;
+	
+	for (const std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : *this)
+	{
+		Subpopulation *subpop = subpop_pair.second;
+		
+		slim_popsize_t subpop_genome_count = (child_generation_valid_ ? 2 * subpop->child_subpop_size_ : 2 * subpop->parent_subpop_size_);
+		std::vector<Genome> &subpop_genomes = (child_generation_valid_ ? subpop->child_genomes_ : subpop->parent_genomes_);
+		
+		for (slim_popsize_t i = 0; i < subpop_genome_count; i++)
+		{
+			Genome &genome = subpop_genomes[i];
+			
+			if (!genome.IsNull())
+			{
+				genome.TallyGenomeReferences(&tally_mutrun_ref_count, &total_mutrun_count, operation_id);
+				total_genome_count++;
+			}
+		}
+	}
+	
+	int mutrun_count = sim_.TheChromosome().mutrun_count_;
+	
+	return (total_genome_count * mutrun_count == tally_mutrun_ref_count);
+}
+
+slim_refcount_t Population::TallyMutationReferences_FAST(void)
+{
+#if SLIM_INCREMENTAL_TALLIES
+	// carry the refcounts forward from the previous tally if possible; this also works as a full tally
+	return TallyMutationReferences_INCREMENTAL();
+#else
+	// first zero out the refcounts in all registered Mutation objects
+	SLiM_ZeroRefcountBlock(mutation_registry_);
+	
+	// then increment the refcounts through all pointers to Mutation in all genomes
+	slim_refcount_t total_genome_count = 0;
+	int64_t operation_id = ++gSLiM_MutationRun_OperationID;
+	int thread_count = sim_.ThreadCount();
+	
+	if (thread_count > 1)
+		return TallyMutationRunsInParallel(thread_count, operation_id, 0, nullptr, nullptr);
+	
+	for (const std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : *this)
+	{
+		Subpopulation *subpop = subpop_pair.second;
+		
+		// Particularly for SLiMgui, we need to be able to tally mutation references after the generations have been swapped, i.e.
+		// when the parental generation is active and the child generation is invalid.
+		slim_popsize_t subpop_genome_count = (child_generation_valid_ ? 2 * subpop->child_subpop_size_ : 2 * subpop->parent_subpop_size_);
+		std::vector<Genome> &subpop_genomes = (child_generation_valid_ ? subpop->child_genomes_ : subpop->parent_genomes_);
+		
+		for (slim_popsize_t i = 0; i < subpop_genome_count; i++)							// child genomes
+		{
+			Genome &genome = subpop_genomes[i];
+			
+			if (!genome.IsNull())
+			{
+				genome.TallyGenomeMutationReferences(operation_id);
+				total_genome_count++;	// count only non-null genomes to determine fixation
+			}
+		}
+	}
+	
+	return total_genome_count;
+#endif
+}
+
+// Tally the mutation runs of the current generation's genomes in parallel, for TallyMutationReferences_FAST() and _INCREMENTAL().
+// Each thread takes the same fraction of the genomes of each subpopulation.  A run shared by genomes in different blocks is claimed
+// by the first thread to swap p_operation_id into it, so that it is tallied only once; the claiming thread adds the run's contribution
+// into its own shard of refcounts, and the shards are then summed into gSLiM_Mutation_Refcounts in parallel, over blocks of mutation
+// indices.  The refcounts are integers, so the result does not depend upon which thread claims which run.  With incremental tallies,
+// the tally epoch is as in TallyMutationReferences_INCREMENTAL(), and the work done and the work a full tally would do are added to
+// *p_scanned_count and *p_total_count; otherwise p_tally_epoch is unused and those may be nullptr.
+slim_refcount_t Population::TallyMutationRunsInParallel(int p_thread_count, int64_t p_operation_id, int64_t p_tally_epoch, int64_t *p_scanned_count, int64_t *p_total_count)
+{
+	int64_t index_count = (int64_t)gSLiM_Mutation_Block_LastUsedIndex + 1;
+	
+	// the shards are kept zeroed between tallies, so they just need to grow to cover all mutation indices in use
+	if ((int)tally_shards_.size() < p_thread_count)
+		tally_shards_.resize(p_thread_count);
+	
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+		if ((int64_t)tally_shards_[thread_index].size() < index_count)
+			tally_shards_[thread_index].resize(index_count, 0);
+	
+	std::vector<Genome *> subpop_genomes;
+	std::vector<slim_popsize_t> subpop_genome_counts;
+	
+	for (const std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : *this)
+	{
+		Subpopulation *subpop = subpop_pair.second;
+		
+		subpop_genomes.emplace_back(child_generation_valid_ ? subpop->child_genomes_.data() : subpop->parent_genomes_.data());
+		subpop_genome_counts.emplace_back(child_generation_valid_ ? 2 * subpop->child_subpop_size_ : 2 * subpop->parent_subpop_size_);
+	}
+	
+	size_t subpop_count = subpop_genomes.size();
+	std::vector<slim_refcount_t> block_genome_counts(p_thread_count, 0);
+	std::vector<int64_t> block_scanned_counts(p_thread_count, 0);
+	std::vector<int64_t> block_total_counts(p_thread_count, 0);
+	
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+	{
+		slim_refcount_t *shard = tally_shards_[thread_index].data();
+		slim_refcount_t genome_count = 0;
+		int64_t scanned_count = 0, total_count = 0;
+		
+		for (size_t subpop_index = 0; subpop_index < subpop_count; ++subpop_index)
+		{
+			Genome *genomes = subpop_genomes[subpop_index];
+			int64_t subpop_genome_count = subpop_genome_counts[subpop_index];
+			int64_t genome_start = (subpop_genome_count * thread_index) / p_thread_count;
+			int64_t genome_end = (subpop_genome_count * (thread_index + 1)) / p_thread_count;
+			
+			for (int64_t genome_index = genome_start; genome_index < genome_end; ++genome_index)
+			{
+				Genome &genome = genomes[genome_index];
+				
+				if (genome.IsNull())
+					continue;
+				
+				int mutrun_count = genome.mutrun_count_;
+				
+				for (int run_index = 0; run_index < mutrun_count; ++run_index)
 				{
-					MutationIndex mut_index = *registry_iter;
-					slim_refcount_t *refcount_ptr = refcount_block_ptr + mut_index;
-					const Mutation *mutation = mut_block_ptr + mut_index;
+					MutationRun *mutrun = genome.mutruns_[run_index].get();
 					
-					mutation->gui_reference_count_ = *refcount_ptr;
-					registry_iter++;
+					// check before swapping, so that runs shared by every genome do not bounce between caches
+					if (__atomic_load_n(&mutrun->operation_id_, __ATOMIC_RELAXED) == p_operation_id)
+						continue;
+					if (__atomic_exchange_n(&mutrun->operation_id_, p_operation_id, __ATOMIC_RELAXED) == p_operation_id)
+						continue;
+					
+					slim_refcount_t use_count = (slim_refcount_t)mutrun->UseCount();
+					slim_refcount_t change = use_count;
+					
+#if SLIM_INCREMENTAL_TALLIES
+					if (mutrun->tally_epoch_ == p_tally_epoch)
+						change -= mutrun->tallied_use_count_;
+					
+					mutrun->tally_epoch_ = p_tally_epoch;
+					mutrun->tallied_use_count_ = use_count;
+#endif
+					total_count += mutrun->size();
+					
+					if (change)
+					{
+						const MutationIndex *mut_iter = mutrun->begin_pointer_const();
+						const MutationIndex *mut_end_iter = mutrun->end_pointer_const();
+						
+						while (mut_iter != mut_end_iter)
+							shard[*mut_iter++] += change;
+						
+						scanned_count += mutrun->size();
+					}
 				}
 				
-				gui_total_genome_count = total_genome_count;
+				genome_count++;		// count only non-null genomes to determine fixation
 			}
+		}
+		
+		block_genome_counts[thread_index] = genome_count;
+		block_scanned_counts[thread_index] = scanned_count;
+		block_total_counts[thread_index] = total_count;
+	}
+	
+	// sum the shards into the refcounts, zeroing them for next time
+	slim_refcount_t *refcount_block_ptr = gSLiM_Mutation_Refcounts;
+	std::vector<slim_refcount_t> *shards = tally_shards_.data();
+	
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+	{
+		int64_t index_start = (index_count * thread_index) / p_thread_count;
+		int64_t index_end = (index_count * (thread_index + 1)) / p_thread_count;
+		
+		for (int shard_index = 0; shard_index < p_thread_count; ++shard_index)
+		{
+			slim_refcount_t *shard = shards[shard_index].data();
 			
-			gui_total_genome_count_ = gui_total_genome_count;
-#endif
-			
-			return total_genome_count;
+			for (int64_t mut_index = index_start; mut_index < index_end; ++mut_index)
+			{
+				refcount_block_ptr[mut_index] += shard[mut_index];
+				shard[mut_index] = 0;
+			}
 		}
 	}
+	
+	slim_refcount_t total_genome_count = 0;
+	
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+	{
+		total_genome_count += block_genome_counts[thread_index];
+		
+		if (p_scanned_count)
+			*p_scanned_count += block_scanned_counts[thread_index];
+		if (p_total_count)
+			*p_total_count += block_total_counts[thread_index];
+	}
+	
+	return total_genome_count;
 }
 
-slim_refcount_t Population::TallyMutationReferences_FAST(void)
+#if SLIM_INCREMENTAL_TALLIES
+// Like TallyMutationReferences_FAST(), but carrying forward the refcounts from the previous tally instead of starting over.  Each
+// MutationRun remembers the use count it was tallied with; a run whose use count is unchanged, such as a run shared by every genome,
+// needs no work at all, and other runs add in only the change in their use count.  Runs freed or modified in place since the last
+// tally have already taken their old contributions back out (see MutationRun::untally_mutation_references()).  When most runs change
+// hands every generation, carrying tallies across generations costs more than a full tally, since the freed parental runs get scanned
+// too; we then start over in each generation for a while (see ClearParentalGenomes()), but still carry tallies forward within each
+// generation, for tallies requested by scripts.  Removing fixed mutations from runs in place does not disturb any of this, since the
+// refcounts of fixed mutations are dead.
+slim_refcount_t Population::TallyMutationReferences_INCREMENTAL(void)
 {
-	// first zero out the refcounts in all registered Mutation objects
-	SLiM_ZeroRefcountBlock(mutation_registry_);
+	bool from_scratch = (incremental_tally_epoch_ != gSLiM_MutationRun_TallyEpoch);
 	
-	// then increment the refcounts through all pointers to Mutation in all genomes
-	slim_refcount_t total_genome_count = 0;
+	if (from_scratch)
+	{
+		// the previous tally is gone, or was never made, so start a new epoch with all refcounts at zero
+		SLiM_ZeroRefcountBlock(mutation_registry_);
+		incremental_tally_epoch_ = ++gSLiM_MutationRun_TallyEpoch;
+	}
+	
+	int64_t tally_epoch = incremental_tally_epoch_;
 	int64_t operation_id = ++gSLiM_MutationRun_OperationID;
+	int64_t scanned_count = gSLiM_MutationRun_UntalliedCount;		// the work done so far, for runs that have untallied themselves
+	int64_t total_count = 0;										// the work a full tally would do
+	slim_refcount_t total_genome_count = 0;
 	
-	for (const std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : *this)
+	int thread_count = sim_.ThreadCount();
+	
+	if (thread_count > 1)
 	{
-		Subpopulation *subpop = subpop_pair.second;
-		
-		// Particularly for SLiMgui, we need to be able to tally mutation references after the generations have been swapped, i.e.
-		// when the parental generation is active and the child generation is invalid.
-		slim_popsize_t subpop_genome_count = (child_generation_valid_ ? 2 * subpop->child_subpop_size_ : 2 * subpop->parent_subpop_size_);
-		std::vector<Genome> &subpop_genomes = (child_generation_valid_ ? subpop->child_genomes_ : subpop->parent_genomes_);
-		
-		for (slim_popsize_t i = 0; i < subpop_genome_count; i++)							// child genomes
+		total_genome_count = TallyMutationRunsInParallel(thread_count, operation_id, tally_epoch, &scanned_count, &total_count);
+	}
+	else
+	{
+		for (const std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : *this)
 		{
-			Genome &genome = subpop_genomes[i];
+			Subpopulation *subpop = subpop_pair.second;
+			slim_popsize_t subpop_genome_count = (child_generation_valid_ ? 2 * subpop->child_subpop_size_ : 2 * subpop->parent_subpop_size_);
+			std::vector<Genome> &subpop_genomes = (child_generation_valid_ ? subpop->child_genomes_ : subpop->parent_genomes_);
 			
-			if (!genome.IsNull())
+			for (slim_popsize_t i = 0; i < subpop_genome_count; i++)
 			{
-				genome.TallyGenomeMutationReferences(operation_id);
-				total_genome_count++;	// count only non-null genomes to determine fixation
+				Genome &genome = subpop_genomes[i];
+				
+				if (!genome.IsNull())
+				{
+					int mutrun_count = genome.mutrun_count_;
+					
+					for (int run_index = 0; run_index < mutrun_count; ++run_index)
+					{
+						MutationRun *mutrun = genome.mutruns_[run_index].get();
+						
+						if (mutrun->operation_id_ != operation_id)
+						{
+							mutrun->operation_id_ = operation_id;
+							
+							slim_refcount_t use_count = (slim_refcount_t)mutrun->UseCount();
+							slim_refcount_t change = use_count;
+							
+							if (mutrun->tally_epoch_ == tally_epoch)
+								change -= mutrun->tallied_use_count_;
+							
+							mutrun->tally_epoch_ = tally_epoch;
+							mutrun->tallied_use_count_ = use_count;
+							total_count += mutrun->size();
+							
+							if (change)
+							{
+								mutrun->add_to_mutation_references(change);
+								scanned_count += mutrun->size();
+							}
+						}
+					}
+					
+					total_genome_count++;	// count only non-null genomes to determine fixation
+				}
 			}
 		}
 	}
 	
+	gSLiM_MutationRun_UntalliedCount = 0;
+	
+	if (!from_scratch && (scanned_count > total_count))
+	{
+		// This tally cost more than a full tally would have, so stop carrying tallies across generations for a while
+		incremental_tally_enabled_ = false;
+		incremental_tally_skip_count_ = 0;
+	}
+	
 	return total_genome_count;
 }
+#endif
 
 // handle negative fixation (remove from the registry) and positive fixation (convert to Substitution), using reference counts from TallyMutationReferences()
 // TallyMutationReferences() must have cached tallies across the whole population before this is called, or it will malfunction!
@@ -4257,6 +5084,7 @@ void Population::RemoveFixedMutations(void)
 			
 #if DEBUG_MUTATION_ZOMBIES
 			(gSLiM_Mutation_Block + mutation)->mutation_type_ptr_ = nullptr;	// render lethal
+			gSLiM_Mutation_Types[mutation] = nullptr;
 			(gSLiM_Mutation_Block + mutation)->reference_count_ = -1;			// zombie
 #else
 			// We no longer delete mutation objects; instead, we remove them from our shared pool
@@ -4324,7 +5152,7 @@ void Population::PrintAll(std::ostream &p_out, bool p_output_spatial_positions)
 	int spatial_output_count = (p_output_spatial_positions ? sim_.SpatialDimensionality() : 0);
 	
 	// Starting in SLiM 2.3, we output a version indicator at the top of the file so we can decode different versions, etc.
-	// We use the same version numbers used in PrintAllBinary(), for simplicity.
+	// We use the same version numbers used in PrintAllBinary(), for simplicity; version 4 changed only the binary format.
 	p_out << "Version: 3" << std::endl;
 	
 	// Output populations first
@@ -4516,6 +5344,12 @@ void Population::PrintAll(std::ostream &p_out, bool p_output_spatial_positions)
 }
 
 // print all mutations and all genomes to a stream in binary, for maximum reading speed
+//
+// Version 4 of the binary format is a snapshot made of contiguous sections, each padded to a multiple of eight bytes so that
+// the reader can use it in place from a memory-mapped file: a subpopulation table, a mutation table stored by column, a table
+// of the unique mutation runs in the population, the run indices of each genome, and the spatial positions of individuals.
+// Each section is written with a single large write.  Because runs are written once no matter how many genomes share them,
+// _InitializePopulationFromBinaryFile() can restore the sharing of runs between genomes, not just their contents.
 void Population::PrintAllBinary(std::ostream &p_out, bool p_output_spatial_positions) const
 {
 	// This function is written to be able to print the population whether child_generation_valid is true or false.
@@ -4526,276 +5360,222 @@ void Population::PrintAllBinary(std::ostream &p_out, bool p_output_spatial_posit
 	int32_t spatial_output_count = (int32_t)(p_output_spatial_positions ? sim_.SpatialDimensionality() : 0);
 	
 	int32_t section_end_tag = 0xFFFF0000;
+	int32_t mutrun_count = sim_.TheChromosome().mutrun_count_;
+	int32_t mutrun_length = sim_.TheChromosome().mutrun_length_;
+	
+	// Subpopulation, genome, and individual tables; each genome is given as the indices of its runs in the run table, or as
+	// mutrun_count entries of -1 if it is a null genome.  Runs are numbered in the order in which they are first seen.
+	std::vector<slim_objectid_t> subpop_ids;
+	std::vector<slim_popsize_t> subpop_sizes;
+	std::vector<int32_t> subpop_sex_flags;
+	std::vector<double> subpop_sex_ratios;
+	std::vector<int32_t> genome_types;
+	std::vector<int32_t> genome_runs;
+	std::vector<double> spatial_positions;
+	std::vector<const MutationRun *> runs;
+	std::vector<slim_refcount_t> run_use_counts;
+	std::unordered_map<const MutationRun *, int32_t> run_lookup;
 	
-	// Header section
-	{
-		// Write a 32-bit endianness tag
-		int32_t endianness_tag = 0x12345678;
-		
-		p_out.write(reinterpret_cast<char *>(&endianness_tag), sizeof endianness_tag);
-		
-		// Write a format version tag
-		int32_t version_tag = 3;																					// version 2 started with SLiM 2.1
-																													// version 3 started with SLiM 2.3
-		
-		p_out.write(reinterpret_cast<char *>(&version_tag), sizeof version_tag);
-		
-		// Write the size of a double
-		int32_t double_size = sizeof(double);
-		
-		p_out.write(reinterpret_cast<char *>(&double_size), sizeof double_size);
-		
-		// Write a test double, to ensure the same format is used on the reading machine
-		double double_test = 1234567890.0987654321;
-		
-		p_out.write(reinterpret_cast<char *>(&double_test), sizeof double_test);
-		
-		// Write the sizes of the various SLiM types
-		int32_t slim_generation_t_size = sizeof(slim_generation_t);
-		int32_t slim_position_t_size = sizeof(slim_position_t);
-		int32_t slim_objectid_t_size = sizeof(slim_objectid_t);
-		int32_t slim_popsize_t_size = sizeof(slim_popsize_t);
-		int32_t slim_refcount_t_size = sizeof(slim_refcount_t);
-		int32_t slim_selcoeff_t_size = sizeof(slim_selcoeff_t);
-		int32_t slim_mutationid_t_size = sizeof(slim_mutationid_t);													// Added in version 2
-		int32_t slim_polymorphismid_t_size = sizeof(slim_polymorphismid_t);											// Added in version 2
-		
-		p_out.write(reinterpret_cast<char *>(&slim_generation_t_size), sizeof slim_generation_t_size);
-		p_out.write(reinterpret_cast<char *>(&slim_position_t_size), sizeof slim_position_t_size);
-		p_out.write(reinterpret_cast<char *>(&slim_objectid_t_size), sizeof slim_objectid_t_size);
-		p_out.write(reinterpret_cast<char *>(&slim_popsize_t_size), sizeof slim_popsize_t_size);
-		p_out.write(reinterpret_cast<char *>(&slim_refcount_t_size), sizeof slim_refcount_t_size);
-		p_out.write(reinterpret_cast<char *>(&slim_selcoeff_t_size), sizeof slim_selcoeff_t_size);
-		p_out.write(reinterpret_cast<char *>(&slim_mutationid_t_size), sizeof slim_mutationid_t_size);				// Added in version 2
-		p_out.write(reinterpret_cast<char *>(&slim_polymorphismid_t_size), sizeof slim_polymorphismid_t_size);		// Added in version 2
-		
-		// Write the generation
-		slim_generation_t generation = sim_.Generation();
-		
-		p_out.write(reinterpret_cast<char *>(&generation), sizeof generation);
-		
-		// Write the number of spatial coordinates we will write per individual.  Added in version 3.
-		p_out.write(reinterpret_cast<char *>(&spatial_output_count), sizeof spatial_output_count);
-	}
-	
-	// Write a tag indicating the section has ended
-	p_out.write(reinterpret_cast<char *>(&section_end_tag), sizeof section_end_tag);
-	
-	// Populations section
 	for (const std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : *this)
 	{
 		Subpopulation *subpop = subpop_pair.second;
-		slim_objectid_t subpop_id = subpop_pair.first;
 		slim_popsize_t subpop_size = (child_generation_valid_ ? subpop->child_subpop_size_ : subpop->parent_subpop_size_);
-		double subpop_sex_ratio = (child_generation_valid_ ? subpop->child_sex_ratio_ : subpop->parent_sex_ratio_);
-		
-		// Write a tag indicating we are starting a new subpopulation
-		int32_t subpop_start_tag = 0xFFFF0001;
-		
-		p_out.write(reinterpret_cast<char *>(&subpop_start_tag), sizeof subpop_start_tag);
-		
-		// Write the subpop identifier
-		p_out.write(reinterpret_cast<char *>(&subpop_id), sizeof subpop_id);
-		
-		// Write the subpop size
-		p_out.write(reinterpret_cast<char *>(&subpop_size), sizeof subpop_size);
-		
-		// Write a flag indicating whether this population has sexual or hermaphroditic
-		int32_t sex_flag = (subpop->sex_enabled_ ? 1 : 0);
+		std::vector<Genome> &subpop_genomes = (child_generation_valid_ ? subpop->child_genomes_ : subpop->parent_genomes_);
+		std::vector<Individual> &subpop_individuals = (child_generation_valid_ ? subpop->child_individuals_ : subpop->parent_individuals_);
 		
-		p_out.write(reinterpret_cast<char *>(&sex_flag), sizeof sex_flag);
+		subpop_ids.emplace_back(subpop_pair.first);
+		subpop_sizes.emplace_back(subpop_size);
+		subpop_sex_flags.emplace_back(subpop->sex_enabled_ ? 1 : 0);
+		subpop_sex_ratios.emplace_back(child_generation_valid_ ? subpop->child_sex_ratio_ : subpop->parent_sex_ratio_);	// garbage if we are not sexual, but that is fine
 		
-		// Write the sex ratio; if we are not sexual, this will be garbage, but that is fine, we want a constant-length record
-		p_out.write(reinterpret_cast<char *>(&subpop_sex_ratio), sizeof subpop_sex_ratio);
+		for (slim_popsize_t i = 0; i < 2 * subpop_size; i++)
+		{
+			Genome &genome = subpop_genomes[i];
+			
+			genome_types.emplace_back((int32_t)genome.Type());
+			
+			if (genome.IsNull())
+			{
+				genome_runs.insert(genome_runs.end(), mutrun_count, -1);
+			}
+			else
+			{
+				if (genome.mutrun_count_ != mutrun_count)
+					EIDOS_TERMINATION << "ERROR (Population::PrintAllBinary): (internal error) genome mutation run count does not match the chromosome." << EidosTerminate();
+				
+				for (int run_index = 0; run_index < mutrun_count; ++run_index)
+				{
+					const MutationRun *mutrun = genome.mutruns_[run_index].get();
+					auto lookup_iter = run_lookup.find(mutrun);
+					int32_t run_table_index;
+					
+					if (lookup_iter == run_lookup.end())
+					{
+						run_table_index = (int32_t)runs.size();
+						run_lookup.emplace(mutrun, run_table_index);
+						runs.emplace_back(mutrun);
+						run_use_counts.emplace_back(0);
+					}
+					else
+					{
+						run_table_index = lookup_iter->second;
+					}
+					
+					run_use_counts[run_table_index]++;
+					genome_runs.emplace_back(run_table_index);
+				}
+			}
+		}
 		
-		// now will come either a subpopulation start tag, or a section end tag
+		for (int individual_index = 0; individual_index < subpop_size; ++individual_index)
+		{
+			Individual &individual = subpop_individuals[individual_index];
+			
+			if (spatial_output_count >= 1)
+				spatial_positions.emplace_back(individual.spatial_x_);
+			if (spatial_output_count >= 2)
+				spatial_positions.emplace_back(individual.spatial_y_);
+			if (spatial_output_count >= 3)
+				spatial_positions.emplace_back(individual.spatial_z_);
+		}
 	}
 	
-	// Write a tag indicating the section has ended
-	p_out.write(reinterpret_cast<char *>(&section_end_tag), sizeof section_end_tag);
-	
-	// Find all polymorphisms
-	PolymorphismMap polymorphisms;
+	// Mutation and run tables; the run table holds the mutation table indices of the mutations in each run, concatenated, with
+	// the offset of each run into that buffer.  Prevalences are tallied from the run use counts, without visiting any genome.
+	std::vector<int32_t> mutation_lookup(gSLiM_Mutation_Block_LastUsedIndex + 1, -1);
+	std::vector<slim_mutationid_t> mutation_ids;
+	std::vector<slim_objectid_t> mutation_type_ids;
+	std::vector<slim_position_t> mutation_positions;
+	std::vector<slim_selcoeff_t> mutation_selection_coeffs;
+	std::vector<slim_selcoeff_t> mutation_dominance_coeffs;
+	std::vector<slim_objectid_t> mutation_subpop_indices;
+	std::vector<slim_generation_t> mutation_generations;
+	std::vector<slim_refcount_t> mutation_prevalences;
+	std::vector<int64_t> run_offsets;
+	std::vector<int32_t> run_contents;
 	Mutation *mut_block_ptr = gSLiM_Mutation_Block;
 	
-	for (const std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : *this)			// go through all subpopulations
+	for (size_t run_table_index = 0; run_table_index < runs.size(); ++run_table_index)
 	{
-		Subpopulation *subpop = subpop_pair.second;
-		slim_popsize_t subpop_size = (child_generation_valid_ ? subpop->child_subpop_size_ : subpop->parent_subpop_size_);
+		const MutationRun *mutrun = runs[run_table_index];
+		int mut_count = mutrun->size();
+		const MutationIndex *mut_ptr = mutrun->begin_pointer_const();
+		slim_refcount_t use_count = run_use_counts[run_table_index];
 		
-		for (slim_popsize_t i = 0; i < 2 * subpop_size; i++)				// go through all children
+		run_offsets.emplace_back((int64_t)run_contents.size());
+		
+		for (int mut_index = 0; mut_index < mut_count; ++mut_index)
 		{
-			Genome &genome = child_generation_valid_ ? subpop->child_genomes_[i] : subpop->parent_genomes_[i];
-			int mutrun_count = genome.mutrun_count_;
+			MutationIndex mutation_block_index = mut_ptr[mut_index];
+			int32_t mutation_table_index = mutation_lookup[mutation_block_index];
 			
-			for (int run_index = 0; run_index < mutrun_count; ++run_index)
+			if (mutation_table_index == -1)
 			{
-				MutationRun *mutrun = genome.mutruns_[run_index].get();
-				int mut_count = mutrun->size();
-				const MutationIndex *mut_ptr = mutrun->begin_pointer_const();
+				const Mutation *mutation_ptr = mut_block_ptr + mutation_block_index;
+				const MutationType *mutation_type_ptr = mutation_ptr->mutation_type_ptr_;
 				
-				for (int mut_index = 0; mut_index < mut_count; ++mut_index)
-					AddMutationToPolymorphismMap(&polymorphisms, mut_block_ptr + mut_ptr[mut_index]);
+				mutation_table_index = (int32_t)mutation_ids.size();
+				mutation_lookup[mutation_block_index] = mutation_table_index;
+				
+				mutation_ids.emplace_back(mutation_ptr->mutation_id_);
+				mutation_type_ids.emplace_back(mutation_type_ptr->mutation_type_id_);
+				mutation_positions.emplace_back(mutation_ptr->position_);
+				mutation_selection_coeffs.emplace_back(mutation_ptr->selection_coeff_);
+				mutation_dominance_coeffs.emplace_back(mutation_type_ptr->dominance_coeff_);
+				mutation_subpop_indices.emplace_back(mutation_ptr->subpop_index_);
+				mutation_generations.emplace_back(mutation_ptr->generation_);
+				mutation_prevalences.emplace_back(0);
 			}
+			
+			mutation_prevalences[mutation_table_index] += use_count;
+			run_contents.emplace_back(mutation_table_index);
 		}
 	}
 	
-	// Write out the size of the mutation map, so we can allocate a vector rather than utilizing std::map when reading
-	int32_t mutation_map_size = (int32_t)polymorphisms.size();
+	run_offsets.emplace_back((int64_t)run_contents.size());
 	
-	p_out.write(reinterpret_cast<char *>(&mutation_map_size), sizeof mutation_map_size);
+	// Each section is followed by zero padding up to a multiple of eight bytes, so that every section starts aligned
+	int64_t bytes_written = 0;
 	
-	// Mutations section
-	for (const PolymorphismPair &polymorphism_pair : polymorphisms)
+	auto write_section = [&p_out, &bytes_written](const void *p_data, size_t p_bytes) {
+		static const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+		
+		if (p_bytes)
+			p_out.write(static_cast<const char *>(p_data), p_bytes);
+		
+		bytes_written += p_bytes;
+		
+		if (bytes_written % 8)
+		{
+			p_out.write(padding, 8 - (bytes_written % 8));
+			bytes_written += 8 - (bytes_written % 8);
+		}
+	};
+	
+	// Header section; this is laid out as in version 3, so that the reader can check the version before anything else
 	{
-		const Polymorphism &polymorphism = polymorphism_pair.second;
-		const Mutation *mutation_ptr = polymorphism.mutation_ptr_;
-		const MutationType *mutation_type_ptr = mutation_ptr->mutation_type_ptr_;
-		
-		slim_polymorphismid_t polymorphism_id = polymorphism.polymorphism_id_;
-		int64_t mutation_id = mutation_ptr->mutation_id_;													// Added in version 2
-		slim_objectid_t mutation_type_id = mutation_type_ptr->mutation_type_id_;
-		slim_position_t position = mutation_ptr->position_;
-		slim_selcoeff_t selection_coeff = mutation_ptr->selection_coeff_;
-		slim_selcoeff_t dominance_coeff = mutation_type_ptr->dominance_coeff_;
-		slim_objectid_t subpop_index = mutation_ptr->subpop_index_;
-		slim_generation_t generation = mutation_ptr->generation_;
-		slim_refcount_t prevalence = polymorphism.prevalence_;
-		
-		// Write a tag indicating we are starting a new mutation
-		int32_t mutation_start_tag = 0xFFFF0002;
-		
-		p_out.write(reinterpret_cast<char *>(&mutation_start_tag), sizeof mutation_start_tag);
-		
-		// Write the mutation data
-		p_out.write(reinterpret_cast<char *>(&polymorphism_id), sizeof polymorphism_id);
-		p_out.write(reinterpret_cast<char *>(&mutation_id), sizeof mutation_id);							// Added in version 2
-		p_out.write(reinterpret_cast<char *>(&mutation_type_id), sizeof mutation_type_id);
-		p_out.write(reinterpret_cast<char *>(&position), sizeof position);
-		p_out.write(reinterpret_cast<char *>(&selection_coeff), sizeof selection_coeff);
-		p_out.write(reinterpret_cast<char *>(&dominance_coeff), sizeof dominance_coeff);
-		p_out.write(reinterpret_cast<char *>(&subpop_index), sizeof subpop_index);
-		p_out.write(reinterpret_cast<char *>(&generation), sizeof generation);
-		p_out.write(reinterpret_cast<char *>(&prevalence), sizeof prevalence);
-		
-		// now will come either a mutation start tag, or a section end tag
+		int32_t header[16];
+		int header_length = 0;
+		double double_test = 1234567890.0987654321;										// a test double, to ensure the same format is used on the reading machine
+		
+		header[header_length++] = 0x12345678;											// endianness tag
+		header[header_length++] = 4;													// version 2 started with SLiM 2.1
+																						// version 3 started with SLiM 2.3
+																						// version 4 started after SLiM 2.6
+		header[header_length++] = sizeof(double);
+		memcpy(header + header_length, &double_test, sizeof(double_test));
+		header_length += sizeof(double_test) / sizeof(int32_t);
+		header[header_length++] = sizeof(slim_generation_t);
+		header[header_length++] = sizeof(slim_position_t);
+		header[header_length++] = sizeof(slim_objectid_t);
+		header[header_length++] = sizeof(slim_popsize_t);
+		header[header_length++] = sizeof(slim_refcount_t);
+		header[header_length++] = sizeof(slim_selcoeff_t);
+		header[header_length++] = sizeof(slim_mutationid_t);
+		header[header_length++] = sizeof(slim_polymorphismid_t);
+		header[header_length++] = sim_.Generation();
+		header[header_length++] = spatial_output_count;
+		header[header_length++] = section_end_tag;
+		
+		write_section(header, header_length * sizeof(int32_t));
 	}
 	
-	// Write a tag indicating the section has ended
-	p_out.write(reinterpret_cast<char *>(&section_end_tag), sizeof section_end_tag);
-	
-	// Genomes section
-	bool use_16_bit = (mutation_map_size <= UINT16_MAX - 1);	// 0xFFFF is reserved as the start of our various tags
-	
-	for (const std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : *this)			// go through all subpopulations
+	// Table sizes section, which determines the sizes of all the sections that follow
 	{
-		Subpopulation *subpop = subpop_pair.second;
-		slim_objectid_t subpop_id = subpop_pair.first;
-		slim_popsize_t subpop_size = (child_generation_valid_ ? subpop->child_subpop_size_ : subpop->parent_subpop_size_);
+		int32_t table_sizes[8] = {(int32_t)subpop_ids.size(), (int32_t)mutation_ids.size(), (int32_t)runs.size(), (int32_t)run_contents.size(), (int32_t)genome_types.size(), mutrun_count, mutrun_length, section_end_tag};
 		
-		for (slim_popsize_t i = 0; i < 2 * subpop_size; i++)							// go through all children
-		{
-			Genome &genome = child_generation_valid_ ? subpop->child_genomes_[i] : subpop->parent_genomes_[i];
-			
-			// Write out the genome header; start with the genome type to guarantee that the first 32 bits are != section_end_tag
-			int32_t genome_type = (int32_t)(genome.Type());
-			
-			p_out.write(reinterpret_cast<char *>(&genome_type), sizeof genome_type);
-			p_out.write(reinterpret_cast<char *>(&subpop_id), sizeof subpop_id);
-			p_out.write(reinterpret_cast<char *>(&i), sizeof i);
-			
-			// Output individual spatial position information before the mutation list.  Added in version 3.
-			if (spatial_output_count && ((i % 2) == 0))
-			{
-				int individual_index = i / 2;
-				Individual &individual = (child_generation_valid_ ? subpop->child_individuals_[individual_index] : subpop->parent_individuals_[individual_index]);
-				
-				if (spatial_output_count >= 1)
-					p_out.write(reinterpret_cast<char *>(&individual.spatial_x_), sizeof individual.spatial_x_);
-				if (spatial_output_count >= 2)
-					p_out.write(reinterpret_cast<char *>(&individual.spatial_y_), sizeof individual.spatial_y_);
-				if (spatial_output_count >= 3)
-					p_out.write(reinterpret_cast<char *>(&individual.spatial_z_), sizeof individual.spatial_z_);
-			}
-			
-			// Write out the mutation list
-			if (genome.IsNull())
-			{
-				// null genomes get a 32-bit flag value written instead of a mutation count
-				int32_t null_genome_tag = 0xFFFF1000;
-				
-				p_out.write(reinterpret_cast<char *>(&null_genome_tag), sizeof null_genome_tag);
-			}
-			else
-			{
-				// write a 32-bit mutation count
-				{
-					int32_t total_mutations = genome.mutation_count();
-					
-					p_out.write(reinterpret_cast<char *>(&total_mutations), sizeof total_mutations);
-				}
-				
-				if (use_16_bit)
-				{
-					// Write out 16-bit mutation tags
-					int mutrun_count = genome.mutrun_count_;
-					
-					for (int run_index = 0; run_index < mutrun_count; ++run_index)
-					{
-						MutationRun *mutrun = genome.mutruns_[run_index].get();
-						int mut_count = mutrun->size();
-						const MutationIndex *mut_ptr = mutrun->begin_pointer_const();
-						
-						for (int mut_index = 0; mut_index < mut_count; ++mut_index)
-						{
-							slim_polymorphismid_t polymorphism_id = FindMutationInPolymorphismMap(polymorphisms, mut_block_ptr + mut_ptr[mut_index]);
-							
-							if (polymorphism_id == -1)
-								EIDOS_TERMINATION << "ERROR (Population::PrintAllBinary): (internal error) polymorphism not found." << EidosTerminate();
-							
-							if (polymorphism_id <= UINT16_MAX - 1)
-							{
-								uint16_t id_16 = (uint16_t)polymorphism_id;
-								
-								p_out.write(reinterpret_cast<char *>(&id_16), sizeof id_16);
-							}
-							else
-							{
-								EIDOS_TERMINATION << "ERROR (Population::PrintAllBinary): (internal error) mutation id out of 16-bit bounds." << EidosTerminate();
-							}
-						}
-					}
-				}
-				else
-				{
-					// Write out 32-bit mutation tags
-					int mutrun_count = genome.mutrun_count_;
-					
-					for (int run_index = 0; run_index < mutrun_count; ++run_index)
-					{
-						MutationRun *mutrun = genome.mutruns_[run_index].get();
-						int mut_count = mutrun->size();
-						const MutationIndex *mut_ptr = mutrun->begin_pointer_const();
-						
-						for (int mut_index = 0; mut_index < mut_count; ++mut_index)
-						{
-							slim_polymorphismid_t polymorphism_id = FindMutationInPolymorphismMap(polymorphisms, mut_block_ptr + mut_ptr[mut_index]);
-							
-							if (polymorphism_id == -1)
-								EIDOS_TERMINATION << "ERROR (Population::PrintAllBinary): (internal error) polymorphism not found." << EidosTerminate();
-							
-							p_out.write(reinterpret_cast<char *>(&polymorphism_id), sizeof polymorphism_id);
-						}
-					}
-				}
-				
-				// now will come either a genome type (32 bits: 0, 1, or 2), or a section end tag
-			}
-		}
+		write_section(table_sizes, sizeof(table_sizes));
 	}
 	
-	// Write a tag indicating the section has ended
-	p_out.write(reinterpret_cast<char *>(&section_end_tag), sizeof section_end_tag);
+	// Subpopulations section
+	write_section(subpop_ids.data(), subpop_ids.size() * sizeof(slim_objectid_t));
+	write_section(subpop_sizes.data(), subpop_sizes.size() * sizeof(slim_popsize_t));
+	write_section(subpop_sex_flags.data(), subpop_sex_flags.size() * sizeof(int32_t));
+	write_section(subpop_sex_ratios.data(), subpop_sex_ratios.size() * sizeof(double));
+	
+	// Mutations section
+	write_section(mutation_ids.data(), mutation_ids.size() * sizeof(slim_mutationid_t));
+	write_section(mutation_type_ids.data(), mutation_type_ids.size() * sizeof(slim_objectid_t));
+	write_section(mutation_positions.data(), mutation_positions.size() * sizeof(slim_position_t));
+	write_section(mutation_selection_coeffs.data(), mutation_selection_coeffs.size() * sizeof(slim_selcoeff_t));
+	write_section(mutation_dominance_coeffs.data(), mutation_dominance_coeffs.size() * sizeof(slim_selcoeff_t));
+	write_section(mutation_subpop_indices.data(), mutation_subpop_indices.size() * sizeof(slim_objectid_t));
+	write_section(mutation_generations.data(), mutation_generations.size() * sizeof(slim_generation_t));
+	write_section(mutation_prevalences.data(), mutation_prevalences.size() * sizeof(slim_refcount_t));
+	
+	// Mutation runs section
+	write_section(run_offsets.data(), run_offsets.size() * sizeof(int64_t));
+	write_section(run_contents.data(), run_contents.size() * sizeof(int32_t));
+	
+	// Genomes section
+	write_section(genome_types.data(), genome_types.size() * sizeof(int32_t));
+	write_section(genome_runs.data(), genome_runs.size() * sizeof(int32_t));
+	
+	// Individuals section
+	write_section(spatial_positions.data(), spatial_positions.size() * sizeof(double));
+	
+	// Write a tag indicating the snapshot has ended
+	write_section(&section_end_tag, sizeof section_end_tag);
 }
 
 // print sample of p_sample_size genomes from subpopulation p_subpop_id
@@ -30,6 +30,7 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 
 #include "slim_global.h"
@@ -43,6 +44,65 @@
 class SLiMSim;
 
 
+// When carrying mutation tallies across generations costs more than a full tally would, we stop for this many generations and then retry
+#define SLIM_INCREMENTAL_TALLY_RETRY_INTERVAL	20
+
+
+// If defined as 1, each mutation run newly assembled during offspring generation is looked up in a table of the runs assembled so far
+// in the generation, and replaced by an identical run if one is found, so that identical runs are shared immediately rather than only
+// when UniqueMutationRuns() is next called.  This saves memory, and raises the hit rate of the non-neutral caches and the fitness memos.
+// Define to 0 to disable this feature; see Population::InternMutationRuns().
+#define SLIM_INTERN_MUTATION_RUNS	1
+
+
+// This struct records the work needed to produce one child genome when offspring are generated in parallel.  Tasks are planned on
+// the main thread, in the same order in which DoCrossoverMutation() / DoClonalMutation() would otherwise be called, and are then
+// carried out in contiguous blocks, one block per thread; see Population::ExecuteReproductionTasks().
+typedef struct {
+	Genome *child_genome_;
+	Genome *parent_genome_1_;						// for clonal reproduction, the parental genome being cloned
+	Genome *parent_genome_2_;						// nullptr for clonal reproduction
+	IndividualSex parent_sex_;						// the sex used to choose mutation and recombination maps (the child's sex, when cloning)
+	slim_objectid_t source_subpop_id_;
+	bool is_clonal_;
+	bool use_only_strand_1_;						// see DoCrossoverMutation()
+	bool do_swap_;									// see DoCrossoverMutation()
+	
+	// the draw plan for the task, locating its data in the flat arrays of its block's ReproductionThreadState
+	int num_mutations_;
+	int32_t breakpoints_start_;						// index into the thread's breakpoints_
+	int32_t breakpoints_count_;
+	int32_t mutations_start_;						// index into the thread's planned_mutations_ and new_mutations_
+} ReproductionTask;
+
+// The position of a new mutation, drawn in advance on a worker thread; the mutation itself is made later on the main thread.
+typedef struct {
+	slim_position_t position_;
+	const GenomicElement *element_;					// the genomic element containing position_, which supplies the mutation type
+} PlannedMutation;
+
+// Per-thread state for parallel offspring generation.  Each block of tasks gets its own random number stream, flat arrays for
+// its draw plan, and MutationRun free list, so that the hot loop needs no locking.  Anything that touches shared state (drawing new
+// mutations, the mutation registry, MutationRun refcounts) is done on the main thread, visiting the blocks in order, which keeps
+// results reproducible for a given seed and thread count regardless of thread scheduling.
+struct _ReproductionThreadState {
+	Eidos_RNG_State rng_;										// this block's random number stream, reseeded for each use
+	
+	std::vector<slim_position_t> breakpoints_;					// the sorted breakpoints of all of this block's tasks, end to end
+	std::vector<PlannedMutation> planned_mutations_;			// the sorted new mutation positions of all of this block's tasks, end to end
+	std::vector<int32_t> deferred_tasks_;						// indices of tasks deferred until their new mutations are made, in order
+	std::vector<MutationIndex> new_mutations_;					// new mutations for deferred tasks, made on the main thread; parallel to planned_mutations_
+	std::vector<MutationIndex> accepted_mutations_;				// new mutations passed by the stacking policy, to be registered
+	std::vector<MutationIndex> rejected_mutations_;				// new mutations rejected by the stacking policy, to be disposed of
+	std::vector<MutationRun *> freed_mutation_runs_;			// this block's share of the MutationRun free list
+	int64_t assembled_mutrun_count_ = 0;						// mutation runs assembled by this block, rather than shared with a parent
+	
+	_ReproductionThreadState(void);
+	~_ReproductionThreadState(void);
+};
+typedef struct _ReproductionThreadState ReproductionThreadState;
+
+
 #ifdef SLIMGUI
 // This struct is used to hold fitness values observed during a run, for display by GraphView_FitnessOverTime
 // The Population keeps the fitness histories for all the subpopulations, because subpops can come and go, but
@@ -79,6 +139,13 @@ public:
 	std::vector<Subpopulation*> last_tallied_subpops_;		// NOT OWNED POINTERS
 	slim_refcount_t cached_tally_genome_count_ = 0;
 	
+#if SLIM_INCREMENTAL_TALLIES
+	// State for carrying refcounts forward between tallies; see TallyMutationReferences_INCREMENTAL()
+	int64_t incremental_tally_epoch_ = 0;					// the tally epoch of our last incremental tally; stale if it is not current
+	bool incremental_tally_enabled_ = true;					// false while carrying tallies across generations costs more than full tallies
+	int incremental_tally_skip_count_ = 0;					// the number of generations since incremental_tally_enabled_ was cleared
+#endif
+	
 	std::vector<Substitution*> substitutions_;				// OWNED POINTERS: Substitution objects for all fixed mutations
 	bool child_generation_valid_ = false;					// this keeps track of whether children have been generated by EvolveSubpopulation() yet, or whether the parents are still in charge
 	
@@ -98,6 +165,22 @@ public:
 	bool gui_all_selected_ = true;
 #endif
 	
+	// parallel offspring generation; used only when the simulation's thread count is greater than 1
+	std::vector<ReproductionTask> reproduction_tasks_;				// tasks planned for the subpopulation currently being generated
+	std::vector<ReproductionThreadState *> reproduction_threads_;	// OWNED POINTERS: per-thread state, kept to avoid reallocation
+	std::vector<slim_popsize_t> drawn_parents_;						// parents drawn in bulk for reproduction without callbacks, kept to avoid reallocation
+	std::vector<std::vector<slim_refcount_t>> tally_shards_;		// per-thread refcounts for TallyMutationRunsInParallel(), kept zeroed between uses
+	
+	// work counter for SLiMSim's mutation run count optimization; the number of mutation runs assembled for child genomes (rather
+	// than shared with a parent) since SLiMSim last reset it; see SLiMSim::MaintainMutationRunCostModel()
+	int64_t assembled_mutrun_count_ = 0;
+	
+#if SLIM_INTERN_MUTATION_RUNS
+	// runs assembled during the current generation's offspring generation, keyed by MutationRun::Hash(); these are not retained, so
+	// an entry may be stale (freed, or reused with other contents), and must be validated on use; see InternMutationRuns()
+	std::unordered_multimap<int64_t, MutationRun *> interned_mutruns_;		// NOT OWNED POINTERS
+#endif
+	
 	Population(const Population&) = delete;					// no copying
 	Population& operator=(const Population&) = delete;		// no copying
 	Population(void) = delete;								// no default constructor
@@ -137,6 +220,23 @@ public:
 	// generate a child genome from a single parental genome, without recombination or gene conversion, but with mutation
 	void DoClonalMutation(Subpopulation *p_subpop, Subpopulation *p_source_subpop, slim_popsize_t p_child_genome_index, slim_objectid_t p_source_subpop_id, slim_popsize_t p_parent_genome_index, const Chromosome &p_chromosome, slim_generation_t p_generation, IndividualSex p_child_sex);
 	
+	// assemble a child genome from its parental genomes, given sorted breakpoints (with the end breakpoint) and sorted new mutations;
+	// f_parallel selects the thread-safe variant used by ExecuteReproductionTasks(), which defers all work on shared state to p_thread
+	template <const bool f_parallel>
+	void AssembleCrossoverGenome(Genome &p_child_genome, Genome *parent_genome_1, Genome *parent_genome_2, const slim_position_t *p_breakpoints, int p_breakpoint_count, const MutationIndex *mutation_iter, const MutationIndex *mutation_iter_max, ReproductionThreadState *p_thread);
+	template <const bool f_parallel>
+	void AssembleClonalGenome(Genome &p_child_genome, Genome *p_parent_genome, const MutationIndex *mutation_iter, const MutationIndex *mutation_iter_max, ReproductionThreadState *p_thread);
+	
+#if SLIM_INTERN_MUTATION_RUNS
+	// replace newly assembled runs in a child genome with identical runs assembled earlier in the generation, if any
+	void InternMutationRuns(Genome &p_child_genome);
+#endif
+	
+	// parallel offspring generation: plan tasks equivalent to DoCrossoverMutation() / DoClonalMutation() calls, then execute them all
+	void PlanCrossoverMutation(Subpopulation *p_subpop, Subpopulation *p_source_subpop, slim_popsize_t p_child_genome_index, slim_objectid_t p_source_subpop_id, slim_popsize_t p_parent_index, IndividualSex p_child_sex, IndividualSex p_parent_sex);
+	void PlanClonalMutation(Subpopulation *p_subpop, Subpopulation *p_source_subpop, slim_popsize_t p_child_genome_index, slim_objectid_t p_source_subpop_id, slim_popsize_t p_parent_genome_index, IndividualSex p_child_sex);
+	void ExecuteReproductionTasks(slim_objectid_t p_subpop_id, const Chromosome &p_chromosome, slim_generation_t p_generation, int p_thread_count);
+	
 	// An internal method that validates cached fitness values kept by Mutation objects
 	void ValidateMutationFitnessCaches(void);
 	
@@ -161,7 +261,12 @@ public:
 	
 	// count the total number of times that each Mutation in the registry is referenced by a population, and set total_genome_count_ to the maximum possible number of references (i.e. fixation)
 	slim_refcount_t TallyMutationReferences(std::vector<Subpopulation*> *p_subpops_to_tally, bool p_force_recache);
+	bool MutationRunUseCountsMatchGenomes(void);
 	slim_refcount_t TallyMutationReferences_FAST(void);
+	slim_refcount_t TallyMutationRunsInParallel(int p_thread_count, int64_t p_operation_id, int64_t p_tally_epoch, int64_t *p_scanned_count, int64_t *p_total_count);
+#if SLIM_INCREMENTAL_TALLIES
+	slim_refcount_t TallyMutationReferences_INCREMENTAL(void);
+#endif
 	
 	// handle negative fixation (remove from the registry) and positive fixation (convert to Substitution), using reference counts from TallyMutationReferences()
 	void RemoveFixedMutations(void);
@@ -35,6 +35,8 @@
 #include "eidos_type_table.h"
 #include "eidos_type_interpreter.h"
 
+#include <functional>
+
 
 enum class SLiMEidosBlockType {
 	SLiMEidosEventEarly = 0,
@@ -97,6 +99,22 @@ public:
 extern EidosObjectClass *gSLiM_SLiMEidosBlock_Class;
 
 
+// A native compilation of a simple callback body, such as { return relFitness * (1.0 + individual.tagF); }, made by
+// SLiMSim::OptimizeScriptBlock().  It is a tree of closures that reads the callback's arguments from the structure
+// below, so calling it needs no interpreter and no symbol table.  Arguments not used by a callback type are ignored.
+typedef struct {
+	double relFitness_;							// fitness callbacks; 1.0 for global fitness callbacks
+	double distance_;							// interaction callbacks
+	double strength_;							// interaction callbacks
+	EidosObjectElement *mut_;					// fitness callbacks (Mutation)
+	EidosObjectElement *individual_;			// fitness callbacks, including global fitness callbacks (Individual)
+	EidosObjectElement *receiver_;				// interaction callbacks (Individual)
+	EidosObjectElement *exerter_;				// interaction callbacks (Individual)
+} SLiMCallbackArguments;
+
+typedef std::function<double(const SLiMCallbackArguments &)> SLiMNativeExpression;
+
+
 class SLiMEidosBlock : public EidosObjectElement
 {
 	//	This class has its copy constructor and assignment operator disabled, to prevent accidental copying.
@@ -166,6 +184,8 @@ public:
 	double cached_opt_B_ = 0.0;
 	double cached_opt_C_ = 0.0;
 	double cached_opt_D_ = 0.0;
+	bool has_cached_opt_native_ = false;		// the callback is evaluated by cached_opt_native_, returning a float singleton
+	SLiMNativeExpression cached_opt_native_;
 	
 	
 	SLiMEidosBlock(const SLiMEidosBlock&) = delete;					// no copying
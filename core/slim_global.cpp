@@ -230,6 +230,7 @@ const std::string gStr_initializeMutationRate = "initializeMutationRate";
 const std::string gStr_initializeRecombinationRate = "initializeRecombinationRate";
 const std::string gStr_initializeSex = "initializeSex";
 const std::string gStr_initializeSLiMOptions = "initializeSLiMOptions";
+const std::string gStr_initializeTreeSeq = "initializeTreeSeq";
 const std::string gStr_initializeInteractionType = "initializeInteractionType";
 
 // SLiMEidosDictionary
@@ -321,6 +322,7 @@ const std::string gStr_sexSegregation = "sexSegregation";
 const std::string gStr_dimensionality = "dimensionality";
 const std::string gStr_periodicity = "periodicity";
 const std::string gStr_spatiality = "spatiality";
+const std::string gStr_sparse = "sparse";
 const std::string gStr_spatialPosition = "spatialPosition";
 const std::string gStr_maxDistance = "maxDistance";
 
@@ -366,6 +368,8 @@ const std::string gStr_registerModifyChildCallback = "registerModifyChildCallbac
 const std::string gStr_registerRecombinationCallback = "registerRecombinationCallback";
 const std::string gStr_rescheduleScriptBlock = "rescheduleScriptBlock";
 const std::string gStr_simulationFinished = "simulationFinished";
+const std::string gStr_treeSeqOutput = "treeSeqOutput";
+const std::string gStr_treeSeqSimplify = "treeSeqSimplify";
 const std::string gStr_setMigrationRates = "setMigrationRates";
 const std::string gStr_pointInBounds = "pointInBounds";
 const std::string gStr_pointReflected = "pointReflected";
@@ -508,6 +512,7 @@ void SLiM_RegisterGlobalStringsAndIDs(void)
 		Eidos_RegisterStringForGlobalID(gStr_initializeRecombinationRate, gID_initializeRecombinationRate);
 		Eidos_RegisterStringForGlobalID(gStr_initializeSex, gID_initializeSex);
 		Eidos_RegisterStringForGlobalID(gStr_initializeSLiMOptions, gID_initializeSLiMOptions);
+		Eidos_RegisterStringForGlobalID(gStr_initializeTreeSeq, gID_initializeTreeSeq);
 		Eidos_RegisterStringForGlobalID(gStr_initializeInteractionType, gID_initializeInteractionType);
 		
 		Eidos_RegisterStringForGlobalID(gStr_getValue, gID_getValue);
@@ -597,6 +602,7 @@ void SLiM_RegisterGlobalStringsAndIDs(void)
 		Eidos_RegisterStringForGlobalID(gStr_dimensionality, gID_dimensionality);
 		Eidos_RegisterStringForGlobalID(gStr_periodicity, gID_periodicity);
 		Eidos_RegisterStringForGlobalID(gStr_spatiality, gID_spatiality);
+		Eidos_RegisterStringForGlobalID(gStr_sparse, gID_sparse);
 		Eidos_RegisterStringForGlobalID(gStr_spatialPosition, gID_spatialPosition);
 		Eidos_RegisterStringForGlobalID(gStr_maxDistance, gID_maxDistance);
 		
@@ -639,6 +645,8 @@ void SLiM_RegisterGlobalStringsAndIDs(void)
 		Eidos_RegisterStringForGlobalID(gStr_registerRecombinationCallback, gID_registerRecombinationCallback);
 		Eidos_RegisterStringForGlobalID(gStr_rescheduleScriptBlock, gID_rescheduleScriptBlock);
 		Eidos_RegisterStringForGlobalID(gStr_simulationFinished, gID_simulationFinished);
+		Eidos_RegisterStringForGlobalID(gStr_treeSeqOutput, gID_treeSeqOutput);
+		Eidos_RegisterStringForGlobalID(gStr_treeSeqSimplify, gID_treeSeqSimplify);
 		Eidos_RegisterStringForGlobalID(gStr_setMigrationRates, gID_setMigrationRates);
 		Eidos_RegisterStringForGlobalID(gStr_pointInBounds, gID_pointInBounds);
 		Eidos_RegisterStringForGlobalID(gStr_pointReflected, gID_pointReflected);
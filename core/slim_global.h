@@ -87,6 +87,7 @@ typedef int64_t slim_usertag_t;			// user-provided "tag" values; also used for t
 typedef int32_t slim_refcount_t;		// mutation refcounts, counts of the number of occurrences of a mutation
 typedef int64_t slim_mutationid_t;		// identifiers for mutations, which require 64 bits since there can be so many
 typedef int32_t slim_polymorphismid_t;	// identifiers for polymorphisms, which need only 32 bits since they are only segregating mutations
+typedef int32_t slim_treenodeid_t;		// node identifiers in a recorded tree sequence; see TreeSequence
 typedef float slim_selcoeff_t;			// storage of selection coefficients in memory-tight classes; also dominance coefficients
 
 #define SLIM_MAX_GENERATION		(1000000000L)	// generation ranges from 0 (init time) to this
@@ -294,6 +295,7 @@ extern const std::string gStr_initializeMutationRate;
 extern const std::string gStr_initializeRecombinationRate;
 extern const std::string gStr_initializeSex;
 extern const std::string gStr_initializeSLiMOptions;
+extern const std::string gStr_initializeTreeSeq;
 extern const std::string gStr_initializeInteractionType;
 
 extern const std::string gStr_getValue;
@@ -383,6 +385,7 @@ extern const std::string gStr_sexSegregation;
 extern const std::string gStr_dimensionality;
 extern const std::string gStr_periodicity;
 extern const std::string gStr_spatiality;
+extern const std::string gStr_sparse;
 extern const std::string gStr_spatialPosition;
 extern const std::string gStr_maxDistance;
 
@@ -427,6 +430,8 @@ extern const std::string gStr_registerModifyChildCallback;
 extern const std::string gStr_registerRecombinationCallback;
 extern const std::string gStr_rescheduleScriptBlock;
 extern const std::string gStr_simulationFinished;
+extern const std::string gStr_treeSeqOutput;
+extern const std::string gStr_treeSeqSimplify;
 extern const std::string gStr_setMigrationRates;
 extern const std::string gStr_pointInBounds;
 extern const std::string gStr_pointReflected;
@@ -531,6 +536,7 @@ enum _SLiMGlobalStringID : int {
 	gID_initializeRecombinationRate,
 	gID_initializeSex,
 	gID_initializeSLiMOptions,
+	gID_initializeTreeSeq,
 	gID_initializeInteractionType,
 	
 	gID_getValue,
@@ -620,6 +626,7 @@ enum _SLiMGlobalStringID : int {
 	gID_dimensionality,
 	gID_periodicity,
 	gID_spatiality,
+	gID_sparse,
 	gID_spatialPosition,
 	gID_maxDistance,
 	
@@ -664,6 +671,8 @@ enum _SLiMGlobalStringID : int {
 	gID_registerRecombinationCallback,
 	gID_rescheduleScriptBlock,
 	gID_simulationFinished,
+	gID_treeSeqOutput,
+	gID_treeSeqSimplify,
 	gID_setMigrationRates,
 	gID_pointInBounds,
 	gID_pointReflected,
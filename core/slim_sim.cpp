@@ -26,6 +26,7 @@
 #include "eidos_ast_node.h"
 #include "individual.h"
 #include "polymorphism.h"
+#include "tree_sequence.h"
 
 #include <iostream>
 #include <fstream>
@@ -35,6 +36,14 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <map>
+#include <iomanip>
+#include <ctime>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 
 #pragma mark -
@@ -100,6 +109,9 @@ SLiMSim::~SLiMSim(void)
 	// All the script blocks that refer to the script are now gone
 	delete script_;
 	
+	delete tree_seq_;
+	tree_seq_ = nullptr;
+	
 	// Dispose of mutation run experiment data
 	if (x_experiments_enabled_)
 	{
@@ -253,12 +265,27 @@ slim_generation_t SLiMSim::InitializePopulationFromFile(const char *p_file, Eido
 		population_.RemoveAllSubpopulationInfo();
 	}
 	
+	slim_generation_t file_generation = 0;
+	
 	if (file_format == 1)
-		return _InitializePopulationFromTextFile(p_file, p_interpreter);
+		file_generation = _InitializePopulationFromTextFile(p_file, p_interpreter);
 	else if (file_format == 2)
-		return _InitializePopulationFromBinaryFile(p_file, p_interpreter);
+		file_generation = _InitializePopulationFromBinaryFile(p_file, p_interpreter);
 	else
 		EIDOS_TERMINATION << "ERROR (SLiMSim::InitializePopulationFromFile): unreconized format code." << EidosTerminate();
+	
+	// the loaded genomes have no recorded history, so the tree sequence starts over with them as founders; this is done after
+	// loading, since the generation counter is set from the file
+	if (tree_seq_)
+	{
+		tree_seq_->Clear();
+		
+		for (std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : population_)
+			for (Genome &genome : subpop_pair.second->parent_genomes_)
+				tree_seq_->AddNode(genome, TreeSeqParentalTime(), subpop_pair.first);
+	}
+	
+	return file_generation;
 }
 
 slim_generation_t SLiMSim::_InitializePopulationFromTextFile(const char *p_file, EidosInterpreter *p_interpreter)
@@ -662,31 +689,35 @@ slim_generation_t SLiMSim::_InitializePopulationFromBinaryFile(const char *p_fil
 	slim_generation_t file_generation;
 	int32_t spatial_output_count;
 	
-	// Read file into buf
-	std::ifstream infile(p_file, std::ios::in | std::ios::binary);
+	// Map the file into memory, rather than reading it into a buffer; the pages are brought in as we go, and version 4 files
+	// are laid out so that their sections can be used in place
+	int infile = open(p_file, O_RDONLY);
+	struct stat infile_stat;
 	
-	if (!infile.is_open() || infile.eof())
+	if ((infile == -1) || (fstat(infile, &infile_stat) == -1) || (infile_stat.st_size == 0))
+	{
+		if (infile != -1)
+			close(infile);
+		
 		EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinaryFile): could not open initialization file." << EidosTerminate();
+	}
 	
-	// Determine the file length
-	infile.seekg(0, std::ios_base::end);
-	file_size = infile.tellg();
+	file_size = (std::size_t)infile_stat.st_size;
 	
-	// Read in the entire file; we assume we have enough memory, for now
-	std::unique_ptr<char[]> raii_buf(new char[file_size]);
-	char *buf = raii_buf.get();
+	void *mapped_file = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, infile, 0);
 	
-	if (!buf)
-		EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinaryFile): could not allocate input buffer." << EidosTerminate();
+	// Close the file; the mapping remains valid until it is unmapped
+	close(infile);
 	
-	char *buf_end = buf + file_size;
-	char *p = buf;
+	if (mapped_file == MAP_FAILED)
+		EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinaryFile): could not map initialization file into memory." << EidosTerminate();
 	
-	infile.seekg(0, std::ios_base::beg);
-	infile.read(buf, file_size);
+	madvise(mapped_file, file_size, MADV_SEQUENTIAL);
 	
-	// Close the file; we will work only with our buffer from here on
-	infile.close();
+	std::unique_ptr<char, std::function<void(char *)>> raii_buf(static_cast<char *>(mapped_file), [file_size](char *p_mapped) { munmap(p_mapped, file_size); });
+	char *buf = raii_buf.get();
+	char *buf_end = buf + file_size;
+	char *p = buf;
 	
 	int32_t section_end_tag;
 	int32_t file_version;
@@ -706,7 +737,7 @@ slim_generation_t SLiMSim::_InitializePopulationFromBinaryFile(const char *p_fil
 		
 		if (endianness_tag != 0x12345678)
 			EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinaryFile): endianness mismatch." << EidosTerminate();
-		if ((version_tag != 1) && (version_tag != 2) && (version_tag != 3))
+		if ((version_tag != 1) && (version_tag != 2) && (version_tag != 3) && (version_tag != 4))
 			EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinaryFile): unrecognized version." << EidosTerminate();
 		
 		file_version = version_tag;
@@ -802,6 +833,18 @@ slim_generation_t SLiMSim::_InitializePopulationFromBinaryFile(const char *p_fil
 			EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinaryFile): missing section end after header." << EidosTerminate();
 	}
 	
+	// Version 4 files are snapshots with a different layout after the header; see Population::PrintAllBinary()
+	if (file_version >= 4)
+	{
+		_InitializePopulationFromBinarySnapshot(p, buf_end, spatial_output_count, p_interpreter);
+		
+		// As in earlier versions, we change the generation as a side effect of loading, and then re-tally mutation references
+		generation_ = file_generation;
+		population_.MaintainRegistry();
+		
+		return file_generation;
+	}
+	
 	// Populations section
 	while (true)
 	{
@@ -1205,12 +1248,265 @@ slim_generation_t SLiMSim::_InitializePopulationFromBinaryFile(const char *p_fil
 	
 	return file_generation;
 }
+
+void SLiMSim::_InitializePopulationFromBinarySnapshot(const char *p, const char *buf_end, int32_t p_spatial_output_count, EidosInterpreter *p_interpreter)
+{
+	// Sections are padded to a multiple of eight bytes; this returns the start of the next section and moves past it
+	auto next_section = [&p, buf_end](std::size_t p_bytes) -> const char * {
+		std::size_t padded_bytes = (p_bytes + 7) & ~(std::size_t)7;
+		
+		if (padded_bytes > (std::size_t)(buf_end - p))
+			EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): unexpected EOF while reading snapshot." << EidosTerminate();
+		
+		const char *section = p;
+		
+		p += padded_bytes;
+		return section;
+	};
+	
+	// Table sizes section
+	const int32_t *table_sizes = (const int32_t *)next_section(8 * sizeof(int32_t));
+	int32_t subpop_count = table_sizes[0];
+	int32_t mutation_count = table_sizes[1];
+	int32_t run_count = table_sizes[2];
+	int32_t run_contents_count = table_sizes[3];
+	int32_t genome_count = table_sizes[4];
+	int32_t file_mutrun_count = table_sizes[5];
+	int32_t file_mutrun_length = table_sizes[6];
+	
+	if ((subpop_count < 0) || (mutation_count < 0) || (run_count < 0) || (run_contents_count < 0) || (genome_count < 0) || (file_mutrun_count < 1) || (file_mutrun_length < 1))
+		EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): table sizes out of range." << EidosTerminate();
+	if (table_sizes[7] != (int32_t)0xFFFF0000)
+		EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): missing section end after table sizes." << EidosTerminate();
+	
+	// Subpopulations section
+	const slim_objectid_t *subpop_ids = (const slim_objectid_t *)next_section(subpop_count * sizeof(slim_objectid_t));
+	const slim_popsize_t *subpop_sizes = (const slim_popsize_t *)next_section(subpop_count * sizeof(slim_popsize_t));
+	const int32_t *subpop_sex_flags = (const int32_t *)next_section(subpop_count * sizeof(int32_t));
+	const double *subpop_sex_ratios = (const double *)next_section(subpop_count * sizeof(double));
+	int64_t total_genome_count = 0;
+	
+	for (int32_t subpop_index = 0; subpop_index < subpop_count; ++subpop_index)
+	{
+		if (subpop_sex_flags[subpop_index] != sex_enabled_)
+			EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): sex vs. hermaphroditism mismatch between file and simulation." << EidosTerminate();
+		if ((subpop_sizes[subpop_index] < 1) || (subpop_sizes[subpop_index] > SLIM_MAX_SUBPOP_SIZE))
+			EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): subpopulation size out of range." << EidosTerminate();
+		
+		// Create the subpopulation
+		Subpopulation *new_subpop = population_.AddSubpopulation(subpop_ids[subpop_index], subpop_sizes[subpop_index], subpop_sex_ratios[subpop_index]);
+		
+		// define a new Eidos variable to refer to the new subpopulation
+		EidosSymbolTableEntry &symbol_entry = new_subpop->SymbolTableEntry();
+		
+		if (p_interpreter && p_interpreter->SymbolTable().ContainsSymbol(symbol_entry.first))
+			EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): new subpopulation symbol " << Eidos_StringForGlobalStringID(symbol_entry.first) << " was already defined prior to its definition here." << EidosTerminate();
+		
+		simulation_constants_->InitializeConstantSymbolEntry(symbol_entry);
+		
+		total_genome_count += 2 * (int64_t)subpop_sizes[subpop_index];
+	}
+	
+	if (total_genome_count != genome_count)
+		EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): genome count does not match the subpopulation sizes." << EidosTerminate();
+	
+	// Mutations section
+	const slim_mutationid_t *mutation_ids = (const slim_mutationid_t *)next_section(mutation_count * sizeof(slim_mutationid_t));
+	const slim_objectid_t *mutation_type_ids = (const slim_objectid_t *)next_section(mutation_count * sizeof(slim_objectid_t));
+	const slim_position_t *mutation_positions = (const slim_position_t *)next_section(mutation_count * sizeof(slim_position_t));
+	const slim_selcoeff_t *mutation_selection_coeffs = (const slim_selcoeff_t *)next_section(mutation_count * sizeof(slim_selcoeff_t));
+	const slim_selcoeff_t *mutation_dominance_coeffs = (const slim_selcoeff_t *)next_section(mutation_count * sizeof(slim_selcoeff_t));
+	const slim_objectid_t *mutation_subpop_indices = (const slim_objectid_t *)next_section(mutation_count * sizeof(slim_objectid_t));
+	const slim_generation_t *mutation_generations = (const slim_generation_t *)next_section(mutation_count * sizeof(slim_generation_t));
+	
+	next_section(mutation_count * sizeof(slim_refcount_t));		// prevalences; we don't use them when reading the pop data back in
+	
+	std::vector<MutationIndex> mutations(mutation_count);
+	
+	for (int32_t mutation_index = 0; mutation_index < mutation_count; ++mutation_index)
+	{
+		slim_objectid_t mutation_type_id = mutation_type_ids[mutation_index];
+		slim_selcoeff_t selection_coeff = mutation_selection_coeffs[mutation_index];
+		slim_selcoeff_t dominance_coeff = mutation_dominance_coeffs[mutation_index];
+		
+		// look up the mutation type from its index
+		auto found_muttype_pair = mutation_types_.find(mutation_type_id);
+		
+		if (found_muttype_pair == mutation_types_.end()) 
+			EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): mutation type m" << mutation_type_id << " has not been defined." << EidosTerminate();
+		
+		MutationType *mutation_type_ptr = found_muttype_pair->second;
+		
+		if (mutation_type_ptr->dominance_coeff_ != dominance_coeff)
+			EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): mutation type m" << mutation_type_id << " has dominance coefficient " << mutation_type_ptr->dominance_coeff_ << " that does not match the population file dominance coefficient of " << dominance_coeff << "." << EidosTerminate();
+		
+		// construct the new mutation; NOTE THAT THE STACKING POLICY IS NOT CHECKED HERE, AS THIS IS NOT CONSIDERED THE ADDITION OF A MUTATION!
+		MutationIndex new_mut_index = SLiM_NewMutationFromBlock();
+		
+		new (gSLiM_Mutation_Block + new_mut_index) Mutation(mutation_ids[mutation_index], mutation_type_ptr, mutation_positions[mutation_index], selection_coeff, mutation_subpop_indices[mutation_index], mutation_generations[mutation_index]);
+		
+		// add it to our local map, so we can find it when making runs, and to the population's mutation registry
+		mutations[mutation_index] = new_mut_index;
+		population_.mutation_registry_.emplace_back(new_mut_index);
+		
+		// all mutations seen here will be added to the simulation somewhere, so check and set pure_neutral_ and all_pure_neutral_DFE_
+		if (selection_coeff != 0.0)
+		{
+			pure_neutral_ = false;
+			mutation_type_ptr->all_pure_neutral_DFE_ = false;
+		}
+	}
+	
+	population_.cached_tally_genome_count_ = 0;
+	
+	// Mutation runs section; the runs are not constructed yet, since that depends on whether we can share them (see below)
+	const int64_t *run_offsets = (const int64_t *)next_section((run_count + 1) * sizeof(int64_t));
+	const int32_t *run_contents = (const int32_t *)next_section(run_contents_count * sizeof(int32_t));
+	
+	if ((run_offsets[0] != 0) || (run_offsets[run_count] != run_contents_count))
+		EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): mutation run offsets out of range." << EidosTerminate();
+	
+	for (int32_t run_index = 0; run_index < run_count; ++run_index)
+		if (run_offsets[run_index] > run_offsets[run_index + 1])
+			EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): mutation run offsets out of range." << EidosTerminate();
+	
+	for (int32_t contents_index = 0; contents_index < run_contents_count; ++contents_index)
+		if ((run_contents[contents_index] < 0) || (run_contents[contents_index] >= mutation_count))
+			EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): mutation " << run_contents[contents_index] << " has not been defined." << EidosTerminate();
+	
+	// Genomes section
+	const int32_t *genome_types = (const int32_t *)next_section(genome_count * sizeof(int32_t));
+	const int32_t *genome_runs = (const int32_t *)next_section((int64_t)genome_count * file_mutrun_count * sizeof(int32_t));
+	
+	// Individuals section
+	const double *spatial_positions = (const double *)next_section((genome_count / 2) * p_spatial_output_count * sizeof(double));
+	
+	if (*(const int32_t *)next_section(sizeof(int32_t)) != (int32_t)0xFFFF0000)
+		EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): missing section end after snapshot." << EidosTerminate();
+	
+	// If the chromosome is divided into runs the same way as when the file was written, the runs in the file can be used as they
+	// are, and shared by genomes as they were before; otherwise, each genome's mutations have to be divided into runs anew
+	bool share_runs = ((file_mutrun_count == chromosome_.mutrun_count_) && (file_mutrun_length == chromosome_.mutrun_length_));
+	std::vector<MutationRun_SP> runs;
+	
+	if (share_runs)
+	{
+		std::vector<MutationIndex> run_buffer;
+		
+		runs.resize(run_count);
+		
+		for (int32_t run_index = 0; run_index < run_count; ++run_index)
+		{
+			MutationRun *new_run = MutationRun::NewMutationRun();
+			
+			run_buffer.clear();
+			
+			for (int64_t contents_index = run_offsets[run_index]; contents_index < run_offsets[run_index + 1]; ++contents_index)
+				run_buffer.emplace_back(mutations[run_contents[contents_index]]);
+			
+			new_run->emplace_back_bulk(run_buffer.data(), run_buffer.size());
+			runs[run_index].reset(new_run);
+		}
+	}
+	
+	Mutation *mut_block_ptr = gSLiM_Mutation_Block;
+	int64_t genome_table_index = 0;
+	
+	for (int32_t subpop_index = 0; subpop_index < subpop_count; ++subpop_index)
+	{
+		Subpopulation &subpop = *population_.find(subpop_ids[subpop_index])->second;
+		slim_popsize_t subpop_size = subpop_sizes[subpop_index];
+		
+		for (slim_popsize_t genome_index = 0; genome_index < 2 * subpop_size; ++genome_index, ++genome_table_index)
+		{
+			Genome &genome = subpop.parent_genomes_[genome_index];
+			const int32_t *genome_run_indices = genome_runs + genome_table_index * file_mutrun_count;
+			
+			// Error-check the genome type
+			if (genome_types[genome_table_index] != (int32_t)genome.Type())
+				EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): genome type does not match the instantiated genome." << EidosTerminate();
+			
+			// Check the null genome state
+			if (genome_run_indices[0] == -1)
+			{
+				if (!genome.IsNull())
+					EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): genome is specified as null, but the instantiated genome is non-null." << EidosTerminate();
+				
+				continue;
+			}
+			
+			if (genome.IsNull())
+				EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): genome is specified as non-null, but the instantiated genome is null." << EidosTerminate();
+			
+			for (int file_run_index = 0; file_run_index < file_mutrun_count; ++file_run_index)
+				if ((genome_run_indices[file_run_index] < 0) || (genome_run_indices[file_run_index] >= run_count))
+					EIDOS_TERMINATION << "ERROR (SLiMSim::_InitializePopulationFromBinarySnapshot): mutation run index out of range." << EidosTerminate();
+			
+			if (share_runs)
+			{
+				for (int run_index = 0; run_index < file_mutrun_count; ++run_index)
+					genome.mutruns_[run_index] = runs[genome_run_indices[run_index]];
+			}
+			else
+			{
+				int32_t mutrun_length_ = genome.mutrun_length_;
+				int current_mutrun_index = -1;
+				MutationRun *current_mutrun = nullptr;
+				
+				for (int file_run_index = 0; file_run_index < file_mutrun_count; ++file_run_index)
+				{
+					int32_t run_table_index = genome_run_indices[file_run_index];
+					
+					for (int64_t contents_index = run_offsets[run_table_index]; contents_index < run_offsets[run_table_index + 1]; ++contents_index)
+					{
+						MutationIndex mutation = mutations[run_contents[contents_index]];
+						int mutrun_index = (mut_block_ptr + mutation)->position_ / mutrun_length_;
+						
+						if (mutrun_index != current_mutrun_index)
+						{
+							current_mutrun_index = mutrun_index;
+							genome.WillModifyRun(current_mutrun_index);
+							
+							current_mutrun = genome.mutruns_[mutrun_index].get();
+						}
+						
+						current_mutrun->emplace_back(mutation);
+					}
+				}
+			}
+		}
+		
+		// Read in individual spatial position information
+		if (p_spatial_output_count)
+		{
+			for (slim_popsize_t individual_index = 0; individual_index < subpop_size; ++individual_index)
+			{
+				Individual &individual = subpop.parent_individuals_[individual_index];
+				
+				if (p_spatial_output_count >= 1)
+					individual.spatial_x_ = *(spatial_positions++);
+				if (p_spatial_output_count >= 2)
+					individual.spatial_y_ = *(spatial_positions++);
+				if (p_spatial_output_count >= 3)
+					individual.spatial_z_ = *(spatial_positions++);
+			}
+		}
+	}
+	
+	// Runs that were shared in the file are shared again already; runs built anew need to be uniqued as for earlier versions
+	if (!share_runs)
+		population_.UniqueMutationRuns();
+}
 #else
-// the static analyzer has a lot of trouble understanding this method
+// the static analyzer has a lot of trouble understanding these methods
 slim_generation_t SLiMSim::_InitializePopulationFromBinaryFile(const char *p_file, EidosInterpreter *p_interpreter)
 {
 	return 0;
 }
+
+void SLiMSim::_InitializePopulationFromBinarySnapshot(const char *p, const char *buf_end, int32_t p_spatial_output_count, EidosInterpreter *p_interpreter)
+{
+}
 #endif
 
 void SLiMSim::ValidateScriptBlockCaches(void)
@@ -1379,6 +1675,180 @@ std::vector<SLiMEidosBlock*> &SLiMSim::AllScriptBlocks()
 	return script_blocks_;
 }
 
+// Compile the expression at p_node, in a callback of type p_block_type, into a native closure for OptimizeScriptBlock().  The expressions accepted are
+// numeric constants; the float parameters of the callback; accelerated integer and float properties of its object parameters; the operators + - * / % ^
+// and unary -; and calls to exp(), log(), sqrt(), and abs() with one unnamed argument.  Nothing else is compiled; the interpreter handles it, including
+// all error cases.  p_is_float is set to true if the expression's value is float in Eidos, false if integer.  Integer operations are never compiled
+// (integer arithmetic checks overflow and produces integer results, which we do not reproduce), so integer values appear only as operands of float
+// operations, where Eidos converts them to float just as we do.  Since Eidos does its float arithmetic with the same C++ operations, the results match.
+static bool SLiM_CompileNativeCallbackExpression(const EidosASTNode *p_node, SLiMEidosBlockType p_block_type, SLiMNativeExpression &p_expression, bool &p_is_float)
+{
+	EidosTokenType token_type = p_node->token_->token_type_;
+	size_t child_count = p_node->children_.size();
+	bool is_fitness_callback = ((p_block_type == SLiMEidosBlockType::SLiMEidosFitnessCallback) || (p_block_type == SLiMEidosBlockType::SLiMEidosFitnessGlobalCallback));
+	bool is_interaction_callback = (p_block_type == SLiMEidosBlockType::SLiMEidosInteractionCallback);
+	
+	if (p_node->HasCachedNumericValue())
+	{
+		// a number, or a negated number
+		const EidosASTNode *number_node = ((token_type == EidosTokenType::kTokenMinus) ? p_node->children_[0] : p_node);
+		double value = p_node->CachedNumericValue();
+		
+		p_is_float = (number_node->cached_value_->Type() == EidosValueType::kValueFloat);
+		p_expression = [value](const SLiMCallbackArguments &) { return value; };
+		return true;
+	}
+	
+	if (token_type == EidosTokenType::kTokenIdentifier)
+	{
+		// a float parameter of the callback
+		EidosGlobalStringID identifier_id = p_node->cached_stringID_;
+		
+		p_is_float = true;
+		
+		if (is_fitness_callback && (identifier_id == gID_relFitness))
+			p_expression = [](const SLiMCallbackArguments &p_args) { return p_args.relFitness_; };
+		else if (is_interaction_callback && (identifier_id == gID_distance))
+			p_expression = [](const SLiMCallbackArguments &p_args) { return p_args.distance_; };
+		else if (is_interaction_callback && (identifier_id == gID_strength))
+			p_expression = [](const SLiMCallbackArguments &p_args) { return p_args.strength_; };
+		else
+			return false;
+		
+		return true;
+	}
+	
+	if ((token_type == EidosTokenType::kTokenDot) && (child_count == 2))
+	{
+		// an accelerated integer or float property of an object parameter of the callback
+		const EidosASTNode *object_node = p_node->children_[0];
+		const EidosASTNode *property_node = p_node->children_[1];
+		
+		if ((object_node->token_->token_type_ != EidosTokenType::kTokenIdentifier) || (property_node->token_->token_type_ != EidosTokenType::kTokenIdentifier))
+			return false;
+		
+		EidosGlobalStringID object_id = object_node->cached_stringID_;
+		EidosObjectElement *SLiMCallbackArguments::*object_member;
+		const EidosObjectClass *object_class;
+		
+		if ((p_block_type == SLiMEidosBlockType::SLiMEidosFitnessCallback) && (object_id == gID_mut))
+			object_member = &SLiMCallbackArguments::mut_, object_class = gSLiM_Mutation_Class;
+		else if (is_fitness_callback && (object_id == gID_individual))
+			object_member = &SLiMCallbackArguments::individual_, object_class = gSLiM_Individual_Class;
+		else if (is_interaction_callback && (object_id == gID_receiver))
+			object_member = &SLiMCallbackArguments::receiver_, object_class = gSLiM_Individual_Class;
+		else if (is_interaction_callback && (object_id == gID_exerter))
+			object_member = &SLiMCallbackArguments::exerter_, object_class = gSLiM_Individual_Class;
+		else
+			return false;
+		
+		EidosGlobalStringID property_id = property_node->cached_stringID_;
+		const EidosPropertySignature *signature = object_class->SignatureForProperty(property_id);
+		
+		if (!signature || !signature->accelerated_get_)
+			return false;
+		
+		if (signature->value_mask_ == (kEidosValueMaskFloat | kEidosValueMaskSingleton))
+		{
+			p_is_float = true;
+			p_expression = [object_member, property_id](const SLiMCallbackArguments &p_args) { return (p_args.*object_member)->GetProperty_Accelerated_Float(property_id); };
+			return true;
+		}
+		if (signature->value_mask_ == (kEidosValueMaskInt | kEidosValueMaskSingleton))
+		{
+			p_is_float = false;
+			p_expression = [object_member, property_id](const SLiMCallbackArguments &p_args) { return (double)(p_args.*object_member)->GetProperty_Accelerated_Int(property_id); };
+			return true;
+		}
+		
+		return false;
+	}
+	
+	if ((token_type == EidosTokenType::kTokenMinus) && (child_count == 1))
+	{
+		// unary minus, for float operands only
+		SLiMNativeExpression operand;
+		bool operand_is_float;
+		
+		if (!SLiM_CompileNativeCallbackExpression(p_node->children_[0], p_block_type, operand, operand_is_float) || !operand_is_float)
+			return false;
+		
+		p_is_float = true;
+		p_expression = [operand](const SLiMCallbackArguments &p_args) { return -operand(p_args); };
+		return true;
+	}
+	
+	if (((token_type == EidosTokenType::kTokenPlus) || (token_type == EidosTokenType::kTokenMinus) || (token_type == EidosTokenType::kTokenMult) || (token_type == EidosTokenType::kTokenDiv) || (token_type == EidosTokenType::kTokenMod) || (token_type == EidosTokenType::kTokenExp)) && (child_count == 2))
+	{
+		// binary operators; + - * are integer operations for two integer operands, which we leave to the interpreter, but / % ^ are always float
+		SLiMNativeExpression first, second;
+		bool first_is_float, second_is_float;
+		
+		if (!SLiM_CompileNativeCallbackExpression(p_node->children_[0], p_block_type, first, first_is_float) || !SLiM_CompileNativeCallbackExpression(p_node->children_[1], p_block_type, second, second_is_float))
+			return false;
+		
+		p_is_float = true;
+		
+		switch (token_type)
+		{
+			case EidosTokenType::kTokenPlus:
+				if (!first_is_float && !second_is_float) return false;
+				p_expression = [first, second](const SLiMCallbackArguments &p_args) { return first(p_args) + second(p_args); };
+				return true;
+			case EidosTokenType::kTokenMinus:
+				if (!first_is_float && !second_is_float) return false;
+				p_expression = [first, second](const SLiMCallbackArguments &p_args) { return first(p_args) - second(p_args); };
+				return true;
+			case EidosTokenType::kTokenMult:
+				if (!first_is_float && !second_is_float) return false;
+				p_expression = [first, second](const SLiMCallbackArguments &p_args) { return first(p_args) * second(p_args); };
+				return true;
+			case EidosTokenType::kTokenDiv:
+				p_expression = [first, second](const SLiMCallbackArguments &p_args) { return first(p_args) / second(p_args); };
+				return true;
+			case EidosTokenType::kTokenMod:
+				p_expression = [first, second](const SLiMCallbackArguments &p_args) { return fmod(first(p_args), second(p_args)); };
+				return true;
+			default:
+				p_expression = [first, second](const SLiMCallbackArguments &p_args) { return pow(first(p_args), second(p_args)); };
+				return true;
+		}
+	}
+	
+	if ((token_type == EidosTokenType::kTokenLParen) && (child_count == 2))
+	{
+		// a call to a one-argument math function; abs() of an integer is an integer, with an overflow check, so it is left to the interpreter
+		const EidosASTNode *call_node = p_node->children_[0];
+		const EidosASTNode *argument_node = p_node->children_[1];
+		SLiMNativeExpression argument;
+		bool argument_is_float;
+		
+		if ((call_node->token_->token_type_ != EidosTokenType::kTokenIdentifier) || (argument_node->token_->token_type_ == EidosTokenType::kTokenAssign))
+			return false;
+		if (!SLiM_CompileNativeCallbackExpression(argument_node, p_block_type, argument, argument_is_float))
+			return false;
+		
+		const std::string &function_name = call_node->token_->token_string_;
+		
+		p_is_float = true;
+		
+		if (function_name == "exp")
+			p_expression = [argument](const SLiMCallbackArguments &p_args) { return exp(argument(p_args)); };
+		else if (function_name == "log")
+			p_expression = [argument](const SLiMCallbackArguments &p_args) { return log(argument(p_args)); };
+		else if (function_name == "sqrt")
+			p_expression = [argument](const SLiMCallbackArguments &p_args) { return sqrt(argument(p_args)); };
+		else if ((function_name == "abs") && argument_is_float)
+			p_expression = [argument](const SLiMCallbackArguments &p_args) { return fabs(argument(p_args)); };
+		else
+			return false;
+		
+		return true;
+	}
+	
+	return false;
+}
+
 void SLiMSim::OptimizeScriptBlock(SLiMEidosBlock *p_script_block)
 {
 	// The goal here is to look for specific structures in callbacks that we are able to optimize by short-circuiting
@@ -1581,6 +2051,34 @@ void SLiMSim::OptimizeScriptBlock(SLiMEidosBlock *p_script_block)
 //				std::cout << "NOT OPTIMIZED:" << std::endl << "   " << p_script_block->script_->String() << std::endl;
 		}
 	}
+	
+	// More generally, callbacks that return a float computed by simple arithmetic on their parameters can be compiled into a native closure; this
+	// covers bodies of the form { return <expr>; } and { <expr>; } for fitness() and interaction() callbacks, with <expr> as described above
+	if (!p_script_block->has_cached_optimization_)
+	{
+		if ((p_script_block->type_ == SLiMEidosBlockType::SLiMEidosFitnessCallback) || (p_script_block->type_ == SLiMEidosBlockType::SLiMEidosFitnessGlobalCallback) || (p_script_block->type_ == SLiMEidosBlockType::SLiMEidosInteractionCallback))
+		{
+			const EidosASTNode *base_node = p_script_block->compound_statement_node_;
+			
+			if ((base_node->token_->token_type_ == EidosTokenType::kTokenLBrace) && (base_node->children_.size() == 1) && !base_node->cached_value_)
+			{
+				const EidosASTNode *expr_node = base_node->children_[0];
+				
+				if ((expr_node->token_->token_type_ == EidosTokenType::kTokenReturn) && (expr_node->children_.size() == 1))
+					expr_node = expr_node->children_[0];
+				
+				SLiMNativeExpression expression;
+				bool is_float;
+				
+				if (SLiM_CompileNativeCallbackExpression(expr_node, p_script_block->type_, expression, is_float) && is_float)
+				{
+					p_script_block->has_cached_optimization_ = true;
+					p_script_block->has_cached_opt_native_ = true;
+					p_script_block->cached_opt_native_ = expression;
+				}
+			}
+		}
+	}
 }
 
 void SLiMSim::AddScriptBlock(SLiMEidosBlock *p_script_block, EidosInterpreter *p_interpreter, const EidosToken *p_error_token)
@@ -1696,6 +2194,7 @@ void SLiMSim::RunInitializeCallbacks(void)
 	num_gene_conversions_ = 0;
 	num_sex_declarations_ = 0;
 	num_options_declarations_ = 0;
+	num_treeseq_declarations_ = 0;
 	
 	if (DEBUG_INPUT)
 		SLIM_OUTSTREAM << "// RunInitializeCallbacks():" << std::endl;
@@ -1713,14 +2212,14 @@ void SLiMSim::RunInitializeCallbacks(void)
 	{
 		if (script_block->active_)
 		{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_START();
 #endif
 			
 			population_.ExecuteScript(script_block, generation_, chromosome_);
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_END(profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosInitializeCallback)]);
 #endif
@@ -1772,6 +2271,10 @@ void SLiMSim::RunInitializeCallbacks(void)
 	chromosome_.InitializeDraws();
 	chromosome_.ChooseMutationRunLayout(preferred_mutrun_count_);
 	
+	// set up tree sequence recording, now that the chromosome length is known
+	if (recording_tree_seq_)
+		tree_seq_ = new TreeSequence(chromosome_.last_position_ + 1, tree_seq_simplification_ratio_);
+	
 	// kick off mutation run experiments, if needed
 	InitiateMutationRunExperiments();
 	
@@ -1827,6 +2330,12 @@ void SLiMSim::InitiateMutationRunExperiments(void)
 	x_prev1_stasis_mutcount_ = 0;		// we have never reached stasis before, so we have no memory of it
 	x_prev2_stasis_mutcount_ = 0;		// we have never reached stasis before, so we have no memory of it
 	
+#if SLIM_MUTRUN_COST_MODEL
+	x_model_generations_ = 0;
+	x_model_genome_runs_ = 0;
+	population_.assembled_mutrun_count_ = 0;
+#endif
+	
 	if (SLiM_verbose_output)
 	{
 		SLIM_OUTSTREAM << std::endl;
@@ -2188,115 +2697,675 @@ void SLiMSim::MaintainMutationRunExperiments(double p_last_gen_runtime)
 						if (SLiM_verbose_output)
 							SLIM_OUTSTREAM << "// ** " << generation_ << " : Experiment failed at " << x_current_mutcount_ << ", opposite side untried, reversing trend back to " << new_mutcount << " (against " << x_previous_mutcount_ << ")" << std::endl;
 #endif
-						
-						TransitionToNewExperimentAgainstPreviousExperiment(new_mutcount);
-						x_continuing_trend_ = true;
-					}
-				}
-			}
-		}
-	}
+						
+						TransitionToNewExperimentAgainstPreviousExperiment(new_mutcount);
+						x_continuing_trend_ = true;
+					}
+				}
+			}
+		}
+	}
+	
+	// Promulgate the new mutation run count
+	PromulgateMutationRunCount();
+}
+
+#if SLIM_MUTRUN_COST_MODEL
+double SLiMSim::PredictedMutationRunCost(int32_t p_mutrun_count, double p_events_per_genome, double p_mutations_per_genome)
+{
+	// Events (crossover breakpoints and new mutations) are assumed to fall independently and uniformly along the chromosome, so a
+	// given run of a child genome has to be assembled, rather than shared with a parent, with probability 1 - exp(-events/count).
+	// The mutations copied into an assembled run are, on average, the mutations per genome divided by the count.  Every run of every
+	// genome also costs something each generation, whether it is shared or not.  The cost returned is per genome per generation.
+	double assembled_fraction = -expm1(-p_events_per_genome / p_mutrun_count);
+	
+	return p_mutrun_count * (SLIM_MUTRUN_COST_PER_VISIT + assembled_fraction * SLIM_MUTRUN_COST_PER_ASSEMBLY) + assembled_fraction * p_mutations_per_genome * SLIM_MUTRUN_COST_PER_MUTATION;
+}
+
+void SLiMSim::MaintainMutationRunCostModel(void)
+{
+	// Remember the history of the mutation run count
+	x_mutcount_history_.push_back(x_current_mutcount_);
+	
+	// Pool the work counts for the offspring generation just done; the children are now the parental generation
+	for (std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : population_)
+		x_model_genome_runs_ += (int64_t)subpop_pair.second->parent_genomes_.size() * x_current_mutcount_;
+	
+	if (++x_model_generations_ < SLIM_MUTRUN_MODEL_INTERVAL)
+		return;
+	
+	// Count the mutations per (non-null) genome in the current population, by summing run lengths
+	int64_t genome_count = 0, mutation_count = 0;
+	
+	for (std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : population_)
+	{
+		for (Genome &genome : subpop_pair.second->parent_genomes_)
+		{
+			if (!genome.IsNull())
+			{
+				genome_count++;
+				mutation_count += genome.mutation_count();
+			}
+		}
+	}
+	
+	// Fit the model: the fraction of runs that had to be assembled gives the rate of events per genome, by inverting the
+	// relationship used by PredictedMutationRunCost().  If every run was assembled the rate is censored, so we cap the
+	// fraction; the model will then favor more runs, and the next assessment will refine the estimate.
+	int64_t assembled_count = population_.assembled_mutrun_count_;
+	
+	if ((genome_count > 0) && (x_model_genome_runs_ > 0))
+	{
+		double assembled_fraction = std::min(assembled_count / (double)x_model_genome_runs_, 0.999);
+		double events_per_genome = -x_current_mutcount_ * log1p(-assembled_fraction);
+		double mutations_per_genome = mutation_count / (double)genome_count;
+		double current_cost = PredictedMutationRunCost(x_current_mutcount_, events_per_genome, mutations_per_genome);
+		double best_cost = current_cost;
+		int32_t best_mutcount = x_current_mutcount_;
+		
+		for (int32_t mutcount = 1; mutcount <= SLIM_MUTRUN_MAXIMUM_COUNT; mutcount *= 2)
+		{
+			double cost = PredictedMutationRunCost(mutcount, events_per_genome, mutations_per_genome);
+			
+			if (cost < best_cost)
+			{
+				best_cost = cost;
+				best_mutcount = mutcount;
+			}
+		}
+		
+#if MUTRUN_EXPERIMENT_OUTPUT
+		if (SLiM_verbose_output)
+		{
+			SLIM_OUTSTREAM << "// " << generation_ << " : Mutation run cost model: " << events_per_genome << " events and " << mutations_per_genome << " mutations per genome; ";
+			SLIM_OUTSTREAM << "predicted cost " << current_cost << " at " << x_current_mutcount_ << ", " << best_cost << " at " << best_mutcount << std::endl;
+		}
+#endif
+		
+		// Move to the best count only if the predicted gain is worthwhile, so that we don't flip back and forth between two counts
+		// that cost about the same; splitting and joining runs is not free, and can undo sharing that interning has achieved
+		if (best_cost < current_cost * SLIM_MUTRUN_MODEL_HYSTERESIS)
+			x_current_mutcount_ = best_mutcount;
+	}
+	
+	x_model_generations_ = 0;
+	x_model_genome_runs_ = 0;
+	population_.assembled_mutrun_count_ = 0;
+	
+	PromulgateMutationRunCount();
+}
+#endif
+
+void SLiMSim::PromulgateMutationRunCount(void)
+{
+	if (x_current_mutcount_ != chromosome_.mutrun_count_)
+	{
+		// Fix all genomes.  We could do this by brute force, by making completely new mutation runs for every
+		// existing genome and then calling Population::UniqueMutationRuns(), but that would be inefficient,
+		// and would also cause a huge memory usage spike.  Instead, we want to preserve existing redundancy.
+		int32_t original_mutcount = chromosome_.mutrun_count_;
+		
+		while (x_current_mutcount_ > chromosome_.mutrun_count_)
+		{
+#if MUTRUN_EXPERIMENT_OUTPUT
+			clock_t start_clock = clock();
+#endif
+			
+			// We are splitting existing runs in two, so make a map from old mutrun index to new pair of
+			// mutrun indices; every time we encounter the same old index we will substitute the same pair.
+			population_.SplitMutationRuns(chromosome_.mutrun_count_ * 2);
+			
+			// Fix the chromosome values
+			chromosome_.mutrun_count_ *= 2;
+			chromosome_.mutrun_length_ /= 2;
+			
+#if MUTRUN_EXPERIMENT_OUTPUT
+			if (SLiM_verbose_output)
+				SLIM_OUTSTREAM << "// ++ Splitting to achieve new mutation run count of " << chromosome_.mutrun_count_ << " took " << ((clock() - start_clock) / (double)CLOCKS_PER_SEC) << " seconds" << std::endl;
+#endif
+		}
+		
+		while (x_current_mutcount_ < chromosome_.mutrun_count_)
+		{
+#if MUTRUN_EXPERIMENT_OUTPUT
+			clock_t start_clock = clock();
+#endif
+			
+			// We are joining existing runs together, so make a map from old mutrun index pairs to a new
+			// index; every time we encounter the same pair of indices we will substitute the same index.
+			population_.JoinMutationRuns(chromosome_.mutrun_count_ / 2);
+			
+			// Fix the chromosome values
+			chromosome_.mutrun_count_ /= 2;
+			chromosome_.mutrun_length_ *= 2;
+			
+#if MUTRUN_EXPERIMENT_OUTPUT
+			if (SLiM_verbose_output)
+				SLIM_OUTSTREAM << "// ++ Joining to achieve new mutation run count of " << chromosome_.mutrun_count_ << " took " << ((clock() - start_clock) / (double)CLOCKS_PER_SEC) << " seconds" << std::endl;
+#endif
+		}
+		
+		// Runs freed by splitting have buffers sized for the old run length; release those, so they don't inflate memory usage as they get recycled
+		if (chromosome_.mutrun_count_ > original_mutcount)
+			MutationRun::TrimMutationRunFreeList();
+		
+		if (chromosome_.mutrun_count_ != x_current_mutcount_)
+			EIDOS_TERMINATION << "ERROR (SLiMSim::PromulgateMutationRunCount): Failed to transition to new mutation run count" << x_current_mutcount_ << "." << EidosTerminate();
+	}
+}
+
+#if (SLIMPROFILING == 1)
+// PROFILING
+#if SLIM_USE_NONNEUTRAL_CACHES
+void SLiMSim::CollectSLiMguiMutationProfileInfo(void)
+{
+	// maintain our history of the number of mutruns per genome and the nonneutral regime
+	profile_mutcount_history_.push_back(chromosome_.mutrun_count_);
+	profile_nonneutral_regime_history_.push_back(last_nonneutral_regime_);
+	
+	// track the maximum number of mutations in existence at one time
+	profile_max_mutation_index_ = std::max(profile_max_mutation_index_, (int64_t)(population_.mutation_registry_.size()));
+	
+	// tally up the number of mutation runs, mutation usage metrics, etc.
+	int64_t operation_id = ++gSLiM_MutationRun_OperationID;
+	
+	for (std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : population_)
+	{
+		Subpopulation *subpop = subpop_pair.second;
+		std::vector<Genome> &subpop_genomes = subpop->parent_genomes_;
+		
+		for (Genome &genome : subpop_genomes)
+		{
+			MutationRun_SP *mutruns = genome.mutruns_;
+			int32_t mutrun_count = genome.mutrun_count_;
+			
+			profile_mutrun_total_usage_ += mutrun_count;
+			
+			for (int32_t mutrun_index = 0; mutrun_index < mutrun_count; ++mutrun_index)
+			{
+				MutationRun *mutrun = mutruns[mutrun_index].get();
+				
+				if (mutrun)
+				{
+					if (mutrun->operation_id_ != operation_id)
+					{
+						mutrun->operation_id_ = operation_id;
+						profile_unique_mutrun_total_++;
+					}
+					
+					// tally the total and nonneutral mutations
+					mutrun->tally_nonneutral_mutations(&profile_mutation_total_usage_, &profile_nonneutral_mutation_total_, &profile_mutrun_nonneutral_recache_total_);
+				}
+			}
+		}
+	}
+}
+#endif
+#endif
+
+#if (SLIMPROFILING == 1)
+// PROFILING
+
+// This is the command-line counterpart of the profiling support in SLiMWindowController: the setup done here matches
+// -startProfiling there, and the reports present the same information, as plain text or as JSON for other tools.
+
+// One line of script and the time spent executing it, for the "hottest lines" section of a profile report
+struct SLiMProfileLine {
+	eidos_profile_t total_;			// the total of the self counts for all nodes that start on this line
+	std::string source_;			// "script" for the input file, otherwise a description of a dynamic block or a function
+	int32_t line_;					// 1-based line number within the script for source_
+	std::string text_;				// the text of the line, with leading whitespace removed
+};
+
+static void SLiM_TallyProfileLines(const EidosASTNode *p_node, const std::string &p_script_string, std::map<int32_t, eidos_profile_t> &p_line_totals)
+{
+	// relies on ConvertProfileTotalsToSelfCounts() having been called, so that time is not counted on more than one line
+	if (p_node->profile_total_)
+	{
+		int32_t position = std::min(std::max(p_node->token_->token_start_, 0), (int32_t)p_script_string.length());
+		int32_t line = (int32_t)std::count(p_script_string.begin(), p_script_string.begin() + position, '\n') + 1;
+		
+		p_line_totals[line] += p_node->profile_total_;
+	}
+	
+	for (const EidosASTNode *child : p_node->children_)
+		SLiM_TallyProfileLines(child, p_script_string, p_line_totals);
+}
+
+static void SLiM_AddProfileLines(const EidosASTNode *p_root, const std::string &p_script_string, const std::string &p_source, std::vector<SLiMProfileLine> &p_lines)
+{
+	std::map<int32_t, eidos_profile_t> line_totals;
+	
+	SLiM_TallyProfileLines(p_root, p_script_string, line_totals);
+	
+	for (auto &line_pair : line_totals)
+	{
+		// find the text of the line; line_pair.first is 1-based
+		size_t line_start = 0;
+		
+		for (int32_t line = 1; (line < line_pair.first) && (line_start != std::string::npos); ++line)
+		{
+			line_start = p_script_string.find('\n', line_start);
+			
+			if (line_start != std::string::npos)
+				line_start++;
+		}
+		
+		std::string line_text;
+		
+		if (line_start != std::string::npos)
+		{
+			size_t line_end = p_script_string.find('\n', line_start);
+			
+			line_text = p_script_string.substr(line_start, (line_end == std::string::npos) ? std::string::npos : line_end - line_start);
+			line_text.erase(0, line_text.find_first_not_of(" \t"));
+		}
+		
+		p_lines.push_back(SLiMProfileLine{line_pair.second, p_source, line_pair.first, line_text});
+	}
+}
+
+static void SLiM_ProfileHotLines(std::vector<SLiMEidosBlock*> &p_script_blocks, EidosFunctionMap &p_function_map, const std::string &p_file_script_string, std::vector<SLiMProfileLine> &p_lines, size_t p_max_lines)
+{
+	// Script blocks derived from the input file share its string, and token positions are relative to it; dynamic
+	// blocks and user-defined functions have their own scripts, so their lines are numbered within those scripts
+	for (SLiMEidosBlock *script_block : p_script_blocks)
+	{
+		if (script_block->type_ == SLiMEidosBlockType::SLiMEidosUserDefinedFunction)
+			continue;
+		
+		if (script_block->script_)
+		{
+			std::string source = "dynamic block" + ((script_block->block_id_ == -1) ? std::string() : (" s" + std::to_string(script_block->block_id_)));
+			
+			SLiM_AddProfileLines(script_block->root_node_, script_block->script_->String(), source, p_lines);
+		}
+		else
+		{
+			SLiM_AddProfileLines(script_block->root_node_, p_file_script_string, "script", p_lines);
+		}
+	}
+	
+	for (auto functionPairIter = p_function_map.begin(); functionPairIter != p_function_map.end(); ++functionPairIter)
+	{
+		const EidosFunctionSignature *signature = functionPairIter->second.get();
+		
+		if (signature->body_script_ && signature->user_defined_)
+			SLiM_AddProfileLines(signature->body_script_->AST(), signature->body_script_->String(), "function " + signature->call_name_ + "()", p_lines);
+	}
+	
+	std::sort(p_lines.begin(), p_lines.end(), [](const SLiMProfileLine &l1, const SLiMProfileLine &l2) { return l1.total_ > l2.total_; });
+	
+	if (p_lines.size() > p_max_lines)
+		p_lines.resize(p_max_lines);
+}
+
+static std::string SLiM_JSONString(const std::string &p_string)
+{
+	std::string result("\"");
+	
+	for (char ch : p_string)
+	{
+		switch (ch)
+		{
+			case '"':	result.append("\\\""); break;
+			case '\\':	result.append("\\\\"); break;
+			case '\n':	result.append("\\n"); break;
+			case '\r':	result.append("\\r"); break;
+			case '\t':	result.append("\\t"); break;
+			default:
+				if ((unsigned char)ch < 0x20)
+				{
+					char buffer[8];
+					
+					snprintf(buffer, 8, "\\u%04x", (unsigned int)(unsigned char)ch);
+					result.append(buffer);
+				}
+				else
+				{
+					result.push_back(ch);
+				}
+				break;
+		}
+	}
+	
+	result.push_back('"');
+	return result;
+}
+
+static void SLiM_WriteProfileTime(std::ostream &p_out, double p_elapsed_time, double p_total_time, const char *p_label)
+{
+	char buffer[64];
+	
+	snprintf(buffer, 64, "%10.3f s (%6.2f%%)", p_elapsed_time, (p_total_time > 0.0) ? (p_elapsed_time / p_total_time) * 100.0 : 0.0);
+	p_out << buffer << " : " << p_label << std::endl;
+}
+
+// The generation stages and callback types, in generation-cycle order, with the names used in profile reports
+static const int gSLiM_ProfileStageCount = 7;
+static const char *gSLiM_ProfileStageNames[gSLiM_ProfileStageCount] = {"initialize() callback execution", "stage 1 - early() event execution", "stage 2 - offspring generation", "stage 3 - bookkeeping (fixed mutation removal, etc.)", "stage 4 - generation swap", "stage 5 - late() event execution", "stage 6 - fitness calculation"};
+static const char *gSLiM_ProfileStageKeys[gSLiM_ProfileStageCount] = {"initialize", "early", "offspring", "bookkeeping", "swap", "late", "fitness"};
+
+static const int gSLiM_ProfileCallbackCount = 9;
+static const SLiMEidosBlockType gSLiM_ProfileCallbackTypes[gSLiM_ProfileCallbackCount] = {SLiMEidosBlockType::SLiMEidosInitializeCallback, SLiMEidosBlockType::SLiMEidosEventEarly, SLiMEidosBlockType::SLiMEidosMateChoiceCallback, SLiMEidosBlockType::SLiMEidosRecombinationCallback, SLiMEidosBlockType::SLiMEidosModifyChildCallback, SLiMEidosBlockType::SLiMEidosEventLate, SLiMEidosBlockType::SLiMEidosFitnessCallback, SLiMEidosBlockType::SLiMEidosFitnessGlobalCallback, SLiMEidosBlockType::SLiMEidosInteractionCallback};
+static const char *gSLiM_ProfileCallbackNames[gSLiM_ProfileCallbackCount] = {"initialize() callbacks", "early() events", "mateChoice() callbacks", "recombination() callbacks", "modifyChild() callbacks", "late() events", "fitness() callbacks", "fitness() callbacks (global)", "interaction() callbacks"};
+static const char *gSLiM_ProfileCallbackKeys[gSLiM_ProfileCallbackCount] = {"initialize", "early", "mateChoice", "recombination", "modifyChild", "late", "fitness", "fitnessGlobal", "interaction"};
+
+static const size_t gSLiM_ProfileHotLineCount = 20;
+
+void SLiMSim::StartProfiling(void)
+{
+	// prepare for profiling by measuring profile block overhead and lag
+	Eidos_PrepareForProfiling();
+	gEidosProfilingClientCount++;
+	
+	profile_elapsed_wall_clock_ = 0;
+	profile_elapsed_cpu_clock_ = 0;
+	profile_start_generation_ = generation_;
+
+#if SLIM_USE_NONNEUTRAL_CACHES
+	// call this first, which has the side effect of emptying out any pending profile counts
+	CollectSLiMguiMutationProfileInfo();
+#endif
 	
-	// Promulgate the new mutation run count
-	if (x_current_mutcount_ != chromosome_.mutrun_count_)
+	// zero out profile counts for generation stages and callback types
+	for (int stage = 0; stage < gSLiM_ProfileStageCount; ++stage)
+		profile_stage_totals_[stage] = 0;
+	
+	for (int callback_type = 0; callback_type < gSLiM_ProfileCallbackCount; ++callback_type)
+		profile_callback_totals_[callback_type] = 0;
+	
+	// zero out profile counts for script blocks and user-defined functions; dynamic scripts will be zeroed on construction
+	for (SLiMEidosBlock *script_block : AllScriptBlocks())
+		if (script_block->type_ != SLiMEidosBlockType::SLiMEidosUserDefinedFunction)
+			script_block->root_node_->ZeroProfileTotals();
+	
+	for (auto functionPairIter = simulation_functions_.begin(); functionPairIter != simulation_functions_.end(); ++functionPairIter)
 	{
-		// Fix all genomes.  We could do this by brute force, by making completely new mutation runs for every
-		// existing genome and then calling Population::UniqueMutationRuns(), but that would be inefficient,
-		// and would also cause a huge memory usage spike.  Instead, we want to preserve existing redundancy.
+		const EidosFunctionSignature *signature = functionPairIter->second.get();
 		
-		while (x_current_mutcount_ > chromosome_.mutrun_count_)
-		{
-#if MUTRUN_EXPERIMENT_OUTPUT
-			clock_t start_clock = clock();
-#endif
-			
-			// We are splitting existing runs in two, so make a map from old mutrun index to new pair of
-			// mutrun indices; every time we encounter the same old index we will substitute the same pair.
-			population_.SplitMutationRuns(chromosome_.mutrun_count_ * 2);
-			
-			// Fix the chromosome values
-			chromosome_.mutrun_count_ *= 2;
-			chromosome_.mutrun_length_ /= 2;
-			
-#if MUTRUN_EXPERIMENT_OUTPUT
-			if (SLiM_verbose_output)
-				SLIM_OUTSTREAM << "// ++ Splitting to achieve new mutation run count of " << chromosome_.mutrun_count_ << " took " << ((clock() - start_clock) / (double)CLOCKS_PER_SEC) << " seconds" << std::endl;
+		if (signature->body_script_ && signature->user_defined_)
+			signature->body_script_->AST()->ZeroProfileTotals();
+	}
+
+#if SLIM_USE_NONNEUTRAL_CACHES
+	// zero out mutation run metrics
+	profile_mutcount_history_.clear();
+	profile_nonneutral_regime_history_.clear();
+	profile_mutation_total_usage_ = 0;
+	profile_nonneutral_mutation_total_ = 0;
+	profile_mutrun_total_usage_ = 0;
+	profile_unique_mutrun_total_ = 0;
+	profile_mutrun_nonneutral_recache_total_ = 0;
+	profile_max_mutation_index_ = 0;
 #endif
-		}
+}
+
+void SLiMSim::EndProfiling(eidos_profile_t p_elapsed_wall_clock, clock_t p_elapsed_cpu_clock)
+{
+	gEidosProfilingClientCount--;
+	
+	profile_elapsed_wall_clock_ = p_elapsed_wall_clock;
+	profile_elapsed_cpu_clock_ = p_elapsed_cpu_clock;
+	
+	// Convert the profile counts in all script blocks and user-defined functions into self counts (excluding the counts of
+	// nodes below them); the reports rely on this having been done, and it must be done only once
+	for (SLiMEidosBlock *script_block : AllScriptBlocks())
+		if (script_block->type_ != SLiMEidosBlockType::SLiMEidosUserDefinedFunction)
+			script_block->root_node_->ConvertProfileTotalsToSelfCounts();
+	
+	for (auto functionPairIter = simulation_functions_.begin(); functionPairIter != simulation_functions_.end(); ++functionPairIter)
+	{
+		const EidosFunctionSignature *signature = functionPairIter->second.get();
 		
-		while (x_current_mutcount_ < chromosome_.mutrun_count_)
-		{
-#if MUTRUN_EXPERIMENT_OUTPUT
-			clock_t start_clock = clock();
-#endif
-			
-			// We are joining existing runs together, so make a map from old mutrun index pairs to a new
-			// index; every time we encounter the same pair of indices we will substitute the same index.
-			population_.JoinMutationRuns(chromosome_.mutrun_count_ / 2);
-			
-			// Fix the chromosome values
-			chromosome_.mutrun_count_ /= 2;
-			chromosome_.mutrun_length_ *= 2;
-			
-#if MUTRUN_EXPERIMENT_OUTPUT
-			if (SLiM_verbose_output)
-				SLIM_OUTSTREAM << "// ++ Joining to achieve new mutation run count of " << chromosome_.mutrun_count_ << " took " << ((clock() - start_clock) / (double)CLOCKS_PER_SEC) << " seconds" << std::endl;
+		if (signature->body_script_ && signature->user_defined_)
+			signature->body_script_->AST()->ConvertProfileTotalsToSelfCounts();
+	}
+}
+
+void SLiMSim::WriteProfileReport(std::ostream &p_out)
+{
+	double elapsed_wall_clock_time = Eidos_ElapsedProfileTime(profile_elapsed_wall_clock_);
+	double elapsed_cpu_time = profile_elapsed_cpu_clock_ / (double)CLOCKS_PER_SEC;
+	
+	p_out << "SLiM profile report" << std::endl << std::endl;
+	
+	p_out << "Elapsed wall clock time inside SLiM core (corrected): " << elapsed_wall_clock_time << " s" << std::endl;
+	p_out << "Elapsed CPU time inside SLiM core (uncorrected): " << elapsed_cpu_time << " s" << std::endl;
+	p_out << "Elapsed generations: " << (generation_ - profile_start_generation_) << ((profile_start_generation_ == 0) ? " (including initialize)" : "") << std::endl;
+	
+	// Report the threads this simulation divided its parallel work among; a build without OpenMP runs those blocks of work one after another
+#ifdef _OPENMP
+	p_out << "Threads: " << ThreadCount() << std::endl;
+#else
+	if (ThreadCount() > 1)
+		p_out << "Threads: 1 (work divided for " << ThreadCount() << " threads, in a build without OpenMP)" << std::endl;
+	else
+		p_out << "Threads: 1" << std::endl;
 #endif
-		}
+	p_out << std::endl;
+	
+	p_out << "Profile block external overhead: " << gEidos_ProfileOverheadTicks << " ticks (" << gEidos_ProfileOverheadSeconds << " s)" << std::endl;
+	p_out << "Profile block internal lag: " << gEidos_ProfileLagTicks << " ticks (" << gEidos_ProfileLagSeconds << " s)" << std::endl;
+	
+	//
+	//	Generation stage breakdown
+	//
+	p_out << std::endl << "Generation stage breakdown" << std::endl << std::endl;
+	
+	for (int stage = 0; stage < gSLiM_ProfileStageCount; ++stage)
+		SLiM_WriteProfileTime(p_out, Eidos_ElapsedProfileTime(profile_stage_totals_[stage]), elapsed_wall_clock_time, gSLiM_ProfileStageNames[stage]);
+	
+	//
+	//	Callback type breakdown
+	//
+	p_out << std::endl << "Callback type breakdown" << std::endl << std::endl;
+	
+	for (int callback_index = 0; callback_index < gSLiM_ProfileCallbackCount; ++callback_index)
+		SLiM_WriteProfileTime(p_out, Eidos_ElapsedProfileTime(profile_callback_totals_[(int)gSLiM_ProfileCallbackTypes[callback_index]]), elapsed_wall_clock_time, gSLiM_ProfileCallbackNames[callback_index]);
+	
+	//
+	//	Script blocks and user-defined functions
+	//
+	p_out << std::endl << "Script blocks and user-defined functions" << std::endl << std::endl;
+	
+	for (SLiMEidosBlock *script_block : AllScriptBlocks())
+	{
+		if (script_block->type_ == SLiMEidosBlockType::SLiMEidosUserDefinedFunction)
+			continue;
 		
-		if (chromosome_.mutrun_count_ != x_current_mutcount_)
-			EIDOS_TERMINATION << "ERROR (SLiMSim::MaintainMutationRunExperiments): Failed to transition to new mutation run count" << x_current_mutcount_ << "." << EidosTerminate();
+		double block_time = Eidos_ElapsedProfileTime(script_block->root_node_->TotalOfSelfCounts());	// relies on ConvertProfileTotalsToSelfCounts() in EndProfiling()
+		const std::string &block_string = script_block->root_node_->token_->token_string_;
+		std::string block_label = block_string.substr(0, block_string.find('\n'));
+		
+		SLiM_WriteProfileTime(p_out, block_time, elapsed_wall_clock_time, block_label.c_str());
 	}
-}
+	
+	for (auto functionPairIter = simulation_functions_.begin(); functionPairIter != simulation_functions_.end(); ++functionPairIter)
+	{
+		const EidosFunctionSignature *signature = functionPairIter->second.get();
+		
+		if (signature->body_script_ && signature->user_defined_)
+			SLiM_WriteProfileTime(p_out, Eidos_ElapsedProfileTime(signature->body_script_->AST()->TotalOfSelfCounts()), elapsed_wall_clock_time, signature->SignatureString().c_str());
+	}
+	
+	//
+	//	Hottest script lines
+	//
+	std::vector<SLiMProfileLine> hot_lines;
+	
+	SLiM_ProfileHotLines(AllScriptBlocks(), simulation_functions_, script_->String(), hot_lines, gSLiM_ProfileHotLineCount);
+	
+	p_out << std::endl << "Hottest script lines (self time)" << std::endl << std::endl;
+	
+	for (SLiMProfileLine &hot_line : hot_lines)
+	{
+		std::string label = hot_line.source_ + " line " + std::to_string(hot_line.line_) + ": " + hot_line.text_;
+		
+		SLiM_WriteProfileTime(p_out, Eidos_ElapsedProfileTime(hot_line.total_), elapsed_wall_clock_time, label.c_str());
+	}
+	
+	//
+	//	MutationRun metrics
+	//
+	p_out << std::endl << "MutationRun usage" << std::endl << std::endl;
+	
+	p_out << "Mutation run experiments: " << (x_experiments_enabled_ ? "enabled" : "disabled") << std::endl;
+	p_out << "Final mutation runs per genome: " << chromosome_.mutrun_count_ << std::endl;
 
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
-// PROFILING
 #if SLIM_USE_NONNEUTRAL_CACHES
-void SLiMSim::CollectSLiMguiMutationProfileInfo(void)
+	{
+		// the history of mutation run counts, as a distribution over powers of two, as in SLiMgui
+		int64_t power_tallies[20];	// we only go up to 1024 mutruns right now, but this gives us some headroom
+		int64_t power_tallies_total = (int64_t)profile_mutcount_history_.size();
+		
+		for (int power = 0; power < 20; ++power)
+			power_tallies[power] = 0;
+		
+		for (int32_t count : profile_mutcount_history_)
+			power_tallies[std::min(std::max((int)round(log2(count)), 0), 19)]++;
+		
+		p_out << std::endl;
+		
+		for (int power = 0; power < 20; ++power)
+			if (power_tallies[power] > 0)
+				p_out << std::setw(6) << std::fixed << std::setprecision(2) << (power_tallies[power] / (double)power_tallies_total) * 100.0 << std::defaultfloat << "% of generations : " << (1 << power) << " mutation runs per genome" << std::endl;
+		
+		int64_t regime_tallies[3] = {0, 0, 0};
+		int64_t regime_tallies_total = 0;
+		
+		for (int32_t regime : profile_nonneutral_regime_history_)
+			if ((regime >= 1) && (regime <= 3))
+			{
+				regime_tallies[regime - 1]++;
+				regime_tallies_total++;
+			}
+		
+		p_out << std::endl;
+		
+		for (int regime = 0; regime < 3; ++regime)
+			p_out << std::setw(6) << std::fixed << std::setprecision(2) << (regime_tallies_total ? (regime_tallies[regime] / (double)regime_tallies_total) * 100.0 : 0.0) << std::defaultfloat << "% of generations : regime " << (regime + 1) << " (" << (regime == 0 ? "no fitness callbacks" : (regime == 1 ? "constant neutral fitness callbacks only" : "unpredictable fitness callbacks present")) << ")" << std::endl;
+		
+		p_out << std::endl;
+		p_out << profile_mutation_total_usage_ << " mutations referenced, summed across all generations" << std::endl;
+		p_out << profile_nonneutral_mutation_total_ << " mutations considered potentially nonneutral" << std::endl;
+		p_out << profile_max_mutation_index_ << " maximum simultaneous mutations" << std::endl;
+		p_out << std::endl;
+		p_out << profile_mutrun_total_usage_ << " mutation runs referenced, summed across all generations" << std::endl;
+		p_out << profile_unique_mutrun_total_ << " unique mutation runs maintained among those" << std::endl;
+		p_out << profile_mutrun_nonneutral_recache_total_ << " mutation run nonneutral caches rebuilt" << std::endl;
+		
+		if (profile_unique_mutrun_total_)
+			p_out << std::fixed << std::setprecision(2) << (1.0 - profile_mutrun_nonneutral_recache_total_ / (double)profile_unique_mutrun_total_) * 100.0 << std::defaultfloat << "% nonneutral cache hit rate (caches reused without rebuilding)" << std::endl;
+		if (profile_mutrun_total_usage_)
+			p_out << std::fixed << std::setprecision(2) << ((profile_mutrun_total_usage_ - profile_unique_mutrun_total_) / (double)profile_mutrun_total_usage_) * 100.0 << std::defaultfloat << "% of mutation runs shared among genomes" << std::endl;
+	}
+#endif
+}
+
+void SLiMSim::WriteProfileReportJSON(std::ostream &p_out)
 {
-	// maintain our history of the number of mutruns per genome and the nonneutral regime
-	profile_mutcount_history_.push_back(chromosome_.mutrun_count_);
-	profile_nonneutral_regime_history_.push_back(last_nonneutral_regime_);
+	double elapsed_wall_clock_time = Eidos_ElapsedProfileTime(profile_elapsed_wall_clock_);
+	double elapsed_cpu_time = profile_elapsed_cpu_clock_ / (double)CLOCKS_PER_SEC;
+	std::ios_base::fmtflags saved_flags = p_out.flags();
+	std::streamsize saved_precision = p_out.precision();
+	
+	p_out << std::setprecision(9);
+	
+	p_out << "{" << std::endl;
+	p_out << "\t\"elapsedWallClockTime\": " << elapsed_wall_clock_time << "," << std::endl;
+	p_out << "\t\"elapsedCPUTime\": " << elapsed_cpu_time << "," << std::endl;
+	p_out << "\t\"startGeneration\": " << profile_start_generation_ << "," << std::endl;
+	p_out << "\t\"endGeneration\": " << generation_ << "," << std::endl;
+#ifdef _OPENMP
+	p_out << "\t\"threads\": " << ThreadCount() << "," << std::endl;
+#else
+	p_out << "\t\"threads\": 1," << std::endl;
+#endif
+	p_out << "\t\"threadBlocks\": " << ThreadCount() << "," << std::endl;
+	p_out << "\t\"profileOverheadSeconds\": " << gEidos_ProfileOverheadSeconds << "," << std::endl;
+	p_out << "\t\"profileLagSeconds\": " << gEidos_ProfileLagSeconds << "," << std::endl;
 	
-	// track the maximum number of mutations in existence at one time
-	profile_max_mutation_index_ = std::max(profile_max_mutation_index_, (int64_t)(population_.mutation_registry_.size()));
+	p_out << "\t\"stages\": {";
+	for (int stage = 0; stage < gSLiM_ProfileStageCount; ++stage)
+		p_out << (stage ? ", " : "") << "\"" << gSLiM_ProfileStageKeys[stage] << "\": " << Eidos_ElapsedProfileTime(profile_stage_totals_[stage]);
+	p_out << "}," << std::endl;
 	
-	// tally up the number of mutation runs, mutation usage metrics, etc.
-	int64_t operation_id = ++gSLiM_MutationRun_OperationID;
+	p_out << "\t\"callbacks\": {";
+	for (int callback_index = 0; callback_index < gSLiM_ProfileCallbackCount; ++callback_index)
+		p_out << (callback_index ? ", " : "") << "\"" << gSLiM_ProfileCallbackKeys[callback_index] << "\": " << Eidos_ElapsedProfileTime(profile_callback_totals_[(int)gSLiM_ProfileCallbackTypes[callback_index]]);
+	p_out << "}," << std::endl;
 	
-	for (std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : population_)
+	p_out << "\t\"scriptBlocks\": [";
 	{
-		Subpopulation *subpop = subpop_pair.second;
-		std::vector<Genome> &subpop_genomes = subpop->parent_genomes_;
+		bool first = true;
 		
-		for (Genome &genome : subpop_genomes)
+		for (SLiMEidosBlock *script_block : AllScriptBlocks())
 		{
-			MutationRun_SP *mutruns = genome.mutruns_;
-			int32_t mutrun_count = genome.mutrun_count_;
+			if (script_block->type_ == SLiMEidosBlockType::SLiMEidosUserDefinedFunction)
+				continue;
 			
-			profile_mutrun_total_usage_ += mutrun_count;
+			const std::string &block_string = script_block->root_node_->token_->token_string_;
 			
-			for (int32_t mutrun_index = 0; mutrun_index < mutrun_count; ++mutrun_index)
+			p_out << (first ? "" : ",") << std::endl << "\t\t{\"id\": " << ((script_block->block_id_ == -1) ? std::string("null") : std::to_string(script_block->block_id_)) << ", \"header\": " << SLiM_JSONString(block_string.substr(0, block_string.find('\n'))) << ", \"seconds\": " << Eidos_ElapsedProfileTime(script_block->root_node_->TotalOfSelfCounts()) << "}";
+			first = false;
+		}
+		
+		for (auto functionPairIter = simulation_functions_.begin(); functionPairIter != simulation_functions_.end(); ++functionPairIter)
+		{
+			const EidosFunctionSignature *signature = functionPairIter->second.get();
+			
+			if (signature->body_script_ && signature->user_defined_)
 			{
-				MutationRun *mutrun = mutruns[mutrun_index].get();
-				
-				if (mutrun)
-				{
-					if (mutrun->operation_id_ != operation_id)
-					{
-						mutrun->operation_id_ = operation_id;
-						profile_unique_mutrun_total_++;
-					}
-					
-					// tally the total and nonneutral mutations
-					mutrun->tally_nonneutral_mutations(&profile_mutation_total_usage_, &profile_nonneutral_mutation_total_, &profile_mutrun_nonneutral_recache_total_);
-				}
+				p_out << (first ? "" : ",") << std::endl << "\t\t{\"function\": " << SLiM_JSONString(signature->SignatureString()) << ", \"seconds\": " << Eidos_ElapsedProfileTime(signature->body_script_->AST()->TotalOfSelfCounts()) << "}";
+				first = false;
 			}
 		}
 	}
-}
-#endif
+	p_out << std::endl << "\t]," << std::endl;
+	
+	p_out << "\t\"hotLines\": [";
+	{
+		std::vector<SLiMProfileLine> hot_lines;
+		
+		SLiM_ProfileHotLines(AllScriptBlocks(), simulation_functions_, script_->String(), hot_lines, gSLiM_ProfileHotLineCount);
+		
+		for (size_t line_index = 0; line_index < hot_lines.size(); ++line_index)
+		{
+			SLiMProfileLine &hot_line = hot_lines[line_index];
+			
+			p_out << (line_index ? "," : "") << std::endl << "\t\t{\"source\": " << SLiM_JSONString(hot_line.source_) << ", \"line\": " << hot_line.line_ << ", \"seconds\": " << Eidos_ElapsedProfileTime(hot_line.total_) << ", \"text\": " << SLiM_JSONString(hot_line.text_) << "}";
+		}
+	}
+	p_out << std::endl << "\t]," << std::endl;
+	
+	p_out << "\t\"mutationRuns\": {" << std::endl;
+	p_out << "\t\t\"experimentsEnabled\": " << (x_experiments_enabled_ ? "true" : "false") << "," << std::endl;
+#if SLIM_USE_NONNEUTRAL_CACHES
+	p_out << "\t\t\"countHistory\": [";
+	for (size_t gen_index = 0; gen_index < profile_mutcount_history_.size(); ++gen_index)
+		p_out << (gen_index ? ", " : "") << profile_mutcount_history_[gen_index];
+	p_out << "]," << std::endl;
+	p_out << "\t\t\"regimeHistory\": [";
+	for (size_t gen_index = 0; gen_index < profile_nonneutral_regime_history_.size(); ++gen_index)
+		p_out << (gen_index ? ", " : "") << profile_nonneutral_regime_history_[gen_index];
+	p_out << "]," << std::endl;
+	p_out << "\t\t\"mutationTotalUsage\": " << profile_mutation_total_usage_ << "," << std::endl;
+	p_out << "\t\t\"nonneutralMutationTotal\": " << profile_nonneutral_mutation_total_ << "," << std::endl;
+	p_out << "\t\t\"maxMutationIndex\": " << profile_max_mutation_index_ << "," << std::endl;
+	p_out << "\t\t\"mutrunTotalUsage\": " << profile_mutrun_total_usage_ << "," << std::endl;
+	p_out << "\t\t\"uniqueMutrunTotal\": " << profile_unique_mutrun_total_ << "," << std::endl;
+	p_out << "\t\t\"nonneutralRecacheTotal\": " << profile_mutrun_nonneutral_recache_total_ << "," << std::endl;
 #endif
+	p_out << "\t\t\"finalCount\": " << chromosome_.mutrun_count_ << std::endl;
+	p_out << "\t}" << std::endl;
+	p_out << "}" << std::endl;
+	
+	p_out.flags(saved_flags);
+	p_out.precision(saved_precision);
+}
+
+#endif	// (SLIMPROFILING == 1)
 
 slim_generation_t SLiMSim::FirstGeneration(void)
 {
@@ -2358,14 +3427,14 @@ bool SLiMSim::_RunOneGeneration(void)
 	
 	if (generation_ == 0)
 	{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 		SLIM_PROFILE_BLOCK_START();
 #endif
 		
 		RunInitializeCallbacks();
 		
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 		SLIM_PROFILE_BLOCK_END(profile_stage_totals_[0]);
 #endif
@@ -2377,7 +3446,7 @@ bool SLiMSim::_RunOneGeneration(void)
 	}
 	else
 	{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 #if SLIM_USE_NONNEUTRAL_CACHES
 		if (gEidosProfilingClientCount)
@@ -2385,8 +3454,10 @@ bool SLiMSim::_RunOneGeneration(void)
 #endif
 #endif
 		
+#if !SLIM_MUTRUN_COST_MODEL
 		// make a clock if we're running experiments
 		clock_t x_clock0 = (x_experiments_enabled_ ? clock() : 0);
+#endif
 		
 		
 		// ******************************************************************
@@ -2394,7 +3465,7 @@ bool SLiMSim::_RunOneGeneration(void)
 		// Stage 1: Execute early() script events for the current generation
 		//
 		{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_START();
 #endif
@@ -2407,14 +3478,14 @@ bool SLiMSim::_RunOneGeneration(void)
 			{
 				if (script_block->active_)
 				{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 					// PROFILING
 					SLIM_PROFILE_BLOCK_START_NESTED();
 #endif
 					
 					population_.ExecuteScript(script_block, generation_, chromosome_);
 					
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 					// PROFILING
 					SLIM_PROFILE_BLOCK_END_NESTED(profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosEventEarly)]);
 #endif
@@ -2424,7 +3495,7 @@ bool SLiMSim::_RunOneGeneration(void)
 			// the stage is done, so deregister script blocks as requested
 			DeregisterScheduledScriptBlocks();
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_END(profile_stage_totals_[1]);
 #endif
@@ -2436,7 +3507,7 @@ bool SLiMSim::_RunOneGeneration(void)
 		// Stage 2: Generate offspring: evolve all subpopulations
 		//
 		{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_START();
 #endif
@@ -2542,7 +3613,7 @@ bool SLiMSim::_RunOneGeneration(void)
 			// the stage is done, so deregister script blocks as requested
 			DeregisterScheduledScriptBlocks();
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_END(profile_stage_totals_[2]);
 #endif
@@ -2554,7 +3625,7 @@ bool SLiMSim::_RunOneGeneration(void)
 		// Stage 3: Remove fixed mutations and associated tasks
 		//
 		{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_START();
 #endif
@@ -2582,7 +3653,7 @@ bool SLiMSim::_RunOneGeneration(void)
 			// Deregister any interaction() callbacks that have been scheduled for deregistration, since it is now safe to do so
 			DeregisterScheduledInteractionBlocks();
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_END(profile_stage_totals_[3]);
 #endif
@@ -2594,7 +3665,7 @@ bool SLiMSim::_RunOneGeneration(void)
 		// Stage 4: Swap generations
 		//
 		{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_START();
 #endif
@@ -2603,7 +3674,7 @@ bool SLiMSim::_RunOneGeneration(void)
 			
 			population_.SwapGenerations();
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_END(profile_stage_totals_[4]);
 #endif
@@ -2615,7 +3686,7 @@ bool SLiMSim::_RunOneGeneration(void)
 		// Stage 5: Execute late() script events for the current generation
 		//
 		{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_START();
 #endif
@@ -2628,14 +3699,14 @@ bool SLiMSim::_RunOneGeneration(void)
 			{
 				if (script_block->active_)
 				{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 					// PROFILING
 					SLIM_PROFILE_BLOCK_START_NESTED();
 #endif
 					
 					population_.ExecuteScript(script_block, generation_, chromosome_);
 					
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 					// PROFILING
 					SLIM_PROFILE_BLOCK_END_NESTED(profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosEventLate)]);
 #endif
@@ -2645,7 +3716,7 @@ bool SLiMSim::_RunOneGeneration(void)
 			// the stage is done, so deregister script blocks as requested
 			DeregisterScheduledScriptBlocks();
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_END(profile_stage_totals_[5]);
 #endif
@@ -2657,7 +3728,7 @@ bool SLiMSim::_RunOneGeneration(void)
 		// Stage 6: Calculate fitness values for the new parental generation
 		//
 		{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_START();
 #endif
@@ -2671,9 +3742,15 @@ bool SLiMSim::_RunOneGeneration(void)
 			
 			// Maintain our mutation run experiments; we want this overhead to appear within the stage 6 profile
 			if (x_experiments_enabled_)
+			{
+#if SLIM_MUTRUN_COST_MODEL
+				MaintainMutationRunCostModel();
+#else
 				MaintainMutationRunExperiments((clock() - x_clock0) / (double)CLOCKS_PER_SEC);
+#endif
+			}
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_END(profile_stage_totals_[6]);
 #endif
@@ -2702,6 +3779,10 @@ bool SLiMSim::_RunOneGeneration(void)
 			population_.TallyMutationReferences(nullptr, false);
 #endif
 			
+			// simplify the recorded tree sequence periodically, to keep it from growing without bound
+			if (tree_seq_ && tree_seq_->ShouldSimplify())
+				TreeSeqSimplify();
+			
 			cached_value_generation_.reset();
 			generation_++;
 			
@@ -2915,6 +3996,7 @@ EidosValue_SP SLiMSim::ContextDefinedFunctionDispatch(const std::string &p_funct
 	else if (p_function_name.compare(gStr_initializeMutationRate) == 0)			return ExecuteContextFunction_initializeMutationRate(p_function_name, p_arguments, p_argument_count, p_interpreter);
 	else if (p_function_name.compare(gStr_initializeSex) == 0)					return ExecuteContextFunction_initializeSex(p_function_name, p_arguments, p_argument_count, p_interpreter);
 	else if (p_function_name.compare(gStr_initializeSLiMOptions) == 0)			return ExecuteContextFunction_initializeSLiMOptions(p_function_name, p_arguments, p_argument_count, p_interpreter);
+	else if (p_function_name.compare(gStr_initializeTreeSeq) == 0)				return ExecuteContextFunction_initializeTreeSeq(p_function_name, p_arguments, p_argument_count, p_interpreter);
 	
 	EIDOS_TERMINATION << "ERROR (SLiMSim::ContextDefinedFunctionDispatch): the function " << p_function_name << "() is not implemented by SLiMSim." << EidosTerminate();
 	return gStaticEidosValueNULLInvisible;
@@ -3068,7 +4150,7 @@ EidosValue_SP SLiMSim::ExecuteContextFunction_initializeGenomicElementType(const
 	return symbol_entry.second;
 }
 
-//	*********************	(object<InteractionType>$)initializeInteractionType(is$ id, string$ spatiality, [logical$ reciprocal = F], [numeric$ maxDistance = INF], [string$ sexSegregation = "**"])
+//	*********************	(object<InteractionType>$)initializeInteractionType(is$ id, string$ spatiality, [logical$ reciprocal = F], [numeric$ maxDistance = INF], [string$ sexSegregation = "**"], [logical$ sparse = F])
 //
 EidosValue_SP SLiMSim::ExecuteContextFunction_initializeInteractionType(const std::string &p_function_name, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter)
 {
@@ -3078,6 +4160,7 @@ EidosValue_SP SLiMSim::ExecuteContextFunction_initializeInteractionType(const st
 	EidosValue *reciprocal_value = p_arguments[2].get();
 	EidosValue *maxDistance_value = p_arguments[3].get();
 	EidosValue *sexSegregation_value = p_arguments[4].get();
+	EidosValue *sparse_value = p_arguments[5].get();
 	std::ostringstream &output_stream = p_interpreter.ExecutionOutputStream();
 	
 	slim_objectid_t map_identifier = SLiM_ExtractObjectIDFromEidosValue_is(id_value, 0, 'i');
@@ -3085,6 +4168,7 @@ EidosValue_SP SLiMSim::ExecuteContextFunction_initializeInteractionType(const st
 	bool reciprocal = reciprocal_value->LogicalAtIndex(0, nullptr);
 	double max_distance = maxDistance_value->FloatAtIndex(0, nullptr);
 	std::string sex_string = sexSegregation_value->StringAtIndex(0, nullptr);
+	bool sparse = sparse_value->LogicalAtIndex(0, nullptr);
 	int required_dimensionality;
 	IndividualSex receiver_sex = IndividualSex::kUnspecified, exerter_sex = IndividualSex::kUnspecified;
 	
@@ -3109,6 +4193,8 @@ EidosValue_SP SLiMSim::ExecuteContextFunction_initializeInteractionType(const st
 		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteContextFunction_initializeInteractionType): initializeInteractionType() maxDistance must be >= 0.0." << EidosTerminate();
 	if ((required_dimensionality == 0) && (!std::isinf(max_distance) || (max_distance < 0.0)))
 		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteContextFunction_initializeInteractionType): initializeInteractionType() maxDistance must be INF for non-spatial interactions." << EidosTerminate();
+	if (sparse && ((required_dimensionality == 0) || std::isinf(max_distance)))
+		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteContextFunction_initializeInteractionType): initializeInteractionType() sparse storage requires a spatial interaction with a finite maxDistance." << EidosTerminate();
 	
 	if (sex_string == "**")			{ receiver_sex = IndividualSex::kUnspecified;	exerter_sex = IndividualSex::kUnspecified;	}
 	else if (sex_string == "*M")	{ receiver_sex = IndividualSex::kUnspecified;	exerter_sex = IndividualSex::kMale;			}
@@ -3125,7 +4211,7 @@ EidosValue_SP SLiMSim::ExecuteContextFunction_initializeInteractionType(const st
 	if (((receiver_sex != IndividualSex::kUnspecified) || (exerter_sex != IndividualSex::kUnspecified)) && !sex_enabled_)
 		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteContextFunction_initializeInteractionType): initializeInteractionType() sexSegregation value other than '**' unsupported in non-sexual simulation." << EidosTerminate();
 	
-	InteractionType *new_interaction_type = new InteractionType(map_identifier, spatiality_string, reciprocal, max_distance, receiver_sex, exerter_sex);
+	InteractionType *new_interaction_type = new InteractionType(map_identifier, spatiality_string, reciprocal, max_distance, receiver_sex, exerter_sex, sparse);
 	
 	interaction_types_.insert(std::pair<const slim_objectid_t,InteractionType*>(map_identifier, new_interaction_type));
 	interaction_types_changed_ = true;
@@ -3151,6 +4237,9 @@ EidosValue_SP SLiMSim::ExecuteContextFunction_initializeInteractionType(const st
 		if (sex_string != "**")
 			output_stream << "\", sexSegregation=" << sex_string;
 		
+		if (sparse)
+			output_stream << "\", sparse=T";
+		
 		output_stream << ");" << std::endl;
 	}
 	
@@ -3630,7 +4719,7 @@ EidosValue_SP SLiMSim::ExecuteContextFunction_initializeSex(const std::string &p
 	return gStaticEidosValueNULLInvisible;
 }
 
-//	*********************	(void)initializeSLiMOptions([logical$ keepPedigrees = F], [string$ dimensionality = ""], [string$ periodicity = ""], [integer$ mutationRuns = 0], [logical$ preventIncidentalSelfing = F])
+//	*********************	(void)initializeSLiMOptions([logical$ keepPedigrees = F], [string$ dimensionality = ""], [string$ periodicity = ""], [integer$ mutationRuns = 0], [logical$ preventIncidentalSelfing = F], [integer$ threads = 0], [logical$ batchFitnessCallbacks = F])
 //
 EidosValue_SP SLiMSim::ExecuteContextFunction_initializeSLiMOptions(const std::string &p_function_name, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter)
 {
@@ -3640,6 +4729,8 @@ EidosValue_SP SLiMSim::ExecuteContextFunction_initializeSLiMOptions(const std::s
 	EidosValue *arg_periodicity_value = p_arguments[2].get();
 	EidosValue *arg_mutationRuns_value = p_arguments[3].get();
 	EidosValue *arg_preventIncidentalSelfing_value = p_arguments[4].get();
+	EidosValue *arg_threads_value = p_arguments[5].get();
+	EidosValue *arg_batchFitnessCallbacks_value = p_arguments[6].get();
 	std::ostringstream &output_stream = p_interpreter.ExecutionOutputStream();
 	
 	if (num_options_declarations_ > 0)
@@ -3723,6 +4814,23 @@ EidosValue_SP SLiMSim::ExecuteContextFunction_initializeSLiMOptions(const std::s
 		prevent_incidental_selfing_ = prevent_selfing;
 	}
 	
+	{
+		// [integer$ threads = 0]
+		int64_t thread_count = arg_threads_value->IntAtIndex(0, nullptr);
+		
+		if ((thread_count < 0) || (thread_count > EIDOS_MAX_THREADS))
+			EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteContextFunction_initializeSLiMOptions): in initializeSLiMOptions(), parameter threads must be between 0 and " << EIDOS_MAX_THREADS << ", inclusive." << EidosTerminate();
+		
+		thread_count_ = (int)thread_count;
+	}
+	
+	{
+		// [logical$ batchFitnessCallbacks = F]
+		bool batch_fitness_callbacks = arg_batchFitnessCallbacks_value->LogicalAtIndex(0, nullptr);
+		
+		batch_fitness_callbacks_ = batch_fitness_callbacks;
+	}
+	
 	if (DEBUG_INPUT)
 	{
 		output_stream << "initializeSLiMOptions(";
@@ -3773,6 +4881,20 @@ EidosValue_SP SLiMSim::ExecuteContextFunction_initializeSLiMOptions(const std::s
 			if (previous_params) output_stream << ", ";
 			output_stream << "preventIncidentalSelfing = " << (prevent_incidental_selfing_ ? "T" : "F");
 			previous_params = true;
+		}
+		
+		if (thread_count_)
+		{
+			if (previous_params) output_stream << ", ";
+			output_stream << "threads = " << thread_count_;
+			previous_params = true;
+		}
+		
+		if (batch_fitness_callbacks_)
+		{
+			if (previous_params) output_stream << ", ";
+			output_stream << "batchFitnessCallbacks = " << (batch_fitness_callbacks_ ? "T" : "F");
+			previous_params = true;
 			(void)previous_params;	// dead store above is deliberate
 		}
 		
@@ -3784,6 +4906,33 @@ EidosValue_SP SLiMSim::ExecuteContextFunction_initializeSLiMOptions(const std::s
 	return gStaticEidosValueNULLInvisible;
 }
 
+//	*********************	(void)initializeTreeSeq([numeric$ simplificationRatio = 10])
+//
+EidosValue_SP SLiMSim::ExecuteContextFunction_initializeTreeSeq(const std::string &p_function_name, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter)
+{
+#pragma unused (p_function_name, p_arguments, p_argument_count, p_interpreter)
+	EidosValue *arg_simplificationRatio_value = p_arguments[0].get();
+	std::ostringstream &output_stream = p_interpreter.ExecutionOutputStream();
+	
+	if (num_treeseq_declarations_ > 0)
+		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteContextFunction_initializeTreeSeq): initializeTreeSeq() may be called only once." << EidosTerminate();
+	
+	double simplification_ratio = arg_simplificationRatio_value->FloatAtIndex(0, nullptr);
+	
+	if (!std::isfinite(simplification_ratio) || (simplification_ratio < 1.0))
+		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteContextFunction_initializeTreeSeq): in initializeTreeSeq(), parameter simplificationRatio must be greater than or equal to 1." << EidosTerminate();
+	
+	recording_tree_seq_ = true;
+	tree_seq_simplification_ratio_ = simplification_ratio;
+	
+	if (DEBUG_INPUT)
+		output_stream << "initializeTreeSeq(simplificationRatio = " << tree_seq_simplification_ratio_ << ");" << std::endl;
+	
+	num_treeseq_declarations_++;
+	
+	return gStaticEidosValueNULLInvisible;
+}
+
 const std::vector<EidosFunctionSignature_SP> *SLiMSim::ZeroGenerationFunctionSignatures(void)
 {
 	// Allocate our own EidosFunctionSignature objects
@@ -3796,7 +4945,7 @@ const std::vector<EidosFunctionSignature_SP> *SLiMSim::ZeroGenerationFunctionSig
 		sim_0_signatures_.emplace_back((EidosFunctionSignature *)(new EidosFunctionSignature(gStr_initializeGenomicElementType, nullptr, kEidosValueMaskObject | kEidosValueMaskSingleton, gSLiM_GenomicElementType_Class, "SLiM"))
 										->AddIntString_S("id")->AddIntObject("mutationTypes", gSLiM_MutationType_Class)->AddNumeric("proportions"));
 		sim_0_signatures_.emplace_back((EidosFunctionSignature *)(new EidosFunctionSignature(gStr_initializeInteractionType, nullptr, kEidosValueMaskObject | kEidosValueMaskSingleton, gSLiM_InteractionType_Class, "SLiM"))
-										->AddIntString_S("id")->AddString_S(gStr_spatiality)->AddLogical_OS(gStr_reciprocal, gStaticEidosValue_LogicalF)->AddNumeric_OS(gStr_maxDistance, gStaticEidosValue_FloatINF)->AddString_OS(gStr_sexSegregation, gStaticEidosValue_StringDoubleAsterisk));
+										->AddIntString_S("id")->AddString_S(gStr_spatiality)->AddLogical_OS(gStr_reciprocal, gStaticEidosValue_LogicalF)->AddNumeric_OS(gStr_maxDistance, gStaticEidosValue_FloatINF)->AddString_OS(gStr_sexSegregation, gStaticEidosValue_StringDoubleAsterisk)->AddLogical_OS(gStr_sparse, gStaticEidosValue_LogicalF));
 		sim_0_signatures_.emplace_back((EidosFunctionSignature *)(new EidosFunctionSignature(gStr_initializeMutationType, nullptr, kEidosValueMaskObject | kEidosValueMaskSingleton, gSLiM_MutationType_Class, "SLiM"))
 										->AddIntString_S("id")->AddNumeric_S("dominanceCoeff")->AddString_S("distributionType")->AddEllipsis());
 		sim_0_signatures_.emplace_back((EidosFunctionSignature *)(new EidosFunctionSignature(gStr_initializeRecombinationRate, nullptr, kEidosValueMaskNULL, "SLiM"))
@@ -3808,7 +4957,9 @@ const std::vector<EidosFunctionSignature_SP> *SLiMSim::ZeroGenerationFunctionSig
 		sim_0_signatures_.emplace_back((EidosFunctionSignature *)(new EidosFunctionSignature(gStr_initializeSex, nullptr, kEidosValueMaskNULL, "SLiM"))
 										->AddString_S("chromosomeType")->AddNumeric_OS("xDominanceCoeff", gStaticEidosValue_Float1));
 		sim_0_signatures_.emplace_back((EidosFunctionSignature *)(new EidosFunctionSignature(gStr_initializeSLiMOptions, nullptr, kEidosValueMaskNULL, "SLiM"))
-										->AddLogical_OS("keepPedigrees", gStaticEidosValue_LogicalF)->AddString_OS("dimensionality", gStaticEidosValue_StringEmpty)->AddString_OS("periodicity", gStaticEidosValue_StringEmpty)->AddInt_OS("mutationRuns", gStaticEidosValue_Integer0)->AddLogical_OS("preventIncidentalSelfing", gStaticEidosValue_LogicalF));
+										->AddLogical_OS("keepPedigrees", gStaticEidosValue_LogicalF)->AddString_OS("dimensionality", gStaticEidosValue_StringEmpty)->AddString_OS("periodicity", gStaticEidosValue_StringEmpty)->AddInt_OS("mutationRuns", gStaticEidosValue_Integer0)->AddLogical_OS("preventIncidentalSelfing", gStaticEidosValue_LogicalF)->AddInt_OS("threads", gStaticEidosValue_Integer0)->AddLogical_OS("batchFitnessCallbacks", gStaticEidosValue_LogicalF));
+		sim_0_signatures_.emplace_back((EidosFunctionSignature *)(new EidosFunctionSignature(gStr_initializeTreeSeq, nullptr, kEidosValueMaskNULL, "SLiM"))
+										->AddNumeric_OS("simplificationRatio", EidosValue_Float_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Float_singleton(10.0))));
 	}
 	
 	return &sim_0_signatures_;
@@ -4178,6 +5329,10 @@ void SLiMSim::SetProperty(EidosGlobalStringID p_property_id, const EidosValue &p
 			generation_ = SLiMCastToGenerationTypeOrRaise(value);
 			cached_value_generation_.reset();
 			
+			// keep the recorded genealogy consistent with the new generation counter, so that parents stay older than their children
+			if (tree_seq_ && (generation_ != old_generation))
+				tree_seq_->ShiftTimes(generation_ - old_generation);
+			
 			// Setting the generation into the future is generally harmless; the simulation logic is designed to handle that anyway, since
 			// that happens every generation.  Setting the generation into the past is a bit tricker, since some things that have already
 			// occurred need to be invalidated.  In particular, historical data cached by SLiMgui needs to be fixed.  Note that here we
@@ -4266,6 +5421,8 @@ EidosValue_SP SLiMSim::ExecuteInstanceMethod(EidosGlobalStringID p_method_id, co
 		case gID_registerRecombinationCallback:	return ExecuteMethod_registerMateModifyRecCallback(p_method_id, p_arguments, p_argument_count, p_interpreter);
 		case gID_rescheduleScriptBlock:			return ExecuteMethod_rescheduleScriptBlock(p_method_id, p_arguments, p_argument_count, p_interpreter);
 		case gID_simulationFinished:			return ExecuteMethod_simulationFinished(p_method_id, p_arguments, p_argument_count, p_interpreter);
+		case gID_treeSeqOutput:					return ExecuteMethod_treeSeqOutput(p_method_id, p_arguments, p_argument_count, p_interpreter);
+		case gID_treeSeqSimplify:				return ExecuteMethod_treeSeqSimplify(p_method_id, p_arguments, p_argument_count, p_interpreter);
 		default:								return SLiMEidosDictionary::ExecuteInstanceMethod(p_method_id, p_arguments, p_argument_count, p_interpreter);
 	}
 }
@@ -5142,6 +6299,85 @@ EidosValue_SP SLiMSim::ExecuteMethod_simulationFinished(EidosGlobalStringID p_me
 	return gStaticEidosValueNULLInvisible;
 }
 
+std::vector<Genome *> SLiMSim::TreeSeqSamples(void)
+{
+	// the samples are all of the non-null genomes in the current parental generation
+	std::vector<Genome *> samples;
+	
+	for (std::pair<const slim_objectid_t,Subpopulation*> &subpop_pair : population_)
+		for (Genome &genome : subpop_pair.second->parent_genomes_)
+			if (!genome.IsNull())
+				samples.emplace_back(&genome);
+	
+	return samples;
+}
+
+void SLiMSim::TreeSeqSimplify(void)
+{
+	tree_seq_->Simplify(TreeSeqSamples());
+}
+
+//	*********************	– (void)treeSeqOutput(string$ nodesPath, string$ edgesPath, [logical$ simplify = T])
+//
+EidosValue_SP SLiMSim::ExecuteMethod_treeSeqOutput(EidosGlobalStringID p_method_id, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter)
+{
+#pragma unused (p_method_id, p_arguments, p_argument_count, p_interpreter)
+	EidosValue *nodesPath_value = p_arguments[0].get();
+	EidosValue *edgesPath_value = p_arguments[1].get();
+	EidosValue *simplify_value = p_arguments[2].get();
+	
+	if (!tree_seq_)
+		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteMethod_treeSeqOutput): treeSeqOutput() may only be called when tree sequence recording has been enabled with initializeTreeSeq()." << EidosTerminate();
+	if (generation_stage_ == SLiMGenerationStage::kStage2GenerateOffspring)
+		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteMethod_treeSeqOutput): treeSeqOutput() may not be called while offspring are being generated." << EidosTerminate();
+	
+	if ((GenerationStage() == SLiMGenerationStage::kStage1ExecuteEarlyScripts) && (!warned_early_output_))
+	{
+		p_interpreter.ExecutionOutputStream() << "#WARNING (SLiMSim::ExecuteMethod_treeSeqOutput): treeSeqOutput() should probably not be called from an early() event; the output will reflect state at the beginning of the generation, not the end." << std::endl;
+		warned_early_output_ = true;
+	}
+	
+	if (simplify_value->LogicalAtIndex(0, nullptr))
+		TreeSeqSimplify();
+	
+	std::vector<Genome *> samples = TreeSeqSamples();
+	std::string nodes_path = Eidos_ResolvedPath(nodesPath_value->StringAtIndex(0, nullptr));
+	std::string edges_path = Eidos_ResolvedPath(edgesPath_value->StringAtIndex(0, nullptr));
+	std::ofstream nodes_file(nodes_path.c_str(), std::ios_base::out);
+	
+	if (!nodes_file.is_open())
+		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteMethod_treeSeqOutput): treeSeqOutput() could not open "<< nodes_path << "." << EidosTerminate();
+	
+	tree_seq_->WriteNodeTable(nodes_file, samples);
+	nodes_file.close();
+	
+	std::ofstream edges_file(edges_path.c_str(), std::ios_base::out);
+	
+	if (!edges_file.is_open())
+		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteMethod_treeSeqOutput): treeSeqOutput() could not open "<< edges_path << "." << EidosTerminate();
+	
+	tree_seq_->WriteEdgeTable(edges_file);
+	edges_file.close();
+	
+	return gStaticEidosValueNULLInvisible;
+}
+
+//	*********************	– (void)treeSeqSimplify(void)
+//
+EidosValue_SP SLiMSim::ExecuteMethod_treeSeqSimplify(EidosGlobalStringID p_method_id, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter)
+{
+#pragma unused (p_method_id, p_arguments, p_argument_count, p_interpreter)
+	
+	if (!tree_seq_)
+		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteMethod_treeSeqSimplify): treeSeqSimplify() may only be called when tree sequence recording has been enabled with initializeTreeSeq()." << EidosTerminate();
+	if (generation_stage_ == SLiMGenerationStage::kStage2GenerateOffspring)
+		EIDOS_TERMINATION << "ERROR (SLiMSim::ExecuteMethod_treeSeqSimplify): treeSeqSimplify() may not be called while offspring are being generated." << EidosTerminate();
+	
+	TreeSeqSimplify();
+	
+	return gStaticEidosValueNULLInvisible;
+}
+
 
 //
 //	SLiMSim_Class
@@ -5303,6 +6539,8 @@ const std::vector<const EidosMethodSignature *> *SLiMSim_Class::Methods(void) co
 		methods->emplace_back(SignatureForMethodOrRaise(gID_registerRecombinationCallback));
 		methods->emplace_back(SignatureForMethodOrRaise(gID_rescheduleScriptBlock));
 		methods->emplace_back(SignatureForMethodOrRaise(gID_simulationFinished));
+		methods->emplace_back(SignatureForMethodOrRaise(gID_treeSeqOutput));
+		methods->emplace_back(SignatureForMethodOrRaise(gID_treeSeqSimplify));
 		std::sort(methods->begin(), methods->end(), CompareEidosCallSignatures);
 	}
 	
@@ -5333,6 +6571,8 @@ const EidosMethodSignature *SLiMSim_Class::SignatureForMethod(EidosGlobalStringI
 	static EidosInstanceMethodSignature *registerRecombinationCallbackSig = nullptr;
 	static EidosInstanceMethodSignature *rescheduleScriptBlockSig = nullptr;
 	static EidosInstanceMethodSignature *simulationFinishedSig = nullptr;
+	static EidosInstanceMethodSignature *treeSeqOutputSig = nullptr;
+	static EidosInstanceMethodSignature *treeSeqSimplifySig = nullptr;
 	
 	if (!addSubpopSig)
 	{
@@ -5357,6 +6597,8 @@ const EidosMethodSignature *SLiMSim_Class::SignatureForMethod(EidosGlobalStringI
 		registerRecombinationCallbackSig = (EidosInstanceMethodSignature *)(new EidosInstanceMethodSignature(gStr_registerRecombinationCallback, kEidosValueMaskObject | kEidosValueMaskSingleton, gSLiM_SLiMEidosBlock_Class))->AddIntString_SN("id")->AddString_S("source")->AddIntObject_OSN("subpop", gSLiM_Subpopulation_Class, gStaticEidosValueNULL)->AddInt_OSN("start", gStaticEidosValueNULL)->AddInt_OSN("end", gStaticEidosValueNULL);
 		rescheduleScriptBlockSig = (EidosInstanceMethodSignature *)(new EidosInstanceMethodSignature(gStr_rescheduleScriptBlock, kEidosValueMaskObject, gSLiM_SLiMEidosBlock_Class))->AddObject_S("block", gSLiM_SLiMEidosBlock_Class)->AddInt_OSN("start", gStaticEidosValueNULL)->AddInt_OSN("end", gStaticEidosValueNULL)->AddInt_ON("generations", gStaticEidosValueNULL);
 		simulationFinishedSig = (EidosInstanceMethodSignature *)(new EidosInstanceMethodSignature(gStr_simulationFinished, kEidosValueMaskNULL));
+		treeSeqOutputSig = (EidosInstanceMethodSignature *)(new EidosInstanceMethodSignature(gStr_treeSeqOutput, kEidosValueMaskNULL))->AddString_S("nodesPath")->AddString_S("edgesPath")->AddLogical_OS("simplify", gStaticEidosValue_LogicalT);
+		treeSeqSimplifySig = (EidosInstanceMethodSignature *)(new EidosInstanceMethodSignature(gStr_treeSeqSimplify, kEidosValueMaskNULL));
 	}
 	
 	// All of our strings are in the global registry, so we can require a successful lookup
@@ -5383,6 +6625,8 @@ const EidosMethodSignature *SLiMSim_Class::SignatureForMethod(EidosGlobalStringI
 		case gID_registerRecombinationCallback:			return registerRecombinationCallbackSig;
 		case gID_rescheduleScriptBlock:					return rescheduleScriptBlockSig;
 		case gID_simulationFinished:					return simulationFinishedSig;
+		case gID_treeSeqOutput:							return treeSeqOutputSig;
+		case gID_treeSeqSimplify:						return treeSeqSimplifySig;
 			
 			// all others, including gID_none
 		default:
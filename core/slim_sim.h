@@ -44,9 +44,11 @@
 #include "slim_eidos_block.h"
 #include "slim_eidos_dictionary.h"
 #include "interaction_type.h"
+#include "eidos_openmp.h"
 
 
 class EidosInterpreter;
+class TreeSequence;
 
 
 extern EidosObjectClass *gSLiM_SLiMSim_Class;
@@ -98,9 +100,12 @@ private:
 public:
 	
 	bool simulation_valid_ = true;													// set to false if a terminating condition is encountered while running in SLiMgui
+#endif
 
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
+public:
+	
 	eidos_profile_t profile_stage_totals_[7];										// profiling clocks; index 0 is initialize(), the rest follow SLiMGenerationStage
 	eidos_profile_t profile_callback_totals_[9];									// profiling clocks; these follow SLiMEidosBlockType, except no SLiMEidosUserDefinedFunction
 #if SLIM_USE_NONNEUTRAL_CACHES
@@ -113,9 +118,19 @@ public:
 	int64_t profile_mutrun_nonneutral_recache_total_;								// of profile_unique_mutrun_total_, how many mutruns regenerated their nonneutral cache
 	int64_t profile_max_mutation_index_;											// the largest mutation index seen over the course of the profile
 #endif
+	
+	// Profiling for the command-line -profile option; SLiMgui does its own setup and reporting in SLiMWindowController
+	eidos_profile_t profile_elapsed_wall_clock_ = 0;								// corrected profile clock total for the whole run, set by EndProfiling()
+	clock_t profile_elapsed_cpu_clock_ = 0;											// CPU clock total for the whole run, set by EndProfiling()
+	slim_generation_t profile_start_generation_ = 0;								// the generation in which profiling began
+	
+	void StartProfiling(void);
+	void EndProfiling(eidos_profile_t p_elapsed_wall_clock, clock_t p_elapsed_cpu_clock);
+	void WriteProfileReport(std::ostream &p_out);
+	void WriteProfileReportJSON(std::ostream &p_out);
 #endif
 	
-#else
+#ifndef SLIMGUI
 private:
 #endif
 	
@@ -148,6 +163,7 @@ private:
 	slim_generation_t InitializePopulationFromFile(const char *p_file, EidosInterpreter *p_interpreter);		// initialize the population from the file
 	slim_generation_t _InitializePopulationFromTextFile(const char *p_file, EidosInterpreter *p_interpreter);	// initialize the population from a text file
 	slim_generation_t _InitializePopulationFromBinaryFile(const char *p_file, EidosInterpreter *p_interpreter);	// initialize the population from a binary file
+	void _InitializePopulationFromBinarySnapshot(const char *p, const char *buf_end, int32_t p_spatial_output_count, EidosInterpreter *p_interpreter);	// read the sections of a version 4 binary file, after its header
 	void InitializeFromFile(std::istream &p_infile);								// parse a input file and set up the simulation state from its contents
 	
 	// initialization completeness check counts; used only when running initialize() callbacks
@@ -160,6 +176,7 @@ private:
 	int num_gene_conversions_;
 	int num_sex_declarations_;	// SEX ONLY; used to check for sex vs. non-sex errors in the file, so the #SEX tag must come before any reliance on SEX ONLY features
 	int num_options_declarations_;
+	int num_treeseq_declarations_;
 	
 	slim_position_t last_genomic_element_position_ = -1;	// used to check new genomic elements for consistency
 	
@@ -185,6 +202,17 @@ private:
 	// preventing incidental selfing in hermaphroditic models
 	bool prevent_incidental_selfing_ = false;
 	
+	// number of threads to use for parallel offspring generation; see Population::ExecuteReproductionTasks()
+	int thread_count_ = 0;															// 0 represents no preference; use gEidosMaxThreads
+	
+	// calling each fitness() callback once per generation with vectors of mutations; see Subpopulation::UpdateFitness_BatchCallbacks()
+	bool batch_fitness_callbacks_ = false;
+	
+	// tree sequence recording: off by default, optionally turned on at init time with initializeTreeSeq(); see TreeSequence
+	bool recording_tree_seq_ = false;
+	double tree_seq_simplification_ratio_ = 10.0;
+	TreeSequence *tree_seq_ = nullptr;												// OWNED POINTER: created after initialization, if recording
+	
 	EidosSymbolTableEntry self_symbol_;												// for fast setup of the symbol table
 	
 	slim_usertag_t tag_value_;														// a user-defined tag value
@@ -195,6 +223,21 @@ private:
 	// A prefix of x_ is used on all mutation run experiment ivars, to avoid confusion.
 #define SLIM_MUTRUN_EXPERIMENT_LENGTH	50		// kind of based on how large a sample size is needed to detect important differences fairly reliably by t-test
 #define SLIM_MUTRUN_MAXIMUM_COUNT		1024	// the most mutation runs we will ever use; hard to imagine that any model will want more than this
+
+	// If SLIM_MUTRUN_COST_MODEL is 1, the mutation run count is chosen from a cost model fitted to hardware-independent work counters (the
+	// number of runs assembled rather than shared, and the number of mutations per genome), instead of by timing generations at different
+	// counts and comparing the timings with t-tests.  Timings are noisy on busy machines, and each t-test experiment spends many generations
+	// at a count that may be bad; the model can pick a count directly, and is reproducible.  The costs below are relative to the cost of copying
+	// one mutation into a new run; see MaintainMutationRunCostModel().  They are estimates that have not yet been calibrated against timings, so
+	// the model is off by default; build with -DSLIM_MUTRUN_COST_MODEL=1 to try it.  Runs are always of uniform length in either case.
+#ifndef SLIM_MUTRUN_COST_MODEL
+#define SLIM_MUTRUN_COST_MODEL			0
+#endif
+#define SLIM_MUTRUN_MODEL_INTERVAL		10		// the number of generations of work counts pooled for each reassessment of the mutation run count
+#define SLIM_MUTRUN_COST_PER_VISIT		8.0		// handling one run of one genome each generation: sharing it with a child, fitness, tallying, freeing
+#define SLIM_MUTRUN_COST_PER_ASSEMBLY	16.0	// assembling one new run, apart from its mutations: allocation, interning, refcounting
+#define SLIM_MUTRUN_COST_PER_MUTATION	1.0		// copying one mutation into a new run, and then hashing, caching, and tallying it there
+#define SLIM_MUTRUN_MODEL_HYSTERESIS	0.9		// a new count must be predicted to cost less than this fraction of the current cost to be adopted
 	
 	bool x_experiments_enabled_;		// if false, no experiments are run and no generation runtimes are recorded
 	
@@ -216,6 +259,11 @@ private:
 	
 	std::vector<int32_t> x_mutcount_history_;	// a record of the mutation run count used in each generation
 	
+#if SLIM_MUTRUN_COST_MODEL
+	int x_model_generations_;			// the number of generations of work counts pooled since the last reassessment
+	int64_t x_model_genome_runs_;		// the number of genome mutation runs (genomes times the mutation run count) generated over those generations
+#endif
+	
 public:
 	
 	// optimization of the pure neutral case; this is set to false if (a) a non-neutral mutation is added by the user, (b) a genomic element type is configured to use a
@@ -271,8 +319,11 @@ public:
 	void TransitionToNewExperimentAgainstPreviousExperiment(int32_t p_new_mutrun_count);
 	void EnterStasisForMutationRunExperiments(void);
 	void MaintainMutationRunExperiments(double p_last_gen_runtime);
+	void MaintainMutationRunCostModel(void);
+	double PredictedMutationRunCost(int32_t p_mutrun_count, double p_events_per_genome, double p_mutations_per_genome);
+	void PromulgateMutationRunCount(void);
 	
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 #if SLIM_USE_NONNEUTRAL_CACHES
 	void CollectSLiMguiMutationProfileInfo(void);
@@ -299,6 +350,14 @@ public:
 	inline bool SexEnabled(void) const												{ return sex_enabled_; }
 	inline bool PedigreesEnabled(void) const										{ return pedigrees_enabled_; }
 	inline bool PreventIncidentalSelfing(void) const								{ return prevent_incidental_selfing_; }
+	inline int ThreadCount(void) const												{ return (thread_count_ ? thread_count_ : gEidosMaxThreads); }
+	inline bool BatchFitnessCallbacks(void) const									{ return batch_fitness_callbacks_; }
+	inline TreeSequence *TreeSeq(void) const										{ return tree_seq_; }
+	
+	// the birth time of the current parental generation in the tree sequence; before generations are swapped, that is the previous generation
+	inline double TreeSeqParentalTime(void) const									{ return (generation_stage_ < SLiMGenerationStage::kStage4SwapGenerations) ? generation_ - 1 : generation_; }
+	std::vector<Genome *> TreeSeqSamples(void);
+	void TreeSeqSimplify(void);
 	inline GenomeType ModeledChromosomeType(void) const								{ return modeled_chromosome_type_; }
 	inline double XDominanceCoefficient(void) const									{ return x_chromosome_dominance_coeff_; }
 	inline int SpatialDimensionality(void) const									{ return spatial_dimensionality_; }
@@ -324,6 +383,7 @@ public:
 	EidosValue_SP ExecuteContextFunction_initializeMutationRate(const std::string &p_function_name, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter);
 	EidosValue_SP ExecuteContextFunction_initializeSex(const std::string &p_function_name, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter);
 	EidosValue_SP ExecuteContextFunction_initializeSLiMOptions(const std::string &p_function_name, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter);
+	EidosValue_SP ExecuteContextFunction_initializeTreeSeq(const std::string &p_function_name, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter);
 	
 	EidosSymbolTable *SymbolsFromBaseSymbols(EidosSymbolTable *p_base_symbols);				// derive a symbol table, adding our own symbols if needed
 	
@@ -357,6 +417,8 @@ public:
 	EidosValue_SP ExecuteMethod_registerMateModifyRecCallback(EidosGlobalStringID p_method_id, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter);
 	EidosValue_SP ExecuteMethod_rescheduleScriptBlock(EidosGlobalStringID p_method_id, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter);
 	EidosValue_SP ExecuteMethod_simulationFinished(EidosGlobalStringID p_method_id, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter);
+	EidosValue_SP ExecuteMethod_treeSeqOutput(EidosGlobalStringID p_method_id, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter);
+	EidosValue_SP ExecuteMethod_treeSeqSimplify(EidosGlobalStringID p_method_id, const EidosValue_SP *const p_arguments, int p_argument_count, EidosInterpreter &p_interpreter);
 };
 
 
@@ -274,6 +274,33 @@ static std::string gen1_setup_p1(gen1_setup + "1 { sim.addSubpop('p1', 10); } ")
 static std::string gen1_setup_sex_p1(gen1_setup_sex + "1 { sim.addSubpop('p1', 10); } ");
 static std::string gen1_setup_p1p2p3(gen1_setup + "1 { sim.addSubpop('p1', 10); sim.addSubpop('p2', 10); sim.addSubpop('p3', 10); } ");
 
+// Fitness test models: m1 is neutral and m2 has dominance 1.0, so the fitness of an individual is a product over its unique m2 mutations, which
+// _FitnessTestCheck() compares against cachedFitness(); the setup leaves the initialize() callback open for further initialization calls
+static std::string _FitnessTestSetup(const std::string &p_options, const std::string &p_mutation_rate = "1e-4", const std::string &p_m2_mean = "0.02", const std::string &p_recombination_rate = "1e-4", bool p_deleterious_m3 = false)
+{
+	std::string setup("initialize() { ");
+	
+	if (p_options.length())
+		setup += "initializeSLiMOptions(" + p_options + "); ";
+	
+	setup += "initializeMutationRate(" + p_mutation_rate + "); initializeMutationType('m1', 0.5, 'f', 0.0); initializeMutationType('m2', 1.0, 'e', " + p_m2_mean + "); ";
+	
+	if (p_deleterious_m3)
+		setup += "initializeMutationType('m3', 0.5, 'f', -0.5); initializeGenomicElementType('g1', c(m1, m2, m3), c(1.0, 0.5, 0.1)); ";
+	else
+		setup += "initializeGenomicElementType('g1', c(m1, m2), c(1.0, 0.5)); ";
+	
+	setup += "initializeGenomicElement(g1, 0, 9999); initializeRecombinationRate(" + p_recombination_rate + "); ";
+	
+	return setup;
+}
+
+// The expected fitness is the product of (1 + p_coeff_scale * s) over the unique m2 mutations in an individual's non-null genomes, times p_individual_factor
+static std::string _FitnessTestCheck(int p_generation, const std::string &p_coeff_scale = "1", const std::string &p_individual_factor = "1.0")
+{
+	return std::to_string(p_generation) + " early() { inds = p1.individuals; w = p1.cachedFitness(NULL); ok = T; for (i in seqAlong(inds)) { g = inds[i].genomes; m = unique(g[!g.isNullGenome].mutationsOfType(m2)); if (abs(product(1.0 + " + p_coeff_scale + " * m.selectionCoeff) * " + p_individual_factor + " - w[i]) > 1e-5) ok = F; } if (ok) stop(); } ";
+}
+
 
 int RunSLiMTests(void)
 {
@@ -523,7 +550,7 @@ void _RunInitTests(void)
 	SLiMAssertScriptStop("initialize() { initializeSex('X', 10000); stop(); }", __LINE__);															// legal: no maximum value for dominance coeff
 	SLiMAssertScriptRaise("initialize() { initializeSex('A'); initializeSex('A'); stop(); }", 1, 35, "may be called only once", __LINE__);
 	
-	// Test (void)initializeSLiMOptions([logical$ keepPedigrees = F], [string$ dimensionality = ""], [string$ periodicity = ""], [integer$ mutationRuns = 0], [logical$ preventIncidentalSelfing = F])
+	// Test (void)initializeSLiMOptions([logical$ keepPedigrees = F], [string$ dimensionality = ""], [string$ periodicity = ""], [integer$ mutationRuns = 0], [logical$ preventIncidentalSelfing = F], [integer$ threads = 0], [logical$ batchFitnessCallbacks = F])
 	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(); stop(); }", __LINE__);
 	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(F); stop(); }", __LINE__);
 	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(T); stop(); }", __LINE__);
@@ -556,10 +583,19 @@ void _RunInitTests(void)
 	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(mutationRuns=100); stop(); }", __LINE__);
 	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(preventIncidentalSelfing=F); stop(); }", __LINE__);
 	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(preventIncidentalSelfing=T); stop(); }", __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(threads=0); stop(); }", __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(threads=1); stop(); }", __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(threads=4); stop(); }", __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(batchFitnessCallbacks=F); stop(); }", __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(batchFitnessCallbacks=T); stop(); }", __LINE__);
 	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(keepPedigrees=NULL); stop(); }", 1, 15, "cannot be type NULL", __LINE__);
 	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(dimensionality=NULL); stop(); }", 1, 15, "cannot be type NULL", __LINE__);
 	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(mutationRuns=NULL); stop(); }", 1, 15, "cannot be type NULL", __LINE__);
 	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(preventIncidentalSelfing=NULL); stop(); }", 1, 15, "cannot be type NULL", __LINE__);
+	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(threads=NULL); stop(); }", 1, 15, "cannot be type NULL", __LINE__);
+	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(batchFitnessCallbacks=NULL); stop(); }", 1, 15, "cannot be type NULL", __LINE__);
+	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(threads=-1); stop(); }", 1, 15, "parameter threads must be between", __LINE__);
+	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(threads=100000); stop(); }", 1, 15, "parameter threads must be between", __LINE__);
 	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(dimensionality='foo'); stop(); }", 1, 15, "legal non-empty values", __LINE__);
 	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(dimensionality='y'); stop(); }", 1, 15, "legal non-empty values", __LINE__);
 	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(dimensionality='z'); stop(); }", 1, 15, "legal non-empty values", __LINE__);
@@ -575,6 +611,54 @@ void _RunInitTests(void)
 	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(); initializeSLiMOptions(); stop(); }", 1, 40, "may be called only once", __LINE__);
 	SLiMAssertScriptRaise("initialize() { initializeMutationRate(0.0); initializeSLiMOptions(); stop(); }", 1, 44, "must be called before all other initialization functions", __LINE__);
 	
+	// Test (void)initializeTreeSeq([numeric$ simplificationRatio = 10])
+	SLiMAssertScriptStop("initialize() { initializeTreeSeq(); stop(); }", __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeTreeSeq(1); stop(); }", __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeTreeSeq(simplificationRatio=2.5); stop(); }", __LINE__);
+	SLiMAssertScriptRaise("initialize() { initializeTreeSeq(simplificationRatio=NULL); stop(); }", 1, 15, "cannot be type NULL", __LINE__);
+	SLiMAssertScriptRaise("initialize() { initializeTreeSeq(0.5); stop(); }", 1, 15, "must be greater than or equal to 1", __LINE__);
+	SLiMAssertScriptRaise("initialize() { initializeTreeSeq(INF); stop(); }", 1, 15, "must be greater than or equal to 1", __LINE__);
+	SLiMAssertScriptRaise("initialize() { initializeTreeSeq(); initializeTreeSeq(); stop(); }", 1, 36, "may be called only once", __LINE__);
+	
+	// Test parallel offspring generation with threads > 1: sex chromosomes with null genomes, cloning, selfing, and stacking policy rejections
+	std::string threads_setup("initialize() { initializeSLiMOptions(threads=4); initializeMutationRate(1e-5); initializeMutationType('m1', 0.5, 'f', 0.0); m1.mutationStackPolicy = 'l'; initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-6); ");
+	std::string threads_check("20 { g = sim.subpopulations.genomes; g = g[!g.isNullGenome]; if (sum(sim.mutationCounts(NULL)) == sum(g.countOfMutationsOfType(m1))) stop(); } ");
+	
+	SLiMAssertScriptStop(threads_setup + "} 1 { sim.addSubpop('p1', 50); p1.setCloningRate(0.2); p1.setSelfingRate(0.2); } " + threads_check, __LINE__);
+	SLiMAssertScriptStop(threads_setup + "initializeSex('X'); } 1 { sim.addSubpop('p1', 50); p1.setCloningRate(0.2); } " + threads_check, __LINE__);
+	SLiMAssertScriptStop(threads_setup + "initializeSex('Y'); } 1 { sim.addSubpop('p1', 50); sim.addSubpop('p2', 50); p2.setMigrationRates(p1, 0.3); } " + threads_check, __LINE__);
+	
+	// Test that with threads > 1, restoring a saved state and re-running a generation gives new draws, as it does single-threaded
+	SLiMAssertScriptStop(threads_setup + "} 1 { sim.addSubpop('p1', 100); sim.tag = 0; } 10 late() { sim.outputFull('/tmp/slimThreadsRetryTest.txt'); } 11 late() { pos = sort(sim.mutations[sim.mutations.originGeneration == 11].position); if (sim.tag == 0) { sim.tag = 1; sim.setValue('first', pos); sim.readFromPopulationFile('/tmp/slimThreadsRetryTest.txt'); } else if (!identical(pos, sim.getValue('first'))) stop(); }", __LINE__);
+	
+	// Test parallel mutation tallies with threads > 1, mutation by mutation, across two subpopulations and with runs shared between thread blocks
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(mutationRuns=4, threads=3); initializeMutationRate(1e-5); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 9999); initializeRecombinationRate(1e-4); } 1 { sim.addSubpop('p1', 40); sim.addSubpop('p2', 25); p1.setCloningRate(0.5); p2.setMigrationRates(p1, 0.2); } 28:30 late() { counts = sim.mutationCounts(NULL); manual = sapply(sim.mutations, 'sum(sim.subpopulations.genomes.containsMutations(applyValue));'); if (!identical(counts, manual)) stop('count mismatch in generation ' + sim.generation); } 30 late() { stop(); }", __LINE__);
+	
+	// Test mutation counts carried forward between tallies, with runs shared across generations by cloning, fixed mutations that are kept, and runs that
+	// are modified in place or copied (by addNewMutation()) after they have been tallied; each early() check sees the counts from the previous generation's tally,
+	// and the late() check makes a new tally, genome by genome, after the generations have been swapped
+	std::string tally_setup("initialize() { initializeSLiMOptions(mutationRuns=4); initializeMutationRate(1e-4); initializeMutationType('m1', 0.5, 'f', 0.0); m1.convertToSubstitution = F; initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 9999); initializeRecombinationRate(1e-6); } ");
+	std::string tally_check("2:40 early() { counts = sim.mutationCounts(NULL); manual = sapply(sim.mutations, 'sum(p1.genomes.containsMutations(applyValue));'); if (!identical(counts, manual)) stop('count mismatch in generation ' + sim.generation); } 40 late() { stop(); } ");
+	
+	SLiMAssertScriptStop(tally_setup + "1 { sim.addSubpop('p1', 20); p1.setCloningRate(0.8); } " + tally_check, __LINE__);
+	SLiMAssertScriptStop(tally_setup + "1 { sim.addSubpop('p1', 20); p1.setCloningRate(0.8); } " + tally_check + "2:40 early() { p1.genomes[sim.generation % 40].addNewMutation(m1, 0.0, 500 + sim.generation); } ", __LINE__);
+	SLiMAssertScriptStop(tally_setup + "1 { sim.addSubpop('p1', 20); } " + tally_check, __LINE__);
+	SLiMAssertScriptStop(tally_setup + "1 { sim.addSubpop('p1', 20); p1.setCloningRate(0.8); } 2:40 late() { p1.genomes[sim.generation % 40].addNewMutation(m1, 0.0, 500 + sim.generation); counts = sim.mutationCounts(NULL); manual = sapply(sim.mutations, 'sum(p1.genomes.containsMutations(applyValue));'); if (!identical(counts, manual)) stop('count mismatch in generation ' + sim.generation); } 40 late() { stop(); } ", __LINE__);
+	
+	// Test mutation counts in generation 100, after mutation runs have been uniqued (which frees runs that were tallied by the registry maintenance just before)
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(mutationRuns=4); initializeMutationRate(1e-5); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 9999); initializeRecombinationRate(1e-3); } 1 { sim.addSubpop('p1', 50); } 98:100 late() { counts = sim.mutationCounts(NULL); manual = sapply(sim.mutations, 'sum(p1.genomes.containsMutations(applyValue));'); if (!identical(counts, manual)) stop('count mismatch in generation ' + sim.generation); } 100 late() { stop(); } ", __LINE__);
+	
+	// Test parents drawn in bulk for reproduction, serially and in parallel, with and without a fitness-based lookup table, with preventIncidentalSelfing, and
+	// with selfing and cloning, which take their parents from separate parts of the buffer of drawn parents
+	std::string threads_selfing_check("10 late() { ids = p1.individuals.pedigreeParentIDs; if (all(ids[seq(0, size(ids) - 1, by=2)] != ids[seq(1, size(ids) - 1, by=2)])) stop(); } ");
+	
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(keepPedigrees=T, preventIncidentalSelfing=T, threads=4); initializeMutationRate(1e-7); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); } 1 { sim.addSubpop('p1', 10); } " + threads_selfing_check, __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(keepPedigrees=T, preventIncidentalSelfing=T, threads=4); initializeMutationRate(1e-5); initializeMutationType('m1', 0.5, 'g', -0.1, 0.5); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); } 1 { sim.addSubpop('p1', 10); } " + threads_selfing_check, __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(keepPedigrees=T, preventIncidentalSelfing=T); initializeMutationRate(1e-7); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); } 1 { sim.addSubpop('p1', 10); } " + threads_selfing_check, __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(keepPedigrees=T, preventIncidentalSelfing=T); initializeMutationRate(1e-5); initializeMutationType('m1', 0.5, 'g', -0.1, 0.5); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); } 1 { sim.addSubpop('p1', 10); } " + threads_selfing_check, __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(keepPedigrees=T, preventIncidentalSelfing=T); initializeMutationRate(1e-5); initializeMutationType('m1', 0.5, 'g', -0.1, 0.5); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); } 1 { sim.addSubpop('p1', 20); p1.setSelfingRate(0.3); p1.setCloningRate(0.3); } 10 late() { ids = p1.individuals.pedigreeParentIDs; same = sum(ids[seq(0, size(ids) - 1, by=2)] == ids[seq(1, size(ids) - 1, by=2)]); if ((same > 0) & (same < 20)) stop(); } ", __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(keepPedigrees=T); initializeSex('A'); initializeMutationRate(1e-5); initializeMutationType('m1', 0.5, 'g', -0.1, 0.5); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); } 1 { sim.addSubpop('p1', 20); p1.setCloningRate(0.5); } 2:10 late() { ids = p1.individuals.pedigreeParentIDs; same = ids[seq(0, size(ids) - 1, by=2)] == ids[seq(1, size(ids) - 1, by=2)]; if (sum(same) == 0) stop('no clones'); sexes = sim.getValue('sexes'); ps = sim.getValue('ids'); for (i in which(same)) if (sexes[match(ids[2 * i], ps)] != p1.individuals[i].sex) stop('clone of the wrong sex'); } late() { sim.setValue('ids', p1.individuals.pedigreeID); sim.setValue('sexes', p1.individuals.sex); } 10 late() { stop(); } ", __LINE__);
+	
 	// Test (object<InteractionType>$)initializeInteractionType(is$ id, string$ spatiality, [logical$ reciprocal = F], [numeric$ maxDistance = INF], [string$ sexSegregation = "**"])
 	SLiMAssertScriptRaise("initialize() { initializeInteractionType(-1, ''); stop(); }", 1, 15, "identifier value is out of range", __LINE__);
 	SLiMAssertScriptStop("initialize() { initializeInteractionType(0, ''); stop(); }", __LINE__);
@@ -795,6 +879,13 @@ void _RunSLiMSimTests(void)
 	SLiMAssertScriptSuccess(gen1_setup_p1 + "1 { sim.readFromPopulationFile('/tmp/slimOutputFullTest.txt'); if (size(sim.subpopulations) != 3) stop(); }", __LINE__);			// legal; should wipe previous state
 	SLiMAssertScriptSuccess(gen1_setup_p1 + "1 { sim.readFromPopulationFile('/tmp/slimOutputFullTest.slimbinary'); if (size(sim.subpopulations) != 3) stop(); }", __LINE__);	// legal; should wipe previous state
 	
+	// Test that binary output round-trips exactly, whether or not the mutation runs in the file match the chromosome's runs
+	std::string roundtrip_setup("initialize() { initializeSLiMOptions(mutationRuns=4); initializeMutationRate(1e-5); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); } 1 { sim.addSubpop('p1', 10); } ");
+	std::string roundtrip_check("m = sapply(p1.genomes, 'paste(applyValue.mutations.id);'); sim.readFromPopulationFile('/tmp/slimOutputFullTest_ROUNDTRIP.slimbinary'); if (identical(sapply(p1.genomes, 'paste(applyValue.mutations.id);'), m) & (sim.generation == 5)) stop(); }");
+	
+	SLiMAssertScriptStop(roundtrip_setup + "5 late() { sim.outputFull('/tmp/slimOutputFullTest_ROUNDTRIP.txt'); sim.outputFull('/tmp/slimOutputFullTest_ROUNDTRIP.slimbinary', T); " + roundtrip_check, __LINE__);
+	SLiMAssertScriptStop(gen1_setup_highmut_p1 + "5 late() { sim.readFromPopulationFile('/tmp/slimOutputFullTest_ROUNDTRIP.slimbinary'); sim.outputFull('/tmp/slimOutputFullTest_ROUNDTRIP2.txt'); a = readFile('/tmp/slimOutputFullTest_ROUNDTRIP.txt'); b = readFile('/tmp/slimOutputFullTest_ROUNDTRIP2.txt'); if (identical(a[1:(size(a)-1)], b[1:(size(b)-1)])) stop(); }", __LINE__);		// depends on the test above; the file has 4 runs per genome, here there is 1
+	
 	// Test sim - (object<SLiMEidosBlock>)registerEarlyEvent(Nis$ id, string$ source, [integer$ start], [integer$ end])
 	SLiMAssertScriptStop(gen1_setup_p1 + "1 { sim.registerEarlyEvent(NULL, '{ stop(); }', 2, 2); }", __LINE__);
 	SLiMAssertScriptRaise(gen1_setup_p1 + "1 { sim.registerEarlyEvent('s1', '{ stop(); }', 2, 2); } s1 { }", 1, 251, "already defined", __LINE__);
@@ -911,6 +1002,23 @@ void _RunSLiMSimTests(void)
 	SLiMAssertScriptStop(gen1_setup_p1 + "11 { stop(); }", __LINE__);
 	SLiMAssertScriptSuccess(gen1_setup_p1 + "10 { sim.simulationFinished(); } 11 { stop(); }", __LINE__);
 	
+	// Test sim - (void)treeSeqOutput(string$ nodesPath, string$ edgesPath, [logical$ simplify = T]) and - (void)treeSeqSimplify(void)
+	std::string gen1_setup_treeseq("initialize() { initializeTreeSeq(simplificationRatio=1.5); initializeMutationRate(1e-7); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-5); } 1 { sim.addSubpop('p1', 10); } ");
+	std::string treeseq_output("sim.treeSeqOutput('/tmp/slimTreeSeqTest_nodes.txt', '/tmp/slimTreeSeqTest_edges.txt'); ");
+	
+	SLiMAssertScriptRaise(gen1_setup_p1 + "10 { sim.treeSeqSimplify(); }", 1, 252, "tree sequence recording has been enabled", __LINE__);
+	SLiMAssertScriptRaise(gen1_setup_p1 + "10 { " + treeseq_output + "}", 1, 252, "tree sequence recording has been enabled", __LINE__);
+	SLiMAssertScriptRaise(gen1_setup_treeseq + "10 { sim.treeSeqOutput('/tmp/slimTreeSeqTest_nodes.txt', '/tmp/slimTreeSeqTest_edges.txt', NULL); }", 1, 296, "cannot be type NULL", __LINE__);
+	SLiMAssertScriptSuccess(gen1_setup_treeseq + "10 late() { sim.treeSeqSimplify(); " + treeseq_output + "}", __LINE__);
+	SLiMAssertScriptSuccess(gen1_setup_treeseq + "5 { sim.addSubpopSplit('p2', 5, p1); p1.setCloningRate(0.5); } modifyChild() { return (runif(1) < 0.8); } 10 late() { sim.treeSeqOutput('/tmp/slimTreeSeqTest_nodes.txt', '/tmp/slimTreeSeqTest_edges.txt', simplify=F); " + treeseq_output + "}", __LINE__);
+	SLiMAssertScriptStop(gen1_setup_treeseq + "10 late() { " + treeseq_output + "nodes = readFile('/tmp/slimTreeSeqTest_nodes.txt'); edges = readFile('/tmp/slimTreeSeqTest_edges.txt'); if ((nodes[0] == 'is_sample\ttime\tpopulation') & (edges[0] == 'left\tright\tparent\tchild') & (sum(substr(nodes, 0, 0) == '1') == 20)) stop(); }", __LINE__);
+	SLiMAssertScriptStop(gen1_setup_treeseq + "10 late() { " + treeseq_output + "nodes = readFile('/tmp/slimTreeSeqTest_nodes.txt'); edges = readFile('/tmp/slimTreeSeqTest_edges.txt'); sim.treeSeqSimplify(); " + treeseq_output + "if (identical(nodes, readFile('/tmp/slimTreeSeqTest_nodes.txt')) & identical(edges, readFile('/tmp/slimTreeSeqTest_edges.txt'))) stop(); }", __LINE__);
+	
+	// Test simplification against a known genealogy: two clonal individuals, one in p1 and one split off into p2 in generation 5, so that each genome of p1 coalesces with the corresponding genome of p2 at the p1 genome that was copied by the split
+	std::string gen1_setup_treeseq_clonal("initialize() { initializeTreeSeq(); initializeMutationRate(0); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99); initializeRecombinationRate(0); } 1 { sim.addSubpop('p1', 1); p1.setCloningRate(1.0); } 5 late() { sim.addSubpopSplit('p2', 1, p1); p2.setCloningRate(1.0); } ");
+	
+	SLiMAssertScriptStop(gen1_setup_treeseq_clonal + "10 late() { " + treeseq_output + "nodes = readFile('/tmp/slimTreeSeqTest_nodes.txt'); edges = readFile('/tmp/slimTreeSeqTest_edges.txt'); if (identical(nodes, c('is_sample	time	population', '1	0	1', '1	0	1', '1	0	2', '1	0	2', '0	5	1', '0	5	1')) & identical(edges, c('left	right	parent	child', '0	100	4	0', '0	100	4	2', '0	100	5	1', '0	100	5	3'))) stop(); }", __LINE__);
+	
 	// Test sim SLiMEidosDictionary functionality: - (+)getValue(string$ key) and - (void)setValue(string$ key, + value)
 	SLiMAssertScriptStop(gen1_setup_p1 + "1 { sim.setValue('foo', 7:9); sim.setValue('bar', 'baz'); } 10 { if (identical(sim.getValue('foo'), 7:9) & identical(sim.getValue('bar'), 'baz')) stop(); }", __LINE__);
 	SLiMAssertScriptStop(gen1_setup_p1 + "1 { sim.setValue('foo', 3:5); sim.setValue('foo', 'foobar'); } 10 { if (identical(sim.getValue('foo'), 'foobar')) stop(); }", __LINE__);
@@ -1480,6 +1588,7 @@ void _RunMutationTests(void)
 	SLiMAssertScriptStop(gen1_setup_highmut_p1 + "10 { mut = sim.mutations[0]; mut.setMutationType(m1); if (mut.mutationType == m1) stop(); }", __LINE__);
 	SLiMAssertScriptStop(gen1_setup_highmut_p1 + "10 { mut = sim.mutations[0]; mut.setMutationType(m1); if (mut.mutationType == m1) stop(); }", __LINE__);
 	SLiMAssertScriptRaise(gen1_setup_highmut_p1 + "10 { mut = sim.mutations[0]; mut.setMutationType(2); if (mut.mutationType == m1) stop(); }", 1, 276, "mutation type m2 not defined", __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeMutationRate(1e-5); initializeMutationType('m1', 0.5, 'f', 0.0); initializeMutationType('m2', 0.0, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); } 1 { sim.addSubpop('p1', 10); } 10 { mut = sim.mutations[whichMax(sim.mutationFrequencies(NULL))]; mut.setSelectionCoeff(0.5); mut.setMutationType(m2); sim.recalculateFitness(); c = p1.individuals.countOfMutationsOfType(m2); if (all(p1.cachedFitness(NULL) == ifelse(c == 2, 1.5, 1.0))) stop(); }", __LINE__);
 	
 	// Test Mutation - (void)setSelectionCoeff(float$ selectionCoeff)
 	SLiMAssertScriptStop(gen1_setup_highmut_p1 + "10 { mut = sim.mutations[0]; mut.setSelectionCoeff(0.5); if (mut.selectionCoeff == 0.5) stop(); }", __LINE__);
@@ -1558,6 +1667,7 @@ void _RunGenomeTests(void)
 	SLiMAssertScriptRaise(gen1_setup_p1 + "1 { gen = p1.genomes[0]; mut = gen.addNewMutation(1, 0.1, 100000, NULL, 1); p1.genomes.addMutations(mut); stop(); }", 1, 278, "past the end", __LINE__);
 	SLiMAssertScriptStop(gen1_setup_p1 + "1 { gen = p1.genomes[0]; mut = gen.addNewMutation(1, 0.1, 5000, NULL, 237); p1.genomes.addMutations(mut); stop(); }", __LINE__);							// bad subpop, but this is legal to allow "tagging" of mutations
 	SLiMAssertScriptRaise(gen1_setup_p1 + "1 { gen = p1.genomes[0]; mut = gen.addNewMutation(1, 0.1, 5000, NULL, -1); p1.genomes.addMutations(mut); stop(); }", 1, 278, "out of range", __LINE__);	// however, such tags must be within range
+	SLiMAssertScriptStop(gen1_setup_p1 + "1 { mut = p1.genomes[0].addNewMutation(m1, 0.1, 5000); muts = p1.genomes[1].addNewMutation(m1, 0.0, 0:99999); if (identical(mut.position, 5000) & (abs(mut.selectionCoeff - 0.1) < 1e-6) & identical(muts.position, 0:99999) & (size(sim.mutations) == 100001)) stop(); }", __LINE__);	// references survive growth of the mutation block
 	
 	// Test Genome + (object<Mutation>)addNewDrawnMutation(io<MutationType> mutationType, integer position, [Ni originGeneration], [io<Subpopulation> originSubpop]) with new class method non-multiplex behavior
 	SLiMAssertScriptStop(gen1_setup_p1 + "1 { p1.genomes.addNewDrawnMutation(m1, 5000, 10, p1); stop(); }", __LINE__);
@@ -2377,6 +2487,29 @@ void _RunSubpopulationTests(void)
 	SLiMAssertScriptStop(gen1_setup_i1xyz_mapIxyz + "if (p1.spatialMapColor('map', 0.0001) == '#007F00') stop(); }", __LINE__);
 	SLiMAssertScriptStop(gen1_setup_i1xyz_mapIxyz + "if (p1.spatialMapColor('map', 2.5) == '#00BF80') stop(); }", __LINE__);
 	SLiMAssertScriptStop(gen1_setup_i1xyz_mapIxyz + "if (p1.spatialMapColor('map', 5.0) == '#00FFFF') stop(); }", __LINE__);
+	
+	// Test parallel fitness evaluation with threads > 1, with no callbacks and with constant neutral callbacks (regime 2)
+	std::string threads_fitness_setup(_FitnessTestSetup("threads=4", "1e-4", "0.02", "1e-4", true));
+	std::string threads_fitness_check(_FitnessTestCheck(11));
+	
+	SLiMAssertScriptStop(threads_fitness_setup + "} 1 { sim.addSubpop('p1', 50); } fitness(m3) { return 1.0; } " + threads_fitness_check, __LINE__);
+	SLiMAssertScriptStop(threads_fitness_setup + "initializeSex('A'); } 1 { sim.addSubpop('p1', 50); } fitness(m3) { return 1.0; } " + threads_fitness_check, __LINE__);
+	SLiMAssertScriptStop(threads_fitness_setup + "} 1 { sim.addSubpop('p1', 50); } late() { sim.mutationsOfType(m3).setSelectionCoeff(0.0); } " + threads_fitness_check, __LINE__);
+	
+	// Test the memo of run pair fitness effects, and the homozygous and unpaired fitness products kept in runs, with runs carrying many mutations that are then shared
+	// among many genomes (no new mutations, low recombination, cloning), with selection coefficients changed between fitness updates, and with the unpaired runs of
+	// males when the X is modeled, serially and in parallel; the checks come late enough that the memo has been turned off (while new mutations made it unprofitable)
+	// and back on again
+	std::string memo_fitness_setup(_FitnessTestSetup("mutationRuns=2", "5e-3", "0.002", "1e-7"));
+	std::string memo_threads_fitness_setup(_FitnessTestSetup("mutationRuns=2, threads=2", "5e-3", "0.002", "1e-7"));
+	std::string memo_fitness_check(_FitnessTestCheck(30));
+	
+	SLiMAssertScriptStop(memo_fitness_setup + "} 1 { sim.addSubpop('p1', 50); p1.setCloningRate(0.5); } 6 { sim.chromosome.setMutationRate(0.0); } " + memo_fitness_check, __LINE__);
+	SLiMAssertScriptStop(memo_fitness_setup + "} 1 { sim.addSubpop('p1', 50); p1.setCloningRate(0.5); } 6 { sim.chromosome.setMutationRate(0.0); } late() { for (m in sim.mutationsOfType(m2)) m.setSelectionCoeff(m.selectionCoeff * 0.5); } " + memo_fitness_check, __LINE__);
+	SLiMAssertScriptStop(memo_fitness_setup + "initializeSex('X'); } 1 { sim.addSubpop('p1', 50); p1.setCloningRate(0.5); } 6 { sim.chromosome.setMutationRate(0.0); } " + memo_fitness_check, __LINE__);
+	SLiMAssertScriptStop(memo_fitness_setup + "initializeSex('X'); } 1 { sim.addSubpop('p1', 50); p1.setCloningRate(0.5); } 6 { sim.chromosome.setMutationRate(0.0); } late() { for (m in sim.mutationsOfType(m2)) m.setSelectionCoeff(m.selectionCoeff * 0.5); } " + memo_fitness_check, __LINE__);
+	SLiMAssertScriptStop(memo_threads_fitness_setup + "} 1 { sim.addSubpop('p1', 50); p1.setCloningRate(0.5); } 6 { sim.chromosome.setMutationRate(0.0); } late() { for (m in sim.mutationsOfType(m2)) m.setSelectionCoeff(m.selectionCoeff * 0.5); } " + memo_fitness_check, __LINE__);
+	SLiMAssertScriptStop(memo_threads_fitness_setup + "initializeSex('X'); } 1 { sim.addSubpop('p1', 50); p1.setCloningRate(0.5); } 6 { sim.chromosome.setMutationRate(0.0); } late() { for (m in sim.mutationsOfType(m2)) m.setSelectionCoeff(m.selectionCoeff * 0.5); } " + memo_fitness_check, __LINE__);
 }
 
 #pragma mark Individual tests
@@ -2499,6 +2632,7 @@ void _RunIndividualTests(void)
 #pragma mark InteractionType tests
 static void _RunInteractionTypeTests_Nonspatial(bool p_reciprocal, bool p_immediate, bool p_sex_enabled, std::string p_sex_segregation);
 static void _RunInteractionTypeTests_Spatial(std::string p_max_distance, bool p_reciprocal, bool p_immediate, bool p_sex_enabled, std::string p_sex_segregation);
+static void _RunInteractionTypeTests_Sparse(std::string p_spatiality, bool p_reciprocal, bool p_immediate, bool p_periodic, std::string p_sex_segregation);
 
 void _RunInteractionTypeTests(void)
 {
@@ -2525,6 +2659,10 @@ void _RunInteractionTypeTests(void)
 	SLiMAssertScriptRaise(gen1_setup_i1x + "1 { i1.spatiality = 'x'; }", 1, 435, "read-only property", __LINE__);
 	SLiMAssertScriptStop(gen1_setup_i1x + "1 { i1.tag = 17; } 2 { if (i1.tag == 17) stop(); }", __LINE__);
 	
+	// Test that evaluate(immediate=T) passes the correct exerter to interaction() callbacks for reciprocal spatial interactions
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(dimensionality='xy'); initializeMutationRate(1e-7); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); initializeInteractionType('i1', 'xy', reciprocal=T, maxDistance=0.3); i1.setInteractionFunction('n', 1.0, 0.1); initializeInteractionType('i2', 'xy', reciprocal=T, maxDistance=0.3); i2.setInteractionFunction('n', 1.0, 0.1); } 1 { sim.addSubpop('p1', 50); ind = p1.individuals; ind.x = runif(50); ind.y = runif(50); i1.evaluate(immediate=T); i2.evaluate(immediate=F); ok = T; for (i in 0:49) ok = ok & identical(i1.strength(ind[i]), i2.strength(ind[i])); if (ok) stop(); } interaction(i1) { return strength * (receiver.x + exerter.x); } interaction(i2) { return strength * (receiver.x + exerter.x); }", __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(dimensionality='xy', periodicity='xy'); initializeMutationRate(1e-7); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); initializeInteractionType('i1', 'xy', reciprocal=T, maxDistance=0.3); i1.setInteractionFunction('n', 1.0, 0.1); initializeInteractionType('i2', 'xy', reciprocal=T, maxDistance=0.3); i2.setInteractionFunction('n', 1.0, 0.1); } 1 { sim.addSubpop('p1', 50); ind = p1.individuals; ind.x = runif(50); ind.y = runif(50); i1.evaluate(immediate=T); i2.evaluate(immediate=F); ok = T; for (i in 0:49) ok = ok & identical(i1.strength(ind[i]), i2.strength(ind[i])); if (ok) stop(); } interaction(i1) { return strength * (receiver.x + exerter.x); } interaction(i2) { return strength * (receiver.x + exerter.x); }", __LINE__);
+	
 	// Run tests in a variety of combinations
 	_RunInteractionTypeTests_Nonspatial(false, false, false, "**");
 	_RunInteractionTypeTests_Nonspatial(true, false, false, "**");
@@ -2575,6 +2713,62 @@ void _RunInteractionTypeTests(void)
 		_RunInteractionTypeTests_Spatial(" INF ", true, true, true, seg_str);
 		_RunInteractionTypeTests_Spatial("999.0", true, true, true, seg_str);
 	}
+	
+	// Test sparse storage; it should give the same results as the default storage
+	SLiMAssertScriptStop(gen1_setup_i1x + "1 { if (i1.sparse == F) stop(); }", __LINE__);
+	SLiMAssertScriptRaise(gen1_setup_i1x + "1 { i1.sparse = T; }", 1, 431, "read-only property", __LINE__);
+	SLiMAssertScriptStop("initialize() { initializeSLiMOptions(dimensionality='x'); initializeMutationRate(1e-5); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); initializeInteractionType('i1', 'x', maxDistance=0.2, sparse=T); } 1 { if (i1.sparse == T) stop(); }", __LINE__);
+	SLiMAssertScriptRaise("initialize() { initializeInteractionType('i1', '', sparse=T); }", 1, 15, "sparse storage requires", __LINE__);
+	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(dimensionality='x'); initializeInteractionType('i1', 'x', sparse=T); }", 1, 58, "sparse storage requires", __LINE__);
+	SLiMAssertScriptRaise("initialize() { initializeSLiMOptions(dimensionality='x'); initializeInteractionType('i1', 'x', maxDistance=0.2, sparse=T); i1.maxDistance = INF; }", 1, 138, "must be finite", __LINE__);
+	
+	_RunInteractionTypeTests_Sparse("x", false, false, false, "**");
+	_RunInteractionTypeTests_Sparse("xy", false, false, false, "**");
+	_RunInteractionTypeTests_Sparse("xyz", false, false, false, "**");
+	_RunInteractionTypeTests_Sparse("xy", true, false, false, "**");
+	_RunInteractionTypeTests_Sparse("xy", false, true, false, "**");
+	_RunInteractionTypeTests_Sparse("xy", true, true, false, "**");
+	_RunInteractionTypeTests_Sparse("xy", false, false, true, "**");
+	_RunInteractionTypeTests_Sparse("xyz", true, false, true, "**");
+	_RunInteractionTypeTests_Sparse("xy", false, false, false, "FM");
+	_RunInteractionTypeTests_Sparse("xy", true, false, false, "MM");
+	_RunInteractionTypeTests_Sparse("xy", true, true, true, "*F");
+	
+	// Test multithreaded k-d tree construction and totalOfNeighborStrengths(); periodic in xyz, the k-d tree for 400 individuals has 10800 nodes, enough
+	// to be built in parallel.  Bulk totals from i1 are compared with totals from i2 requested one receiver at a time, which are calculated serially;
+	// they should be identical except for rounding error from mirrored periodic distances in the reciprocal case (see TotalNeighborStrengthsParallel()).
+	// A vector with repeated receivers is handled serially, and should be identical to requesting the same receivers one at a time.
+	for (std::string spatiality_string : {"x", "xy", "xyz"})
+	{
+		for (std::string reciprocal_string : {"F", "T"})
+		{
+			for (std::string sparse_string : {"F", "T"})
+			{
+				std::string compare_string = (reciprocal_string == "T") ? "all(abs(t1 - t2) < 1e-12)" : "identical(t1, t2)";
+				std::string options_string = "'" + spatiality_string + "', reciprocal=" + reciprocal_string + ", maxDistance=0.1, sparse=" + sparse_string;
+				std::string gen1_setup_threaded("initialize() { initializeSLiMOptions(dimensionality='xyz', periodicity='xyz', threads=4); initializeMutationRate(1e-7); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); initializeInteractionType('i1', " + options_string + "); i1.setInteractionFunction('n', 1.0, 0.05); initializeInteractionType('i2', " + options_string + "); i2.setInteractionFunction('n', 1.0, 0.05); } 1 { sim.addSubpop('p1', 400); p1.setSpatialBounds(c(0.0, 0.0, 0.0, 1.0, 1.0, 1.0)); ind = p1.individuals; ind.x = runif(400); ind.y = runif(400); ind.z = runif(400); i1.evaluate(); i2.evaluate(); ");
+				
+				SLiMAssertScriptStop(gen1_setup_threaded + "t1 = i1.totalOfNeighborStrengths(ind); t2 = sapply(ind, 'i2.totalOfNeighborStrengths(applyValue);'); if (" + compare_string + " & identical(i1.nearestNeighbors(ind[5], 10), i2.nearestNeighbors(ind[5], 10))) stop(); }", __LINE__);
+				SLiMAssertScriptStop(gen1_setup_threaded + "t1 = i1.totalOfNeighborStrengths(c(ind, ind)); t2 = sapply(c(ind, ind), 'i2.totalOfNeighborStrengths(applyValue);'); if (identical(t1, t2)) stop(); }", __LINE__);
+			}
+		}
+	}
+}
+
+void _RunInteractionTypeTests_Sparse(std::string p_spatiality, bool p_reciprocal, bool p_immediate, bool p_periodic, std::string p_sex_segregation)
+{
+	// i1 uses the default storage and i2 uses sparse storage; every query is compared between them
+	std::string periodicity_string = p_periodic ? ", periodicity='" + p_spatiality + "'" : "";
+	std::string sex_string = (p_sex_segregation != "**") ? "initializeSex('A'); " : "";
+	std::string options_string = "'" + p_spatiality + "', reciprocal=" + (p_reciprocal ? "T" : "F") + ", maxDistance=0.2, sexSegregation='" + p_sex_segregation + "'";
+	std::string immediate_string = p_immediate ? "immediate=T" : "immediate=F";
+	std::string gen1_setup_sparse("initialize() { initializeSLiMOptions(dimensionality='xyz'" + periodicity_string + "); " + sex_string + "initializeMutationRate(1e-7); initializeMutationType('m1', 0.5, 'f', 0.0); initializeGenomicElementType('g1', m1, 1.0); initializeGenomicElement(g1, 0, 99999); initializeRecombinationRate(1e-8); initializeInteractionType('i1', " + options_string + "); i1.setInteractionFunction('n', 1.0, 0.1); initializeInteractionType('i2', " + options_string + ", sparse=T); i2.setInteractionFunction('n', 1.0, 0.1); } 1 { sim.addSubpop('p1', 200); ind = p1.individuals; ind.x = runif(200); ind.y = runif(200); ind.z = runif(200); i1.evaluate(" + immediate_string + "); i2.evaluate(" + immediate_string + "); ok = T; ");
+	std::string comparisons("for (i in 0:19) { ok = ok & identical(i1.strength(ind[i]), i2.strength(ind[i])); ok = ok & identical(i1.strength(ind[i], ind), i2.strength(ind[i], ind)); ok = ok & identical(i1.strength(ind, ind[i]), i2.strength(ind, ind[i])); ok = ok & identical(i1.distance(ind[i]), i2.distance(ind[i])); ok = ok & all(i1.strength(ind[i], i2.drawByStrength(ind[i], 10)) > 0.0); ok = ok & all(i1.strength(ind[i], i2.drawByStrength(ind[i], 100)) > 0.0); } ok = ok & all(abs(i1.totalOfNeighborStrengths(ind) - i2.totalOfNeighborStrengths(ind)) < 1e-12); ok = ok & identical(i1.nearestNeighbors(ind[0], 5), i2.nearestNeighbors(ind[0], 5)); if (ok) stop(); }");
+	
+	SLiMAssertScriptStop(gen1_setup_sparse + comparisons, __LINE__);
+	SLiMAssertScriptStop(gen1_setup_sparse + comparisons + " interaction(i1) { return strength * (receiver.x + exerter.x); } interaction(i2) { return strength * (receiver.x + exerter.x); }", __LINE__);
+	SLiMAssertScriptStop(gen1_setup_sparse + comparisons + " interaction(i1) { return strength * exp(-distance); } interaction(i2) { return strength * exp(-distance) + 0.0 * size(exerter); }", __LINE__);
+	SLiMAssertScriptStop(gen1_setup_sparse + "i2.unevaluate(); ind.x = runif(200); i1.unevaluate(); i1.evaluate(); i2.evaluate(); " + comparisons, __LINE__);
 }
 
 void _RunInteractionTypeTests_Nonspatial(bool p_reciprocal, bool p_immediate, bool p_sex_enabled, std::string p_sex_segregation)
@@ -3233,6 +3427,28 @@ void _RunSLiMEidosBlockTests(void)
 	SLiMAssertScriptStop(gen1_setup_p1 + "function (i)A(i x) {B(x)+1;} function (i)B(i x) {x*2;} 1 { if (A(2) == 5) stop(); } 10 {  } ", __LINE__);
 	SLiMAssertScriptStop(gen1_setup_p1 + "function (i)fac([i b=10]) { if (b <= 1) return 1; else return b*fac(b-1); } 1 { if (fac(5) == 120) stop(); } 10 {  } ", __LINE__);
 	SLiMAssertScriptStop(gen1_setup_p1 + "function (i)spsize(o<Subpopulation>$ sp) { sp.individualCount; } 2 { if (spsize(p1) == 10) stop(); } 10 {  } ", __LINE__);
+	
+	// Test batched fitness() callbacks, which are called once per generation with vectors; m2 has dominance 1.0, so fitness is a product over its unique mutations.
+	// Chained callbacks see the relFitness values of the callbacks before them, mutation types without callbacks are unaffected, and global callbacks still apply.
+	std::string batch_fitness_setup(_FitnessTestSetup("batchFitnessCallbacks=T"));
+	std::string batch_fitness_check(_FitnessTestCheck(11, "2"));
+	
+	SLiMAssertScriptStop(batch_fitness_setup + "} 1 { sim.addSubpop('p1', 50); } fitness(m2) { if ((size(mut) != size(relFitness)) | (size(mut) != size(individual)) | (size(mut) != size(homozygous))) stop('size mismatch'); return 1.0 + mut.selectionCoeff * 2; } " + batch_fitness_check, __LINE__);
+	SLiMAssertScriptStop(batch_fitness_setup + "initializeSex('A'); } 1 { sim.addSubpop('p1', 50); } fitness(m2) { return relFitness * 2 - 1.0; } fitness(NULL) { return 1.0; } " + batch_fitness_check, __LINE__);
+	SLiMAssertScriptStop(batch_fitness_setup + "} 1 { sim.addSubpop('p1', 50); } fitness(m2) { return relFitness * 4 - 3.0; } fitness(NULL) { return 1.0; } fitness(m2) { return (relFitness + 1.0) / 2; } fitness(m1) { return relFitness; } " + batch_fitness_check, __LINE__);
+	SLiMAssertScriptStop(batch_fitness_setup + "initializeSex('X'); } 1 { sim.addSubpop('p1', 50); } fitness(m2) { return ifelse(homozygous | genome2.isNullGenome, relFitness, relFitness) * 2 - 1.0; } " + batch_fitness_check, __LINE__);
+	SLiMAssertScriptRaise(batch_fitness_setup + "} 1 { sim.addSubpop('p1', 50); } fitness(m2) { return c(relFitness, 1.0); } ", 1, 351, "either a singleton or one value per mutation", __LINE__);
+	SLiMAssertScriptRaise(batch_fitness_setup + "} 1 { sim.addSubpop('p1', 50); } fitness(m2) { return 2; } ", 1, 351, "either a singleton or one value per mutation", __LINE__);
+	SLiMAssertScriptStop(batch_fitness_setup + "} 1 { sim.addSubpop('p1', 50); } 1 early() { sim.setValue('gen', 0); } fitness(m2) { if (any(mut.mutationType != m2)) stop('mixed mutation types'); if (sim.getValue('gen') == sim.generation) stop('called twice'); sim.setValue('gen', sim.generation); return 1.0 + mut.selectionCoeff * 2; } " + batch_fitness_check, __LINE__);
+	
+	// Test fitness() callbacks compiled to native closures by SLiMSim::OptimizeScriptBlock(); integer results are left to the interpreter, which raises
+	std::string native_fitness_setup(_FitnessTestSetup(""));
+	std::string native_fitness_check(_FitnessTestCheck(11, "2", "(1.0 + (i % 2) * 0.5)"));
+	
+	SLiMAssertScriptStop(native_fitness_setup + "} 1 { sim.addSubpop('p1', 50); } fitness(m2) { return 1.0 + mut.selectionCoeff * 2; } fitness(NULL) { return 1.0 + (individual.index % 2) * 0.5; } " + native_fitness_check, __LINE__);
+	SLiMAssertScriptStop(native_fitness_setup + "} 1 { sim.addSubpop('p1', 50); } fitness(m2) { return relFitness * 2 - 1.0; } fitness(m1) { return relFitness; } fitness(NULL) { 1.0 + sqrt(individual.index % 2) / 2; } " + native_fitness_check, __LINE__);
+	SLiMAssertScriptStop(native_fitness_setup + "} 1 { sim.addSubpop('p1', 50); } fitness(m2) { return exp(log(relFitness) * 4.0) ^ 0.25 * 2 - abs(-1.0); } fitness(NULL) { return 1.0 + (individual.index % 2) * 0.5; } " + native_fitness_check, __LINE__);
+	SLiMAssertScriptRaise(native_fitness_setup + "} 1 { sim.addSubpop('p1', 50); } fitness(NULL) { return individual.index + 1; } ", 1, 303, "float singleton return value", __LINE__);
 }
 
 #pragma mark Continuous space tests
@@ -278,6 +278,51 @@ void _SpatialMap::ColorForValue(double p_value, float *p_rgb_ptr)
 }
 
 
+#pragma mark -
+#pragma mark MutationRunPairMemo
+#pragma mark -
+
+void MutationRunPairMemo::Clear(bool p_enabled)
+{
+	if (count_)
+	{
+		std::fill(entries_.begin(), entries_.end(), MemoEntry{nullptr, nullptr, 0.0});
+		count_ = 0;
+	}
+	
+	enabled_ = p_enabled;
+	lookup_count_ = 0;
+	hit_count_ = 0;
+}
+
+void MutationRunPairMemo::Grow(void)
+{
+	std::vector<MemoEntry> old_entries(std::max((size_t)1024, entries_.size() * 2), MemoEntry{nullptr, nullptr, 0.0});
+	
+	old_entries.swap(entries_);
+	count_ = 0;
+	
+	for (MemoEntry &entry : old_entries)
+		if (entry.run1_)
+			Insert(entry.run1_, entry.run2_, entry.fitness_);
+}
+
+void MutationRunPairMemo::Insert(const MutationRun *p_run1, const MutationRun *p_run2, double p_fitness)
+{
+	if ((count_ + 1) * 2 > entries_.size())
+		Grow();
+	
+	size_t mask = entries_.size() - 1;
+	size_t slot = SlotForKey(p_run1, p_run2);
+	
+	while (entries_[slot].run1_)
+		slot = (slot + 1) & mask;
+	
+	entries_[slot] = MemoEntry{p_run1, p_run2, p_fitness};
+	count_++;
+}
+
+
 #pragma mark -
 #pragma mark Subpopulation
 #pragma mark -
@@ -520,7 +565,7 @@ Subpopulation::Subpopulation(Population &p_population, slim_objectid_t p_subpopu
 	for (slim_popsize_t i = 0; i < parent_subpop_size_; i++)
 		*(fitness_buffer_ptr++) = 1.0;
 	
-	lookup_parent_ = gsl_ran_discrete_preproc(parent_subpop_size_, cached_parental_fitness_);
+	lookup_parent_.Build(parent_subpop_size_, cached_parental_fitness_);
 }
 
 // SEX ONLY
@@ -554,8 +599,8 @@ population_(p_population), subpopulation_id_(p_subpopulation_id), sex_enabled_(t
 		*(male_buffer_ptr++) = 1.0;
 	}
 	
-	lookup_female_parent_ = gsl_ran_discrete_preproc(parent_first_male_index_, cached_parental_fitness_);
-	lookup_male_parent_ = gsl_ran_discrete_preproc(num_males, cached_parental_fitness_ + parent_first_male_index_);
+	lookup_female_parent_.Build(parent_first_male_index_, cached_parental_fitness_);
+	lookup_male_parent_.Build(num_males, cached_parental_fitness_ + parent_first_male_index_);
 }
 
 
@@ -563,15 +608,6 @@ Subpopulation::~Subpopulation(void)
 {
 	//std::cout << "Subpopulation::~Subpopulation" << std::endl;
 	
-	if (lookup_parent_)
-		gsl_ran_discrete_free(lookup_parent_);
-	
-	if (lookup_female_parent_)
-		gsl_ran_discrete_free(lookup_female_parent_);
-	
-	if (lookup_male_parent_)
-		gsl_ran_discrete_free(lookup_male_parent_);
-	
 	if (cached_parental_fitness_)
 		free(cached_parental_fitness_);
 	
@@ -587,6 +623,50 @@ Subpopulation::~Subpopulation(void)
 	}
 }
 
+void Subpopulation::DrawParentsUsingFitness(slim_popsize_t p_count, slim_popsize_t *p_buffer) const
+{
+#if DEBUG
+	if (sex_enabled_)
+		EIDOS_TERMINATION << "ERROR (Subpopulation::DrawParentsUsingFitness): (internal error) called on a population for which sex is enabled." << EidosTerminate();
+#endif
+	
+	if (lookup_parent_.IsBuilt())
+		lookup_parent_.DrawMultiple(gEidos_rng, p_count, p_buffer, 0);
+	else
+		for (slim_popsize_t draw_index = 0; draw_index < p_count; ++draw_index)
+			p_buffer[draw_index] = static_cast<slim_popsize_t>(Eidos_RandomInt(gEidos_rng, parent_subpop_size_));
+}
+
+// SEX ONLY
+void Subpopulation::DrawFemaleParentsUsingFitness(slim_popsize_t p_count, slim_popsize_t *p_buffer) const
+{
+#if DEBUG
+	if (!sex_enabled_)
+		EIDOS_TERMINATION << "ERROR (Subpopulation::DrawFemaleParentsUsingFitness): (internal error) called on a population for which sex is not enabled." << EidosTerminate();
+#endif
+	
+	if (lookup_female_parent_.IsBuilt())
+		lookup_female_parent_.DrawMultiple(gEidos_rng, p_count, p_buffer, 0);
+	else
+		for (slim_popsize_t draw_index = 0; draw_index < p_count; ++draw_index)
+			p_buffer[draw_index] = static_cast<slim_popsize_t>(Eidos_RandomInt(gEidos_rng, parent_first_male_index_));
+}
+
+// SEX ONLY
+void Subpopulation::DrawMaleParentsUsingFitness(slim_popsize_t p_count, slim_popsize_t *p_buffer) const
+{
+#if DEBUG
+	if (!sex_enabled_)
+		EIDOS_TERMINATION << "ERROR (Subpopulation::DrawMaleParentsUsingFitness): (internal error) called on a population for which sex is not enabled." << EidosTerminate();
+#endif
+	
+	if (lookup_male_parent_.IsBuilt())
+		lookup_male_parent_.DrawMultiple(gEidos_rng, p_count, p_buffer, parent_first_male_index_);
+	else
+		for (slim_popsize_t draw_index = 0; draw_index < p_count; ++draw_index)
+			p_buffer[draw_index] = static_cast<slim_popsize_t>(Eidos_RandomInt(gEidos_rng, parent_subpop_size_ - parent_first_male_index_) + parent_first_male_index_);
+}
+
 void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callbacks, std::vector<SLiMEidosBlock*> &p_global_fitness_callbacks)
 {
 	const std::map<slim_objectid_t,MutationType*> &mut_types = population_.sim_.MutationTypes();
@@ -797,24 +877,85 @@ void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callba
 	// We optimize the pure neutral case, as long as no fitness callbacks are defined; fitness values are then simply 1.0, for everybody.
 	bool pure_neutral = (!fitness_callbacks_exist && !global_fitness_callbacks_exist && population_.sim_.pure_neutral_);
 	
-	// calculate fitnesses in parent population and create new lookup table
-	if (sex_enabled_)
+	// Figure out whether we can calculate fitness values in parallel.  We do this only in the general case, and only when no Eidos
+	// code will run, since Eidos is not thread-safe: no global fitness() callbacks, and either no fitness() callbacks at all, or only
+	// the global constant neutral-making callbacks of nonneutral regime 2 (see mutation_run.h).  In regime 2 the nonneutral caches
+	// exclude the mutation types that those callbacks neutralize, so the callbacks can never alter a fitness value, and the result
+	// of FitnessOfParentWithGenomeIndices_NoCallbacks() is identical to that of the callback versions.
+	int thread_count = population_.sim_.ThreadCount();
+	bool parallel_fitness = ((thread_count > 1) && !pure_neutral && !skip_chromosomal_fitness && !global_fitness_callbacks_exist);
+	
+	if (parallel_fitness && fitness_callbacks_exist)
 	{
-		// SEX ONLY
-		double totalMaleFitness = 0.0, totalFemaleFitness = 0.0;
-		
-		if (lookup_female_parent_)
+#if SLIM_USE_NONNEUTRAL_CACHES
+		if (population_.sim_.last_nonneutral_regime_ == 2)
+		{
+			for (SLiMEidosBlock *fitness_callback : p_fitness_callbacks)
+			{
+				if (fitness_callback->active_)
+				{
+					auto found_muttype_pair = mut_types.find(fitness_callback->mutation_type_id_);
+					
+					if ((found_muttype_pair == mut_types.end()) || !found_muttype_pair->second->set_neutral_by_global_active_callback_)
+					{
+						parallel_fitness = false;
+						break;
+					}
+				}
+			}
+		}
+		else
+#endif
 		{
-			gsl_ran_discrete_free(lookup_female_parent_);
-			lookup_female_parent_ = nullptr;
+			parallel_fitness = false;
 		}
+	}
+	
+	if (parallel_fitness)
+		ValidateParentalNonneutralCaches(thread_count);
+	
+	// With batched callbacks, the fitness of every individual is calculated up front, calling each fitness() callback only once; the general
+	// case loops below then just pick up the results.  Global fitness() callbacks are called afterwards, per individual, as they always are.
+	bool batch_fitness = (fitness_callbacks_exist && !pure_neutral && !skip_chromosomal_fitness && !parallel_fitness && population_.sim_.BatchFitnessCallbacks());
+	
+	// Clear the memos of run pair fitness effects; each thread gets its own when working in parallel.  The memos are turned off if they
+	// did not pay off in the last update that used them, and turned back on periodically; see MutationRunPairMemo.
+	if (!pure_neutral && !skip_chromosomal_fitness)
+	{
+		int64_t lookup_count = 0, hit_count = 0;
 		
-		if (lookup_male_parent_)
+		for (MutationRunPairMemo &memo : fitness_memos_)
 		{
-			gsl_ran_discrete_free(lookup_male_parent_);
-			lookup_male_parent_ = nullptr;
+			lookup_count += memo.LookupCount();
+			hit_count += memo.HitCount();
 		}
 		
+		if (lookup_count >= SLIM_FITNESS_MEMO_MIN_LOOKUPS)
+			fitness_memo_enabled_ = (hit_count * SLIM_FITNESS_MEMO_MIN_HIT_RATIO >= lookup_count);
+		
+		if (fitness_memo_enabled_)
+			fitness_memo_skip_count_ = 0;
+		else if (++fitness_memo_skip_count_ >= SLIM_FITNESS_MEMO_RETRY_INTERVAL)
+			fitness_memo_enabled_ = true;
+		
+		fitness_memos_.resize(parallel_fitness ? thread_count : 1);
+		
+		for (MutationRunPairMemo &memo : fitness_memos_)
+			memo.Clear(fitness_memo_enabled_);
+	}
+	
+	if (batch_fitness)
+		UpdateFitness_BatchCallbacks(p_fitness_callbacks, single_fitness_callback, single_callback_mut_type);
+	
+	// calculate fitnesses in parent population and create new lookup table
+	if (sex_enabled_)
+	{
+		// SEX ONLY
+		double totalMaleFitness = 0.0, totalFemaleFitness = 0.0;
+		
+		lookup_female_parent_.Clear();
+		lookup_male_parent_.Clear();
+		
 		// Set up to draw random females
 		if (pure_neutral)
 		{
@@ -841,6 +982,11 @@ void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callba
 				totalFemaleFitness += fitness;
 			}
 		}
+		else if (parallel_fitness)
+		{
+			// general case for females, in parallel
+			totalFemaleFitness = UpdateFitnessOfParentRange_NoCallbacks(0, parent_first_male_index_, false, thread_count);
+		}
 		else
 		{
 			// general case for females
@@ -848,8 +994,10 @@ void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callba
 			{
 				double fitness;
 				
-				if (!fitness_callbacks_exist)
-					fitness = FitnessOfParentWithGenomeIndices_NoCallbacks(i);
+				if (batch_fitness)
+					fitness = batch_fitness_[i];
+				else if (!fitness_callbacks_exist)
+					fitness = FitnessOfParentWithGenomeIndices_NoCallbacks(i, fitness_memos_[0]);
 				else if (single_fitness_callback)
 					fitness = FitnessOfParentWithGenomeIndices_SingleCallback(i, p_fitness_callbacks, single_callback_mut_type);
 				else
@@ -870,9 +1018,9 @@ void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callba
 		if (totalFemaleFitness <= 0.0)
 			EIDOS_TERMINATION << "ERROR (Subpopulation::UpdateFitness): total fitness of females is <= 0.0." << EidosTerminate(nullptr);
 		
-		// in pure neutral models we don't set up the discrete preproc
-		if (!pure_neutral)
-			lookup_female_parent_ = gsl_ran_discrete_preproc(parent_first_male_index_, cached_parental_fitness_);
+		// in pure neutral models we don't set up the lookup table; in parallel, it is set up below along with the male lookup table
+		if (!pure_neutral && !parallel_fitness)
+			lookup_female_parent_.Build(parent_first_male_index_, cached_parental_fitness_);
 		
 		// Set up to draw random males
 		slim_popsize_t num_males = parent_subpop_size_ - parent_first_male_index_;
@@ -905,6 +1053,11 @@ void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callba
 				totalMaleFitness += fitness;
 			}
 		}
+		else if (parallel_fitness)
+		{
+			// general case for males, in parallel
+			totalMaleFitness = UpdateFitnessOfParentRange_NoCallbacks(parent_first_male_index_, parent_subpop_size_, true, thread_count);
+		}
 		else
 		{
 			// general case for males
@@ -913,8 +1066,10 @@ void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callba
 				slim_popsize_t individual_index = (i + parent_first_male_index_);
 				double fitness;
 				
-				if (!fitness_callbacks_exist)
-					fitness = FitnessOfParentWithGenomeIndices_NoCallbacks(individual_index);
+				if (batch_fitness)
+					fitness = batch_fitness_[individual_index];
+				else if (!fitness_callbacks_exist)
+					fitness = FitnessOfParentWithGenomeIndices_NoCallbacks(individual_index, fitness_memos_[0]);
 				else if (single_fitness_callback)
 					fitness = FitnessOfParentWithGenomeIndices_SingleCallback(individual_index, p_fitness_callbacks, single_callback_mut_type);
 				else
@@ -937,19 +1092,31 @@ void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callba
 		if (totalMaleFitness <= 0.0)
 			EIDOS_TERMINATION << "ERROR (Subpopulation::UpdateFitness): total fitness of males is <= 0.0." << EidosTerminate(nullptr);
 		
-		// in pure neutral models we don't set up the discrete preproc
+		// in pure neutral models we don't set up the lookup table
 		if (!pure_neutral)
-			lookup_male_parent_ = gsl_ran_discrete_preproc(num_males, cached_parental_fitness_ + parent_first_male_index_);
+		{
+			if (parallel_fitness)
+			{
+				// the female and male lookup tables are independent, so we can build them concurrently
+#pragma omp parallel sections num_threads(2)
+				{
+#pragma omp section
+					lookup_female_parent_.Build(parent_first_male_index_, cached_parental_fitness_);
+#pragma omp section
+					lookup_male_parent_.Build(num_males, cached_parental_fitness_ + parent_first_male_index_);
+				}
+			}
+			else
+			{
+				lookup_male_parent_.Build(num_males, cached_parental_fitness_ + parent_first_male_index_);
+			}
+		}
 	}
 	else
 	{
 		double *fitness_buffer_ptr = cached_parental_fitness_;
 		
-		if (lookup_parent_)
-		{
-			gsl_ran_discrete_free(lookup_parent_);
-			lookup_parent_ = nullptr;
-		}
+		lookup_parent_.Clear();
 		
 		if (pure_neutral)
 		{
@@ -975,6 +1142,11 @@ void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callba
 				totalFitness += fitness;
 			}
 		}
+		else if (parallel_fitness)
+		{
+			// general case for hermaphrodites, in parallel
+			totalFitness = UpdateFitnessOfParentRange_NoCallbacks(0, parent_subpop_size_, false, thread_count);
+		}
 		else
 		{
 			// general case for hermaphrodites
@@ -982,8 +1154,10 @@ void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callba
 			{
 				double fitness;
 				
-				if (!fitness_callbacks_exist)
-					fitness = FitnessOfParentWithGenomeIndices_NoCallbacks(i);
+				if (batch_fitness)
+					fitness = batch_fitness_[i];
+				else if (!fitness_callbacks_exist)
+					fitness = FitnessOfParentWithGenomeIndices_NoCallbacks(i, fitness_memos_[0]);
 				else if (single_fitness_callback)
 					fitness = FitnessOfParentWithGenomeIndices_SingleCallback(i, p_fitness_callbacks, single_callback_mut_type);
 				else
@@ -1002,9 +1176,9 @@ void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callba
 		if (totalFitness <= 0.0)
 			EIDOS_TERMINATION << "ERROR (Subpopulation::UpdateFitness): total fitness of all individuals is <= 0.0." << EidosTerminate(nullptr);
 		
-		// in pure neutral models we don't set up the discrete preproc
+		// in pure neutral models we don't set up the lookup table
 		if (!pure_neutral)
-			lookup_parent_ = gsl_ran_discrete_preproc(parent_subpop_size_, cached_parental_fitness_);
+			lookup_parent_.Build(parent_subpop_size_, cached_parental_fitness_);
 	}
 	
 	cached_fitness_size_ = parent_subpop_size_;
@@ -1014,9 +1188,205 @@ void Subpopulation::UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callba
 #endif
 }
 
+// Validate the nonneutral caches of all mutation runs used by the parental generation, so that FitnessOfParentWithGenomeIndices_NoCallbacks()
+// will not modify any run as a side effect; since runs are shared among genomes, that would not be safe when calculating fitness in parallel.
+// Each run needing validation is collected once, and then the runs are validated in parallel, so that each run is modified by only one thread.
+// The fitness products kept in the runs (see FitnessOfHomozygousMutationRun_NoCallbacks()) are then calculated in the same way, for each run
+// that is paired with itself or unpaired in some individual and does not already have the product it needs.
+void Subpopulation::ValidateParentalNonneutralCaches(int p_thread_count)
+{
+#if SLIM_USE_NONNEUTRAL_CACHES
+	SLiMSim &sim = population_.sim_;
+	int32_t nonneutral_change_counter = sim.nonneutral_change_counter_;
+	int32_t nonneutral_regime = sim.last_nonneutral_regime_;
+	std::vector<MutationRun *> invalid_runs;
+	std::vector<MutationRun *> homozygous_runs;
+	std::vector<std::pair<MutationRun *, GenomeType>> unpaired_runs;
+	
+	for (slim_popsize_t individual_index = 0; individual_index < parent_subpop_size_; ++individual_index)
+	{
+		Genome &genome1 = parent_genomes_[individual_index * 2];
+		Genome &genome2 = parent_genomes_[individual_index * 2 + 1];
+		bool genome1_null = genome1.IsNull();
+		bool genome2_null = genome2.IsNull();
+		
+		if (genome1_null && genome2_null)
+			continue;
+		
+		if (genome1_null || genome2_null)
+		{
+			Genome &genome = genome1_null ? genome2 : genome1;
+			const int32_t mutrun_count = genome.mutrun_count_;
+			
+			for (int run_index = 0; run_index < mutrun_count; ++run_index)
+			{
+				MutationRun *mutrun = genome.mutruns_[run_index].get();
+				bool needs_validation = mutrun->nonneutral_cache_needs_validation(nonneutral_change_counter);
+				
+				if (needs_validation)
+					invalid_runs.emplace_back(mutrun);
+				
+				if (needs_validation || (mutrun->cached_unpaired_fitness(x_chromosome_dominance_coeff_) < 0.0))
+					unpaired_runs.emplace_back(mutrun, genome.Type());
+			}
+		}
+		else
+		{
+			const int32_t mutrun_count = genome1.mutrun_count_;
+			
+			for (int run_index = 0; run_index < mutrun_count; ++run_index)
+			{
+				MutationRun *mutrun1 = genome1.mutruns_[run_index].get();
+				MutationRun *mutrun2 = genome2.mutruns_[run_index].get();
+				bool needs_validation = mutrun1->nonneutral_cache_needs_validation(nonneutral_change_counter);
+				
+				if (needs_validation)
+					invalid_runs.emplace_back(mutrun1);
+				
+				if (mutrun1 == mutrun2)
+				{
+					if (needs_validation || (mutrun1->cached_homozygous_fitness() < 0.0))
+						homozygous_runs.emplace_back(mutrun1);
+				}
+				else if (mutrun2->nonneutral_cache_needs_validation(nonneutral_change_counter))
+				{
+					invalid_runs.emplace_back(mutrun2);
+				}
+			}
+		}
+	}
+	
+	// each of these steps must finish before the next begins, since a run can appear in more than one of these vectors
+	if (invalid_runs.size())
+	{
+		std::sort(invalid_runs.begin(), invalid_runs.end());
+		invalid_runs.erase(std::unique(invalid_runs.begin(), invalid_runs.end()), invalid_runs.end());
+		
+		int64_t run_count = (int64_t)invalid_runs.size();
+		MutationRun **runs = invalid_runs.data();
+		
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+		for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+		{
+			int64_t run_start = (run_count * thread_index) / p_thread_count;
+			int64_t run_end = (run_count * (thread_index + 1)) / p_thread_count;
+			
+			for (int64_t run_index = run_start; run_index < run_end; ++run_index)
+				runs[run_index]->validate_nonneutral_cache(nonneutral_change_counter, nonneutral_regime);
+		}
+	}
+	
+	if (homozygous_runs.size())
+	{
+		std::sort(homozygous_runs.begin(), homozygous_runs.end());
+		homozygous_runs.erase(std::unique(homozygous_runs.begin(), homozygous_runs.end()), homozygous_runs.end());
+		
+		int64_t run_count = (int64_t)homozygous_runs.size();
+		MutationRun **runs = homozygous_runs.data();
+		
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+		for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+		{
+			int64_t run_start = (run_count * thread_index) / p_thread_count;
+			int64_t run_end = (run_count * (thread_index + 1)) / p_thread_count;
+			
+			for (int64_t run_index = run_start; run_index < run_end; ++run_index)
+				FitnessOfHomozygousMutationRun_NoCallbacks(runs[run_index]);
+		}
+	}
+	
+	if (unpaired_runs.size())
+	{
+		std::sort(unpaired_runs.begin(), unpaired_runs.end());
+		unpaired_runs.erase(std::unique(unpaired_runs.begin(), unpaired_runs.end()), unpaired_runs.end());
+		
+		int64_t run_count = (int64_t)unpaired_runs.size();
+		std::pair<MutationRun *, GenomeType> *runs = unpaired_runs.data();
+		
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+		for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+		{
+			int64_t run_start = (run_count * thread_index) / p_thread_count;
+			int64_t run_end = (run_count * (thread_index + 1)) / p_thread_count;
+			
+			for (int64_t run_index = run_start; run_index < run_end; ++run_index)
+				FitnessOfUnpairedMutationRun_NoCallbacks(runs[run_index].first, runs[run_index].second);
+		}
+	}
+#else
+	(void)p_thread_count;
+#endif
+}
+
+// Calculate and cache the fitness of the parents in [p_start_index, p_end_index), in parallel, with no fitness() callbacks; the nonneutral caches
+// must already be valid (see ValidateParentalNonneutralCaches()).  The range is divided into one contiguous block per thread, and the block totals
+// are summed in block order, so the total depends only upon p_thread_count, not upon how the threads happen to be scheduled.
+double Subpopulation::UpdateFitnessOfParentRange_NoCallbacks(slim_popsize_t p_start_index, slim_popsize_t p_end_index, bool p_males, int p_thread_count)
+{
+	std::vector<double> block_totals(p_thread_count, 0.0);
+	double *block_totals_ptr = block_totals.data();
+	int64_t range_count = p_end_index - p_start_index;
+
+#pragma omp parallel for schedule(static, 1) num_threads(p_thread_count)
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+	{
+		slim_popsize_t block_start = p_start_index + (slim_popsize_t)((range_count * thread_index) / p_thread_count);
+		slim_popsize_t block_end = p_start_index + (slim_popsize_t)((range_count * (thread_index + 1)) / p_thread_count);
+		MutationRunPairMemo &memo = fitness_memos_[thread_index];
+		double block_total = 0.0;
+		
+		for (slim_popsize_t i = block_start; i < block_end; i++)
+		{
+			double fitness = FitnessOfParentWithGenomeIndices_NoCallbacks(i, memo);
+			
+			cached_parental_fitness_[i] = fitness;
+			
+			if (sex_enabled_)
+				cached_male_fitness_[i] = (p_males ? fitness : 0);		// this vector has 0 for all females, for mateChoice() callbacks
+			
+			block_total += fitness;
+		}
+		
+		block_totals_ptr[thread_index] = block_total;
+	}
+	
+	double total_fitness = 0.0;
+	
+	for (int thread_index = 0; thread_index < p_thread_count; ++thread_index)
+		total_fitness += block_totals_ptr[thread_index];
+	
+	return total_fitness;
+}
+
 double Subpopulation::ApplyFitnessCallbacks(MutationIndex p_mutation, int p_homozygous, double p_computed_fitness, std::vector<SLiMEidosBlock*> &p_fitness_callbacks, Individual *p_individual, Genome *p_genome1, Genome *p_genome2)
 {
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+	if (batch_fitness_recording_)
+	{
+		// Batched callbacks: note the mutation if an active callback applies to it, for UpdateFitness_BatchCallbacks() to pass to the callbacks later
+		slim_objectid_t mutation_type_id = (gSLiM_Mutation_Block + p_mutation)->mutation_type_ptr_->mutation_type_id_;
+		
+		for (SLiMEidosBlock *fitness_callback : p_fitness_callbacks)
+		{
+			if (fitness_callback->active_)
+			{
+				slim_objectid_t callback_mutation_type_id = fitness_callback->mutation_type_id_;
+				
+				if ((callback_mutation_type_id == -1) || (callback_mutation_type_id == mutation_type_id))
+				{
+					batch_individuals_.emplace_back(p_individual->index_);
+					batch_mutations_.emplace_back(p_mutation);
+					batch_homozygous_.emplace_back((int8_t)p_homozygous);
+					batch_rel_fitness_.emplace_back(p_computed_fitness);
+					
+					return 1.0;		// the callbacks' results are multiplied in later
+				}
+			}
+		}
+		
+		return p_computed_fitness;
+	}
+	
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_START();
 #endif
@@ -1050,6 +1420,24 @@ double Subpopulation::ApplyFitnessCallbacks(MutationIndex p_mutation, int p_homo
 					// the cached value is owned by the tree, so we do not dispose of it
 					// there is also no script output to handle
 				}
+				else if (fitness_callback->has_cached_optimization_)
+				{
+					// The callback has been compiled to C++ code; see SLiMSim::OptimizeScriptBlock()
+					if (fitness_callback->has_cached_opt_native_)
+					{
+						SLiMCallbackArguments args;
+						
+						args.relFitness_ = p_computed_fitness;
+						args.mut_ = gSLiM_Mutation_Block + p_mutation;
+						args.individual_ = p_individual;
+						
+						p_computed_fitness = fitness_callback->cached_opt_native_(args);
+					}
+					else
+					{
+						EIDOS_TERMINATION << "ERROR (Subpopulation::ApplyFitnessCallbacks): (internal error) cached optimization flag mismatch" << EidosTerminate(fitness_callback->identifier_token_);
+					}
+				}
 				else
 				{
 					// local variables for the callback parameters that we might need to allocate here, and thus need to free below
@@ -1127,7 +1515,7 @@ double Subpopulation::ApplyFitnessCallbacks(MutationIndex p_mutation, int p_homo
 		}
 	}
 	
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_END(population_.sim_.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosFitnessCallback)]);
 #endif
@@ -1138,7 +1526,7 @@ double Subpopulation::ApplyFitnessCallbacks(MutationIndex p_mutation, int p_homo
 // This calculates the effects of global fitness callbacks, i.e. those with muttype==NULL and which therefore do not reference any mutation
 double Subpopulation::ApplyGlobalFitnessCallbacks(std::vector<SLiMEidosBlock*> &p_fitness_callbacks, slim_popsize_t p_individual_index)
 {
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_START();
 #endif
@@ -1187,6 +1575,15 @@ double Subpopulation::ApplyGlobalFitnessCallbacks(std::vector<SLiMEidosBlock*> &
 					
 					computed_fitness *= (D + (gsl_ran_gaussian_pdf(individual->TagFloat() - A, B) / C));
 				}
+				else if (fitness_callback->has_cached_opt_native_)
+				{
+					SLiMCallbackArguments args;
+					
+					args.relFitness_ = 1.0;
+					args.individual_ = individual;
+					
+					computed_fitness *= fitness_callback->cached_opt_native_(args);
+				}
 				else
 				{
 					EIDOS_TERMINATION << "ERROR (Subpopulation::ApplyGlobalFitnessCallbacks): (internal error) cached optimization flag mismatch" << EidosTerminate(fitness_callback->identifier_token_);
@@ -1257,7 +1654,7 @@ double Subpopulation::ApplyGlobalFitnessCallbacks(std::vector<SLiMEidosBlock*> &
 		}
 	}
 	
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	SLIM_PROFILE_BLOCK_END(population_.sim_.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosFitnessGlobalCallback)]);
 #endif
@@ -1265,235 +1662,546 @@ double Subpopulation::ApplyGlobalFitnessCallbacks(std::vector<SLiMEidosBlock*> &
 	return computed_fitness;
 }
 
-// FitnessOfParentWithGenomeIndices has three versions, for no callbacks, a single callback, and multiple callbacks.  This is for two reasons.  First,
-// it allows the case without fitness() callbacks to run at full speed.  Second, the non-callback case short-circuits when the selection coefficient
-// is exactly 0.0f, as an optimization; but that optimization would be invalid in the callback case, since callbacks can change the relative fitness
-// of ostensibly neutral mutations.  For reasons of maintainability, the three versions should be kept in synch as closely as possible.
-//
-// When there is just a single callback, it usually refers to a mutation type that is relatively uncommon.  The model might have neutral mutations in most
-// cases, plus a rare (or unique) mutation type that is subject to more complex selection, for example.  We can optimize that very common case substantially
-// by making the callout to ApplyFitnessCallbacks() only for mutations of the mutation type that the callback modifies.  This pays off mostly when there
-// are many common mutations with no callback, plus one rare mutation type that has a callback.  A model of neutral drift across a long chromosome with a
-// high mutation rate, with an introduced beneficial mutation with a selection coefficient extremely close to 0, for example, would hit this case hard and
-// see a speedup of as much as 25%, so the additional complexity seems worth it (since that's quite a realistic and common case).
-
-// This version of FitnessOfParentWithGenomeIndices assumes no callbacks exist.  It tests for neutral mutations and skips processing them.
-//
-double Subpopulation::FitnessOfParentWithGenomeIndices_NoCallbacks(slim_popsize_t p_individual_index)
+// With batchFitnessCallbacks=T in initializeSLiMOptions(), fitness() callbacks are called once per generation with vectors, rather than once per
+// mutation per individual.  We first calculate fitness for every individual with ApplyFitnessCallbacks() in recording mode, which folds in the
+// effects of mutations not subject to callbacks and notes all the others as items.  Each active callback is then called once, in declaration
+// order, with all of the items it applies to; since a non-global fitness() callback is declared for a single mutation type, that is one call
+// per mutation type per callback.  As in the unbatched case, each callback receives the relFitness values produced by the callbacks before it.
+// Finally, the relFitness value of each item is multiplied into the fitness of its individual.
+void Subpopulation::UpdateFitness_BatchCallbacks(std::vector<SLiMEidosBlock*> &p_fitness_callbacks, bool p_single_callback, MutationType *p_single_callback_mut_type)
 {
-	// calculate the fitness of the individual constituted by genome1 and genome2 in the parent population
-	double w = 1.0;
-	
-#if SLIM_USE_NONNEUTRAL_CACHES
-	SLiMSim &sim = population_.sim_;
-	int32_t nonneutral_change_counter = sim.nonneutral_change_counter_;
-	int32_t nonneutral_regime = sim.last_nonneutral_regime_;
-#endif
+	batch_individuals_.clear();
+	batch_mutations_.clear();
+	batch_homozygous_.clear();
+	batch_rel_fitness_.clear();
+	batch_fitness_.resize(parent_subpop_size_);
 	
-	Mutation *mut_block_ptr = gSLiM_Mutation_Block;
-	Genome *genome1 = &(parent_genomes_[p_individual_index * 2]);
-	Genome *genome2 = &(parent_genomes_[p_individual_index * 2 + 1]);
-	bool genome1_null = genome1->IsNull();
-	bool genome2_null = genome2->IsNull();
+	batch_fitness_recording_ = true;
 	
-	if (genome1_null && genome2_null)
+	for (slim_popsize_t i = 0; i < parent_subpop_size_; i++)
 	{
-		// SEX ONLY: both genomes are placeholders; for example, we might be simulating the Y chromosome, and this is a female
-		return w;
+		if (p_single_callback)
+			batch_fitness_[i] = FitnessOfParentWithGenomeIndices_SingleCallback(i, p_fitness_callbacks, p_single_callback_mut_type);
+		else
+			batch_fitness_[i] = FitnessOfParentWithGenomeIndices_Callbacks(i, p_fitness_callbacks);
 	}
-	else if (genome1_null || genome2_null)
+	
+	batch_fitness_recording_ = false;
+	
+	// Call each callback with the items it applies to; a callback made inactive by an earlier callback is skipped, as it would be otherwise
+	size_t item_count = batch_mutations_.size();
+	std::vector<size_t> callback_items;
+	
+	for (SLiMEidosBlock *fitness_callback : p_fitness_callbacks)
 	{
-		// SEX ONLY: one genome is null, so we just need to scan through the modeled genome and account for its mutations, including the x-dominance coefficient
-		const Genome *genome = genome1_null ? genome2 : genome1;
-		const int32_t mutrun_count = genome->mutrun_count_;
-		
-		for (int run_index = 0; run_index < mutrun_count; ++run_index)
+		if (fitness_callback->active_)
 		{
-			MutationRun *mutrun = genome->mutruns_[run_index].get();
+			slim_objectid_t callback_mutation_type_id = fitness_callback->mutation_type_id_;
 			
-#if SLIM_USE_NONNEUTRAL_CACHES
-			// Cache non-neutral mutations and read from the non-neutral buffers
-			const MutationIndex *genome_iter, *genome_max;
+			callback_items.clear();
 			
-			mutrun->beginend_nonneutral_pointers(&genome_iter, &genome_max, nonneutral_change_counter, nonneutral_regime);
-#else
-			// Read directly from the MutationRun buffers
-			const MutationIndex *genome_iter = mutrun->begin_pointer_const();
-			const MutationIndex *genome_max = mutrun->end_pointer_const();
+			for (size_t item_index = 0; item_index < item_count; ++item_index)
+				if ((callback_mutation_type_id == -1) || ((gSLiM_Mutation_Block + batch_mutations_[item_index])->mutation_type_ptr_->mutation_type_id_ == callback_mutation_type_id))
+					callback_items.emplace_back(item_index);
+			
+			if (callback_items.size())
+				ApplyBatchFitnessCallback(fitness_callback, callback_items);
+		}
+	}
+	
+	// Fold the results into the fitness of each individual; as in FitnessOfParentWithGenomeIndices_Callbacks(), fitness stops at zero
+	for (size_t item_index = 0; item_index < item_count; ++item_index)
+	{
+		double &fitness = batch_fitness_[batch_individuals_[item_index]];
+		
+		if (fitness > 0.0)
+			fitness *= batch_rel_fitness_[item_index];
+	}
+	
+	for (slim_popsize_t i = 0; i < parent_subpop_size_; i++)
+		if (batch_fitness_[i] <= 0.0)
+			batch_fitness_[i] = 0.0;
+}
+
+// Call one fitness() callback with the given items, as vectors in the order of the items; the result replaces the items' relFitness values
+void Subpopulation::ApplyBatchFitnessCallback(SLiMEidosBlock *p_fitness_callback, const std::vector<size_t> &p_items)
+{
+#if (SLIMPROFILING == 1)
+	// PROFILING
+	SLIM_PROFILE_BLOCK_START();
 #endif
+	
+	SLiMSim &sim = population_.sim_;
+	size_t item_count = p_items.size();
+	const EidosASTNode *compound_statement_node = p_fitness_callback->compound_statement_node_;
+	
+	if (compound_statement_node->cached_value_)
+	{
+		// The script is a constant expression such as "{ return 1.1; }", so we can short-circuit it completely
+		EidosValue *result = compound_statement_node->cached_value_.get();
+		
+		if ((result->Type() != EidosValueType::kValueFloat) || (result->Count() != 1))
+			EIDOS_TERMINATION << "ERROR (Subpopulation::ApplyBatchFitnessCallback): fitness() callbacks must provide a float return value, either a singleton or one value per mutation." << EidosTerminate(p_fitness_callback->identifier_token_);
+		
+		double rel_fitness = result->FloatAtIndex(0, nullptr);
+		
+		for (size_t item_index : p_items)
+			batch_rel_fitness_[item_index] = rel_fitness;
+	}
+	else if (p_fitness_callback->has_cached_opt_native_)
+	{
+		// The callback has been compiled to C++ code (see SLiMSim::OptimizeScriptBlock()), so we just call it for each item
+		SLiMCallbackArguments args;
+		
+		for (size_t item_index : p_items)
+		{
+			args.relFitness_ = batch_rel_fitness_[item_index];
+			args.mut_ = gSLiM_Mutation_Block + batch_mutations_[item_index];
+			args.individual_ = &parent_individuals_[batch_individuals_[item_index]];
 			
-			if (genome->Type() == GenomeType::kXChromosome)
+			batch_rel_fitness_[item_index] = p_fitness_callback->cached_opt_native_(args);
+		}
+	}
+	else
+	{
+		// We need to actually execute the script; the symbol tables live until the end of this block
+		EidosSymbolTable callback_symbols(EidosSymbolTableType::kContextConstantsTable, &sim.SymbolTable());
+		EidosSymbolTable client_symbols(EidosSymbolTableType::kVariablesTable, &callback_symbols);
+		EidosFunctionMap &function_map = sim.FunctionMap();
+		EidosInterpreter interpreter(p_fitness_callback->compound_statement_node_, client_symbols, function_map, &sim);
+		
+		if (p_fitness_callback->contains_self_)
+			callback_symbols.InitializeConstantSymbolEntry(p_fitness_callback->SelfSymbolTableEntry());		// define "self"
+		
+		// Set up each parameter used by the callback as a vector with one element per item
+		if (p_fitness_callback->contains_mut_)
+		{
+			EidosValue_Object_vector *vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Object_vector(gSLiM_Mutation_Class))->resize_no_initialize(item_count);
+			
+			for (size_t value_index = 0; value_index < item_count; ++value_index)
+				vec->set_object_element_no_check(gSLiM_Mutation_Block + batch_mutations_[p_items[value_index]], value_index);
+			
+			callback_symbols.InitializeConstantSymbolEntry(gID_mut, EidosValue_SP(vec));
+		}
+		if (p_fitness_callback->contains_relFitness_)
+		{
+			EidosValue_Float_vector *vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Float_vector())->resize_no_initialize(item_count);
+			
+			for (size_t value_index = 0; value_index < item_count; ++value_index)
+				vec->set_float_no_check(batch_rel_fitness_[p_items[value_index]], value_index);
+			
+			callback_symbols.InitializeConstantSymbolEntry(gID_relFitness, EidosValue_SP(vec));
+		}
+		if (p_fitness_callback->contains_individual_)
+		{
+			EidosValue_Object_vector *vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Object_vector(gSLiM_Individual_Class))->resize_no_initialize(item_count);
+			
+			for (size_t value_index = 0; value_index < item_count; ++value_index)
+				vec->set_object_element_no_check(&parent_individuals_[batch_individuals_[p_items[value_index]]], value_index);
+			
+			callback_symbols.InitializeConstantSymbolEntry(gID_individual, EidosValue_SP(vec));
+		}
+		if (p_fitness_callback->contains_genome1_)
+		{
+			EidosValue_Object_vector *vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Object_vector(gSLiM_Genome_Class))->resize_no_initialize(item_count);
+			
+			for (size_t value_index = 0; value_index < item_count; ++value_index)
+				vec->set_object_element_no_check(&parent_genomes_[batch_individuals_[p_items[value_index]] * 2], value_index);
+			
+			callback_symbols.InitializeConstantSymbolEntry(gID_genome1, EidosValue_SP(vec));
+		}
+		if (p_fitness_callback->contains_genome2_)
+		{
+			EidosValue_Object_vector *vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Object_vector(gSLiM_Genome_Class))->resize_no_initialize(item_count);
+			
+			for (size_t value_index = 0; value_index < item_count; ++value_index)
+				vec->set_object_element_no_check(&parent_genomes_[batch_individuals_[p_items[value_index]] * 2 + 1], value_index);
+			
+			callback_symbols.InitializeConstantSymbolEntry(gID_genome2, EidosValue_SP(vec));
+		}
+		if (p_fitness_callback->contains_subpop_)
+			callback_symbols.InitializeConstantSymbolEntry(gID_subpop, SymbolTableEntry().second);
+		
+		// homozygous is T for homozygous mutations and F otherwise; a vector cannot contain NULL, so mutations opposed by a null genome are F
+		if (p_fitness_callback->contains_homozygous_)
+		{
+			EidosValue_Logical *vec = (new (gEidosValuePool->AllocateChunk()) EidosValue_Logical())->resize_no_initialize(item_count);
+			
+			for (size_t value_index = 0; value_index < item_count; ++value_index)
+				vec->set_logical_no_check(batch_homozygous_[p_items[value_index]] == 1, value_index);
+			
+			callback_symbols.InitializeConstantSymbolEntry(gID_homozygous, EidosValue_SP(vec));
+		}
+		
+		try
+		{
+			// Interpret the script; the result must be a float vector of new relative fitness values, or a singleton applying to all items
+			EidosValue_SP result_SP = interpreter.EvaluateInternalBlock(p_fitness_callback->script_);
+			EidosValue *result = result_SP.get();
+			int result_count = result->Count();
+			
+			if ((result->Type() != EidosValueType::kValueFloat) || ((result_count != 1) && ((size_t)result_count != item_count)))
+				EIDOS_TERMINATION << "ERROR (Subpopulation::ApplyBatchFitnessCallback): fitness() callbacks must provide a float return value, either a singleton or one value per mutation." << EidosTerminate(p_fitness_callback->identifier_token_);
+			
+			if (result_count == 1)
 			{
-				// with an unpaired X chromosome, we need to multiply each selection coefficient by the X chromosome dominance coefficient
-				// we don't cache this fitness effect because x_chromosome_dominance_coeff_ is not readily available to Mutation
-				while (genome_iter != genome_max)
-				{
-					slim_selcoeff_t selection_coeff = (mut_block_ptr + *genome_iter)->selection_coeff_;
-					
-					if (selection_coeff != 0.0F)
-					{
-						w *= (1.0 + x_chromosome_dominance_coeff_ * selection_coeff);
-						
-						if (w <= 0.0)
-							return 0.0;
-					}
-					
-					genome_iter++;
-				}
+				double rel_fitness = result->FloatAtIndex(0, nullptr);
+				
+				for (size_t item_index : p_items)
+					batch_rel_fitness_[item_index] = rel_fitness;
 			}
 			else
 			{
-				// with other types of unpaired chromosomes (like the Y chromosome of a male when we are modeling the Y) there is no dominance coefficient
-				while (genome_iter != genome_max)
-					w *= (mut_block_ptr + *genome_iter++)->cached_one_plus_sel_;
+				const double *result_data = result->FloatVector()->data();
+				
+				for (size_t value_index = 0; value_index < item_count; ++value_index)
+					batch_rel_fitness_[p_items[value_index]] = result_data[value_index];
 			}
+			
+			// Output generated by the interpreter goes to our output stream
+			SLIM_OUTSTREAM << interpreter.ExecutionOutput();
 		}
-		
-		return w;
-	}
-	else
-	{
-		// both genomes are being modeled, so we need to scan through and figure out which mutations are heterozygous and which are homozygous
-		const int32_t mutrun_count = genome1->mutrun_count_;
-		
-		for (int run_index = 0; run_index < mutrun_count; ++run_index)
+		catch (...)
 		{
-			MutationRun *mutrun1 = genome1->mutruns_[run_index].get();
-			MutationRun *mutrun2 = genome2->mutruns_[run_index].get();
+			// Emit final output even on a throw, so that stop() messages and such get printed
+			SLIM_OUTSTREAM << interpreter.ExecutionOutput();
 			
+			throw;
+		}
+	}
+	
+#if (SLIMPROFILING == 1)
+	// PROFILING
+	SLIM_PROFILE_BLOCK_END(population_.sim_.profile_callback_totals_[(int)(SLiMEidosBlockType::SLiMEidosFitnessCallback)]);
+#endif
+}
+
+// FitnessOfParentWithGenomeIndices has three versions, for no callbacks, a single callback, and multiple callbacks.  This is for two reasons.  First,
+// it allows the case without fitness() callbacks to run at full speed.  Second, the non-callback case short-circuits when the selection coefficient
+// is exactly 0.0f, as an optimization; but that optimization would be invalid in the callback case, since callbacks can change the relative fitness
+// of ostensibly neutral mutations.  For reasons of maintainability, the three versions should be kept in synch as closely as possible.
+//
+// When there is just a single callback, it usually refers to a mutation type that is relatively uncommon.  The model might have neutral mutations in most
+// cases, plus a rare (or unique) mutation type that is subject to more complex selection, for example.  We can optimize that very common case substantially
+// by making the callout to ApplyFitnessCallbacks() only for mutations of the mutation type that the callback modifies.  This pays off mostly when there
+// are many common mutations with no callback, plus one rare mutation type that has a callback.  A model of neutral drift across a long chromosome with a
+// high mutation rate, with an introduced beneficial mutation with a selection coefficient extremely close to 0, for example, would hit this case hard and
+// see a speedup of as much as 25%, so the additional complexity seems worth it (since that's quite a realistic and common case).
+
+// The fitness effect of one pair of mutation runs at the same position in the two genomes of an individual, with no callbacks; this scans through
+// the two runs in parallel to figure out which mutations are heterozygous and which are homozygous.  Pairs with enough non-neutral mutations are
+// memoized in p_memo; for short pairs the scan is cheaper than a hash table probe, so they are just recalculated.  A run paired with itself is
+// handled by FitnessOfHomozygousMutationRun_NoCallbacks() instead.
+double Subpopulation::FitnessOfMutationRunPair_NoCallbacks(MutationRun *p_mutrun1, MutationRun *p_mutrun2, MutationRunPairMemo &p_memo)
+{
+	// the same run in both genomes, so every mutation is homozygous; this gives the same result as the scan below, more quickly
+	if (p_mutrun1 == p_mutrun2)
+		return FitnessOfHomozygousMutationRun_NoCallbacks(p_mutrun1);
+	
+	double w = 1.0;
+	slim_position_t *position_block_ptr = gSLiM_Mutation_Positions;
+	slim_selcoeff_t *one_plus_sel_block_ptr = gSLiM_Mutation_OnePlusSel;
+	slim_selcoeff_t *one_plus_dom_sel_block_ptr = gSLiM_Mutation_OnePlusDomSel;
+	
 #if SLIM_USE_NONNEUTRAL_CACHES
-			// Cache non-neutral mutations and read from the non-neutral buffers
-			const MutationIndex *genome1_iter, *genome2_iter, *genome1_max, *genome2_max;
-			
-			mutrun1->beginend_nonneutral_pointers(&genome1_iter, &genome1_max, nonneutral_change_counter, nonneutral_regime);
-			mutrun2->beginend_nonneutral_pointers(&genome2_iter, &genome2_max, nonneutral_change_counter, nonneutral_regime);
+	// Cache non-neutral mutations and read from the non-neutral buffers
+	SLiMSim &sim = population_.sim_;
+	int32_t nonneutral_change_counter = sim.nonneutral_change_counter_;
+	int32_t nonneutral_regime = sim.last_nonneutral_regime_;
+	const MutationIndex *genome1_iter, *genome2_iter, *genome1_max, *genome2_max;
+	
+	p_mutrun1->beginend_nonneutral_pointers(&genome1_iter, &genome1_max, nonneutral_change_counter, nonneutral_regime);
+	p_mutrun2->beginend_nonneutral_pointers(&genome2_iter, &genome2_max, nonneutral_change_counter, nonneutral_regime);
 #else
-			// Read directly from the MutationRun buffers
-			const MutationIndex *genome1_iter = mutrun1->begin_pointer_const();
-			const MutationIndex *genome2_iter = mutrun2->begin_pointer_const();
-			
-			const MutationIndex *genome1_max = mutrun1->end_pointer_const();
-			const MutationIndex *genome2_max = mutrun2->end_pointer_const();
+	// Read directly from the MutationRun buffers
+	const MutationIndex *genome1_iter = p_mutrun1->begin_pointer_const();
+	const MutationIndex *genome2_iter = p_mutrun2->begin_pointer_const();
+	
+	const MutationIndex *genome1_max = p_mutrun1->end_pointer_const();
+	const MutationIndex *genome2_max = p_mutrun2->end_pointer_const();
 #endif
-			
-			// first, handle the situation before either genome iterator has reached the end of its genome, for simplicity/speed
-			if (genome1_iter != genome1_max && genome2_iter != genome2_max)
+	
+	bool memoize = (p_memo.Enabled() && ((genome1_max - genome1_iter) + (genome2_max - genome2_iter) >= SLIM_FITNESS_MEMO_MIN_MUTATIONS));
+	
+	if (memoize && p_memo.Lookup(p_mutrun1, p_mutrun2, &w))
+		return w;
+	
+	// first, handle the situation before either genome iterator has reached the end of its genome, for simplicity/speed
+	if (genome1_iter != genome1_max && genome2_iter != genome2_max)
+	{
+		MutationIndex genome1_mutation = *genome1_iter, genome2_mutation = *genome2_iter;
+		slim_position_t genome1_iter_position = position_block_ptr[genome1_mutation], genome2_iter_position = position_block_ptr[genome2_mutation];
+		
+		do
+		{
+			if (genome1_iter_position < genome2_iter_position)
 			{
-				MutationIndex genome1_mutation = *genome1_iter, genome2_mutation = *genome2_iter;
-				slim_position_t genome1_iter_position = (mut_block_ptr + genome1_mutation)->position_, genome2_iter_position = (mut_block_ptr + genome2_mutation)->position_;
+				// Process the mutations in genome1 that lead genome2; they are all heterozygous
+				const MutationIndex *genome1_stop = SLiM_FirstMutationAtOrAfter(genome1_iter + 1, genome1_max, genome2_iter_position);
+				
+				while (genome1_iter != genome1_stop)
+					w *= one_plus_dom_sel_block_ptr[*genome1_iter++];
 				
+				if (genome1_iter == genome1_max)
+					break;
+				else {
+					genome1_mutation = *genome1_iter;
+					genome1_iter_position = position_block_ptr[genome1_mutation];
+				}
+			}
+			else if (genome1_iter_position > genome2_iter_position)
+			{
+				// Process the mutations in genome2 that lead genome1; they are all heterozygous
+				const MutationIndex *genome2_stop = SLiM_FirstMutationAtOrAfter(genome2_iter + 1, genome2_max, genome1_iter_position);
+				
+				while (genome2_iter != genome2_stop)
+					w *= one_plus_dom_sel_block_ptr[*genome2_iter++];
+				
+				if (genome2_iter == genome2_max)
+					break;
+				else {
+					genome2_mutation = *genome2_iter;
+					genome2_iter_position = position_block_ptr[genome2_mutation];
+				}
+			}
+			else
+			{
+				// Look for homozygosity: genome1_iter_position == genome2_iter_position
+				slim_position_t position = genome1_iter_position;
+				const MutationIndex *genome1_start = genome1_iter;
+				
+				// advance through genome1 as long as we remain at the same position, handling one mutation at a time
 				do
 				{
-					if (genome1_iter_position < genome2_iter_position)
+					const MutationIndex *genome2_matchscan = genome2_iter; 
+					
+					// advance through genome2 with genome2_matchscan, looking for a match for the current mutation in genome1, to determine whether we are homozygous or not
+					while (genome2_matchscan != genome2_max && position_block_ptr[*genome2_matchscan] == position)
 					{
-						// Process a mutation in genome1 since it is leading
-						w *= (mut_block_ptr + genome1_mutation)->cached_one_plus_dom_sel_;
-						
-						if (++genome1_iter == genome1_max)
-							break;
-						else {
-							genome1_mutation = *genome1_iter;
-							genome1_iter_position = (mut_block_ptr + genome1_mutation)->position_;
+						if (genome1_mutation == *genome2_matchscan) 		// note pointer equality test
+						{
+							// a match was found, so we multiply our fitness by the full selection coefficient
+							w *= one_plus_sel_block_ptr[genome1_mutation];
+							goto homozygousExit1;
 						}
-					}
-					else if (genome1_iter_position > genome2_iter_position)
-					{
-						// Process a mutation in genome2 since it is leading
-						w *= (mut_block_ptr + genome2_mutation)->cached_one_plus_dom_sel_;
 						
-						if (++genome2_iter == genome2_max)
-							break;
-						else {
-							genome2_mutation = *genome2_iter;
-							genome2_iter_position = (mut_block_ptr + genome2_mutation)->position_;
-						}
+						genome2_matchscan++;
 					}
-					else
+					
+					// no match was found, so we are heterozygous; we multiply our fitness by the selection coefficient and the dominance coefficient
+					w *= one_plus_dom_sel_block_ptr[genome1_mutation];
+				
+				homozygousExit1:
+					
+					if (++genome1_iter == genome1_max)
+						break;
+					else {
+						genome1_mutation = *genome1_iter;
+						genome1_iter_position = position_block_ptr[genome1_mutation];
+					}
+				} while (genome1_iter_position == position);
+				
+				// advance through genome2 as long as we remain at the same position, handling one mutation at a time
+				do
+				{
+					const MutationIndex *genome1_matchscan = genome1_start; 
+					
+					// advance through genome1 with genome1_matchscan, looking for a match for the current mutation in genome2, to determine whether we are homozygous or not
+					while (genome1_matchscan != genome1_max && position_block_ptr[*genome1_matchscan] == position)
 					{
-						// Look for homozygosity: genome1_iter_position == genome2_iter_position
-						slim_position_t position = genome1_iter_position;
-						const MutationIndex *genome1_start = genome1_iter;
-						
-						// advance through genome1 as long as we remain at the same position, handling one mutation at a time
-						do
-						{
-							const MutationIndex *genome2_matchscan = genome2_iter; 
-							
-							// advance through genome2 with genome2_matchscan, looking for a match for the current mutation in genome1, to determine whether we are homozygous or not
-							while (genome2_matchscan != genome2_max && (mut_block_ptr + *genome2_matchscan)->position_ == position)
-							{
-								if (genome1_mutation == *genome2_matchscan) 		// note pointer equality test
-								{
-									// a match was found, so we multiply our fitness by the full selection coefficient
-									w *= (mut_block_ptr + genome1_mutation)->cached_one_plus_sel_;
-									goto homozygousExit1;
-								}
-								
-								genome2_matchscan++;
-							}
-							
-							// no match was found, so we are heterozygous; we multiply our fitness by the selection coefficient and the dominance coefficient
-							w *= (mut_block_ptr + genome1_mutation)->cached_one_plus_dom_sel_;
-							
-						homozygousExit1:
-							
-							if (++genome1_iter == genome1_max)
-								break;
-							else {
-								genome1_mutation = *genome1_iter;
-								genome1_iter_position = (mut_block_ptr + genome1_mutation)->position_;
-							}
-						} while (genome1_iter_position == position);
-						
-						// advance through genome2 as long as we remain at the same position, handling one mutation at a time
-						do
+						if (genome2_mutation == *genome1_matchscan)		// note pointer equality test
 						{
-							const MutationIndex *genome1_matchscan = genome1_start; 
-							
-							// advance through genome1 with genome1_matchscan, looking for a match for the current mutation in genome2, to determine whether we are homozygous or not
-							while (genome1_matchscan != genome1_max && (mut_block_ptr + *genome1_matchscan)->position_ == position)
-							{
-								if (genome2_mutation == *genome1_matchscan)		// note pointer equality test
-								{
-									// a match was found; we know this match was already found by the genome1 loop above, so our fitness has already been multiplied appropriately
-									goto homozygousExit2;
-								}
-								
-								genome1_matchscan++;
-							}
-							
-							// no match was found, so we are heterozygous; we multiply our fitness by the selection coefficient and the dominance coefficient
-							w *= (mut_block_ptr + genome2_mutation)->cached_one_plus_dom_sel_;
-							
-						homozygousExit2:
-							
-							if (++genome2_iter == genome2_max)
-								break;
-							else {
-								genome2_mutation = *genome2_iter;
-								genome2_iter_position = (mut_block_ptr + genome2_mutation)->position_;
-							}
-						} while (genome2_iter_position == position);
+							// a match was found; we know this match was already found by the genome1 loop above, so our fitness has already been multiplied appropriately
+							goto homozygousExit2;
+						}
 						
-						// break out if either genome has reached its end
-						if (genome1_iter == genome1_max || genome2_iter == genome2_max)
-							break;
+						genome1_matchscan++;
 					}
-				} while (true);
+					
+					// no match was found, so we are heterozygous; we multiply our fitness by the selection coefficient and the dominance coefficient
+					w *= one_plus_dom_sel_block_ptr[genome2_mutation];
+				
+				homozygousExit2:
+					
+					if (++genome2_iter == genome2_max)
+						break;
+					else {
+						genome2_mutation = *genome2_iter;
+						genome2_iter_position = position_block_ptr[genome2_mutation];
+					}
+				} while (genome2_iter_position == position);
+				
+				// break out if either genome has reached its end
+				if (genome1_iter == genome1_max || genome2_iter == genome2_max)
+					break;
 			}
-			
-			// one or the other genome has now reached its end, so now we just need to handle the remaining mutations in the unfinished genome
+		} while (true);
+	}
+	
+	// one or the other genome has now reached its end, so now we just need to handle the remaining mutations in the unfinished genome
 #ifdef DEBUG
-			assert(!(genome1_iter != genome1_max && genome2_iter != genome2_max));
+	assert(!(genome1_iter != genome1_max && genome2_iter != genome2_max));
 #endif
+	
+	// if genome1 is unfinished, finish it
+	while (genome1_iter != genome1_max)
+		w *= one_plus_dom_sel_block_ptr[*genome1_iter++];
+	
+	// if genome2 is unfinished, finish it
+	while (genome2_iter != genome2_max)
+		w *= one_plus_dom_sel_block_ptr[*genome2_iter++];
+	
+	if (memoize)
+		p_memo.Insert(p_mutrun1, p_mutrun2, w);
+	
+	return w;
+}
+
+// The fitness effect of a mutation run paired with itself, so that all of its mutations are homozygous, with no callbacks.  A run paired with
+// itself usually recurs so in many individuals, so with non-neutral caches the product is kept in the run (see MutationRun::homozygous_fitness_)
+// until its cache is next revalidated; ValidateParentalNonneutralCaches() calculates it beforehand when fitness is calculated in parallel.
+double Subpopulation::FitnessOfHomozygousMutationRun_NoCallbacks(MutationRun *p_mutrun)
+{
+	slim_selcoeff_t *one_plus_sel_block_ptr = gSLiM_Mutation_OnePlusSel;
+	
+#if SLIM_USE_NONNEUTRAL_CACHES
+	// Cache non-neutral mutations and read from the non-neutral buffers
+	SLiMSim &sim = population_.sim_;
+	const MutationIndex *genome_iter, *genome_max;
+	
+	p_mutrun->beginend_nonneutral_pointers(&genome_iter, &genome_max, sim.nonneutral_change_counter_, sim.last_nonneutral_regime_);
+	
+	double w = p_mutrun->cached_homozygous_fitness();
+	
+	if (w >= 0.0)
+		return w;
+	
+	w = 1.0;
+#else
+	// Read directly from the MutationRun buffers
+	const MutationIndex *genome_iter = p_mutrun->begin_pointer_const();
+	const MutationIndex *genome_max = p_mutrun->end_pointer_const();
+	double w = 1.0;
+#endif
+	
+	while (genome_iter != genome_max)
+		w *= one_plus_sel_block_ptr[*genome_iter++];
+	
+#if SLIM_USE_NONNEUTRAL_CACHES
+	p_mutrun->set_cached_homozygous_fitness(w);
+#endif
+	
+	return w;
+}
+
+// The fitness effect of a mutation run with no partner, in the modeled chromosome of an individual whose other genome is null, with no callbacks;
+// it is kept in the run in the same way as the homozygous product above.  An X chromosome stops early if its fitness reaches zero.
+double Subpopulation::FitnessOfUnpairedMutationRun_NoCallbacks(MutationRun *p_mutrun, GenomeType p_genome_type)
+{
+	Mutation *mut_block_ptr = gSLiM_Mutation_Block;
+	slim_selcoeff_t *one_plus_sel_block_ptr = gSLiM_Mutation_OnePlusSel;
+
+#if SLIM_USE_NONNEUTRAL_CACHES
+	// Cache non-neutral mutations and read from the non-neutral buffers
+	SLiMSim &sim = population_.sim_;
+	const MutationIndex *genome_iter, *genome_max;
+	
+	p_mutrun->beginend_nonneutral_pointers(&genome_iter, &genome_max, sim.nonneutral_change_counter_, sim.last_nonneutral_regime_);
+	
+	double w = p_mutrun->cached_unpaired_fitness(x_chromosome_dominance_coeff_);
+	
+	if (w >= 0.0)
+		return w;
+	
+	w = 1.0;
+#else
+	// Read directly from the MutationRun buffers
+	const MutationIndex *genome_iter = p_mutrun->begin_pointer_const();
+	const MutationIndex *genome_max = p_mutrun->end_pointer_const();
+	double w = 1.0;
+#endif
+	
+	if (p_genome_type == GenomeType::kXChromosome)
+	{
+		// with an unpaired X chromosome, we need to multiply each selection coefficient by the X chromosome dominance coefficient
+		// we don't cache this fitness effect in Mutation because x_chromosome_dominance_coeff_ is not readily available to Mutation
+		while (genome_iter != genome_max)
+		{
+			slim_selcoeff_t selection_coeff = (mut_block_ptr + *genome_iter)->selection_coeff_;
 			
-			// if genome1 is unfinished, finish it
-			while (genome1_iter != genome1_max)
-				w *= (mut_block_ptr + *genome1_iter++)->cached_one_plus_dom_sel_;
+			if (selection_coeff != 0.0F)
+			{
+				w *= (1.0 + x_chromosome_dominance_coeff_ * selection_coeff);
+				
+				if (w <= 0.0)
+				{
+					w = 0.0;
+					break;
+				}
+			}
 			
-			// if genome2 is unfinished, finish it
-			while (genome2_iter != genome2_max)
-				w *= (mut_block_ptr + *genome2_iter++)->cached_one_plus_dom_sel_;
+			genome_iter++;
+		}
+	}
+	else
+	{
+		// with other types of unpaired chromosomes (like the Y chromosome of a male when we are modeling the Y) there is no dominance coefficient
+		while (genome_iter != genome_max)
+			w *= one_plus_sel_block_ptr[*genome_iter++];
+	}
+	
+#if SLIM_USE_NONNEUTRAL_CACHES
+	p_mutrun->set_cached_unpaired_fitness(w, x_chromosome_dominance_coeff_);
+#endif
+	
+	return w;
+}
+
+// This version of FitnessOfParentWithGenomeIndices assumes no callbacks exist.  It tests for neutral mutations and skips processing them.
+//
+// Mutation runs are shared among many genomes, so the same pairing of runs recurs in many individuals, particularly with low recombination.  The
+// fitness effect of each distinct pairing is therefore calculated once, and kept in p_memo (see MutationRunPairMemo) for the rest of the fitness
+// update, unless the pairing is short enough that recalculating it is cheaper.  The fitness of an individual is the product of the effects of its
+// run pairings.
+double Subpopulation::FitnessOfParentWithGenomeIndices_NoCallbacks(slim_popsize_t p_individual_index, MutationRunPairMemo &p_memo)
+{
+	// calculate the fitness of the individual constituted by genome1 and genome2 in the parent population
+	double w = 1.0;
+	
+	Genome *genome1 = &(parent_genomes_[p_individual_index * 2]);
+	Genome *genome2 = &(parent_genomes_[p_individual_index * 2 + 1]);
+	bool genome1_null = genome1->IsNull();
+	bool genome2_null = genome2->IsNull();
+	
+	if (genome1_null && genome2_null)
+	{
+		// SEX ONLY: both genomes are placeholders; for example, we might be simulating the Y chromosome, and this is a female
+		return w;
+	}
+	else if (genome1_null || genome2_null)
+	{
+		// SEX ONLY: one genome is null, so we just need to account for the mutations in the modeled genome, including the x-dominance coefficient
+		const Genome *genome = genome1_null ? genome2 : genome1;
+		const int32_t mutrun_count = genome->mutrun_count_;
+		
+		for (int run_index = 0; run_index < mutrun_count; ++run_index)
+		{
+			w *= FitnessOfUnpairedMutationRun_NoCallbacks(genome->mutruns_[run_index].get(), genome->Type());
+			
+			if (w <= 0.0)
+				return 0.0;
+		}
+		
+		return w;
+	}
+	else
+	{
+		// both genomes are being modeled, so we need the effect of each pair of runs
+		const int32_t mutrun_count = genome1->mutrun_count_;
+		
+		for (int run_index = 0; run_index < mutrun_count; ++run_index)
+		{
+			w *= FitnessOfMutationRunPair_NoCallbacks(genome1->mutruns_[run_index].get(), genome2->mutruns_[run_index].get(), p_memo);
 		}
 		
 		return w;
@@ -1514,6 +2222,9 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 #endif
 	
 	Mutation *mut_block_ptr = gSLiM_Mutation_Block;
+	slim_position_t *position_block_ptr = gSLiM_Mutation_Positions;
+	slim_selcoeff_t *one_plus_sel_block_ptr = gSLiM_Mutation_OnePlusSel;
+	slim_selcoeff_t *one_plus_dom_sel_block_ptr = gSLiM_Mutation_OnePlusDomSel;
 	Individual *individual = &(parent_individuals_[p_individual_index]);
 	Genome *genome1 = &(parent_genomes_[p_individual_index * 2]);
 	Genome *genome2 = &(parent_genomes_[p_individual_index * 2 + 1]);
@@ -1570,7 +2281,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 				{
 					MutationIndex genome_mutation = *genome_iter;
 					
-					w *= ApplyFitnessCallbacks(genome_mutation, -1, (mut_block_ptr + genome_mutation)->cached_one_plus_sel_, p_fitness_callbacks, individual, genome1, genome2);
+					w *= ApplyFitnessCallbacks(genome_mutation, -1, one_plus_sel_block_ptr[genome_mutation], p_fitness_callbacks, individual, genome1, genome2);
 					
 					if (w <= 0.0)
 						return 0.0;
@@ -1611,14 +2322,14 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 			if (genome1_iter != genome1_max && genome2_iter != genome2_max)
 			{
 				MutationIndex genome1_mutation = *genome1_iter, genome2_mutation = *genome2_iter;
-				slim_position_t genome1_iter_position = (mut_block_ptr + genome1_mutation)->position_, genome2_iter_position = (mut_block_ptr + genome2_mutation)->position_;
+				slim_position_t genome1_iter_position = position_block_ptr[genome1_mutation], genome2_iter_position = position_block_ptr[genome2_mutation];
 				
 				do
 				{
 					if (genome1_iter_position < genome2_iter_position)
 					{
 						// Process a mutation in genome1 since it is leading
-						w *= ApplyFitnessCallbacks(genome1_mutation, false, (mut_block_ptr + genome1_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+						w *= ApplyFitnessCallbacks(genome1_mutation, false, one_plus_dom_sel_block_ptr[genome1_mutation], p_fitness_callbacks, individual, genome1, genome2);
 						
 						if (w <= 0.0)
 							return 0.0;
@@ -1627,13 +2338,13 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 							break;
 						else {
 							genome1_mutation = *genome1_iter;
-							genome1_iter_position = (mut_block_ptr + genome1_mutation)->position_;
+							genome1_iter_position = position_block_ptr[genome1_mutation];
 						}
 					}
 					else if (genome1_iter_position > genome2_iter_position)
 					{
 						// Process a mutation in genome2 since it is leading
-						w *= ApplyFitnessCallbacks(genome2_mutation, false, (mut_block_ptr + genome2_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+						w *= ApplyFitnessCallbacks(genome2_mutation, false, one_plus_dom_sel_block_ptr[genome2_mutation], p_fitness_callbacks, individual, genome1, genome2);
 						
 						if (w <= 0.0)
 							return 0.0;
@@ -1642,7 +2353,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 							break;
 						else {
 							genome2_mutation = *genome2_iter;
-							genome2_iter_position = (mut_block_ptr + genome2_mutation)->position_;
+							genome2_iter_position = position_block_ptr[genome2_mutation];
 						}
 					}
 					else
@@ -1657,12 +2368,12 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 							const MutationIndex *genome2_matchscan = genome2_iter; 
 							
 							// advance through genome2 with genome2_matchscan, looking for a match for the current mutation in genome1, to determine whether we are homozygous or not
-							while (genome2_matchscan != genome2_max && (mut_block_ptr + *genome2_matchscan)->position_ == position)
+							while (genome2_matchscan != genome2_max && position_block_ptr[*genome2_matchscan] == position)
 							{
 								if (genome1_mutation == *genome2_matchscan)		// note pointer equality test
 								{
 									// a match was found, so we multiply our fitness by the full selection coefficient
-									w *= ApplyFitnessCallbacks(genome1_mutation, true, (mut_block_ptr + genome1_mutation)->cached_one_plus_sel_, p_fitness_callbacks, individual, genome1, genome2);
+									w *= ApplyFitnessCallbacks(genome1_mutation, true, one_plus_sel_block_ptr[genome1_mutation], p_fitness_callbacks, individual, genome1, genome2);
 									
 									goto homozygousExit3;
 								}
@@ -1671,7 +2382,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 							}
 							
 							// no match was found, so we are heterozygous; we multiply our fitness by the selection coefficient and the dominance coefficient
-							w *= ApplyFitnessCallbacks(genome1_mutation, false, (mut_block_ptr + genome1_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+							w *= ApplyFitnessCallbacks(genome1_mutation, false, one_plus_dom_sel_block_ptr[genome1_mutation], p_fitness_callbacks, individual, genome1, genome2);
 							
 						homozygousExit3:
 							
@@ -1682,7 +2393,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 								break;
 							else {
 								genome1_mutation = *genome1_iter;
-								genome1_iter_position = (mut_block_ptr + genome1_mutation)->position_;
+								genome1_iter_position = position_block_ptr[genome1_mutation];
 							}
 						} while (genome1_iter_position == position);
 						
@@ -1692,7 +2403,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 							const MutationIndex *genome1_matchscan = genome1_start; 
 							
 							// advance through genome1 with genome1_matchscan, looking for a match for the current mutation in genome2, to determine whether we are homozygous or not
-							while (genome1_matchscan != genome1_max && (mut_block_ptr + *genome1_matchscan)->position_ == position)
+							while (genome1_matchscan != genome1_max && position_block_ptr[*genome1_matchscan] == position)
 							{
 								if (genome2_mutation == *genome1_matchscan)		// note pointer equality test
 								{
@@ -1704,7 +2415,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 							}
 							
 							// no match was found, so we are heterozygous; we multiply our fitness by the selection coefficient and the dominance coefficient
-							w *= ApplyFitnessCallbacks(genome2_mutation, false, (mut_block_ptr + genome2_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+							w *= ApplyFitnessCallbacks(genome2_mutation, false, one_plus_dom_sel_block_ptr[genome2_mutation], p_fitness_callbacks, individual, genome1, genome2);
 							
 							if (w <= 0.0)
 								return 0.0;
@@ -1715,7 +2426,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 								break;
 							else {
 								genome2_mutation = *genome2_iter;
-								genome2_iter_position = (mut_block_ptr + genome2_mutation)->position_;
+								genome2_iter_position = position_block_ptr[genome2_mutation];
 							}
 						} while (genome2_iter_position == position);
 						
@@ -1734,7 +2445,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 			{
 				MutationIndex genome1_mutation = *genome1_iter;
 				
-				w *= ApplyFitnessCallbacks(genome1_mutation, false, (mut_block_ptr + genome1_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+				w *= ApplyFitnessCallbacks(genome1_mutation, false, one_plus_dom_sel_block_ptr[genome1_mutation], p_fitness_callbacks, individual, genome1, genome2);
 				
 				if (w <= 0.0)
 					return 0.0;
@@ -1747,7 +2458,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t
 			{
 				MutationIndex genome2_mutation = *genome2_iter;
 				
-				w *= ApplyFitnessCallbacks(genome2_mutation, false, (mut_block_ptr + genome2_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+				w *= ApplyFitnessCallbacks(genome2_mutation, false, one_plus_dom_sel_block_ptr[genome2_mutation], p_fitness_callbacks, individual, genome1, genome2);
 				
 				if (w <= 0.0)
 					return 0.0;
@@ -1774,6 +2485,10 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 #endif
 	
 	Mutation *mut_block_ptr = gSLiM_Mutation_Block;
+	slim_position_t *position_block_ptr = gSLiM_Mutation_Positions;
+	MutationType **muttype_block_ptr = gSLiM_Mutation_Types;
+	slim_selcoeff_t *one_plus_sel_block_ptr = gSLiM_Mutation_OnePlusSel;
+	slim_selcoeff_t *one_plus_dom_sel_block_ptr = gSLiM_Mutation_OnePlusDomSel;
 	Individual *individual = &(parent_individuals_[p_individual_index]);
 	Genome *genome1 = &(parent_genomes_[p_individual_index * 2]);
 	Genome *genome2 = &(parent_genomes_[p_individual_index * 2 + 1]);
@@ -1815,7 +2530,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 					MutationIndex genome_mutation = *genome_iter;
 					slim_selcoeff_t selection_coeff = (mut_block_ptr + genome_mutation)->selection_coeff_;
 					
-					if ((mut_block_ptr + genome_mutation)->mutation_type_ptr_ == p_single_callback_mut_type)
+					if (muttype_block_ptr[genome_mutation] == p_single_callback_mut_type)
 					{
 						w *= ApplyFitnessCallbacks(genome_mutation, -1, 1.0 + x_chromosome_dominance_coeff_ * selection_coeff, p_fitness_callbacks, individual, genome1, genome2);
 						
@@ -1843,16 +2558,16 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 				{
 					MutationIndex genome_mutation = *genome_iter;
 					
-					if ((mut_block_ptr + genome_mutation)->mutation_type_ptr_ == p_single_callback_mut_type)
+					if (muttype_block_ptr[genome_mutation] == p_single_callback_mut_type)
 					{
-						w *= ApplyFitnessCallbacks(genome_mutation, -1, (mut_block_ptr + genome_mutation)->cached_one_plus_sel_, p_fitness_callbacks, individual, genome1, genome2);
+						w *= ApplyFitnessCallbacks(genome_mutation, -1, one_plus_sel_block_ptr[genome_mutation], p_fitness_callbacks, individual, genome1, genome2);
 						
 						if (w <= 0.0)
 							return 0.0;
 					}
 					else
 					{
-						w *= (mut_block_ptr + genome_mutation)->cached_one_plus_sel_;
+						w *= one_plus_sel_block_ptr[genome_mutation];
 					}
 					
 					genome_iter++;
@@ -1891,56 +2606,56 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 			if (genome1_iter != genome1_max && genome2_iter != genome2_max)
 			{
 				MutationIndex genome1_mutation = *genome1_iter, genome2_mutation = *genome2_iter;
-				slim_position_t genome1_iter_position = (mut_block_ptr + genome1_mutation)->position_, genome2_iter_position = (mut_block_ptr + genome2_mutation)->position_;
+				slim_position_t genome1_iter_position = position_block_ptr[genome1_mutation], genome2_iter_position = position_block_ptr[genome2_mutation];
 				
 				do
 				{
 					if (genome1_iter_position < genome2_iter_position)
 					{
 						// Process a mutation in genome1 since it is leading
-						MutationType *genome1_muttype = (mut_block_ptr + genome1_mutation)->mutation_type_ptr_;
+						MutationType *genome1_muttype = muttype_block_ptr[genome1_mutation];
 						
 						if (genome1_muttype == p_single_callback_mut_type)
 						{
-							w *= ApplyFitnessCallbacks(genome1_mutation, false, (mut_block_ptr + genome1_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+							w *= ApplyFitnessCallbacks(genome1_mutation, false, one_plus_dom_sel_block_ptr[genome1_mutation], p_fitness_callbacks, individual, genome1, genome2);
 							
 							if (w <= 0.0)
 								return 0.0;
 						}
 						else
 						{
-							w *= (mut_block_ptr + genome1_mutation)->cached_one_plus_dom_sel_;
+							w *= one_plus_dom_sel_block_ptr[genome1_mutation];
 						}
 						
 						if (++genome1_iter == genome1_max)
 							break;
 						else {
 							genome1_mutation = *genome1_iter;
-							genome1_iter_position = (mut_block_ptr + genome1_mutation)->position_;
+							genome1_iter_position = position_block_ptr[genome1_mutation];
 						}
 					}
 					else if (genome1_iter_position > genome2_iter_position)
 					{
 						// Process a mutation in genome2 since it is leading
-						MutationType *genome2_muttype = (mut_block_ptr + genome2_mutation)->mutation_type_ptr_;
+						MutationType *genome2_muttype = muttype_block_ptr[genome2_mutation];
 						
 						if (genome2_muttype == p_single_callback_mut_type)
 						{
-							w *= ApplyFitnessCallbacks(genome2_mutation, false, (mut_block_ptr + genome2_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+							w *= ApplyFitnessCallbacks(genome2_mutation, false, one_plus_dom_sel_block_ptr[genome2_mutation], p_fitness_callbacks, individual, genome1, genome2);
 							
 							if (w <= 0.0)
 								return 0.0;
 						}
 						else
 						{
-							w *= (mut_block_ptr + genome2_mutation)->cached_one_plus_dom_sel_;
+							w *= one_plus_dom_sel_block_ptr[genome2_mutation];
 						}
 						
 						if (++genome2_iter == genome2_max)
 							break;
 						else {
 							genome2_mutation = *genome2_iter;
-							genome2_iter_position = (mut_block_ptr + genome2_mutation)->position_;
+							genome2_iter_position = position_block_ptr[genome2_mutation];
 						}
 					}
 					else
@@ -1952,19 +2667,19 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 						// advance through genome1 as long as we remain at the same position, handling one mutation at a time
 						do
 						{
-							MutationType *genome1_muttype = (mut_block_ptr + genome1_mutation)->mutation_type_ptr_;
+							MutationType *genome1_muttype = muttype_block_ptr[genome1_mutation];
 							
 							if (genome1_muttype == p_single_callback_mut_type)
 							{
 								const MutationIndex *genome2_matchscan = genome2_iter; 
 								
 								// advance through genome2 with genome2_matchscan, looking for a match for the current mutation in genome1, to determine whether we are homozygous or not
-								while (genome2_matchscan != genome2_max && (mut_block_ptr + *genome2_matchscan)->position_ == position)
+								while (genome2_matchscan != genome2_max && position_block_ptr[*genome2_matchscan] == position)
 								{
 									if (genome1_mutation == *genome2_matchscan)		// note pointer equality test
 									{
 										// a match was found, so we multiply our fitness by the full selection coefficient
-										w *= ApplyFitnessCallbacks(genome1_mutation, true, (mut_block_ptr + genome1_mutation)->cached_one_plus_sel_, p_fitness_callbacks, individual, genome1, genome2);
+										w *= ApplyFitnessCallbacks(genome1_mutation, true, one_plus_sel_block_ptr[genome1_mutation], p_fitness_callbacks, individual, genome1, genome2);
 										
 										goto homozygousExit5;
 									}
@@ -1973,7 +2688,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 								}
 								
 								// no match was found, so we are heterozygous; we multiply our fitness by the selection coefficient and the dominance coefficient
-								w *= ApplyFitnessCallbacks(genome1_mutation, false, (mut_block_ptr + genome1_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+								w *= ApplyFitnessCallbacks(genome1_mutation, false, one_plus_dom_sel_block_ptr[genome1_mutation], p_fitness_callbacks, individual, genome1, genome2);
 								
 							homozygousExit5:
 								
@@ -1985,12 +2700,12 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 								const MutationIndex *genome2_matchscan = genome2_iter; 
 								
 								// advance through genome2 with genome2_matchscan, looking for a match for the current mutation in genome1, to determine whether we are homozygous or not
-								while (genome2_matchscan != genome2_max && (mut_block_ptr + *genome2_matchscan)->position_ == position)
+								while (genome2_matchscan != genome2_max && position_block_ptr[*genome2_matchscan] == position)
 								{
 									if (genome1_mutation == *genome2_matchscan) 		// note pointer equality test
 									{
 										// a match was found, so we multiply our fitness by the full selection coefficient
-										w *= (mut_block_ptr + genome1_mutation)->cached_one_plus_sel_;
+										w *= one_plus_sel_block_ptr[genome1_mutation];
 										goto homozygousExit6;
 									}
 									
@@ -1998,7 +2713,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 								}
 								
 								// no match was found, so we are heterozygous; we multiply our fitness by the selection coefficient and the dominance coefficient
-								w *= (mut_block_ptr + genome1_mutation)->cached_one_plus_dom_sel_;
+								w *= one_plus_dom_sel_block_ptr[genome1_mutation];
 								
 							homozygousExit6:
 								;
@@ -2008,21 +2723,21 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 								break;
 							else {
 								genome1_mutation = *genome1_iter;
-								genome1_iter_position = (mut_block_ptr + genome1_mutation)->position_;
+								genome1_iter_position = position_block_ptr[genome1_mutation];
 							}
 						} while (genome1_iter_position == position);
 						
 						// advance through genome2 as long as we remain at the same position, handling one mutation at a time
 						do
 						{
-							MutationType *genome2_muttype = (mut_block_ptr + genome2_mutation)->mutation_type_ptr_;
+							MutationType *genome2_muttype = muttype_block_ptr[genome2_mutation];
 							
 							if (genome2_muttype == p_single_callback_mut_type)
 							{
 								const MutationIndex *genome1_matchscan = genome1_start; 
 								
 								// advance through genome1 with genome1_matchscan, looking for a match for the current mutation in genome2, to determine whether we are homozygous or not
-								while (genome1_matchscan != genome1_max && (mut_block_ptr + *genome1_matchscan)->position_ == position)
+								while (genome1_matchscan != genome1_max && position_block_ptr[*genome1_matchscan] == position)
 								{
 									if (genome2_mutation == *genome1_matchscan)		// note pointer equality test
 									{
@@ -2034,7 +2749,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 								}
 								
 								// no match was found, so we are heterozygous; we multiply our fitness by the selection coefficient and the dominance coefficient
-								w *= ApplyFitnessCallbacks(genome2_mutation, false, (mut_block_ptr + genome2_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+								w *= ApplyFitnessCallbacks(genome2_mutation, false, one_plus_dom_sel_block_ptr[genome2_mutation], p_fitness_callbacks, individual, genome1, genome2);
 								
 								if (w <= 0.0)
 									return 0.0;
@@ -2047,7 +2762,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 								const MutationIndex *genome1_matchscan = genome1_start; 
 								
 								// advance through genome1 with genome1_matchscan, looking for a match for the current mutation in genome2, to determine whether we are homozygous or not
-								while (genome1_matchscan != genome1_max && (mut_block_ptr + *genome1_matchscan)->position_ == position)
+								while (genome1_matchscan != genome1_max && position_block_ptr[*genome1_matchscan] == position)
 								{
 									if (genome2_mutation == *genome1_matchscan)		// note pointer equality test
 									{
@@ -2059,7 +2774,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 								}
 								
 								// no match was found, so we are heterozygous; we multiply our fitness by the selection coefficient and the dominance coefficient
-								w *= (mut_block_ptr + genome2_mutation)->cached_one_plus_dom_sel_;
+								w *= one_plus_dom_sel_block_ptr[genome2_mutation];
 								
 							homozygousExit8:
 								;
@@ -2069,7 +2784,7 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 								break;
 							else {
 								genome2_mutation = *genome2_iter;
-								genome2_iter_position = (mut_block_ptr + genome2_mutation)->position_;
+								genome2_iter_position = position_block_ptr[genome2_mutation];
 							}
 						} while (genome2_iter_position == position);
 						
@@ -2087,18 +2802,18 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 			while (genome1_iter != genome1_max)
 			{
 				MutationIndex genome1_mutation = *genome1_iter;
-				MutationType *genome1_muttype = (mut_block_ptr + genome1_mutation)->mutation_type_ptr_;
+				MutationType *genome1_muttype = muttype_block_ptr[genome1_mutation];
 				
 				if (genome1_muttype == p_single_callback_mut_type)
 				{
-					w *= ApplyFitnessCallbacks(genome1_mutation, false, (mut_block_ptr + genome1_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+					w *= ApplyFitnessCallbacks(genome1_mutation, false, one_plus_dom_sel_block_ptr[genome1_mutation], p_fitness_callbacks, individual, genome1, genome2);
 					
 					if (w <= 0.0)
 						return 0.0;
 				}
 				else
 				{
-					w *= (mut_block_ptr + genome1_mutation)->cached_one_plus_dom_sel_;
+					w *= one_plus_dom_sel_block_ptr[genome1_mutation];
 				}
 				
 				genome1_iter++;
@@ -2108,18 +2823,18 @@ double Subpopulation::FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsi
 			while (genome2_iter != genome2_max)
 			{
 				MutationIndex genome2_mutation = *genome2_iter;
-				MutationType *genome2_muttype = (mut_block_ptr + genome2_mutation)->mutation_type_ptr_;
+				MutationType *genome2_muttype = muttype_block_ptr[genome2_mutation];
 				
 				if (genome2_muttype == p_single_callback_mut_type)
 				{
-					w *= ApplyFitnessCallbacks(genome2_mutation, false, (mut_block_ptr + genome2_mutation)->cached_one_plus_dom_sel_, p_fitness_callbacks, individual, genome1, genome2);
+					w *= ApplyFitnessCallbacks(genome2_mutation, false, one_plus_dom_sel_block_ptr[genome2_mutation], p_fitness_callbacks, individual, genome1, genome2);
 					
 					if (w <= 0.0)
 						return 0.0;
 				}
 				else
 				{
-					w *= (mut_block_ptr + genome2_mutation)->cached_one_plus_dom_sel_;
+					w *= one_plus_dom_sel_block_ptr[genome2_mutation];
 				}
 				
 				genome2_iter++;
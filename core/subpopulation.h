@@ -89,6 +89,83 @@ typedef std::pair<std::string, SpatialMap *> SpatialMapPair;
 typedef std::map<std::string, SpatialMap *> SpatialMapMap;
 
 
+#pragma mark -
+#pragma mark MutationRunPairMemo
+#pragma mark -
+
+// A memo of the fitness effects of pairs of distinct mutation runs, keyed by the pair of run pointers, used by FitnessOfParentWithGenomeIndices_NoCallbacks();
+// the effect of a run paired with itself, or with no partner (in a male, when a sex chromosome is modeled), is kept in the run instead (see
+// MutationRun::homozygous_fitness_).  This is an open-addressing hash table with linear probing, kept at most half full.  Entries are valid only while the runs and the selection coefficients of their mutations are unchanged,
+// and run addresses can be reused after a run is freed, so the memo is cleared at the start of every fitness update and never carried across them.
+// Pairs whose non-neutral mutations number fewer than SLIM_FITNESS_MEMO_MIN_MUTATIONS are not memoized, since scanning them is cheaper than a probe.
+// Distinct pairings seldom recur under random mating, so Subpopulation::UpdateFitness() turns the memo off after an update with at least
+// SLIM_FITNESS_MEMO_MIN_LOOKUPS lookups in which fewer than one lookup in SLIM_FITNESS_MEMO_MIN_HIT_RATIO hit, and turns it back on every
+// SLIM_FITNESS_MEMO_RETRY_INTERVAL updates to see whether that has changed.
+
+#define SLIM_FITNESS_MEMO_MIN_MUTATIONS		16
+#define SLIM_FITNESS_MEMO_MIN_LOOKUPS		100
+#define SLIM_FITNESS_MEMO_MIN_HIT_RATIO		8
+#define SLIM_FITNESS_MEMO_RETRY_INTERVAL	20
+
+class MutationRunPairMemo
+{
+	struct MemoEntry {
+		const MutationRun *run1_;		// nullptr marks an empty slot
+		const MutationRun *run2_;
+		double fitness_;
+	};
+	
+	std::vector<MemoEntry> entries_;	// the table; its size is zero or a power of two, and is kept across Clear() to avoid reallocation
+	size_t count_ = 0;					// the number of slots in use
+	
+	bool enabled_ = true;				// if false, nothing is memoized; see Subpopulation::UpdateFitness()
+	int64_t lookup_count_ = 0;			// the number of lookups since the last Clear(), for assessing whether the memo is paying off
+	int64_t hit_count_ = 0;				// the number of those lookups that hit
+	
+	inline size_t SlotForKey(const MutationRun *p_run1, const MutationRun *p_run2) const
+	{
+		uint64_t hash = ((uint64_t)(uintptr_t)p_run1 * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)(uintptr_t)p_run2 * 0xC2B2AE3D27D4EB4FULL);
+		
+		return (size_t)(hash ^ (hash >> 32)) & (entries_.size() - 1);
+	}
+	
+	void Grow(void);
+
+public:
+	void Clear(bool p_enabled);
+	void Insert(const MutationRun *p_run1, const MutationRun *p_run2, double p_fitness);
+	
+	inline bool Enabled(void) const { return enabled_; }
+	inline int64_t LookupCount(void) const { return lookup_count_; }
+	inline int64_t HitCount(void) const { return hit_count_; }
+	
+	inline bool Lookup(const MutationRun *p_run1, const MutationRun *p_run2, double *p_fitness)
+	{
+		lookup_count_++;
+		
+		if (count_ == 0)
+			return false;
+		
+		size_t mask = entries_.size() - 1;
+		
+		for (size_t slot = SlotForKey(p_run1, p_run2); ; slot = (slot + 1) & mask)
+		{
+			const MemoEntry &entry = entries_[slot];
+			
+			if ((entry.run1_ == p_run1) && (entry.run2_ == p_run2))
+			{
+				*p_fitness = entry.fitness_;
+				hit_count_++;
+				return true;
+			}
+			
+			if (!entry.run1_)
+				return false;
+		}
+	}
+};
+
+
 #pragma mark -
 #pragma mark Subpopulation
 #pragma mark -
@@ -99,12 +176,25 @@ class Subpopulation : public SLiMEidosDictionary
 
 private:
 	
-	gsl_ran_discrete_t *lookup_parent_ = nullptr;			// OWNED POINTER: lookup table for drawing a parent based upon fitness
-	gsl_ran_discrete_t *lookup_female_parent_ = nullptr;	// OWNED POINTER: lookup table for drawing a female parent based upon fitness, SEX ONLY
-	gsl_ran_discrete_t *lookup_male_parent_ = nullptr;		// OWNED POINTER: lookup table for drawing a male parent based upon fitness, SEX ONLY
+	EidosAliasTable lookup_parent_;					// lookup table for drawing a parent based upon fitness; rebuilt in place each generation
+	EidosAliasTable lookup_female_parent_;			// lookup table for drawing a female parent based upon fitness, SEX ONLY
+	EidosAliasTable lookup_male_parent_;			// lookup table for drawing a male parent based upon fitness, SEX ONLY
 	
 	EidosSymbolTableEntry self_symbol_;						// for fast setup of the symbol table
 	
+	std::vector<MutationRunPairMemo> fitness_memos_;		// memos of run pair fitness effects, one per thread; valid only within UpdateFitness()
+	bool fitness_memo_enabled_ = true;						// whether the memos are in use; see UpdateFitness()
+	int fitness_memo_skip_count_ = 0;						// the number of updates since the memos were turned off
+	
+	// Batched fitness() callbacks (see UpdateFitness_BatchCallbacks()); these are valid only within UpdateFitness().  While batch_fitness_recording_
+	// is set, ApplyFitnessCallbacks() does not call callbacks, but instead notes each mutation it is asked about as an item in the vectors below
+	bool batch_fitness_recording_ = false;
+	std::vector<slim_popsize_t> batch_individuals_;			// the index of the individual for each item
+	std::vector<MutationIndex> batch_mutations_;			// the mutation for each item
+	std::vector<int8_t> batch_homozygous_;					// -1 if opposed by a null genome, 0 if heterozygous, 1 if homozygous, as in ApplyFitnessCallbacks()
+	std::vector<double> batch_rel_fitness_;					// the relative fitness effect of each item, updated by each callback in turn
+	std::vector<double> batch_fitness_;						// the fitness of each parental individual, apart from global fitness() callbacks
+
 public:
 	
 	Population &population_;						// we need to know our Population so we can remove ourselves, etc.
@@ -178,18 +268,34 @@ public:
 	slim_popsize_t DrawMaleParentUsingFitness(void) const;									// draw a male from the subpopulation based upon fitness; SEX ONLY
 	slim_popsize_t DrawMaleParentEqualProbability(void) const;								// draw a male from the subpopulation  with equal probabilities; SEX ONLY
 	
+	// draw many parents at once, based upon fitness, filling p_buffer with p_count indices; the same draws as repeated calls to the methods above
+	void DrawParentsUsingFitness(slim_popsize_t p_count, slim_popsize_t *p_buffer) const;
+	void DrawFemaleParentsUsingFitness(slim_popsize_t p_count, slim_popsize_t *p_buffer) const;		// SEX ONLY
+	void DrawMaleParentsUsingFitness(slim_popsize_t p_count, slim_popsize_t *p_buffer) const;			// SEX ONLY
+	
 	void GenerateChildrenToFit(const bool p_parents_also);											// given the subpop size and sex ratio currently set for the child generation, make new genomes to fit
 	IndividualSex SexOfIndividual(slim_popsize_t p_individual_index);						// return the sex of the individual at the given index; uses child_generation_valid
 	void UpdateFitness(std::vector<SLiMEidosBlock*> &p_fitness_callbacks, std::vector<SLiMEidosBlock*> &p_global_fitness_callbacks);							// update the fitness lookup table based upon current mutations
 	
 	// calculate the fitness of a given individual; the x dominance coeff is used only if the X is modeled
-	double FitnessOfParentWithGenomeIndices_NoCallbacks(slim_popsize_t p_individual_index);
+	double FitnessOfParentWithGenomeIndices_NoCallbacks(slim_popsize_t p_individual_index, MutationRunPairMemo &p_memo);
+	double FitnessOfMutationRunPair_NoCallbacks(MutationRun *p_mutrun1, MutationRun *p_mutrun2, MutationRunPairMemo &p_memo);
+	double FitnessOfHomozygousMutationRun_NoCallbacks(MutationRun *p_mutrun);
+	double FitnessOfUnpairedMutationRun_NoCallbacks(MutationRun *p_mutrun, GenomeType p_genome_type);
 	double FitnessOfParentWithGenomeIndices_Callbacks(slim_popsize_t p_individual_index, std::vector<SLiMEidosBlock*> &p_fitness_callbacks);
 	double FitnessOfParentWithGenomeIndices_SingleCallback(slim_popsize_t p_individual_index, std::vector<SLiMEidosBlock*> &p_fitness_callbacks, MutationType *p_single_callback_mut_type);
 	
+	// calculate and cache the fitness of a range of individuals in parallel, with no callbacks, returning the total fitness of the range
+	void ValidateParentalNonneutralCaches(int p_thread_count);
+	double UpdateFitnessOfParentRange_NoCallbacks(slim_popsize_t p_start_index, slim_popsize_t p_end_index, bool p_males, int p_thread_count);
+	
 	double ApplyFitnessCallbacks(MutationIndex p_mutation, int p_homozygous, double p_computed_fitness, std::vector<SLiMEidosBlock*> &p_fitness_callbacks, Individual *p_individual, Genome *p_genome1, Genome *p_genome2);
 	double ApplyGlobalFitnessCallbacks(std::vector<SLiMEidosBlock*> &p_fitness_callbacks, slim_popsize_t p_individual_index);
 	
+	// calculate the fitness of all parental individuals into batch_fitness_, calling each fitness() callback once with vectors of mutations
+	void UpdateFitness_BatchCallbacks(std::vector<SLiMEidosBlock*> &p_fitness_callbacks, bool p_single_callback, MutationType *p_single_callback_mut_type);
+	void ApplyBatchFitnessCallback(SLiMEidosBlock *p_fitness_callback, const std::vector<size_t> &p_items);
+	
 	void SwapChildAndParentGenomes(void);															// switch to the next generation by swapping; the children become the parents
 	
 	//
@@ -234,8 +340,8 @@ inline __attribute__((always_inline)) slim_popsize_t Subpopulation::DrawParentUs
 		EIDOS_TERMINATION << "ERROR (Subpopulation::DrawParentUsingFitness): (internal error) called on a population for which sex is enabled." << EidosTerminate();
 #endif
 	
-	if (lookup_parent_)
-		return static_cast<slim_popsize_t>(gsl_ran_discrete(gEidos_rng, lookup_parent_));
+	if (lookup_parent_.IsBuilt())
+		return static_cast<slim_popsize_t>(lookup_parent_.Draw(gEidos_rng));
 	else
 		return static_cast<slim_popsize_t>(Eidos_RandomInt(gEidos_rng, parent_subpop_size_));
 }
@@ -258,8 +364,8 @@ inline __attribute__((always_inline)) slim_popsize_t Subpopulation::DrawFemalePa
 		EIDOS_TERMINATION << "ERROR (Subpopulation::DrawFemaleParentUsingFitness): (internal error) called on a population for which sex is not enabled." << EidosTerminate();
 #endif
 	
-	if (lookup_female_parent_)
-		return static_cast<slim_popsize_t>(gsl_ran_discrete(gEidos_rng, lookup_female_parent_));
+	if (lookup_female_parent_.IsBuilt())
+		return static_cast<slim_popsize_t>(lookup_female_parent_.Draw(gEidos_rng));
 	else
 		return static_cast<slim_popsize_t>(Eidos_RandomInt(gEidos_rng, parent_first_male_index_));
 }
@@ -283,8 +389,8 @@ inline __attribute__((always_inline)) slim_popsize_t Subpopulation::DrawMalePare
 		EIDOS_TERMINATION << "ERROR (Subpopulation::DrawMaleParentUsingFitness): (internal error) called on a population for which sex is not enabled." << EidosTerminate();
 #endif
 	
-	if (lookup_male_parent_)
-		return static_cast<slim_popsize_t>(gsl_ran_discrete(gEidos_rng, lookup_male_parent_)) + parent_first_male_index_;
+	if (lookup_male_parent_.IsBuilt())
+		return static_cast<slim_popsize_t>(lookup_male_parent_.Draw(gEidos_rng)) + parent_first_male_index_;
 	else
 		return static_cast<slim_popsize_t>(Eidos_RandomInt(gEidos_rng, parent_subpop_size_ - parent_first_male_index_) + parent_first_male_index_);
 }
@@ -0,0 +1,381 @@
+//
+//  tree_sequence.cpp
+//  SLiM
+//
+//  Created by Ben Haller on 10/16/17.
+//  Copyright (c) 2017 Philipp Messer.  All rights reserved.
+//	A product of the Messer Lab, http://messerlab.org/slim/
+//
+
+//	This file is part of SLiM.
+//
+//	SLiM is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+//
+//	SLiM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License along with SLiM.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "tree_sequence.h"
+#include "genome.h"
+
+#include <algorithm>
+#include <numeric>
+#include <iomanip>
+
+
+TreeSequence::TreeSequence(slim_position_t p_sequence_length, double p_simplification_ratio) : sequence_length_(p_sequence_length), simplification_ratio_(p_simplification_ratio)
+{
+}
+
+void TreeSequence::Clear(void)
+{
+	node_time_.clear();
+	node_population_.clear();
+	node_is_null_.clear();
+	
+	edge_left_.clear();
+	edge_right_.clear();
+	edge_parent_.clear();
+	edge_child_.clear();
+	
+	simplified_node_count_ = 0;
+	split_base_time_ = -1;
+	split_count_ = 0;
+}
+
+void TreeSequence::ShiftTimes(double p_offset)
+{
+	for (double &time : node_time_)
+		time += p_offset;
+	
+	if (split_base_time_ != -1)
+		split_base_time_ += p_offset;
+}
+
+slim_treenodeid_t TreeSequence::AddNode(Genome &p_genome, double p_time, slim_objectid_t p_population)
+{
+	slim_treenodeid_t node_id = (slim_treenodeid_t)node_time_.size();
+	
+	node_time_.emplace_back(p_time);
+	node_population_.emplace_back(p_population);
+	node_is_null_.emplace_back(p_genome.IsNull() ? 1 : 0);
+	
+	p_genome.SetTreeNodeID(node_id);
+	
+	return node_id;
+}
+
+void TreeSequence::AddCrossoverEdges(slim_treenodeid_t p_child, const Genome &p_parent_1, const Genome &p_parent_2, const slim_position_t *p_breakpoints, int p_breakpoint_count)
+{
+	// The child inherits from parent 1 up to the first breakpoint, then from parent 2 up to the next, and so on; the breakpoints are
+	// sorted and uniqued, and may end with a sentinel past the end of the chromosome, so they are clipped to the sequence length here
+	slim_treenodeid_t parents[2] = {p_parent_1.TreeNodeID(), p_parent_2.TreeNodeID()};
+	slim_position_t left = 0;
+	int parent_index = 0;
+	
+	for (int breakpoint_index = 0; breakpoint_index < p_breakpoint_count; ++breakpoint_index)
+	{
+		slim_position_t right = std::min(p_breakpoints[breakpoint_index], sequence_length_);
+		
+		if (right > left)
+		{
+			edge_left_.emplace_back(left);
+			edge_right_.emplace_back(right);
+			edge_parent_.emplace_back(parents[parent_index]);
+			edge_child_.emplace_back(p_child);
+			left = right;
+		}
+		
+		parent_index ^= 1;
+		
+		if (left >= sequence_length_)
+			break;
+	}
+	
+	if (left < sequence_length_)
+	{
+		edge_left_.emplace_back(left);
+		edge_right_.emplace_back(sequence_length_);
+		edge_parent_.emplace_back(parents[parent_index]);
+		edge_child_.emplace_back(p_child);
+	}
+}
+
+void TreeSequence::AddClonalEdge(slim_treenodeid_t p_child, const Genome &p_parent)
+{
+	edge_left_.emplace_back(0);
+	edge_right_.emplace_back(sequence_length_);
+	edge_parent_.emplace_back(p_parent.TreeNodeID());
+	edge_child_.emplace_back(p_child);
+}
+
+void TreeSequence::RetractNodes(slim_treenodeid_t p_first_node)
+{
+	// edges are recorded in the same order as their child nodes, so the edges to remove are all at the end
+	size_t edge_count = edge_child_.size();
+	
+	while ((edge_count > 0) && (edge_child_[edge_count - 1] >= p_first_node))
+		edge_count--;
+	
+	edge_left_.resize(edge_count);
+	edge_right_.resize(edge_count);
+	edge_parent_.resize(edge_count);
+	edge_child_.resize(edge_count);
+	
+	node_time_.resize(p_first_node);
+	node_population_.resize(p_first_node);
+	node_is_null_.resize(p_first_node);
+}
+
+double TreeSequence::NextSplitTime(double p_base_time)
+{
+	if (p_base_time != split_base_time_)
+	{
+		split_base_time_ = p_base_time;
+		split_count_ = 0;
+	}
+	
+	// a small power of two keeps the offsets exact; this allows many thousands of splits per generation
+	return p_base_time + (++split_count_) / 65536.0;
+}
+
+void TreeSequence::SortedEdgeOrder(std::vector<size_t> &p_edge_order) const
+{
+	// the order tskit requires: by parent birth time (youngest first), then parent, then child, then left
+	p_edge_order.resize(edge_parent_.size());
+	std::iota(p_edge_order.begin(), p_edge_order.end(), 0);
+	std::sort(p_edge_order.begin(), p_edge_order.end(), [this](size_t a, size_t b) {
+		slim_treenodeid_t parent_a = edge_parent_[a], parent_b = edge_parent_[b];
+		
+		if (parent_a != parent_b)
+		{
+			double time_a = node_time_[parent_a], time_b = node_time_[parent_b];
+			
+			if (time_a != time_b)
+				return time_a > time_b;
+			return parent_a < parent_b;
+		}
+		if (edge_child_[a] != edge_child_[b])
+			return edge_child_[a] < edge_child_[b];
+		return edge_left_[a] < edge_left_[b];
+	});
+}
+
+slim_treenodeid_t TreeSequence::AddSimplifiedNode(slim_treenodeid_t p_old_node)
+{
+	slim_treenodeid_t new_node = (slim_treenodeid_t)new_node_time_.size();
+	
+	new_node_time_.emplace_back(node_time_[p_old_node]);
+	new_node_population_.emplace_back(node_population_[p_old_node]);
+	new_node_is_null_.emplace_back(node_is_null_[p_old_node]);
+	node_map_[p_old_node] = new_node;
+	
+	return new_node;
+}
+
+void TreeSequence::Simplify(const std::vector<Genome *> &p_samples)
+{
+	size_t node_count = node_time_.size();
+	size_t edge_count = edge_parent_.size();
+	
+	node_map_.assign(node_count, -1);
+	ancestry_.resize(node_count);
+	
+	for (std::vector<AncestrySegment> &segments : ancestry_)
+		segments.clear();
+	
+	new_node_time_.clear();
+	new_node_population_.clear();
+	new_node_is_null_.clear();
+	new_edge_left_.clear();
+	new_edge_right_.clear();
+	new_edge_parent_.clear();
+	new_edge_child_.clear();
+	
+	// the samples come first in the new node table, and carry their own ancestry along the whole chromosome
+	for (Genome *genome : p_samples)
+	{
+		slim_treenodeid_t old_node = genome->TreeNodeID();
+		
+		if ((old_node < 0) || ((size_t)old_node >= node_count) || (node_map_[old_node] != -1))
+			EIDOS_TERMINATION << "ERROR (TreeSequence::Simplify): (internal error) sample genome without a unique tree sequence node." << EidosTerminate();
+		
+		slim_treenodeid_t new_node = AddSimplifiedNode(old_node);
+		
+		ancestry_[old_node].emplace_back(AncestrySegment{0, sequence_length_, new_node});
+		genome->SetTreeNodeID(new_node);
+	}
+	
+	// process parents from youngest to oldest, so that the ancestry of every child is complete before its parents are processed;
+	// a parent's children are gathered together, since all of its edges are adjacent in this order
+	std::vector<size_t> edge_order;
+	
+	SortedEdgeOrder(edge_order);
+	
+	std::vector<AncestrySegment> overlapping;
+	
+	for (size_t edge_index = 0; edge_index < edge_count; )
+	{
+		slim_treenodeid_t parent = edge_parent_[edge_order[edge_index]];
+		
+		overlapping.clear();
+		
+		for (; (edge_index < edge_count) && (edge_parent_[edge_order[edge_index]] == parent); ++edge_index)
+		{
+			size_t edge = edge_order[edge_index];
+			slim_position_t left = edge_left_[edge], right = edge_right_[edge];
+			
+			for (AncestrySegment &segment : ancestry_[edge_child_[edge]])
+				if ((segment.right_ > left) && (right > segment.left_))
+					overlapping.emplace_back(AncestrySegment{std::max(left, segment.left_), std::min(right, segment.right_), segment.node_});
+		}
+		
+		if (overlapping.size())
+			MergeAncestors(parent, overlapping);
+	}
+	
+	// swap in the new tables; the old ancestry is no longer needed, so free it if it has grown large
+	std::swap(node_time_, new_node_time_);
+	std::swap(node_population_, new_node_population_);
+	std::swap(node_is_null_, new_node_is_null_);
+	std::swap(edge_left_, new_edge_left_);
+	std::swap(edge_right_, new_edge_right_);
+	std::swap(edge_parent_, new_edge_parent_);
+	std::swap(edge_child_, new_edge_child_);
+	
+	if (ancestry_.size() > 4 * node_time_.size())
+		std::vector<std::vector<AncestrySegment>>().swap(ancestry_);
+	
+	simplified_node_count_ = node_time_.size();
+}
+
+void TreeSequence::MergeAncestors(slim_treenodeid_t p_parent, std::vector<AncestrySegment> &p_segments)
+{
+	// Sweep along the chromosome through the intervals defined by the overlaps of p_segments.  Where only one segment covers an
+	// interval, the parent is just a pass-through and its ancestry is inherited; where more than one does, the parent is a
+	// coalescence point and gets a node in the new tables, with an edge to each child segment.  Samples always get edges.
+	slim_treenodeid_t new_parent = node_map_[p_parent];
+	bool is_sample = (new_parent != -1);
+	std::vector<AncestrySegment> &parent_ancestry = ancestry_[p_parent];
+	size_t segment_count = p_segments.size();
+	
+	std::sort(p_segments.begin(), p_segments.end(), [](const AncestrySegment &a, const AncestrySegment &b) { return a.left_ < b.left_; });
+	p_segments.emplace_back(AncestrySegment{sequence_length_, sequence_length_, -1});		// sentinel
+	
+	active_segments_.clear();
+	child_edges_.clear();
+	
+	slim_position_t left, right = p_segments[0].left_;
+	size_t segment_index = 0;
+	
+	while ((segment_index < segment_count) || active_segments_.size())
+	{
+		left = right;
+		active_segments_.erase(std::remove_if(active_segments_.begin(), active_segments_.end(), [left](const AncestrySegment &x) { return x.right_ <= left; }), active_segments_.end());
+		
+		if (segment_index < segment_count)
+		{
+			if (active_segments_.size() == 0)
+				left = p_segments[segment_index].left_;
+			
+			while ((segment_index < segment_count) && (p_segments[segment_index].left_ == left))
+				active_segments_.emplace_back(p_segments[segment_index++]);
+		}
+		else if (active_segments_.size() == 0)
+		{
+			break;
+		}
+		
+		right = p_segments[segment_index].left_;
+		
+		for (AncestrySegment &x : active_segments_)
+			right = std::min(right, x.right_);
+		
+		if ((active_segments_.size() == 1) && !is_sample)
+		{
+			// pass-through; extend the previous ancestry segment if it is contiguous and carried by the same node
+			slim_treenodeid_t child = active_segments_[0].node_;
+			
+			if (parent_ancestry.size() && (parent_ancestry.back().right_ == left) && (parent_ancestry.back().node_ == child))
+				parent_ancestry.back().right_ = right;
+			else
+				parent_ancestry.emplace_back(AncestrySegment{left, right, child});
+		}
+		else
+		{
+			if (new_parent == -1)
+				new_parent = AddSimplifiedNode(p_parent);
+			
+			for (AncestrySegment &x : active_segments_)
+				child_edges_.emplace_back(AncestrySegment{left, right, x.node_});
+			
+			if (!is_sample)
+			{
+				if (parent_ancestry.size() && (parent_ancestry.back().right_ == left) && (parent_ancestry.back().node_ == new_parent))
+					parent_ancestry.back().right_ = right;
+				else
+					parent_ancestry.emplace_back(AncestrySegment{left, right, new_parent});
+			}
+		}
+	}
+	
+	// write out the new edges for this parent, sorted by child and merged where contiguous
+	std::sort(child_edges_.begin(), child_edges_.end(), [](const AncestrySegment &a, const AncestrySegment &b) { return (a.node_ < b.node_) || ((a.node_ == b.node_) && (a.left_ < b.left_)); });
+	
+	size_t first_new_edge = new_edge_child_.size();
+	
+	for (AncestrySegment &edge : child_edges_)
+	{
+		size_t last = new_edge_child_.size();
+		
+		if ((last > first_new_edge) && (new_edge_child_[last - 1] == edge.node_) && (new_edge_right_[last - 1] == edge.left_))
+		{
+			new_edge_right_[last - 1] = edge.right_;
+		}
+		else
+		{
+			new_edge_left_.emplace_back(edge.left_);
+			new_edge_right_.emplace_back(edge.right_);
+			new_edge_parent_.emplace_back(new_parent);
+			new_edge_child_.emplace_back(edge.node_);
+		}
+	}
+}
+
+void TreeSequence::WriteNodeTable(std::ostream &p_out, const std::vector<Genome *> &p_samples) const
+{
+	// times are written as generations before the youngest node, which is where tskit puts the present
+	size_t node_count = node_time_.size();
+	double present = (node_count ? *std::max_element(node_time_.begin(), node_time_.end()) : 0.0);
+	std::vector<uint8_t> is_sample(node_count, 0);
+	
+	for (Genome *genome : p_samples)
+		if (genome->TreeNodeID() >= 0)
+			is_sample[genome->TreeNodeID()] = 1;
+	
+	p_out << "is_sample\ttime\tpopulation" << std::endl;
+	p_out << std::setprecision(15);
+	
+	for (size_t node_index = 0; node_index < node_count; ++node_index)
+		p_out << (int)is_sample[node_index] << '\t' << (present - node_time_[node_index]) << '\t' << node_population_[node_index] << '\n';
+}
+
+void TreeSequence::WriteEdgeTable(std::ostream &p_out) const
+{
+	std::vector<size_t> edge_order;
+	
+	SortedEdgeOrder(edge_order);
+	
+	p_out << "left\tright\tparent\tchild" << std::endl;
+	
+	for (size_t edge : edge_order)
+		p_out << edge_left_[edge] << '\t' << edge_right_[edge] << '\t' << edge_parent_[edge] << '\t' << edge_child_[edge] << '\n';
+}
+
+
+
+
+
@@ -0,0 +1,131 @@
+//
+//  tree_sequence.h
+//  SLiM
+//
+//  Created by Ben Haller on 10/16/17.
+//  Copyright (c) 2017 Philipp Messer.  All rights reserved.
+//	A product of the Messer Lab, http://messerlab.org/slim/
+//
+
+//	This file is part of SLiM.
+//
+//	SLiM is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+//
+//	SLiM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License along with SLiM.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+
+ The class TreeSequence records the genealogy of the genomes in the simulation, as a table of nodes (one per genome ever created)
+ and a table of edges (each saying that a child node inherited the interval [left, right) of the chromosome from a parent node).
+ Recording is turned on with initializeTreeSeq(); each new genome is then given a node, and its parental genomes and crossover
+ breakpoints are logged as edges.  The tables grow without bound unless they are simplified, which discards all nodes and edges
+ that are not ancestral to the current generation, using the algorithm of Kelleher et al. (2018), "Efficiently performing
+ forward-time population genetic simulations with tree sequence recording"; this is done periodically by SLiMSim.
+
+ Node times are kept as birth generations, counting forward; the times written out are in generations before the youngest node,
+ as tskit expects.  The tables are written in tskit's text format, and can be loaded with tskit.load_text().  No mutations are
+ recorded; neutral mutations can be overlaid on the tree sequence afterwards.
+
+ */
+
+#ifndef __SLiM__tree_sequence__
+#define __SLiM__tree_sequence__
+
+
+#include <vector>
+#include <iostream>
+
+#include "slim_global.h"
+
+
+class Genome;
+
+
+class TreeSequence
+{
+	//	This class has its copy constructor and assignment operator disabled, to prevent accidental copying.
+
+private:
+	
+	// a segment of the chromosome, [left_, right_), whose ancestry is carried by node_; used by Simplify()
+	struct AncestrySegment {
+		slim_position_t left_;
+		slim_position_t right_;
+		slim_treenodeid_t node_;
+	};
+	
+	void MergeAncestors(slim_treenodeid_t p_parent, std::vector<AncestrySegment> &p_segments);
+	slim_treenodeid_t AddSimplifiedNode(slim_treenodeid_t p_old_node);
+	void SortedEdgeOrder(std::vector<size_t> &p_edge_order) const;
+	
+	// state used during Simplify(); kept here to avoid reallocation
+	std::vector<slim_treenodeid_t> node_map_;								// old node id -> new node id, or -1
+	std::vector<std::vector<AncestrySegment>> ancestry_;					// old node id -> the segments it is ancestral to, in new node ids
+	std::vector<AncestrySegment> active_segments_;							// segments overlapping the current interval
+	std::vector<AncestrySegment> child_edges_;								// new edges for the current parent; node_ is the child
+	
+	std::vector<double> new_node_time_;
+	std::vector<slim_objectid_t> new_node_population_;
+	std::vector<uint8_t> new_node_is_null_;
+	std::vector<slim_position_t> new_edge_left_, new_edge_right_;
+	std::vector<slim_treenodeid_t> new_edge_parent_, new_edge_child_;
+
+public:
+	
+	slim_position_t sequence_length_;			// the chromosome length; edges span [0, sequence_length_)
+	double simplification_ratio_;				// simplify when the node count exceeds this multiple of its size after the last simplification
+	size_t simplified_node_count_ = 0;			// the node count after the last simplification
+	
+	// the node table: one row per genome, indexed by slim_treenodeid_t
+	std::vector<double> node_time_;				// the generation in which the genome was created, counting forward
+	std::vector<slim_objectid_t> node_population_;	// the id of the subpopulation in which the genome was created
+	std::vector<uint8_t> node_is_null_;			// 1 if the genome is a null genome; such nodes have no edges and are never samples
+	
+	// the edge table: one row per inherited interval of a child node
+	std::vector<slim_position_t> edge_left_;
+	std::vector<slim_position_t> edge_right_;
+	std::vector<slim_treenodeid_t> edge_parent_;
+	std::vector<slim_treenodeid_t> edge_child_;
+	
+	// offsets used to keep the nodes of split subpopulations younger than their source nodes; see NextSplitTime()
+	double split_base_time_ = -1;
+	int split_count_ = 0;
+	
+	TreeSequence(const TreeSequence&) = delete;					// no copying
+	TreeSequence& operator=(const TreeSequence&) = delete;		// no copying
+	TreeSequence(void) = delete;								// no null construction
+	TreeSequence(slim_position_t p_sequence_length, double p_simplification_ratio);
+	
+	void Clear(void);											// discard all nodes and edges
+	void ShiftTimes(double p_offset);							// shift all node times; used when the generation counter is changed
+	
+	// Recording; each new genome gets a node, and then (unless it is null) edges to its parental genomes
+	slim_treenodeid_t AddNode(Genome &p_genome, double p_time, slim_objectid_t p_population);
+	void AddCrossoverEdges(slim_treenodeid_t p_child, const Genome &p_parent_1, const Genome &p_parent_2, const slim_position_t *p_breakpoints, int p_breakpoint_count);
+	void AddClonalEdge(slim_treenodeid_t p_child, const Genome &p_parent);
+	void RetractNodes(slim_treenodeid_t p_first_node);			// remove nodes p_first_node and later, and their edges; used when a child is rejected
+	
+	// Split subpopulations are founded by copying genomes within a single generation; each split gets a slightly later time than
+	// the last, so that parent nodes are always strictly older than their children
+	double NextSplitTime(double p_base_time);
+	
+	// Simplification; p_samples are the genomes to keep the ancestry of, and get their node ids remapped
+	inline bool ShouldSimplify(void) const { return (node_time_.size() > simplification_ratio_ * simplified_node_count_); }
+	void Simplify(const std::vector<Genome *> &p_samples);
+	
+	// Output in tskit's text format; p_samples are the genomes flagged as samples
+	void WriteNodeTable(std::ostream &p_out, const std::vector<Genome *> &p_samples) const;
+	void WriteEdgeTable(std::ostream &p_out) const;
+};
+
+
+#endif /* defined(__SLiM__tree_sequence__) */
+
+
+
+
+
@@ -20,6 +20,7 @@
 
 #include "eidos_ast_node.h"
 #include "eidos_interpreter.h"
+#include "eidos_bytecode.h"
 
 #include "errno.h"
 #include <string>
@@ -55,6 +56,14 @@ EidosASTNode::~EidosASTNode(void)
 		delete token_;
 		token_ = nullptr;
 	}
+	
+#if EIDOS_BYTECODE
+	if (cached_bytecode_)
+	{
+		delete cached_bytecode_;
+		cached_bytecode_ = nullptr;
+	}
+#endif
 }
 
 void EidosASTNode::AddChild(EidosASTNode *p_child_node)
@@ -84,6 +93,11 @@ void EidosASTNode::OptimizeTree(void) const
 	_OptimizeEvaluators();		// cache evaluator functions in cached_evaluator_ for fast node evaluation
 	_OptimizeFor();				// cache information about for loops that allows them to be accelerated at runtime
 	_OptimizeAssignments();		// cache information about assignments that allows simple increment/decrement assignments to be accelerated
+	
+#if EIDOS_BYTECODE
+	if (gEidosBytecodeEnabled)
+		_OptimizeBytecode();	// compile arithmetic/logical expressions to bytecode; must come after _OptimizeEvaluators()
+#endif
 }
 
 void EidosASTNode::_OptimizeConstants(void) const
@@ -338,6 +352,29 @@ void EidosASTNode::_OptimizeAssignments(void) const
 	}
 }
 
+#if EIDOS_BYTECODE
+void EidosASTNode::_OptimizeBytecode(void) const
+{
+	// Compile the largest subtrees we can, so work top-down; if we compile this node, our children are left to the interpreter,
+	// which evaluates them only when the bytecode bails out.  See eidos_bytecode.h.
+	EidosBytecode *bytecode = EidosBytecode::CompileSubtree(this);
+	
+	if (bytecode)
+	{
+		cached_bytecode_ = bytecode;
+		cached_evaluator_ = &EidosInterpreter::Evaluate_Bytecode;
+		return;
+	}
+	
+	for (auto child : children_)
+		child->_OptimizeBytecode();
+}
+#else
+void EidosASTNode::_OptimizeBytecode(void) const
+{
+}
+#endif
+
 bool EidosASTNode::HasCachedNumericValue(void) const
 {
 	if ((token_->token_type_ == EidosTokenType::kTokenNumber) && cached_value_ && (cached_value_->Count() == 1))
@@ -453,7 +490,7 @@ void EidosASTNode::PrintTreeWithIndent(std::ostream &p_outstream, int p_indent)
 	}
 }
 
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 // PROFILING
 
 void EidosASTNode::ZeroProfileTotals(void) const
@@ -538,7 +575,7 @@ void EidosASTNode::FullUTF16Range(int32_t *p_start, int32_t *p_end) const
 	*p_end = end;
 }
 
-#endif	// defined(SLIMGUI) && (SLIMPROFILING == 1)
+#endif	// (SLIMPROFILING == 1)
 
 
 
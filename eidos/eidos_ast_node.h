@@ -31,6 +31,7 @@
 
 class EidosASTNode;
 class EidosInterpreter;
+class EidosBytecode;
 
 
 // EidosASTNodes must be allocated out of the global pool, for speed.  See eidos_object_pool.h.  When Eidos disposes of a node,
@@ -56,16 +57,18 @@ public:
 	mutable EidosFunctionSignature_SP cached_signature_ = nullptr;		// a cached pointer to the function signature corresponding to the token
 	mutable EidosEvaluationMethod cached_evaluator_ = nullptr;			// a pre-cached pointer to method to evaluate this node; shorthand for EvaluateNode()
 	mutable EidosGlobalStringID cached_stringID_ = gEidosID_none;		// a pre-cached identifier for the token string, for fast property/method lookup
+	mutable EidosBytecode *cached_bytecode_ = nullptr;					// OWNED: compiled bytecode for this subtree, run by Evaluate_Bytecode(); see eidos_bytecode.h
 	
 	uint8_t token_is_owned_ = false;									// if T, we own token_ because it is a virtual token that replaced a real token
 	mutable uint8_t cached_for_references_index_ = true;				// pre-cached as true if the index variable is referenced at all in the loop
 	mutable uint8_t cached_for_assigns_index_ = true;					// pre-cached as true if the index variable is assigned to in the loop
 	mutable uint8_t cached_compound_assignment_ = false;				// pre-cached on assignment nodes if they are of the form "x=x+1" or "x=x-1" only
+	mutable uint8_t cached_symbol_slot_ = 0;							// for identifiers, a hint: the symbol table slot in which the symbol was last found
 	
 	mutable EidosTypeSpecifier typespec_;								// only valid for type-specifier nodes inside function declarations
 	mutable bool hit_eof_in_tolerant_parse_ = false;					// only valid for compound statement nodes; used by the type-interpreter to handle scoping
 	
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	mutable eidos_profile_t profile_total_ = 0;							// profiling clock for this node and its children; only set for some nodes
 	EidosToken *full_range_end_token_ = nullptr;						// the ")" or "]" that ends the full range of tokens like "(", "[", for, if, and while
@@ -89,6 +92,7 @@ public:
 	void _OptimizeFor(void) const;										// determine whether/how for-loop index variables need to be set up
 	void _OptimizeForScan(const std::string &p_for_index_identifier, uint8_t *p_references, uint8_t *p_assigns) const;	// internal method
 	void _OptimizeAssignments(void) const;								// detect and mark simple increment/decrement assignments on a variable
+	void _OptimizeBytecode(void) const;									// compile maximal arithmetic/logical subtrees to bytecode
 	
 	bool HasCachedNumericValue(void) const;
 	double CachedNumericValue(void) const;
@@ -96,7 +100,7 @@ public:
 	void PrintToken(std::ostream &p_outstream) const;
 	void PrintTreeWithIndent(std::ostream &p_outstream, int p_indent) const;
 	
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 	// PROFILING
 	void ZeroProfileTotals(void) const;
 	eidos_profile_t ConvertProfileTotalsToSelfCounts(void) const;
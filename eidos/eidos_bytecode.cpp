@@ -0,0 +1,389 @@
+//
+//  eidos_bytecode.cpp
+//  Eidos
+//
+//  Created by Ben Haller on 10/17/17.
+//  Copyright (c) 2017 Philipp Messer.  All rights reserved.
+//	A product of the Messer Lab, http://messerlab.org/slim/
+//
+
+//	This file is part of Eidos.
+//
+//	Eidos is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+//
+//	Eidos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License along with Eidos.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "eidos_bytecode.h"
+#include "eidos_symbol_table.h"
+
+#include <cmath>
+
+
+#if EIDOS_BYTECODE
+
+bool gEidosBytecodeEnabled = true;
+
+
+EidosBytecode *EidosBytecode::CompileSubtree(const EidosASTNode *p_node)
+{
+	if (!p_node->cached_evaluator_)
+		return nullptr;
+	
+	EidosBytecode *bytecode = new EidosBytecode(p_node->cached_evaluator_);
+	int operation_count = 0;
+	
+	if ((bytecode->_CompileNode(p_node, &operation_count) == -1) || (operation_count < EIDOS_BYTECODE_MINIMUM_OPERATIONS))
+	{
+		delete bytecode;
+		return nullptr;
+	}
+	
+	return bytecode;
+}
+
+int EidosBytecode::_Emit(EidosBytecodeOp p_op, int p_first, int p_second)
+{
+	int result_register = (int)instructions_.size();
+	
+	if (result_register >= EIDOS_BYTECODE_MAXIMUM_LENGTH)
+		return -1;
+	
+	EidosBytecodeInstruction instruction;
+	
+	instruction.op_ = p_op;
+	instruction.first_ = (uint8_t)p_first;
+	instruction.second_ = (uint8_t)p_second;
+	instruction.operand_.int_ = 0;
+	
+	instructions_.emplace_back(instruction);
+	return result_register;
+}
+
+int EidosBytecode::_CompileNode(const EidosASTNode *p_node, int *p_operation_count)
+{
+	const std::vector<EidosASTNode *> &children = p_node->children_;
+	size_t child_count = children.size();
+	EidosBytecodeOp op;
+	
+	switch (p_node->token_->token_type_)
+	{
+		case EidosTokenType::kTokenNumber:
+		{
+			// numbers always have a cached constant from _OptimizeConstants(), but we check anyway
+			EidosValue *constant = p_node->cached_value_.get();
+			
+			if (!constant || (constant->Count() != 1))
+				return -1;
+			
+			if (constant->Type() == EidosValueType::kValueInt)
+			{
+				int result_register = _Emit(EidosBytecodeOp::kLoadInt, 0, 0);
+				
+				if (result_register != -1)
+					instructions_[result_register].operand_.int_ = constant->IntAtIndex(0, nullptr);
+				return result_register;
+			}
+			else if (constant->Type() == EidosValueType::kValueFloat)
+			{
+				int result_register = _Emit(EidosBytecodeOp::kLoadFloat, 0, 0);
+				
+				if (result_register != -1)
+					instructions_[result_register].operand_.float_ = constant->FloatAtIndex(0, nullptr);
+				return result_register;
+			}
+			return -1;
+		}
+		case EidosTokenType::kTokenIdentifier:
+		{
+			int result_register = _Emit(EidosBytecodeOp::kLoadSymbol, 0, 0);
+			
+			if (result_register != -1)
+				instructions_[result_register].operand_.symbol_node_ = p_node;
+			return result_register;
+		}
+		case EidosTokenType::kTokenMinus:
+		case EidosTokenType::kTokenNot:
+		{
+			if (child_count == 1)
+			{
+				int operand_register = _CompileNode(children[0], p_operation_count);
+				
+				if (operand_register == -1)
+					return -1;
+				
+				++(*p_operation_count);
+				return _Emit((p_node->token_->token_type_ == EidosTokenType::kTokenNot) ? EidosBytecodeOp::kNot : EidosBytecodeOp::kNegate, operand_register, 0);
+			}
+			if (p_node->token_->token_type_ == EidosTokenType::kTokenNot)
+				return -1;
+			op = EidosBytecodeOp::kSubtract;
+			break;
+		}
+		case EidosTokenType::kTokenAnd:
+		case EidosTokenType::kTokenOr:
+		{
+			// & and | take any number of operands; since singleton logicals are all we handle, we can chain them pairwise
+			op = ((p_node->token_->token_type_ == EidosTokenType::kTokenAnd) ? EidosBytecodeOp::kAnd : EidosBytecodeOp::kOr);
+			
+			if (child_count < 2)
+				return -1;
+			
+			int result_register = _CompileNode(children[0], p_operation_count);
+			
+			for (size_t child_index = 1; child_index < child_count; ++child_index)
+			{
+				if (result_register == -1)
+					return -1;
+				
+				int operand_register = _CompileNode(children[child_index], p_operation_count);
+				
+				if (operand_register == -1)
+					return -1;
+				
+				++(*p_operation_count);
+				result_register = _Emit(op, result_register, operand_register);
+			}
+			return result_register;
+		}
+		case EidosTokenType::kTokenPlus:	op = EidosBytecodeOp::kAdd;			break;		// unary + is not compiled; it returns its operand as-is
+		case EidosTokenType::kTokenMult:	op = EidosBytecodeOp::kMultiply;	break;
+		case EidosTokenType::kTokenDiv:		op = EidosBytecodeOp::kDivide;		break;
+		case EidosTokenType::kTokenMod:		op = EidosBytecodeOp::kModulo;		break;
+		case EidosTokenType::kTokenExp:		op = EidosBytecodeOp::kExponent;	break;
+		case EidosTokenType::kTokenEq:		op = EidosBytecodeOp::kEq;			break;
+		case EidosTokenType::kTokenNotEq:	op = EidosBytecodeOp::kNotEq;		break;
+		case EidosTokenType::kTokenLt:		op = EidosBytecodeOp::kLt;			break;
+		case EidosTokenType::kTokenLtEq:	op = EidosBytecodeOp::kLtEq;		break;
+		case EidosTokenType::kTokenGt:		op = EidosBytecodeOp::kGt;			break;
+		case EidosTokenType::kTokenGtEq:	op = EidosBytecodeOp::kGtEq;		break;
+		default:
+			return -1;
+	}
+	
+	// binary operators
+	if (child_count != 2)
+		return -1;
+	
+	int first_register = _CompileNode(children[0], p_operation_count);
+	
+	if (first_register == -1)
+		return -1;
+	
+	int second_register = _CompileNode(children[1], p_operation_count);
+	
+	if (second_register == -1)
+		return -1;
+	
+	++(*p_operation_count);
+	return _Emit(op, first_register, second_register);
+}
+
+// Three-way comparison of two numeric registers, promoting to float if either is float; this must match CompareEidosValues()
+static inline __attribute__((always_inline)) int _CompareNumericRegisters(const EidosBytecodeRegister &p_first, const EidosBytecodeRegister &p_second)
+{
+	if ((p_first.type_ == EidosValueType::kValueInt) && (p_second.type_ == EidosValueType::kValueInt))
+		return (p_first.int_ < p_second.int_) ? -1 : ((p_first.int_ > p_second.int_) ? 1 : 0);
+	
+	double float1 = ((p_first.type_ == EidosValueType::kValueInt) ? (double)p_first.int_ : p_first.float_);
+	double float2 = ((p_second.type_ == EidosValueType::kValueInt) ? (double)p_second.int_ : p_second.float_);
+	
+	return (float1 < float2) ? -1 : ((float1 > float2) ? 1 : 0);
+}
+
+static inline __attribute__((always_inline)) double _FloatFromNumericRegister(const EidosBytecodeRegister &p_register)
+{
+	return ((p_register.type_ == EidosValueType::kValueInt) ? (double)p_register.int_ : p_register.float_);
+}
+
+bool EidosBytecode::Execute(const EidosSymbolTable &p_symbols, EidosValue_SP &p_result) const
+{
+	EidosBytecodeRegister registers[EIDOS_BYTECODE_MAXIMUM_LENGTH];
+	const EidosBytecodeInstruction *instructions = instructions_.data();
+	size_t instruction_count = instructions_.size();
+	
+	for (size_t instruction_index = 0; instruction_index < instruction_count; ++instruction_index)
+	{
+		const EidosBytecodeInstruction &instruction = instructions[instruction_index];
+		EidosBytecodeRegister &result = registers[instruction_index];
+		const EidosBytecodeRegister &first = registers[instruction.first_];
+		const EidosBytecodeRegister &second = registers[instruction.second_];
+		
+		// Registers only ever hold logical, int, or float values, so "not logical" means numeric below
+		switch (instruction.op_)
+		{
+			case EidosBytecodeOp::kLoadInt:
+				result.type_ = EidosValueType::kValueInt;
+				result.int_ = instruction.operand_.int_;
+				break;
+			case EidosBytecodeOp::kLoadFloat:
+				result.type_ = EidosValueType::kValueFloat;
+				result.float_ = instruction.operand_.float_;
+				break;
+			case EidosBytecodeOp::kLoadSymbol:
+			{
+				EidosValue *value = p_symbols.GetValuePointerOrNullForASTNode(instruction.operand_.symbol_node_);
+				
+				if (!value || (value->Count() != 1) || (value->DimensionCount() != 1))
+					return false;
+				
+				EidosValueType value_type = value->Type();
+				
+				if (value_type == EidosValueType::kValueInt)
+					result.int_ = (value->IsSingleton() ? static_cast<EidosValue_Int_singleton *>(value)->IntValue() : value->IntAtIndex(0, nullptr));
+				else if (value_type == EidosValueType::kValueFloat)
+					result.float_ = (value->IsSingleton() ? static_cast<EidosValue_Float_singleton *>(value)->FloatValue() : value->FloatAtIndex(0, nullptr));
+				else if (value_type == EidosValueType::kValueLogical)
+					result.logical_ = value->LogicalAtIndex(0, nullptr);
+				else
+					return false;
+				
+				result.type_ = value_type;
+				break;
+			}
+			case EidosBytecodeOp::kAdd:
+			case EidosBytecodeOp::kSubtract:
+			case EidosBytecodeOp::kMultiply:
+			{
+				if ((first.type_ == EidosValueType::kValueInt) && (second.type_ == EidosValueType::kValueInt))
+				{
+					// integer overflow is left to the interpreter to diagnose
+					bool overflow;
+					
+					if (instruction.op_ == EidosBytecodeOp::kAdd)
+						overflow = Eidos_add_overflow(first.int_, second.int_, &result.int_);
+					else if (instruction.op_ == EidosBytecodeOp::kSubtract)
+						overflow = Eidos_sub_overflow(first.int_, second.int_, &result.int_);
+					else
+						overflow = Eidos_mul_overflow(first.int_, second.int_, &result.int_);
+					
+					if (overflow)
+						return false;
+					
+					result.type_ = EidosValueType::kValueInt;
+				}
+				else
+				{
+					if ((first.type_ == EidosValueType::kValueLogical) || (second.type_ == EidosValueType::kValueLogical))
+						return false;
+					
+					double float1 = _FloatFromNumericRegister(first);
+					double float2 = _FloatFromNumericRegister(second);
+					
+					if (instruction.op_ == EidosBytecodeOp::kAdd)
+						result.float_ = float1 + float2;
+					else if (instruction.op_ == EidosBytecodeOp::kSubtract)
+						result.float_ = float1 - float2;
+					else
+						result.float_ = float1 * float2;
+					
+					result.type_ = EidosValueType::kValueFloat;
+				}
+				break;
+			}
+			case EidosBytecodeOp::kDivide:
+			case EidosBytecodeOp::kModulo:
+			case EidosBytecodeOp::kExponent:
+			{
+				// these operators always produce float, as in the interpreter
+				if ((first.type_ == EidosValueType::kValueLogical) || (second.type_ == EidosValueType::kValueLogical))
+					return false;
+				
+				double float1 = _FloatFromNumericRegister(first);
+				double float2 = _FloatFromNumericRegister(second);
+				
+				if (instruction.op_ == EidosBytecodeOp::kDivide)
+					result.float_ = float1 / float2;
+				else if (instruction.op_ == EidosBytecodeOp::kModulo)
+					result.float_ = fmod(float1, float2);
+				else
+					result.float_ = pow(float1, float2);
+				
+				result.type_ = EidosValueType::kValueFloat;
+				break;
+			}
+			case EidosBytecodeOp::kNegate:
+			{
+				if (first.type_ == EidosValueType::kValueInt)
+				{
+					if (Eidos_sub_overflow((int64_t)0, first.int_, &result.int_))
+						return false;
+				}
+				else if (first.type_ == EidosValueType::kValueFloat)
+					result.float_ = -first.float_;
+				else
+					return false;
+				
+				result.type_ = first.type_;
+				break;
+			}
+			case EidosBytecodeOp::kEq:
+			case EidosBytecodeOp::kNotEq:
+			case EidosBytecodeOp::kLt:
+			case EidosBytecodeOp::kLtEq:
+			case EidosBytecodeOp::kGt:
+			case EidosBytecodeOp::kGtEq:
+			{
+				// comparisons involving logical are legal, but are left to the interpreter
+				if ((first.type_ == EidosValueType::kValueLogical) || (second.type_ == EidosValueType::kValueLogical))
+					return false;
+				
+				int compare_result = _CompareNumericRegisters(first, second);
+				
+				switch (instruction.op_)
+				{
+					case EidosBytecodeOp::kEq:		result.logical_ = (compare_result == 0);	break;
+					case EidosBytecodeOp::kNotEq:	result.logical_ = (compare_result != 0);	break;
+					case EidosBytecodeOp::kLt:		result.logical_ = (compare_result == -1);	break;
+					case EidosBytecodeOp::kLtEq:	result.logical_ = (compare_result != 1);	break;
+					case EidosBytecodeOp::kGt:		result.logical_ = (compare_result == 1);	break;
+					default:						result.logical_ = (compare_result != -1);	break;
+				}
+				
+				result.type_ = EidosValueType::kValueLogical;
+				break;
+			}
+			case EidosBytecodeOp::kAnd:
+			case EidosBytecodeOp::kOr:
+			{
+				if ((first.type_ != EidosValueType::kValueLogical) || (second.type_ != EidosValueType::kValueLogical))
+					return false;
+				
+				if (instruction.op_ == EidosBytecodeOp::kAnd)
+					result.logical_ = (first.logical_ && second.logical_);
+				else
+					result.logical_ = (first.logical_ || second.logical_);
+				
+				result.type_ = EidosValueType::kValueLogical;
+				break;
+			}
+			case EidosBytecodeOp::kNot:
+			{
+				if (first.type_ != EidosValueType::kValueLogical)
+					return false;
+				
+				result.logical_ = !first.logical_;
+				result.type_ = EidosValueType::kValueLogical;
+				break;
+			}
+		}
+	}
+	
+	// Box the final result exactly as the interpreter would for a singleton without dimensions
+	const EidosBytecodeRegister &final_register = registers[instruction_count - 1];
+	
+	if (final_register.type_ == EidosValueType::kValueFloat)
+		p_result = EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Float_singleton(final_register.float_));
+	else if (final_register.type_ == EidosValueType::kValueInt)
+		p_result = EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(final_register.int_));
+	else
+		p_result = (final_register.logical_ ? gStaticEidosValue_LogicalT : gStaticEidosValue_LogicalF);
+	
+	return true;
+}
+
+#endif	// EIDOS_BYTECODE
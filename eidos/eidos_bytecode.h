@@ -0,0 +1,149 @@
+//
+//  eidos_bytecode.h
+//  Eidos
+//
+//  Created by Ben Haller on 10/17/17.
+//  Copyright (c) 2017 Philipp Messer.  All rights reserved.
+//	A product of the Messer Lab, http://messerlab.org/slim/
+//
+
+//	This file is part of Eidos.
+//
+//	Eidos is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+//
+//	Eidos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License along with Eidos.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+
+ EidosBytecode is a small register-machine compilation of an arithmetic/logical expression subtree.  The tree-walking
+ interpreter evaluates an expression like (a * b + c) / d by dispatching through every node and boxing every intermediate
+ result in a pooled, refcounted EidosValue.  When such an expression is applied to singleton int/float/logical values, which
+ is the overwhelmingly common case in loops and callbacks, almost all of that work is overhead.  A compiled subtree instead
+ runs as a flat list of instructions over unboxed registers, and boxes only its final result.
+
+ The compiler is deliberately conservative.  It accepts only maximal subtrees built from numeric constants, identifiers,
+ and the arithmetic, comparison, and logical operators, none of which have side effects.  At runtime, any value the
+ bytecode does not handle itself – a non-singleton, a matrix/array, a string/object/NULL, an undefined identifier, an integer
+ overflow – makes it bail out, and the subtree is then re-evaluated by the interpreter from scratch.  The interpreter thus
+ remains the reference implementation: it produces all results that the bytecode does not, and all errors and their
+ messages.  A compiled subtree that bails more often than not is reverted to the interpreter permanently.
+
+ */
+
+#ifndef __Eidos__eidos_bytecode__
+#define __Eidos__eidos_bytecode__
+
+#include "eidos_ast_node.h"
+
+#include <vector>
+
+
+class EidosSymbolTable;
+
+
+// If EIDOS_BYTECODE is 1, EidosASTNode::OptimizeTree() compiles suitable expression subtrees to bytecode when
+// gEidosBytecodeEnabled is true; if it is 0, the compiler is not built and all evaluation uses the interpreter.
+#ifndef EIDOS_BYTECODE
+#define EIDOS_BYTECODE	1
+#endif
+
+// Subtrees with fewer operators than this are left to the interpreter, since the savings would not pay for a
+// bailout; subtrees with more instructions than this are not compiled as a whole (their children may be).
+#define EIDOS_BYTECODE_MINIMUM_OPERATIONS	2
+#define EIDOS_BYTECODE_MAXIMUM_LENGTH		64
+
+// The number of bailouts after which a compiled subtree that bails more often than it succeeds is reverted
+#define EIDOS_BYTECODE_BAILOUT_LIMIT		16
+
+#if EIDOS_BYTECODE
+
+// Checked at parse time; scripts parsed while this is false are evaluated entirely by the interpreter
+extern bool gEidosBytecodeEnabled;
+
+
+enum class EidosBytecodeOp : uint8_t {
+	kLoadInt = 0,
+	kLoadFloat,
+	kLoadSymbol,
+	kAdd,
+	kSubtract,
+	kMultiply,
+	kDivide,
+	kModulo,
+	kExponent,
+	kNegate,
+	kEq,
+	kNotEq,
+	kLt,
+	kLtEq,
+	kGt,
+	kGtEq,
+	kAnd,
+	kOr,
+	kNot
+};
+
+// Each instruction writes the register with the same index as the instruction; operands are earlier registers
+typedef struct {
+	EidosBytecodeOp op_;
+	uint8_t first_;
+	uint8_t second_;
+	union {
+		int64_t int_;
+		double float_;
+		const EidosASTNode *symbol_node_;		// the identifier node, for its symbol and slot hint; owned by the tree, like the bytecode
+	} operand_;
+} EidosBytecodeInstruction;
+
+typedef struct {
+	EidosValueType type_;				// kValueLogical, kValueInt, or kValueFloat
+	union {
+		eidos_logical_t logical_;
+		int64_t int_;
+		double float_;
+	};
+} EidosBytecodeRegister;
+
+
+class EidosBytecode
+{
+	//	This class has its copy constructor and assignment operator disabled, to prevent accidental copying.
+	
+private:
+	
+	std::vector<EidosBytecodeInstruction> instructions_;
+	
+	int64_t bailout_count_ = 0;
+	int64_t success_count_ = 0;
+	
+	int _CompileNode(const EidosASTNode *p_node, int *p_operation_count);	// returns the result register, or -1
+	int _Emit(EidosBytecodeOp p_op, int p_first, int p_second);
+	
+public:
+	
+	EidosEvaluationMethod fallback_evaluator_;		// the evaluator of the root node, used when the bytecode bails
+	
+	EidosBytecode(const EidosBytecode&) = delete;					// no copying
+	EidosBytecode& operator=(const EidosBytecode&) = delete;		// no copying
+	EidosBytecode(void) = delete;									// no null construction
+	explicit EidosBytecode(EidosEvaluationMethod p_fallback_evaluator) : fallback_evaluator_(p_fallback_evaluator) {}
+	
+	// Returns a new EidosBytecode for the subtree at p_node, or nullptr if it is not compilable or not worth compiling
+	static EidosBytecode *CompileSubtree(const EidosASTNode *p_node);
+	
+	// Returns true and sets p_result if the bytecode handled the evaluation; returns false if the interpreter must evaluate
+	bool Execute(const EidosSymbolTable &p_symbols, EidosValue_SP &p_result) const;
+	
+	// Called after Execute() returns false; returns true if the subtree should be reverted to the interpreter
+	inline __attribute__((always_inline)) bool NoteBailout(void) { return ((++bailout_count_ >= EIDOS_BYTECODE_BAILOUT_LIMIT) && (bailout_count_ > success_count_)); }
+	inline __attribute__((always_inline)) void NoteSuccess(void) { ++success_count_; }
+};
+
+#endif	// EIDOS_BYTECODE
+
+
+#endif /* defined(__Eidos__eidos_bytecode__) */
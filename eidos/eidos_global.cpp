@@ -25,6 +25,7 @@
 #include "eidos_object_pool.h"
 #include "eidos_ast_node.h"
 #include "eidos_test_element.h"
+#include "eidos_openmp.h"
 
 #include <stdlib.h>
 #include <execinfo.h>
@@ -57,6 +58,8 @@
 
 bool eidos_do_memory_checks = true;
 
+int gEidosMaxThreads = 1;
+
 EidosSymbolTable *gEidosConstantsSymbolTable = nullptr;
 
 
@@ -64,7 +67,7 @@ EidosSymbolTable *gEidosConstantsSymbolTable = nullptr;
 #pragma mark Profiling support
 #pragma mark -
 
-#if ((defined(SLIMGUI) && (SLIMPROFILING == 1)) || defined(EIDOS_GUI))
+#if ((SLIMPROFILING == 1) || defined(EIDOS_GUI))
 // PROFILING
 
 int gEidosProfilingClientCount = 0;
@@ -75,6 +78,8 @@ double gEidos_ProfileOverheadSeconds;
 double gEidos_ProfileLagTicks;
 double gEidos_ProfileLagSeconds;
 
+#if defined(__APPLE__)
+
 #include <mach/mach.h>
 #include <mach/mach_time.h>
 
@@ -102,6 +107,18 @@ double Eidos_ElapsedProfileTime(uint64_t p_elapsed_profile_time)
 	return p_elapsed_profile_time * timebaseRatio;
 }
 
+#else
+
+double Eidos_ElapsedProfileTime(uint64_t p_elapsed_profile_time)
+{
+	// Eidos_ProfileTime() returns a count of std::chrono::steady_clock ticks here; the tick period is known at compile time
+	static const double timebaseRatio = std::chrono::steady_clock::period::num / (double)std::chrono::steady_clock::period::den;
+	
+	return p_elapsed_profile_time * timebaseRatio;
+}
+
+#endif
+
 static eidos_profile_t gEidos_ProfilePrep_Ticks;
 
 void Eidos_PrepareForProfiling(void)
@@ -27,8 +27,16 @@
 #include <vector>
 #include <string>
 
-#if ((defined(SLIMGUI) && (SLIMPROFILING == 1)) || defined(EIDOS_GUI))
-#include <mach/mach_time.h>		// for mach_absolute_time(), for profiling; needed only in SLiMgui and the Eidos GUI (the latter for the timing test code)
+// SLIMPROFILING enables the profiling code.  SLiMgui defines it to 1 in its build settings; the command-line tools leave it
+// out by default, since it adds overhead to every profiled block, but it can be compiled in for the -profile option of slim
+// by passing -DSLIMPROFILING=1 to the compiler (with make, PROFILING=-DSLIMPROFILING=1).
+
+#if ((SLIMPROFILING == 1) || defined(EIDOS_GUI))
+#if defined(__APPLE__)
+#include <mach/mach_time.h>		// for mach_absolute_time(), for profiling; also used by the timing test code in the Eidos GUI
+#else
+#include <chrono>				// for std::chrono::steady_clock, for profiling on platforms without mach_absolute_time()
+#endif
 #endif
 
 class EidosScript;
@@ -135,16 +143,16 @@ void Eidos_CheckRSSAgainstMax(std::string p_message1, std::string p_message2);
 #pragma mark Profiling support
 #pragma mark -
 
-#if ((defined(SLIMGUI) && (SLIMPROFILING == 1)) || defined(EIDOS_GUI))
+#if ((SLIMPROFILING == 1) || defined(EIDOS_GUI))
 // PROFILING
 
 extern int gEidosProfilingClientCount;	// if non-zero, profiling is happening in some context
 
 // Profiling clocks; note that these can overflow, we don't care, only (t2-t1) ever matters and that is overflow-robust
 
-// This is the fastest clock, is available across OS X versions, and gives us nanoseconds.  The only disadvantage to
-// it is that it is platform-specific, so we can only use this clock in SLiMgui and Eidos_GUI.  That is OK.  This
-// returns uint64_t in CPU-specific time units; see https://developer.apple.com/library/content/qa/qa1398/_index.html
+// On OS X we use mach_absolute_time(), which is the fastest clock, is available across OS X versions, and gives us
+// nanoseconds; it returns uint64_t in CPU-specific time units, see https://developer.apple.com/library/content/qa/qa1398/_index.html
+// Elsewhere we use std::chrono::steady_clock, which is monotonic and high-resolution (clock_gettime() on Linux).
 typedef uint64_t eidos_profile_t;
 
 extern uint64_t gEidos_ProfileCounter;			// incremented by Eidos_ProfileTime() every time it is called
@@ -154,7 +162,11 @@ extern double gEidos_ProfileLagTicks;			// the clocked length of an empty profil
 extern double gEidos_ProfileLagSeconds;			// the clocked length of an empty profile block, in seconds
 
 // Get a profile clock measurement, to be used as a start or end time
+#if defined(__APPLE__)
 inline eidos_profile_t Eidos_ProfileTime(void) { gEidos_ProfileCounter++; return mach_absolute_time(); }
+#else
+inline eidos_profile_t Eidos_ProfileTime(void) { gEidos_ProfileCounter++; return (eidos_profile_t)std::chrono::steady_clock::now().time_since_epoch().count(); }
+#endif
 
 // Convert an elapsed profiling time (the difference between two Eidos_ProfileTime() results) to seconds
 double Eidos_ElapsedProfileTime(uint64_t p_elapsed_profile_time);
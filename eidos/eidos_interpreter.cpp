@@ -23,6 +23,7 @@
 #include "eidos_ast_node.h"
 #include "eidos_rng.h"
 #include "eidos_call_signature.h"
+#include "eidos_bytecode.h"
 
 #include <sstream>
 #include <stdexcept>
@@ -269,14 +270,14 @@ EidosValue_SP EidosInterpreter::EvaluateInterpreterBlock(bool p_print_output)
 	
 	for (EidosASTNode *child_node : root_node_->children_)
 	{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 		SLIM_PROFILE_BLOCK_START();
 #endif
 		
 		result_SP = FastEvaluateNode(child_node);
 		
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 		SLIM_PROFILE_BLOCK_END(child_node->profile_total_);
 #endif
@@ -654,7 +655,7 @@ void EidosInterpreter::_ProcessSubsetAssignment(EidosValue_SP *p_base_value_ptr,
 				identifier_value_SP = identifier_value->VectorBasedCopy();
 				identifier_value = identifier_value_SP.get();
 				
-				global_symbols_->SetValueForSymbolNoCopy(p_parent_node->cached_stringID_, identifier_value_SP);
+				global_symbols_->SetValueForASTNodeNoCopy(p_parent_node, identifier_value_SP);
 			}
 			
 			*p_base_value_ptr = std::move(identifier_value_SP);
@@ -811,7 +812,7 @@ void EidosInterpreter::_AssignRValueToLValue(EidosValue_SP p_rvalue, const Eidos
 			EIDOS_ASSERT_CHILD_COUNT_X(p_lvalue_node, "identifier", "EidosInterpreter::_AssignRValueToLValue", 0, nullptr);
 			
 			// Simple identifier; the symbol host is the global symbol table, at least for now
-			global_symbols_->SetValueForSymbol(p_lvalue_node->cached_stringID_, std::move(p_rvalue));
+			global_symbols_->SetValueForASTNode(p_lvalue_node, std::move(p_rvalue));
 			break;
 		}
 		default:
@@ -884,14 +885,14 @@ EidosValue_SP EidosInterpreter::Evaluate_CompoundStatement(const EidosASTNode *p
 	
 	for (EidosASTNode *child_node : p_node->children_)
 	{
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 		SLIM_PROFILE_BLOCK_START();
 #endif
 		
 		result_SP = FastEvaluateNode(child_node);
 		
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 		SLIM_PROFILE_BLOCK_END(child_node->profile_total_);
 #endif
@@ -935,11 +936,15 @@ EidosValue_SP EidosInterpreter::_Evaluate_RangeExpr_Internal(const EidosASTNode
 		int64_t first_int = p_first_child_value.IntAtIndex(0, operator_token);
 		int64_t second_int = p_second_child_value.IntAtIndex(0, operator_token);
 		
+		// Ranges consumed directly by for loops and subsets are never constructed, so this limit applies only to ranges that
+		// are actually built in memory; the span is computed with an overflow check since the operands are arbitrary
+		int64_t range_span;
+		
+		if (Eidos_sub_overflow((first_int <= second_int) ? second_int : first_int, (first_int <= second_int) ? first_int : second_int, &range_span) || (range_span + 1 >= 10000000))
+			EIDOS_TERMINATION << "ERROR (EidosInterpreter::_Evaluate_RangeExpr_Internal): a range with more than 10000000 entries cannot be constructed." << EidosTerminate(operator_token);
+		
 		if (first_int <= second_int)
 		{
-			if (second_int - first_int + 1 >= 10000000)
-				EIDOS_TERMINATION << "ERROR (EidosInterpreter::_Evaluate_RangeExpr_Internal): a range with more than 10000000 entries cannot be constructed." << EidosTerminate(operator_token);
-			
 			EidosValue_Int_vector_SP int_result_SP = EidosValue_Int_vector_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_vector());
 			EidosValue_Int_vector *int_result = int_result_SP->resize_no_initialize((int)(second_int - first_int + 1));
 			
@@ -950,9 +955,6 @@ EidosValue_SP EidosInterpreter::_Evaluate_RangeExpr_Internal(const EidosASTNode
 		}
 		else
 		{
-			if (first_int - second_int + 1 >= 10000000)
-				EIDOS_TERMINATION << "ERROR (EidosInterpreter::_Evaluate_RangeExpr_Internal): a range with more than 10000000 entries cannot be constructed." << EidosTerminate(operator_token);
-			
 			EidosValue_Int_vector_SP int_result_SP = EidosValue_Int_vector_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_vector());
 			EidosValue_Int_vector *int_result = int_result_SP->resize_no_initialize((int)(first_int - second_int + 1));
 			
@@ -1504,6 +1506,32 @@ EidosValue_SP EidosInterpreter::Evaluate_Subset(const EidosASTNode *p_node)
 	// organize our subset arguments
 	int child_count = (int)p_node->children_.size();
 	std::vector <EidosValue_SP> subset_indices;
+	EidosValue_SP range_index_value;
+	
+	// A vector subset by a non-constant integer range, x[a:b], is common enough (and its ranges large enough) that we take the
+	// elements directly instead of constructing the range; if the range turns out not to be int:int, we construct it here,
+	// since its operands have already been evaluated (and might have side effects), and the general code below uses it
+	if ((child_count == 2) && (first_child_dim_count == 1) && (first_child_type != EidosValueType::kValueNULL))
+	{
+		const EidosASTNode *range_node = p_node->children_[1];
+		
+		if ((range_node->token_->token_type_ == EidosTokenType::kTokenColon) && (range_node->children_.size() == 2) && !range_node->cached_value_)
+		{
+			EidosValue_SP range_start_value = FastEvaluateNode(range_node->children_[0]);
+			EidosValue_SP range_end_value = FastEvaluateNode(range_node->children_[1]);
+			
+			if ((range_start_value->Type() == EidosValueType::kValueInt) && (range_start_value->Count() == 1) && (range_start_value->DimensionCount() == 1) &&
+				(range_end_value->Type() == EidosValueType::kValueInt) && (range_end_value->Count() == 1) && (range_end_value->DimensionCount() == 1))
+			{
+				result_SP = _Evaluate_Subset_IntegerRange(*first_child_value, range_start_value->IntAtIndex(0, nullptr), range_end_value->IntAtIndex(0, nullptr), operator_token);
+				
+				EIDOS_EXIT_EXECUTION_LOG("Evaluate_Subset()");
+				return result_SP;
+			}
+			
+			range_index_value = _Evaluate_RangeExpr_Internal(range_node, *range_start_value, *range_end_value);
+		}
+	}
 	
 	for (int child_index = 1; child_index < child_count; ++child_index)
 	{
@@ -1518,7 +1546,7 @@ EidosValue_SP EidosInterpreter::Evaluate_Subset(const EidosASTNode *p_node)
 		else
 		{
 			// We have an expression node, so we evaluate it, check the value, and save it
-			EidosValue_SP child_value = FastEvaluateNode(subset_index_node);
+			EidosValue_SP child_value = (range_index_value ? range_index_value : FastEvaluateNode(subset_index_node));
 			EidosValueType child_type = child_value->Type();
 			
 			if ((child_type != EidosValueType::kValueInt) && (child_type != EidosValueType::kValueFloat) && (child_type != EidosValueType::kValueLogical) && (child_type != EidosValueType::kValueNULL))
@@ -1964,6 +1992,78 @@ EidosValue_SP EidosInterpreter::Evaluate_Subset(const EidosASTNode *p_node)
 	return result_SP;
 }
 
+// This handles x[a:b] for a vector x and integer a and b, taking the elements directly rather than constructing the vector
+// of indices that a:b would produce; the result, and any out-of-range error, are the same as for the constructed range
+EidosValue_SP EidosInterpreter::_Evaluate_Subset_IntegerRange(const EidosValue &p_value, int64_t p_first_index, int64_t p_last_index, EidosToken *p_operator_token)
+{
+	int value_count = p_value.Count();
+	bool counting_up = (p_first_index <= p_last_index);
+	
+	// find the first out-of-range index in the order that the range would produce them, for the error message
+	if ((p_first_index < 0) || (p_first_index >= value_count))
+		EIDOS_TERMINATION << "ERROR (EidosInterpreter::Evaluate_Subset): out-of-range index " << p_first_index << " used with the '[]' operator." << EidosTerminate(p_operator_token);
+	if (counting_up && (p_last_index >= value_count))
+		EIDOS_TERMINATION << "ERROR (EidosInterpreter::Evaluate_Subset): out-of-range index " << value_count << " used with the '[]' operator." << EidosTerminate(p_operator_token);
+	if (!counting_up && (p_last_index < 0))
+		EIDOS_TERMINATION << "ERROR (EidosInterpreter::Evaluate_Subset): out-of-range index " << -1 << " used with the '[]' operator." << EidosTerminate(p_operator_token);
+	
+	// both ends are now within [0, value_count), so the arithmetic below is safe
+	int first_index = (int)p_first_index;
+	int step = (counting_up ? 1 : -1);
+	int result_count = (counting_up ? (int)(p_last_index - p_first_index) : (int)(p_first_index - p_last_index)) + 1;
+	
+	// a singleton index returns a singleton value, as with any singleton subscript
+	if (result_count == 1)
+		return p_value.GetValueAtIndex(first_index, p_operator_token);
+	
+	EidosValueType value_type = p_value.Type();
+	
+	if (value_type == EidosValueType::kValueInt)
+	{
+		const int64_t *value_data = p_value.IntVector()->data();
+		EidosValue_Int_vector_SP int_result_SP = EidosValue_Int_vector_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_vector());
+		EidosValue_Int_vector *int_result = int_result_SP->resize_no_initialize(result_count);
+		
+		for (int result_index = 0; result_index < result_count; ++result_index)
+			int_result->set_int_no_check(value_data[first_index + result_index * step], result_index);
+		
+		return std::move(int_result_SP);
+	}
+	else if (value_type == EidosValueType::kValueFloat)
+	{
+		const double *value_data = p_value.FloatVector()->data();
+		EidosValue_Float_vector_SP float_result_SP = EidosValue_Float_vector_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Float_vector());
+		EidosValue_Float_vector *float_result = float_result_SP->resize_no_initialize(result_count);
+		
+		for (int result_index = 0; result_index < result_count; ++result_index)
+			float_result->set_float_no_check(value_data[first_index + result_index * step], result_index);
+		
+		return std::move(float_result_SP);
+	}
+	else if (value_type == EidosValueType::kValueObject)
+	{
+		EidosObjectElement * const *value_data = p_value.ObjectElementVector()->data();
+		EidosValue_Object_vector_SP obj_result_SP = EidosValue_Object_vector_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Object_vector(((const EidosValue_Object &)p_value).Class()));
+		EidosValue_Object_vector *obj_result = obj_result_SP->resize_no_initialize(result_count);
+		
+		for (int result_index = 0; result_index < result_count; ++result_index)
+			obj_result->set_object_element_no_check(value_data[first_index + result_index * step], result_index);
+		
+		return std::move(obj_result_SP);
+	}
+	else
+	{
+		// logical and string values take the simple path using NewMatchingType() / PushValueFromIndexOfEidosValue()
+		EidosValue_SP result_SP = p_value.NewMatchingType();
+		EidosValue *result = result_SP.get();
+		
+		for (int result_index = 0; result_index < result_count; ++result_index)
+			result->PushValueFromIndexOfEidosValue(first_index + result_index * step, p_value, p_operator_token);
+		
+		return result_SP;
+	}
+}
+
 EidosValue_SP EidosInterpreter::Evaluate_MemberRef(const EidosASTNode *p_node)
 {
 	EIDOS_ENTRY_EXECUTION_LOG("Evaluate_MemberRef()");
@@ -4986,14 +5086,14 @@ EidosValue_SP EidosInterpreter::Evaluate_If(const EidosASTNode *p_node)
 		// Handle a static singleton logical true super fast; no need for type check, count, etc
 		EidosASTNode *true_node = p_node->children_[1];
 		
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 		SLIM_PROFILE_BLOCK_START_CONDITION(true_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 		
 		result_SP = FastEvaluateNode(true_node);
 		
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 		SLIM_PROFILE_BLOCK_END_CONDITION(true_node->profile_total_);
 #endif
@@ -5005,14 +5105,14 @@ EidosValue_SP EidosInterpreter::Evaluate_If(const EidosASTNode *p_node)
 		{
 			EidosASTNode *false_node = p_node->children_[2];
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 			SLIM_PROFILE_BLOCK_START_CONDITION(false_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 			
 			result_SP = FastEvaluateNode(false_node);
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_END_CONDITION(false_node->profile_total_);
 #endif
@@ -5030,14 +5130,14 @@ EidosValue_SP EidosInterpreter::Evaluate_If(const EidosASTNode *p_node)
 		{
 			EidosASTNode *true_node = p_node->children_[1];
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 			SLIM_PROFILE_BLOCK_START_CONDITION(true_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 			
 			result_SP = FastEvaluateNode(true_node);
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_END_CONDITION(true_node->profile_total_);
 #endif
@@ -5046,14 +5146,14 @@ EidosValue_SP EidosInterpreter::Evaluate_If(const EidosASTNode *p_node)
 		{
 			EidosASTNode *false_node = p_node->children_[2];
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 			SLIM_PROFILE_BLOCK_START_CONDITION(false_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 			
 			result_SP = FastEvaluateNode(false_node);
 			
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 			// PROFILING
 			SLIM_PROFILE_BLOCK_END_CONDITION(false_node->profile_total_);
 #endif
@@ -5085,14 +5185,14 @@ EidosValue_SP EidosInterpreter::Evaluate_Do(const EidosASTNode *p_node)
 		// execute the do...while loop's statement by evaluating its node; evaluation values get thrown away
 		EidosASTNode *statement_node = p_node->children_[0];
 		
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 		SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 		
 		EidosValue_SP statement_value = FastEvaluateNode(statement_node);
 		
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 		SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
 #endif
@@ -5186,14 +5286,14 @@ EidosValue_SP EidosInterpreter::Evaluate_While(const EidosASTNode *p_node)
 		// execute the while loop's statement by evaluating its node; evaluation values get thrown away
 		EidosASTNode *statement_node = p_node->children_[1];
 		
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 		SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 		
 		EidosValue_SP statement_value = FastEvaluateNode(statement_node);
 		
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 		// PROFILING
 		SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
 #endif
@@ -5256,70 +5356,68 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 	uint8_t assigns_index = p_node->cached_for_assigns_index_;
 	
 	// In some cases we do not need to actually construct the range that we are going to iterate over; we check for that case here
-	// and handle it immediately, otherwise we drop through to the (!simpleIntegerRange) case below
+	// and handle it immediately, otherwise we drop through to the (!simpleIntegerRange) case below.  This is done whether or not
+	// the loop assigns to its index variable, so that a loop like for (i in 0:(N-1)) never allocates or fills N integers.
 	bool simpleIntegerRange = false;
 	int64_t start_int = 0, end_int = 0;
 	EidosValue_SP range_value(nullptr);
 	
-	if (!assigns_index)
+	if ((range_node->token_->token_type_ == EidosTokenType::kTokenColon) && (range_node->children_.size() == 2))
 	{
-		if ((range_node->token_->token_type_ == EidosTokenType::kTokenColon) && (range_node->children_.size() == 2))
+		// Maybe we can streamline a colon-operator range expression; let's check
+		if (!range_node->cached_value_)
 		{
-			// Maybe we can streamline a colon-operator range expression; let's check
-			if (!range_node->cached_value_)
+			EidosValue_SP range_start_value_SP = FastEvaluateNode(range_node->children_[0]);
+			EidosValue *range_start_value = range_start_value_SP.get();
+			EidosValue_SP range_end_value_SP = FastEvaluateNode(range_node->children_[1]);
+			EidosValue *range_end_value = range_end_value_SP.get();
+			
+			if ((range_start_value->Type() == EidosValueType::kValueInt) && (range_start_value->Count() == 1) && (range_start_value->DimensionCount() == 1) &&
+				(range_end_value->Type() == EidosValueType::kValueInt) && (range_end_value->Count() == 1) && (range_end_value->DimensionCount() == 1))
 			{
-				EidosValue_SP range_start_value_SP = FastEvaluateNode(range_node->children_[0]);
-				EidosValue *range_start_value = range_start_value_SP.get();
-				EidosValue_SP range_end_value_SP = FastEvaluateNode(range_node->children_[1]);
-				EidosValue *range_end_value = range_end_value_SP.get();
+				// OK, we have a simple integer:integer range, so this should be very straightforward
+				simpleIntegerRange = true;
 				
-				if ((range_start_value->Type() == EidosValueType::kValueInt) && (range_start_value->Count() == 1) && (range_start_value->DimensionCount() == 1) &&
-					(range_end_value->Type() == EidosValueType::kValueInt) && (range_end_value->Count() == 1) && (range_end_value->DimensionCount() == 1))
-				{
-					// OK, we have a simple integer:integer range, so this should be very straightforward
-					simpleIntegerRange = true;
-					
-					start_int = range_start_value->IntAtIndex(0, nullptr);
-					end_int = range_end_value->IntAtIndex(0, nullptr);
-				}
-				else
-				{
-					// If we are not using the general case, we have a bit of a problem now, because we have evaluated the child nodes
-					// of the range expression.  Because that might have side effects, we can't let the code below do it again.
-					// We therefore have to construct the range here that will be used below.  No good deed goes unpunished.
-					
-					// Note that this call to Evaluate_RangeExpr_Internal() gives ownership of the child values; it deletes them for us
-					range_value = _Evaluate_RangeExpr_Internal(range_node, *range_start_value, *range_end_value);
-				}
+				start_int = range_start_value->IntAtIndex(0, nullptr);
+				end_int = range_end_value->IntAtIndex(0, nullptr);
+			}
+			else
+			{
+				// If we are not using the general case, we have a bit of a problem now, because we have evaluated the child nodes
+				// of the range expression.  Because that might have side effects, we can't let the code below do it again.
+				// We therefore have to construct the range here that will be used below.  No good deed goes unpunished.
+				
+				// Note that this call to Evaluate_RangeExpr_Internal() gives ownership of the child values; it deletes them for us
+				range_value = _Evaluate_RangeExpr_Internal(range_node, *range_start_value, *range_end_value);
 			}
 		}
-		else if ((range_node->token_->token_type_ == EidosTokenType::kTokenLParen) && (range_node->children_.size() == 2))
+	}
+	else if ((range_node->token_->token_type_ == EidosTokenType::kTokenLParen) && (range_node->children_.size() == 2))
+	{
+		// Maybe we can streamline a seqAlong() call; let's check
+		const EidosASTNode *call_name_node = range_node->children_[0];
+		
+		if (call_name_node->token_->token_type_ == EidosTokenType::kTokenIdentifier)
 		{
-			// Maybe we can streamline a seqAlong() call; let's check
-			const EidosASTNode *call_name_node = range_node->children_[0];
+			const EidosFunctionSignature *signature = call_name_node->cached_signature_.get();
 			
-			if (call_name_node->token_->token_type_ == EidosTokenType::kTokenIdentifier)
+			if (signature && (signature->internal_function_ == &Eidos_ExecuteFunction_seqAlong))
 			{
-				const EidosFunctionSignature *signature = call_name_node->cached_signature_.get();
-				
-				if (signature && (signature->internal_function_ == &Eidos_ExecuteFunction_seqAlong))
+				if (range_node->children_.size() == 2)
 				{
-					if (range_node->children_.size() == 2)
-					{
-						// We have a qualifying seqAlong() call, so evaluate its argument and set up our simple integer sequence
-						const EidosASTNode *argument_node = range_node->children_[1];
-						
-						simpleIntegerRange = true;
-						
-						EidosValue_SP argument_value = FastEvaluateNode(argument_node);
-						
-						start_int = 0;
-						end_int = argument_value->Count() - 1;
-						
-						// A seqAlong() on a zero-length operand would give us a loop from 0 to -1; short-circuit that
-						if (end_int == -1)
-							goto for_exit;
-					}
+					// We have a qualifying seqAlong() call, so evaluate its argument and set up our simple integer sequence
+					const EidosASTNode *argument_node = range_node->children_[1];
+					
+					simpleIntegerRange = true;
+					
+					EidosValue_SP argument_value = FastEvaluateNode(argument_node);
+					
+					start_int = 0;
+					end_int = argument_value->Count() - 1;
+					
+					// A seqAlong() on a zero-length operand would give us a loop from 0 to -1; short-circuit that
+					if (end_int == -1)
+						goto for_exit;
 				}
 			}
 		}
@@ -5328,31 +5426,34 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 	if (simpleIntegerRange)
 	{
 		// OK, we have a simple integer:integer range, so this should be very straightforward
+		// The bounds are arbitrary, so the span is computed with an overflow check, as in _Evaluate_RangeExpr_Internal(); a range
+		// that is never constructed has no length limit, but its length must still be representable
 		bool counting_up = (start_int < end_int);
-		int64_t range_count = (counting_up ? (end_int - start_int + 1) : (start_int - end_int + 1));
+		int64_t range_span;
+		
+		if (Eidos_sub_overflow(counting_up ? end_int : start_int, counting_up ? start_int : end_int, &range_span) || (range_span == INT64_MAX))
+			EIDOS_TERMINATION << "ERROR (EidosInterpreter::Evaluate_For): a for loop cannot iterate over a range with more than " << INT64_MAX << " entries." << EidosTerminate(range_node->token_);
 		
-		// An empty simple integer range can be skipped altogether, without modifying the index variable
-		if (range_count <= 0)
-			goto for_exit;
+		int64_t range_count = range_span + 1;
 		
 		if (!assigns_index && !references_index)
 		{
 			// the loop index variable is not actually used at all; we are just being asked to do a set number of iterations
 			// we do need to set up the index variable on exit, though, since code below us might use the final value
-			int range_index;
+			int64_t range_index;
 			
 			for (range_index = 0; range_index < range_count; ++range_index)
 			{
 				EidosASTNode *statement_node = p_node->children_[2];
 				
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 				// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 				SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 				
 				EidosValue_SP statement_value = FastEvaluateNode(statement_node);
 				
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 				// PROFILING
 				SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
 #endif
@@ -5366,31 +5467,58 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 			if (range_index == range_count)
 				range_index--;
 			
-			global_symbols_->SetValueForSymbolNoCopy(identifier_name, EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(counting_up ? start_int + range_index : start_int - range_index)));
+			global_symbols_->SetValueForASTNodeNoCopy(identifier_child, EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(counting_up ? start_int + range_index : start_int - range_index)));
 		}
-		else	// !assigns_index, guaranteed above
+		else if (assigns_index)
+		{
+			// the loop index variable is assigned to in the loop body, so it gets a new value each iteration; we still
+			// generate those values from the bounds, rather than from a constructed range
+			for (int64_t range_index = 0; range_index < range_count; ++range_index)
+			{
+				global_symbols_->SetValueForASTNodeNoCopy(identifier_child, EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(counting_up ? start_int + range_index : start_int - range_index)));
+				
+				EidosASTNode *statement_node = p_node->children_[2];
+				
+#if (SLIMPROFILING == 1)
+				// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
+				SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
+#endif
+				
+				EidosValue_SP statement_value = FastEvaluateNode(statement_node);
+				
+#if (SLIMPROFILING == 1)
+				// PROFILING
+				SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
+#endif
+				
+				if (return_statement_hit_)				{ result_SP = std::move(statement_value); break; }
+				if (next_statement_hit_)				next_statement_hit_ = false;
+				if (break_statement_hit_)				{ break_statement_hit_ = false; break; }
+			}
+		}
+		else
 		{
 			// the loop index variable is referenced in the loop body but is not assigned to, so we can use a single
 			// EidosValue that we stick new values into – much, much faster.
 			EidosValue_Int_singleton_SP index_value_SP = EidosValue_Int_singleton_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(0));
 			EidosValue_Int_singleton *index_value = index_value_SP.get();
 			
-			global_symbols_->SetValueForSymbolNoCopy(identifier_name, std::move(index_value_SP));
+			global_symbols_->SetValueForASTNodeNoCopy(identifier_child, std::move(index_value_SP));
 			
-			for (int range_index = 0; range_index < range_count; ++range_index)
+			for (int64_t range_index = 0; range_index < range_count; ++range_index)
 			{
 				index_value->SetValue(counting_up ? start_int + range_index : start_int - range_index);
 				
 				EidosASTNode *statement_node = p_node->children_[2];
 				
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 				// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 				SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 				
 				EidosValue_SP statement_value = FastEvaluateNode(statement_node);
 				
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 				// PROFILING
 				SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
 #endif
@@ -5427,14 +5555,14 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 				{
 					EidosASTNode *statement_node = p_node->children_[2];
 					
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 					// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 					SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 					
 					EidosValue_SP statement_value = FastEvaluateNode(statement_node);
 					
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 					// PROFILING
 					SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
 #endif
@@ -5448,7 +5576,7 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 				if (range_index == range_count)
 					range_index--;
 				
-				global_symbols_->SetValueForSymbolNoCopy(identifier_name, range_value->GetValueAtIndex(range_index, operator_token));
+				global_symbols_->SetValueForASTNodeNoCopy(identifier_child, range_value->GetValueAtIndex(range_index, operator_token));
 				
 				loop_handled = true;
 			}
@@ -5462,7 +5590,7 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 					EidosValue_Int_singleton_SP index_value_SP = EidosValue_Int_singleton_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(0));
 					EidosValue_Int_singleton *index_value = index_value_SP.get();
 					
-					global_symbols_->SetValueForSymbolNoCopy(identifier_name, std::move(index_value_SP));
+					global_symbols_->SetValueForASTNodeNoCopy(identifier_child, std::move(index_value_SP));
 					
 					for (int range_index = 0; range_index < range_count; ++range_index)
 					{
@@ -5470,14 +5598,14 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 						
 						EidosASTNode *statement_node = p_node->children_[2];
 						
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 						// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 						SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 						
 						EidosValue_SP statement_value = FastEvaluateNode(statement_node);
 						
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 						// PROFILING
 						SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
 #endif
@@ -5495,7 +5623,7 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 					EidosValue_Float_singleton_SP index_value_SP = EidosValue_Float_singleton_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Float_singleton(0));
 					EidosValue_Float_singleton *index_value = index_value_SP.get();
 					
-					global_symbols_->SetValueForSymbolNoCopy(identifier_name, std::move(index_value_SP));
+					global_symbols_->SetValueForASTNodeNoCopy(identifier_child, std::move(index_value_SP));
 					
 					for (int range_index = 0; range_index < range_count; ++range_index)
 					{
@@ -5503,14 +5631,14 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 						
 						EidosASTNode *statement_node = p_node->children_[2];
 						
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 						// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 						SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 						
 						EidosValue_SP statement_value = FastEvaluateNode(statement_node);
 						
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 						// PROFILING
 						SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
 #endif
@@ -5528,7 +5656,7 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 					EidosValue_String_singleton_SP index_value_SP = EidosValue_String_singleton_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_String_singleton(gEidosStr_empty_string));
 					EidosValue_String_singleton *index_value = index_value_SP.get();
 					
-					global_symbols_->SetValueForSymbolNoCopy(identifier_name, std::move(index_value_SP));
+					global_symbols_->SetValueForASTNodeNoCopy(identifier_child, std::move(index_value_SP));
 					
 					for (int range_index = 0; range_index < range_count; ++range_index)
 					{
@@ -5536,14 +5664,14 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 						
 						EidosASTNode *statement_node = p_node->children_[2];
 						
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 						// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 						SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 						
 						EidosValue_SP statement_value = FastEvaluateNode(statement_node);
 						
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 						// PROFILING
 						SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
 #endif
@@ -5561,7 +5689,7 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 					EidosValue_Object_singleton_SP index_value_SP = EidosValue_Object_singleton_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Object_singleton(nullptr, ((EidosValue_Object *)range_value.get())->Class()));
 					EidosValue_Object_singleton *index_value = index_value_SP.get();
 					
-					global_symbols_->SetValueForSymbolNoCopy(identifier_name, std::move(index_value_SP));
+					global_symbols_->SetValueForASTNodeNoCopy(identifier_child, std::move(index_value_SP));
 					
 					for (int range_index = 0; range_index < range_count; ++range_index)
 					{
@@ -5569,14 +5697,14 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 						
 						EidosASTNode *statement_node = p_node->children_[2];
 						
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 						// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 						SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 						
 						EidosValue_SP statement_value = FastEvaluateNode(statement_node);
 						
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 						// PROFILING
 						SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
 #endif
@@ -5596,7 +5724,7 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 					
 					index_value->set_logical_no_check(false, 0);	// initial placeholder
 					
-					global_symbols_->SetValueForSymbolNoCopy(identifier_name, std::move(index_value_SP));
+					global_symbols_->SetValueForASTNodeNoCopy(identifier_child, std::move(index_value_SP));
 					
 					for (int range_index = 0; range_index < range_count; ++range_index)
 					{
@@ -5604,14 +5732,14 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 						
 						EidosASTNode *statement_node = p_node->children_[2];
 						
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 						// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 						SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 						
 						EidosValue_SP statement_value = FastEvaluateNode(statement_node);
 						
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 						// PROFILING
 						SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
 #endif
@@ -5631,19 +5759,19 @@ EidosValue_SP EidosInterpreter::Evaluate_For(const EidosASTNode *p_node)
 				for (int range_index = 0; range_index < range_count; ++range_index)
 				{
 					// set the index variable to the range value and then throw the range value away
-					global_symbols_->SetValueForSymbolNoCopy(identifier_name, range_value->GetValueAtIndex(range_index, operator_token));
+					global_symbols_->SetValueForASTNodeNoCopy(identifier_child, range_value->GetValueAtIndex(range_index, operator_token));
 					
 					// execute the for loop's statement by evaluating its node; evaluation values get thrown away
 					EidosASTNode *statement_node = p_node->children_[2];
 					
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 					// PROFILING: profile child statement unless it is a compound statement (which does its own profiling)
 					SLIM_PROFILE_BLOCK_START_CONDITION(statement_node->token_->token_type_ != EidosTokenType::kTokenLBrace);
 #endif
 					
 					EidosValue_SP statement_value = FastEvaluateNode(statement_node);
 					
-#if defined(SLIMGUI) && (SLIMPROFILING == 1)
+#if (SLIMPROFILING == 1)
 					// PROFILING
 					SLIM_PROFILE_BLOCK_END_CONDITION(statement_node->profile_total_);
 #endif
@@ -5930,3 +6058,35 @@ EidosValue_SP EidosInterpreter::Evaluate_FunctionDecl(const EidosASTNode *p_node
 
 
 
+
+EidosValue_SP EidosInterpreter::Evaluate_Bytecode(const EidosASTNode *p_node)
+{
+#if EIDOS_BYTECODE
+	// The bytecode for this subtree was compiled by EidosASTNode::_OptimizeBytecode(); see eidos_bytecode.h
+	EidosBytecode *bytecode = p_node->cached_bytecode_;
+	
+#if defined(DEBUG) || defined(EIDOS_GUI)
+	// the execution log is a trace of the tree-walking evaluators, so use them while logging
+	if (logging_execution_)
+		return (this->*(bytecode->fallback_evaluator_))(p_node);
+#endif
+	
+	EidosValue_SP result_SP;
+	
+	if (bytecode->Execute(*global_symbols_, result_SP))
+	{
+		bytecode->NoteSuccess();
+		return result_SP;
+	}
+	
+	// The bytecode bailed out on the values it found; the interpreter evaluates the subtree from scratch, and raises any errors.
+	// If this keeps happening, the operands are probably not singletons, so stop trying the bytecode for this subtree.
+	if (bytecode->NoteBailout())
+		p_node->cached_evaluator_ = bytecode->fallback_evaluator_;
+	
+	return (this->*(bytecode->fallback_evaluator_))(p_node);
+#else
+	// CODE COVERAGE: This is dead code
+	EIDOS_TERMINATION << "ERROR (EidosInterpreter::Evaluate_Bytecode): (internal error) bytecode is not supported in this build." << EidosTerminate(p_node->token_);
+#endif
+}
@@ -116,6 +116,7 @@ public:
 	void _ProcessSubsetAssignment(EidosValue_SP *p_base_value_ptr, EidosGlobalStringID *p_property_string_id_ptr, std::vector<int> *p_indices_ptr, const EidosASTNode *p_parent_node);
 	void _AssignRValueToLValue(EidosValue_SP p_rvalue, const EidosASTNode *p_lvalue_node);
 	EidosValue_SP _Evaluate_RangeExpr_Internal(const EidosASTNode *p_node, const EidosValue &p_first_child_value, const EidosValue &p_second_child_value);
+	EidosValue_SP _Evaluate_Subset_IntegerRange(const EidosValue &p_value, int64_t p_first_index, int64_t p_last_index, EidosToken *p_operator_token);
 	int _ProcessArgumentList(const EidosASTNode *p_node, const EidosCallSignature *p_call_signature, EidosValue_SP *p_arg_buffer);
 	
 	EidosValue_SP DispatchUserDefinedFunction(const EidosFunctionSignature &p_function_signature, const EidosValue_SP *const p_arguments, int p_argument_count);
@@ -157,6 +158,7 @@ public:
 	EidosValue_SP Evaluate_Break(const EidosASTNode *p_node);
 	EidosValue_SP Evaluate_Return(const EidosASTNode *p_node);
 	EidosValue_SP Evaluate_FunctionDecl(const EidosASTNode *p_node);
+	EidosValue_SP Evaluate_Bytecode(const EidosASTNode *p_node);
 	
 	// Function dispatch/execution; these are implemented in eidos_functions.cpp
 	static std::vector<EidosFunctionSignature_SP> &BuiltInFunctions(void);
@@ -0,0 +1,58 @@
+//
+//  eidos_openmp.h
+//  Eidos
+//
+//  Created by Ben Haller on 10/16/17.
+//  Copyright (c) 2017 Philipp Messer.  All rights reserved.
+//	A product of the Messer Lab, http://messerlab.org/slim/
+//
+
+//	This file is part of Eidos.
+//
+//	Eidos is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+//	the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+//
+//	Eidos is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//	You should have received a copy of the GNU General Public License along with Eidos.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+
+ This file contains the small amount of glue needed for multithreading with OpenMP.  Eidos itself is not thread-safe; the
+ Context may do work in parallel in specific places where it knows that no Eidos code will run.  The number of threads to
+ use is kept in gEidosMaxThreads; a value of 1 (the default) means that all such work is done on the main thread, using
+ exactly the same code paths as before multithreading support was added.
+
+ Builds without OpenMP are fully supported.  Parallel code is written so that the division of work into per-thread blocks
+ depends only upon the requested thread count, not upon how many threads actually run; a build without OpenMP simply
+ executes the blocks one after another on the main thread, and produces the same results as a multithreaded build would.
+ Worker threads must not use gEidos_rng; each block should draw from its own stream instead (see Eidos_RNG_State).
+
+ */
+
+#ifndef __Eidos__eidos_openmp__
+#define __Eidos__eidos_openmp__
+
+
+#ifdef _OPENMP
+
+#include <omp.h>
+
+#else
+
+// Stand-ins for the OpenMP runtime functions we use, so that calling code does not need to be conditional
+inline int omp_get_thread_num(void) { return 0; }
+inline int omp_get_max_threads(void) { return 1; }
+
+#endif
+
+
+// The maximum number of threads to use for parallel work; set with the -threads command-line option, 1 by default
+extern int gEidosMaxThreads;
+
+// The largest thread count we allow to be requested; requests above this are almost certainly an error
+#define EIDOS_MAX_THREADS	1024
+
+
+#endif /* __Eidos__eidos_openmp__ */
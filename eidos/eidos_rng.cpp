@@ -74,6 +74,149 @@ void Eidos_InitializeRNGFromSeed(unsigned long int p_seed)
 	gEidos_random_bool_bit_buffer = 0;
 }
 
+
+//
+//	Random number streams
+//
+
+// SplitMix64, used for seeding and for deriving stream keys; see http://xoshiro.di.unimi.it/splitmix64.c
+static inline uint64_t _Eidos_SplitMix64(uint64_t *p_state)
+{
+	uint64_t z = (*p_state += 0x9E3779B97F4A7C15ULL);
+	
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// xoshiro256++ by David Blackman and Sebastiano Vigna; see http://xoshiro.di.unimi.it/xoshiro256plusplus.c
+typedef struct {
+	uint64_t s[4];
+} _Eidos_xoshiro256pp_state;
+
+static inline uint64_t _Eidos_rotl(const uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t _Eidos_xoshiro256pp_next(_Eidos_xoshiro256pp_state *p_state)
+{
+	uint64_t *s = p_state->s;
+	const uint64_t result = _Eidos_rotl(s[0] + s[3], 23) + s[0];
+	const uint64_t t = s[1] << 17;
+	
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = _Eidos_rotl(s[3], 45);
+	
+	return result;
+}
+
+static void _Eidos_xoshiro256pp_set(void *p_state, unsigned long int p_seed)
+{
+	_Eidos_xoshiro256pp_state *state = (_Eidos_xoshiro256pp_state *)p_state;
+	uint64_t splitmix_state = p_seed;
+	
+	// SplitMix64 never produces four zero words in a row, so the state is never all-zero, which xoshiro does not allow
+	for (int i = 0; i < 4; ++i)
+		state->s[i] = _Eidos_SplitMix64(&splitmix_state);
+}
+
+static unsigned long int _Eidos_xoshiro256pp_get(void *p_state)
+{
+	// the upper bits are the best bits; we return 32 bits so that code written for gsl_rng_taus2 works unmodified
+	return (unsigned long int)(_Eidos_xoshiro256pp_next((_Eidos_xoshiro256pp_state *)p_state) >> 32);
+}
+
+static double _Eidos_xoshiro256pp_get_double(void *p_state)
+{
+	// 53 random bits, in [0, 1)
+	return (_Eidos_xoshiro256pp_next((_Eidos_xoshiro256pp_state *)p_state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static const gsl_rng_type _Eidos_xoshiro256pp_type = {
+	"xoshiro256++",					// name
+	0xffffffffUL,					// RAND_MAX
+	0,								// RAND_MIN
+	sizeof(_Eidos_xoshiro256pp_state),
+	&_Eidos_xoshiro256pp_set,
+	&_Eidos_xoshiro256pp_get,
+	&_Eidos_xoshiro256pp_get_double
+};
+
+const gsl_rng_type *gEidos_rng_xoshiro256pp = &_Eidos_xoshiro256pp_type;
+
+void Eidos_InitializeRNGStream(Eidos_RNG_State *p_stream)
+{
+	p_stream->gsl_rng_ = gsl_rng_alloc(gEidos_rng_xoshiro256pp);
+	p_stream->random_bool_bit_counter_ = 0;
+	p_stream->random_bool_bit_buffer_ = 0;
+}
+
+void Eidos_FreeRNGStream(Eidos_RNG_State *p_stream)
+{
+	if (p_stream->gsl_rng_)
+	{
+		gsl_rng_free(p_stream->gsl_rng_);
+		p_stream->gsl_rng_ = nullptr;
+	}
+}
+
+uint64_t Eidos_RNGStreamKey(uint64_t p_seed, uint64_t p_counter1, uint64_t p_counter2)
+{
+	// chain SplitMix64 through the inputs, so that every input affects every bit of the key
+	uint64_t state = p_seed;
+	uint64_t key = _Eidos_SplitMix64(&state);
+	
+	state = key ^ p_counter1;
+	key = _Eidos_SplitMix64(&state);
+	
+	state = key ^ p_counter2;
+	return _Eidos_SplitMix64(&state);
+}
+
+void Eidos_SeedRNGStream(Eidos_RNG_State *p_stream, uint64_t p_key, int p_stream_index)
+{
+	static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+	
+	gsl_rng_set(p_stream->gsl_rng_, (unsigned long int)p_key);
+	
+	// jump ahead by 2^128 draws for each stream index, so that streams sharing a key cannot overlap
+	_Eidos_xoshiro256pp_state *state = (_Eidos_xoshiro256pp_state *)p_stream->gsl_rng_->state;
+	
+	for (int jump_index = 0; jump_index < p_stream_index; ++jump_index)
+	{
+		uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+		
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int b = 0; b < 64; ++b)
+			{
+				if (JUMP[i] & (((uint64_t)1) << b))
+				{
+					s0 ^= state->s[0];
+					s1 ^= state->s[1];
+					s2 ^= state->s[2];
+					s3 ^= state->s[3];
+				}
+				
+				_Eidos_xoshiro256pp_next(state);
+			}
+		}
+		
+		state->s[0] = s0;
+		state->s[1] = s1;
+		state->s[2] = s2;
+		state->s[3] = s3;
+	}
+	
+	p_stream->random_bool_bit_counter_ = 0;
+	p_stream->random_bool_bit_buffer_ = 0;
+}
+
 #ifndef USE_GSL_POISSON
 double Eidos_FastRandomPoisson_PRECALCULATE(double p_mu)
 {
@@ -94,6 +237,118 @@ double Eidos_FastRandomPoisson_PRECALCULATE(double p_mu)
 }
 #endif
 
+EidosAliasTable::~EidosAliasTable(void)
+{
+	if (cutoffs_)
+		free(cutoffs_);
+	if (aliases_)
+		free(aliases_);
+	if (stack_)
+		free(stack_);
+}
+
+void EidosAliasTable::Build(size_t p_count, const double *p_weights)
+{
+	// This follows gsl_ran_discrete_preproc() step by step, including the order in which entries are pushed and popped, so that the
+	// resulting table, and thus every draw made from it, is identical to what the GSL would produce.  The normalized weights (E in the
+	// GSL) are kept in cutoffs_ while the table is built; each slot's cutoff replaces its weight once that slot has been finished.
+	if (p_count < 1)
+		EIDOS_TERMINATION << "ERROR (EidosAliasTable::Build): (internal error) an alias table must have at least one entry." << EidosTerminate(nullptr);
+	
+	if (p_count > capacity_)
+	{
+		cutoffs_ = (double *)realloc(cutoffs_, p_count * sizeof(double));
+		aliases_ = (size_t *)realloc(aliases_, p_count * sizeof(size_t));
+		stack_ = (size_t *)realloc(stack_, p_count * sizeof(size_t));
+		
+		if (!cutoffs_ || !aliases_ || !stack_)
+			EIDOS_TERMINATION << "ERROR (EidosAliasTable::Build): allocation failed; you may need to raise the memory limit for SLiM." << EidosTerminate(nullptr);
+		
+		capacity_ = p_count;
+	}
+	
+	count_ = 0;		// invalid until we are done
+	
+	double total = 0.0;
+	
+	for (size_t k = 0; k < p_count; ++k)
+	{
+		double weight = p_weights[k];
+		
+		if (weight < 0)
+			EIDOS_TERMINATION << "ERROR (EidosAliasTable::Build): weights must be non-negative." << EidosTerminate(nullptr);
+		
+		total += weight;
+	}
+	
+	double *E = cutoffs_;
+	
+	for (size_t k = 0; k < p_count; ++k)
+		E[k] = p_weights[k] / total;
+	
+	// Sort the slots into small and big stacks, in index order; the two stacks share one buffer, since together they never hold
+	// more than p_count entries.  Note that the GSL's stacks are LIFO, so the top of the big stack is its lowest position here.
+	double mean = 1.0 / p_count;
+	size_t *smalls = stack_;
+	size_t *bigs_end = stack_ + p_count;
+	size_t small_count = 0, big_count = 0;
+	
+	for (size_t k = 0; k < p_count; ++k)
+	{
+		if (E[k] < mean)
+			smalls[small_count++] = k;
+		else
+			*(bigs_end - (++big_count)) = k;
+	}
+	
+	// Now work through the smalls, pairing each with a big that donates probability to it
+	while (small_count > 0)
+	{
+		size_t s = smalls[--small_count];
+		
+		if (big_count == 0)
+		{
+			aliases_[s] = s;
+			E[s] = 1.0;
+			continue;
+		}
+		
+		size_t b = *(bigs_end - (big_count--));
+		double d = mean - E[s];
+		
+		aliases_[s] = b;
+		E[s] = p_count * E[s];		// slot s is finished; it now holds F[s]
+		E[b] -= d;
+		
+		if (E[b] < mean)
+			smalls[small_count++] = b;				// no longer big, join ranks of the small
+		else if (E[b] > mean)
+			*(bigs_end - (++big_count)) = b;		// still big, put it back where you found it
+		else
+		{
+			aliases_[b] = b;						// E[b] == mean implies it is finished too
+			E[b] = 1.0;
+		}
+	}
+	
+	while (big_count > 0)
+	{
+		size_t b = *(bigs_end - (big_count--));
+		
+		aliases_[b] = b;
+		E[b] = 1.0;
+	}
+	
+	// Convert F[k] to the cutoff (k + F[k]) / K, as the GSL does with KNUTH_CONVENTION, to save arithmetic in Draw()
+	for (size_t k = 0; k < p_count; ++k)
+	{
+		cutoffs_[k] += k;
+		cutoffs_[k] /= p_count;
+	}
+	
+	count_ = p_count;
+}
+
 
 
 
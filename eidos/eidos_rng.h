@@ -21,6 +21,13 @@
  
  Eidos uses a globally shared random number generator called gEidos_rng.  This file defines that global and relevant helper functions.
  
+ It also provides independent random number streams, represented by Eidos_RNG_State, for work done in parallel.  Streams use the
+ xoshiro256++ generator, wrapped as a GSL generator type so that all of the gsl_ran_* functions work with them.  A stream is seeded
+ from a 64-bit key, which should be derived with Eidos_RNGStreamKey() from a value drawn from gEidos_rng and counters identifying the
+ work being done (a generation number, for example), and a stream index, which selects a non-overlapping subsequence of the key's
+ sequence.  Drawing the key's seed value from gEidos_rng, on the main thread, ties the streams to the state of the main generator, so
+ that restoring a saved state and re-running gives new draws in parallel work just as it does in sequential work.
+
  */
 
 #ifndef __Eidos__eidos_rng__
@@ -60,12 +67,34 @@
 // This is a globally shared random number generator.  Note that the globals for random bit generation below are also
 // considered to be part of the RNG state; if the Context plays games with swapping different RNGs in and out, those
 // globals need to get swapped as well.  Likewise for the last seed value; this is part of the RNG state in Eidos.
+// This generator may be used only on the main thread; worker threads must use a stream of their own (see below).
 extern gsl_rng *gEidos_rng;
 extern int gEidos_random_bool_bit_counter;
 extern uint32_t gEidos_random_bool_bit_buffer;
 extern unsigned long int gEidos_rng_last_seed;				// unsigned long int is the type used by gsl_rng_set()
 
 
+// An independent random number stream, usable by one thread at a time.  The bit buffer serves Eidos_RandomBool(), as the
+// globals above do for gEidos_rng.  Pass gsl_rng_ to Eidos_RandomInt(), Eidos_FastRandomPoisson(), and gsl_ran_* functions.
+typedef struct {
+	gsl_rng *gsl_rng_;										// OWNED POINTER: a generator of type gEidos_rng_xoshiro256pp
+	int random_bool_bit_counter_;
+	uint32_t random_bool_bit_buffer_;
+} Eidos_RNG_State;
+
+// the GSL generator type used by streams; it returns 32 bits per gsl_rng_get(), like gsl_rng_taus2, as Eidos_RandomInt() requires
+extern const gsl_rng_type *gEidos_rng_xoshiro256pp;
+
+void Eidos_InitializeRNGStream(Eidos_RNG_State *p_stream);
+void Eidos_FreeRNGStream(Eidos_RNG_State *p_stream);
+
+// derive a stream key from a seed value (normally drawn from gEidos_rng) and two counters; each distinct combination gives an unrelated key
+uint64_t Eidos_RNGStreamKey(uint64_t p_seed, uint64_t p_counter1, uint64_t p_counter2);
+
+// seed a stream from a key; streams with the same key and different indices are non-overlapping (2^128 draws apart)
+void Eidos_SeedRNGStream(Eidos_RNG_State *p_stream, uint64_t p_key, int p_stream_index);
+
+
 // generate a new random number seed from the PID and clock time
 unsigned long int Eidos_GenerateSeedFromPIDAndTime(void);
 
@@ -98,6 +127,27 @@ static inline __attribute__((always_inline)) bool Eidos_RandomBool(gsl_rng *p_r)
 	return retval;
 }
 
+// the same, drawing from a stream and using its bit buffer
+static inline __attribute__((always_inline)) bool Eidos_RandomBool(Eidos_RNG_State *p_stream)
+{
+	bool retval;
+	
+	if (p_stream->random_bool_bit_counter_ > 0)
+	{
+		p_stream->random_bool_bit_counter_--;
+		p_stream->random_bool_bit_buffer_ >>= 1;
+		retval = p_stream->random_bool_bit_buffer_ & 0x01;
+	}
+	else
+	{
+		p_stream->random_bool_bit_buffer_ = (uint32_t)gsl_rng_get(p_stream->gsl_rng_);	// streams also return 32 bits per draw
+		retval = p_stream->random_bool_bit_buffer_ & 0x01;
+		p_stream->random_bool_bit_counter_ = 31;
+	}
+	
+	return retval;
+}
+
 
 // the gsl_rng_uniform_int() function is very slow, so this is a customized version that should be faster
 // basically it is faster because (1) the range of the taus2 generator is hard-coded, (2) the range check
@@ -142,16 +192,18 @@ inline uint32_t Eidos_RandomInt(gsl_rng *p_r, uint32_t p_n)
 
 #ifndef USE_GSL_POISSON
 
-static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisson(double p_mu)
+// Each of these functions takes the generator to draw from; the versions without a generator parameter draw from gEidos_rng.
+
+static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisson(gsl_rng *p_r, double p_mu)
 {
 	// Defer to the GSL for large values of mu; see comments above.
 	if (p_mu > 250)
-		return gsl_ran_poisson(gEidos_rng, p_mu);
+		return gsl_ran_poisson(p_r, p_mu);
 	
 	unsigned int x = 0;
 	double p = exp(-p_mu);
 	double s = p;
-	double u = gsl_rng_uniform(gEidos_rng);
+	double u = gsl_rng_uniform(p_r);
 	
 	while (u > s)
 	{
@@ -166,11 +218,11 @@ static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisso
 }
 
 // This version allows the caller to supply a precalculated exp(-mu) value
-static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisson(double p_mu, double p_exp_neg_mu)
+static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisson(gsl_rng *p_r, double p_mu, double p_exp_neg_mu)
 {
 	// Defer to the GSL for large values of mu; see comments above.
 	if (p_mu > 250)
-		return gsl_ran_poisson(gEidos_rng, p_mu);
+		return gsl_ran_poisson(p_r, p_mu);
 	
 	// Test consistency; normally this is commented out
 	//if (p_exp_neg_mu != exp(-p_mu))
@@ -179,7 +231,7 @@ static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisso
 	unsigned int x = 0;
 	double p = p_exp_neg_mu;
 	double s = p;
-	double u = gsl_rng_uniform(gEidos_rng);
+	double u = gsl_rng_uniform(p_r);
 	
 	while (u > s)
 	{
@@ -194,7 +246,7 @@ static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisso
 }
 
 // This version specifies that the count is guaranteed not to be zero; zero has been ruled out by a previous test
-static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisson_NONZERO(double p_mu, double p_exp_neg_mu)
+static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisson_NONZERO(gsl_rng *p_r, double p_mu, double p_exp_neg_mu)
 {
 	// Defer to the GSL for large values of mu; see comments above.
 	if (p_mu > 250)
@@ -203,7 +255,7 @@ static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisso
 		
 		do
 		{
-			result = gsl_ran_poisson(gEidos_rng, p_mu);
+			result = gsl_ran_poisson(p_r, p_mu);
 		}
 		while (result == 0);
 		
@@ -217,7 +269,7 @@ static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisso
 	unsigned int x = 0;
 	double p = p_exp_neg_mu;
 	double s = p;
-	double u = gsl_rng_uniform_pos(gEidos_rng);	// exclude 0.0 so u != s after rescaling
+	double u = gsl_rng_uniform_pos(p_r);	// exclude 0.0 so u != s after rescaling
 	
 	// rescale u so that (u > s) is true in the first round
 	u = u * (1.0 - s) + s;
@@ -239,12 +291,76 @@ static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisso
 	return x;
 }
 
+static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisson(double p_mu)
+{
+	return Eidos_FastRandomPoisson(gEidos_rng, p_mu);
+}
+
+static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisson(double p_mu, double p_exp_neg_mu)
+{
+	return Eidos_FastRandomPoisson(gEidos_rng, p_mu, p_exp_neg_mu);
+}
+
+static inline __attribute__((always_inline)) unsigned int Eidos_FastRandomPoisson_NONZERO(double p_mu, double p_exp_neg_mu)
+{
+	return Eidos_FastRandomPoisson_NONZERO(gEidos_rng, p_mu, p_exp_neg_mu);
+}
+
 double Eidos_FastRandomPoisson_PRECALCULATE(double p_mu);	// exp(-mu); can underflow to zero, in which case the GSL will be used
 
 
 #endif // USE_GSL_POISSON
 
 
+// A table for drawing indices 0..count-1 with probability proportional to given non-negative weights, using Walker's alias method.
+// This is derived from gsl_ran_discrete_preproc() and gsl_ran_discrete(), and produces exactly the same draws that they would.  The
+// difference is that the table keeps its buffers when it is rebuilt, so rebuilding it every generation does not allocate; and it can
+// fill a buffer with many draws at once, avoiding per-draw call overhead.  Build() is O(N); its normalization and finishing passes
+// are simple loops over the weights that the compiler can vectorize.
+class EidosAliasTable
+{
+private:
+	size_t count_ = 0;					// the number of indices drawn from; 0 if the table has not been built
+	size_t capacity_ = 0;				// the number of entries our buffers can hold
+	double *cutoffs_ = nullptr;			// OWNED POINTER: for each slot k, the cutoff (k + F[k]) / count; draws below it are k, above it are aliases_[k]
+	size_t *aliases_ = nullptr;			// OWNED POINTER: for each slot k, the index drawn when the uniform deviate is above cutoffs_[k]
+	size_t *stack_ = nullptr;			// OWNED POINTER: scratch space for Build(); "small" entries stack up from the bottom, "big" entries down from the top
+
+public:
+	EidosAliasTable(const EidosAliasTable&) = delete;					// no copying
+	EidosAliasTable& operator=(const EidosAliasTable&) = delete;		// no copying
+	EidosAliasTable(void) = default;
+	~EidosAliasTable(void);
+	
+	void Build(size_t p_count, const double *p_weights);				// weights need not be normalized
+	inline void Clear(void) { count_ = 0; }
+	inline bool IsBuilt(void) const { return (count_ > 0); }
+	
+	inline __attribute__((always_inline)) size_t Draw(gsl_rng *p_rng) const
+	{
+		double u = gsl_rng_uniform(p_rng);
+		size_t slot = (size_t)(u * count_);
+		
+		return (u < cutoffs_[slot]) ? slot : aliases_[slot];
+	}
+	
+	template <typename T> void DrawMultiple(gsl_rng *p_rng, size_t p_draw_count, T *p_buffer, T p_offset) const
+	{
+		const double *cutoffs = cutoffs_;
+		const size_t *aliases = aliases_;
+		double count = count_;
+		
+		for (size_t draw_index = 0; draw_index < p_draw_count; ++draw_index)
+		{
+			double u = gsl_rng_uniform(p_rng);
+			size_t slot = (size_t)(u * count);
+			
+			p_buffer[draw_index] = (T)((u < cutoffs[slot]) ? slot : aliases[slot]) + p_offset;
+		}
+	}
+};
+
+
 #endif /* defined(__Eidos__eidos_rng__) */
 
 
@@ -287,6 +287,92 @@ EidosValue_SP EidosSymbolTable::_GetValue_IsConst(EidosGlobalStringID p_symbol_n
 	EIDOS_TERMINATION << "ERROR (EidosSymbolTable::_GetValue_IsConst): undefined identifier " << Eidos_StringForGlobalStringID(p_symbol_name) << "." << EidosTerminate(p_symbol_token);
 }
 
+// same as above except that it returns a bare pointer, and nullptr instead of raising for an undefined symbol
+EidosValue *EidosSymbolTable::_GetValuePointerOrNull(EidosGlobalStringID p_symbol_name) const
+{
+	if (using_internal_symbols_)
+	{
+		for (int symbol_index = (int)internal_symbol_count_ - 1; symbol_index >= 0; --symbol_index)
+		{
+			const EidosSymbolTable_InternalSlot *symbol_slot = internal_symbols_ + symbol_index;
+			
+			if (symbol_slot->symbol_name_ == p_symbol_name)
+				return symbol_slot->symbol_value_SP_.get();
+		}
+	}
+	else
+	{
+		auto symbol_slot_iter = hash_symbols_.find(p_symbol_name);
+		
+		if (symbol_slot_iter != hash_symbols_.end())
+			return symbol_slot_iter->second.get();
+	}
+	
+	// We didn't get a hit, so try our chained table
+	if (chain_symbol_table_)
+		return chain_symbol_table_->_GetValuePointerOrNull(p_symbol_name);
+	
+	return nullptr;
+}
+
+// the slow paths of the ASTNode-based lookups in the header; these search as above, and update the node's slot hint on a hit in this table
+EidosValue_SP EidosSymbolTable::_GetValueForASTNode(const EidosASTNode *p_symbol_node, bool *p_is_const) const
+{
+	EidosGlobalStringID symbol_name = p_symbol_node->cached_stringID_;
+	
+	if (using_internal_symbols_)
+	{
+		for (int symbol_index = (int)internal_symbol_count_ - 1; symbol_index >= 0; --symbol_index)
+		{
+			const EidosSymbolTable_InternalSlot *symbol_slot = internal_symbols_ + symbol_index;
+			
+			if (symbol_slot->symbol_name_ == symbol_name)
+			{
+				p_symbol_node->cached_symbol_slot_ = (uint8_t)symbol_index;
+				
+				if (p_is_const)
+					*p_is_const = (table_type_ != EidosSymbolTableType::kVariablesTable);
+				return symbol_slot->symbol_value_SP_;
+			}
+		}
+		
+		// We didn't get a hit, so try our chained table; without one, the calls below raise for the undefined symbol
+		if (chain_symbol_table_)
+		{
+			if (p_is_const)
+				return chain_symbol_table_->_GetValue_IsConst(symbol_name, p_symbol_node->token_, p_is_const);
+			return chain_symbol_table_->_GetValue(symbol_name, p_symbol_node->token_);
+		}
+	}
+	
+	if (p_is_const)
+		return _GetValue_IsConst(symbol_name, p_symbol_node->token_, p_is_const);
+	return _GetValue(symbol_name, p_symbol_node->token_);
+}
+
+EidosValue *EidosSymbolTable::_GetValuePointerOrNullForASTNode(const EidosASTNode *p_symbol_node) const
+{
+	EidosGlobalStringID symbol_name = p_symbol_node->cached_stringID_;
+	
+	if (using_internal_symbols_)
+	{
+		for (int symbol_index = (int)internal_symbol_count_ - 1; symbol_index >= 0; --symbol_index)
+		{
+			const EidosSymbolTable_InternalSlot *symbol_slot = internal_symbols_ + symbol_index;
+			
+			if (symbol_slot->symbol_name_ == symbol_name)
+			{
+				p_symbol_node->cached_symbol_slot_ = (uint8_t)symbol_index;
+				return symbol_slot->symbol_value_SP_.get();
+			}
+		}
+		
+		return (chain_symbol_table_ ? chain_symbol_table_->_GetValuePointerOrNull(symbol_name) : nullptr);
+	}
+	
+	return _GetValuePointerOrNull(symbol_name);
+}
+
 void EidosSymbolTable::_SwitchToHash(void)
 {
 	if (using_internal_symbols_)
@@ -441,6 +527,27 @@ void EidosSymbolTable::SetValueForSymbolNoCopy(EidosGlobalStringID p_symbol_name
 	}
 }
 
+void EidosSymbolTable::_SetValueForASTNode(const EidosASTNode *p_symbol_node, EidosValue_SP p_value, bool p_no_copy)
+{
+	EidosGlobalStringID symbol_name = p_symbol_node->cached_stringID_;
+	
+	if (p_no_copy)
+		SetValueForSymbolNoCopy(symbol_name, std::move(p_value));
+	else
+		SetValueForSymbol(symbol_name, std::move(p_value));
+	
+	// record the slot the symbol landed in, for the next assignment or lookup through this node
+	if (using_internal_symbols_)
+	{
+		for (int symbol_index = (int)internal_symbol_count_ - 1; symbol_index >= 0; --symbol_index)
+			if (internal_symbols_[symbol_index].symbol_name_ == symbol_name)
+			{
+				p_symbol_node->cached_symbol_slot_ = (uint8_t)symbol_index;
+				break;
+			}
+	}
+}
+
 void EidosSymbolTable::DefineConstantForSymbol(EidosGlobalStringID p_symbol_name, EidosValue_SP p_value)
 {
 	// First make sure this symbol is not in use as either a variable or a constant
@@ -43,6 +43,12 @@
  uses EidosGlobalStringID, which is an integer type that represents a uniqued string.  This allows greater speed, since
  strings get uniqued only once, and an integer key can be used from then onward.
  
+ Lookups and assignments made through an identifier's AST node also use a slot hint kept in the node: the index of the
+ internal slot in which the symbol was last found.  If that slot in the table searched first still holds the symbol, it
+ is used directly, so a local variable referenced repeatedly in a loop or a callback costs an array index rather than a
+ search.  Otherwise the normal search is done, and the hint is updated.  Since each hint is checked before use, it needs no
+ invalidation when symbols are removed, when tables come and go, or when one node is evaluated against different tables.
+ 
  */
 
 #ifndef __Eidos__eidos_symbol_table__
@@ -141,6 +147,20 @@ private:
 	std::vector<std::string> _SymbolNames(bool p_include_constants, bool p_include_variables) const;
 	EidosValue_SP _GetValue(EidosGlobalStringID p_symbol_name, const EidosToken *p_symbol_token) const;
 	EidosValue_SP _GetValue_IsConst(EidosGlobalStringID p_symbol_name, const EidosToken *p_symbol_token, bool *p_is_const) const;
+	EidosValue *_GetValuePointerOrNull(EidosGlobalStringID p_symbol_name) const;
+	EidosValue_SP _GetValueForASTNode(const EidosASTNode *p_symbol_node, bool *p_is_const) const;
+	EidosValue *_GetValuePointerOrNullForASTNode(const EidosASTNode *p_symbol_node) const;
+	void _SetValueForASTNode(const EidosASTNode *p_symbol_node, EidosValue_SP p_value, bool p_no_copy);
+	
+	// Returns the index of the internal slot given by the node's slot hint, if it holds the node's symbol, or -1
+	inline __attribute__((always_inline)) int _HintedSlotIndex(const EidosASTNode *p_symbol_node) const
+	{
+		uint8_t slot_index = p_symbol_node->cached_symbol_slot_;
+		
+		if (using_internal_symbols_ && (slot_index < internal_symbol_count_) && (internal_symbols_[slot_index].symbol_name_ == p_symbol_node->cached_stringID_))
+			return slot_index;
+		return -1;
+	}
 	void _RemoveSymbol(EidosGlobalStringID p_symbol_name, bool p_remove_constant);
 	void _InitializeConstantSymbolEntry(EidosGlobalStringID p_symbol_name, EidosValue_SP p_value);
 	void _SwitchToHash(void);
@@ -167,6 +187,26 @@ public:
 	void SetValueForSymbol(EidosGlobalStringID p_symbol_name, EidosValue_SP p_value);
 	void SetValueForSymbolNoCopy(EidosGlobalStringID p_symbol_name, EidosValue_SP p_value);
 	
+	// Set as a variable given the identifier's AST node, using its slot hint; otherwise the same as SetValueForSymbol() / SetValueForSymbolNoCopy()
+	inline __attribute__((always_inline)) void SetValueForASTNode(const EidosASTNode *p_symbol_node, EidosValue_SP p_value)
+	{
+		int slot_index = _HintedSlotIndex(p_symbol_node);
+		
+		if ((slot_index != -1) && (table_type_ == EidosSymbolTableType::kVariablesTable) && (p_value->UseCount() == 1) && !p_value->Invisible())
+			internal_symbols_[slot_index].symbol_value_SP_ = std::move(p_value);
+		else
+			_SetValueForASTNode(p_symbol_node, std::move(p_value), false);
+	}
+	inline __attribute__((always_inline)) void SetValueForASTNodeNoCopy(const EidosASTNode *p_symbol_node, EidosValue_SP p_value)
+	{
+		int slot_index = _HintedSlotIndex(p_symbol_node);
+		
+		if ((slot_index != -1) && (table_type_ == EidosSymbolTableType::kVariablesTable) && !p_value->Invisible())
+			internal_symbols_[slot_index].symbol_value_SP_ = std::move(p_value);
+		else
+			_SetValueForASTNode(p_symbol_node, std::move(p_value), true);
+	}
+	
 	// Set as a constant (raises if already defined as a variable or a constant); adds to the kEidosDefinedConstantsTable, creating it if necessary
 	void DefineConstantForSymbol(EidosGlobalStringID p_symbol_name, EidosValue_SP p_value);
 	
@@ -175,13 +215,41 @@ public:
 	inline __attribute__((always_inline)) void RemoveConstantForSymbol(EidosGlobalStringID p_symbol_name) { _RemoveSymbol(p_symbol_name, true); }
 	
 	// Get a value, with an optional token used if the call raises due to an undefined symbol
-	inline __attribute__((always_inline)) EidosValue_SP GetValueOrRaiseForASTNode(const EidosASTNode *p_symbol_node) const { return _GetValue(p_symbol_node->cached_stringID_, p_symbol_node->token_); }
+	inline __attribute__((always_inline)) EidosValue_SP GetValueOrRaiseForASTNode(const EidosASTNode *p_symbol_node) const
+	{
+		int slot_index = _HintedSlotIndex(p_symbol_node);
+		
+		if (slot_index != -1)
+			return internal_symbols_[slot_index].symbol_value_SP_;
+		return _GetValueForASTNode(p_symbol_node, nullptr);
+	}
 	inline __attribute__((always_inline)) EidosValue_SP GetValueOrRaiseForSymbol(EidosGlobalStringID p_symbol_name) const { return _GetValue(p_symbol_name, nullptr); }
 	
 	// Special getters that return a boolean flag, true if the fetched symbol is a constant
-	inline __attribute__((always_inline)) EidosValue_SP GetValueOrRaiseForASTNode_IsConst(const EidosASTNode *p_symbol_node, bool *p_is_const) const { return _GetValue_IsConst(p_symbol_node->cached_stringID_, p_symbol_node->token_, p_is_const); }
+	inline __attribute__((always_inline)) EidosValue_SP GetValueOrRaiseForASTNode_IsConst(const EidosASTNode *p_symbol_node, bool *p_is_const) const
+	{
+		int slot_index = _HintedSlotIndex(p_symbol_node);
+		
+		if (slot_index != -1)
+		{
+			*p_is_const = (table_type_ != EidosSymbolTableType::kVariablesTable);
+			return internal_symbols_[slot_index].symbol_value_SP_;
+		}
+		return _GetValueForASTNode(p_symbol_node, p_is_const);
+	}
 	inline __attribute__((always_inline)) EidosValue_SP GetValueOrRaiseForSymbol_IsConst(EidosGlobalStringID p_symbol_name, bool *p_is_const) const { return _GetValue_IsConst(p_symbol_name, nullptr, p_is_const); }
 	
+	// Get a value without raising or retaining it; returns nullptr if the symbol is undefined.  The pointer is valid only until the table is next modified.
+	inline __attribute__((always_inline)) EidosValue *GetValuePointerOrNullForSymbol(EidosGlobalStringID p_symbol_name) const { return _GetValuePointerOrNull(p_symbol_name); }
+	inline __attribute__((always_inline)) EidosValue *GetValuePointerOrNullForASTNode(const EidosASTNode *p_symbol_node) const
+	{
+		int slot_index = _HintedSlotIndex(p_symbol_node);
+		
+		if (slot_index != -1)
+			return internal_symbols_[slot_index].symbol_value_SP_.get();
+		return _GetValuePointerOrNullForASTNode(p_symbol_node);
+	}
+	
 	// Special-purpose methods used for fast setup of new symbol tables with constants.
 	//
 	// These methods assume (1) that the name string is a global constant that does not need to be copied and
@@ -25,6 +25,7 @@
 #include "eidos_global.h"
 #include "eidos_rng.h"
 #include "eidos_test_element.h"
+#include "eidos_bytecode.h"
 
 #include <iostream>
 #include <string>
@@ -255,8 +256,29 @@ static void _RunFunctionMiscTests(void);
 static void _RunMethodTests(void);
 static void _RunCodeExampleTests(void);
 static void _RunUserDefinedFunctionTests(void);
+static void _RunBytecodeTests(void);
 
 
+static void _RunExpressionTests(void)
+{
+	_RunOperatorPlusTests();
+	_RunOperatorMinusTests();
+	_RunOperatorMultTests();
+	_RunOperatorDivTests();
+	_RunOperatorModTests();
+	_RunOperatorGtTests();
+	_RunOperatorLtTests();
+	_RunOperatorGtEqTests();
+	_RunOperatorLtEqTests();
+	_RunOperatorEqTests();
+	_RunOperatorNotEqTests();
+	_RunOperatorExpTests();
+	_RunOperatorLogicalAndTests();
+	_RunOperatorLogicalOrTests();
+	_RunOperatorLogicalNotTests();
+	_RunBytecodeTests();
+}
+
 int RunEidosTests(void)
 {
 	// Reset error counts
@@ -312,6 +334,17 @@ int RunEidosTests(void)
 	_RunMethodTests();
 	_RunCodeExampleTests();
 	_RunUserDefinedFunctionTests();
+	_RunBytecodeTests();
+	
+#if EIDOS_BYTECODE
+	// Run the expression tests again with bytecode compilation toggled, so they run both with the bytecode and with the interpreter
+	// alone; the interpreter must produce every result and error that the bytecode handles, or bails out on
+	bool saved_bytecode_enabled = gEidosBytecodeEnabled;
+	
+	gEidosBytecodeEnabled = !saved_bytecode_enabled;
+	_RunExpressionTests();
+	gEidosBytecodeEnabled = saved_bytecode_enabled;
+#endif
 	
 	// ************************************************************************************
 	//
@@ -1859,6 +1892,17 @@ void _RunOperatorSubsetTests(void)
 	EidosAssertScriptSuccess("x = 1:5; x[2.0:3];", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_vector{3, 4}));
 	EidosAssertScriptSuccess("x = 1:5; x[c(0.0, 2, 4)];", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_vector{1, 3, 5}));
 	EidosAssertScriptSuccess("x = 1:5; x[0.0:4];", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_vector{1, 2, 3, 4, 5}));
+	EidosAssertScriptSuccess("x = 1:5; a = 1; b = 3; x[a:b];", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_vector{2, 3, 4}));
+	EidosAssertScriptSuccess("x = 1:5; a = 1; b = 3; x[b:a];", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_vector{4, 3, 2}));
+	EidosAssertScriptSuccess("x = 1:5; a = 4; x[a:a];", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(5)));
+	EidosAssertScriptSuccess("x = (1:5) * 0.5; b = 4; x[3:b];", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Float_vector{2.0, 2.5}));
+	EidosAssertScriptSuccess("x = c('a', 'b', 'c'); b = 0; x[2:b];", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_String_vector{"c", "b", "a"}));
+	EidosAssertScriptSuccess("x = c(T, F, F); b = 1; x[0:b];", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Logical{true, false}));
+	EidosAssertScriptSuccess("x = rep(_Test(7), 3); b = 2; sum(x[1:b]._yolk);", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(14)));
+	EidosAssertScriptRaise("x = 1:5; b = 5; x[2:b];", 17, "out-of-range index 5");
+	EidosAssertScriptRaise("x = 1:5; b = -1; x[1:b];", 18, "out-of-range index -1");
+	EidosAssertScriptRaise("x = 1:5; b = 6; x[b:2];", 17, "out-of-range index 6");
+	EidosAssertScriptRaise("x = 1:5; b = 1.5; x['a':b];", 23, "is not supported by the ':' operator");
 	EidosAssertScriptRaise("x = 1:5; x[c(7,8)];", 10, "out-of-range index");
 	EidosAssertScriptRaise("x = 1:5; x[logical(0)];", 10, "operator requires that the size()");
 	EidosAssertScriptRaise("x = 1:5; x[T];", 10, "operator requires that the size()");
@@ -2866,6 +2910,12 @@ void _RunOperatorRangeTests(void)
 	EidosAssertScriptRaise("NAN:1.5;", 3, "must not be NAN");
 	EidosAssertScriptRaise("1:10000010;", 1, "more than 10000000 entries");
 	EidosAssertScriptRaise("10000010:1;", 8, "more than 10000000 entries");
+	EidosAssertScriptSuccess("for (i in 0:10000010) ; i;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(10000010)));
+	EidosAssertScriptSuccess("m = 4611686018427387904; M = (m - 1) + m; for (i in 1:M) break; i;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(1)));
+	EidosAssertScriptRaise("m = 4611686018427387904; M = (m - 1) + m; for (i in 0:M) break;", 53, "more than 9223372036854775807 entries");
+	EidosAssertScriptRaise("m = 4611686018427387904; M = (m - 1) + m; for (i in M:-M) break;", 53, "more than 9223372036854775807 entries");
+	EidosAssertScriptRaise("m = 4611686018427387904; M = (m - 1) + m; for (i in -M:M) break;", 54, "more than 9223372036854775807 entries");
+	EidosAssertScriptRaise("x = 1:5; b = 10000010; x[0:b];", 24, "out-of-range index 5");
 	
 	EidosAssertScriptRaise("matrix(5):9;", 9, "must not be matrices or arrays");
 	EidosAssertScriptRaise("1:matrix(5);", 1, "must not be matrices or arrays");
@@ -3318,6 +3368,9 @@ void _RunKeywordForInTests(void)
 	EidosAssertScriptSuccess("x=0; for (y in 1:10) x=x+1; x;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(10)));
 	EidosAssertScriptSuccess("x=0; for (y in 1:10) { x=x+y; y = 7; } x;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(55)));
 	EidosAssertScriptSuccess("x=0; for (y in 1:10) { x=x+1; y = 7; } x;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(10)));
+	EidosAssertScriptSuccess("n=10; x=0; for (y in 1:n) { x=x+y; y = 7; } x;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(55)));
+	EidosAssertScriptSuccess("n=10; x=0; for (y in n:1) { x=x+y; y = y * 2; } y;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(2)));
+	EidosAssertScriptSuccess("x=0; q=11:20; for (y in seqAlong(q)) { x=x+y; y = -1; } x;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(45)));
 	EidosAssertScriptSuccess("x=0; for (y in 10:1) x=x+y; x;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(55)));
 	EidosAssertScriptSuccess("x=0; for (y in 10:1) x=x+1; x;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(10)));
 	EidosAssertScriptSuccess("x=0; for (y in 1.0:10) x=x+y; x;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Float_singleton(55.0)));
@@ -6654,6 +6707,8 @@ void _RunFunctionMiscTests(void)
 	EidosAssertScriptRaise("x=37; rm('x'); x;", 15, "undefined identifier");
 	EidosAssertScriptSuccess("x=37; rm('y'); x;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(37)));
 	EidosAssertScriptRaise("x=37; rm(); x;", 12, "undefined identifier");
+	EidosAssertScriptSuccess("x=1; y=2; z=3; for (i in 1:3) { if (i == 2) rm('x'); y = y + z; } y;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(11)));
+	EidosAssertScriptSuccess("a=1; b=2; for (i in 1:4) { if (i % 2) { rm('a'); a = i * 10; } b = b + a; } b;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(82)));
 	EidosAssertScriptRaise("rm(3);", 0, "cannot be type");
 	EidosAssertScriptRaise("rm(3.5);", 0, "cannot be type");
 	EidosAssertScriptRaise("rm(_Test(7));", 0, "cannot be type");
@@ -6882,6 +6937,34 @@ void _RunUserDefinedFunctionTests(void)
 		, gStaticEidosValue_LogicalT);
 }
 
+#pragma mark bytecode
+void _RunBytecodeTests(void)
+{
+	// expressions compiled to bytecode; these are also run with the interpreter alone, and must behave identically
+	EidosAssertScriptSuccess("x = 5; y = 3; x * y + x - y;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(17)));
+	EidosAssertScriptSuccess("x = 5; y = 2.5; (x + 1) * y / 2;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Float_singleton(7.5)));
+	EidosAssertScriptSuccess("x = 7; y = 2; x / y + x % y;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Float_singleton(4.5)));
+	EidosAssertScriptSuccess("x = 2; -x ^ 3 + 1;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Float_singleton(-7.0)));
+	EidosAssertScriptSuccess("x = 5; y = 3.0; x > y & y >= 3 & !(x == 4);", gStaticEidosValue_LogicalT);
+	EidosAssertScriptSuccess("x = 5; y = 3; x < y | x != 5 | F;", gStaticEidosValue_LogicalF);
+	EidosAssertScriptSuccess("x = NAN; x == 1.0 & x <= 1.0 & x >= 1.0 & !(x < 1.0) & !(x > 1.0);", gStaticEidosValue_LogicalT);
+	EidosAssertScriptSuccess("s = 0; for (i in 1:100) s = s + i * 2 - 1; s;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(10000)));
+	
+	// operands the bytecode does not handle, which fall back to the interpreter, including after the bytecode reverts
+	EidosAssertScriptSuccess("x = 1:3; x * 2 + 1;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_vector{3, 5, 7}));
+	EidosAssertScriptSuccess("x = 1:3; for (i in 1:20) y = x * 2 + 1; y;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_vector{3, 5, 7}));
+	EidosAssertScriptSuccess("for (i in 1:20) { x = 4; if (i <= 10) x = 1:3; y = x * 2 + 1; } y;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_Int_singleton(9)));
+	EidosAssertScriptSuccess("x = matrix(5); identical(x * 2 + 1, matrix(11));", gStaticEidosValue_LogicalT);
+	EidosAssertScriptSuccess("x = 'a'; y = 2; x + y * 3;", EidosValue_SP(new (gEidosValuePool->AllocateChunk()) EidosValue_String_singleton("a6")));
+	EidosAssertScriptSuccess("x = T; y = 2; x == y - 1 + 0;", gStaticEidosValue_LogicalT);
+	EidosAssertScriptRaise("x = 5; x * y + 1;", 11, "undefined identifier");
+	EidosAssertScriptRaise("x = NULL; y = 2; x + y * 3;", 19, "combination of operand types");
+#if EIDOS_HAS_OVERFLOW_BUILTINS
+	EidosAssertScriptRaise("x = 5e18; y = 1; x + x * y;", 19, "overflow with the binary");
+	EidosAssertScriptRaise("x = -5e18; y = 2; -x * y - 1;", 21, "multiplication overflow");
+#endif
+}
+
 
 
 